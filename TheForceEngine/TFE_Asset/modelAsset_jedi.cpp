@@ -22,7 +22,7 @@ extern MemoryRegion* s_gameRegion;
 extern MemoryRegion* s_levelRegion;
 static MemoryRegion* s_memRegion;
 
-#define model_alloc(size) TFE_Memory::region_alloc(s_memRegion, size)
+#define model_alloc(size) TFE_Memory::region_alloc(s_memRegion, size, "model")
 #define model_free(ptr) TFE_Memory::region_free(s_memRegion, ptr)
 
 // Jedi code for processing models.
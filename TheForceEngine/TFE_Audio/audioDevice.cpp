@@ -155,7 +155,12 @@ namespace TFE_AudioDevice
 		}
 		catch (...)
 		{
-			TFE_System::logWrite(LOG_ERROR, "Audio", "Cannot start audio stream for output device %u.", s_outputDevice);
+			TFE_System::logWrite(LOG_ERROR, "Audio", "Cannot start audio stream for output device %u at %u Hz.", s_outputDevice, sampleRate);
+			// Close the stream so that the caller can try again with different parameters.
+			if (s_device->isStreamOpen())
+			{
+				s_device->closeStream();
+			}
 			s_streamStarted = false;
 			return false;
 		}
@@ -163,6 +168,18 @@ namespace TFE_AudioDevice
 		return true;
 	}
 
+	u32 getPreferredSampleRate()
+	{
+		if (!s_device) { return 0; }
+		return s_OutputInfo.preferredSampleRate;
+	}
+
+	u32 getOutputSampleRate()
+	{
+		if (!s_device || !s_streamStarted) { return 0; }
+		return s_device->getStreamSampleRate();
+	}
+
 	void stopOutput()
 	{
 		if (s_device && s_streamStarted)
@@ -29,4 +29,9 @@ namespace TFE_AudioDevice
 
 	bool startOutput(StreamCallback callback, void* userData = 0, u32 channels = 2, u32 sampleRate = 44100);
 	void stopOutput();
+
+	// The native rate of the output device, 0 if unknown.
+	u32  getPreferredSampleRate();
+	// The rate of the running output stream, 0 if there is no stream.
+	u32  getOutputSampleRate();
 };
@@ -0,0 +1,181 @@
+#include <cstring>
+
+#include "audioRecorder.h"
+#include "midi.h"
+#include <TFE_System/system.h>
+#include <TFE_FileSystem/filestream.h>
+#include <algorithm>
+#include <vector>
+
+namespace TFE_AudioRecorder
+{
+	enum RecorderConstants
+	{
+		WAV_HEADER_SIZE   = 58,		// RIFF + fmt (18) + fact + data chunk headers.
+		WAV_FORMAT_FLOAT  = 3,
+		MIDI_MAX_DIVISION = 0x7fff,
+	};
+
+	struct MidiEvent
+	{
+		u64 frame;
+		u8  data[3];
+		u8  size;
+	};
+
+	static FileStream s_wavFile;
+	static u32 s_wavFrames = 0;
+	static u32 s_wavSampleRate = 0;
+
+	static FileStream s_midiFile;
+	static std::vector<MidiEvent> s_midiEvents;
+	static u32 s_midiDivision = 0;
+	static f64 s_midiTickScale = 1.0;
+
+	static void writeU16(u8* dst, u16 value) { memcpy(dst, &value, sizeof(u16)); }
+	static void writeU32(u8* dst, u32 value) { memcpy(dst, &value, sizeof(u32)); }
+	static void writeU32BE(std::vector<u8>& dst, u32 value)
+	{
+		dst.push_back(u8(value >> 24u));
+		dst.push_back(u8(value >> 16u));
+		dst.push_back(u8(value >> 8u));
+		dst.push_back(u8(value));
+	}
+
+	//////////////////////////////////////////
+	// WAV
+	//////////////////////////////////////////
+	static void writeWavHeader()
+	{
+		const u32 sampleRate = s_wavSampleRate;
+		const u32 dataSize = s_wavFrames * 2 * sizeof(f32);
+		u8 header[WAV_HEADER_SIZE];
+		memcpy(header, "RIFF", 4);
+		writeU32(header + 4, WAV_HEADER_SIZE - 8 + dataSize);
+		memcpy(header + 8, "WAVE", 4);
+
+		memcpy(header + 12, "fmt ", 4);
+		writeU32(header + 16, 18);
+		writeU16(header + 20, WAV_FORMAT_FLOAT);
+		writeU16(header + 22, 2);
+		writeU32(header + 24, sampleRate);
+		writeU32(header + 28, sampleRate * 2 * sizeof(f32));
+		writeU16(header + 32, 2 * sizeof(f32));
+		writeU16(header + 34, 32);
+		writeU16(header + 36, 0);
+
+		memcpy(header + 38, "fact", 4);
+		writeU32(header + 42, 4);
+		writeU32(header + 46, s_wavFrames);
+
+		memcpy(header + 50, "data", 4);
+		writeU32(header + 54, dataSize);
+		s_wavFile.writeBuffer(header, WAV_HEADER_SIZE);
+	}
+
+	bool wavBegin(const char* path, u32 sampleRate)
+	{
+		if (!s_wavFile.open(path, Stream::MODE_WRITE))
+		{
+			TFE_System::logWrite(LOG_ERROR, "AudioRecorder", "Cannot open '%s' for writing.", path);
+			return false;
+		}
+		// The sizes are filled in by wavEnd().
+		s_wavFrames = 0;
+		s_wavSampleRate = sampleRate;
+		writeWavHeader();
+		return true;
+	}
+
+	void wavWrite(const f32* frames, u32 frameCount)
+	{
+		if (!s_wavFile.isOpen()) { return; }
+		s_wavFile.writeBuffer(frames, sizeof(f32) * 2, frameCount);
+		s_wavFrames += frameCount;
+	}
+
+	void wavEnd()
+	{
+		if (!s_wavFile.isOpen()) { return; }
+
+		s_wavFile.seek(0);
+		writeWavHeader();
+		s_wavFile.close();
+	}
+
+	//////////////////////////////////////////
+	// MIDI
+	//////////////////////////////////////////
+	bool midiBegin(const char* path, u32 sampleRate)
+	{
+		if (!s_midiFile.open(path, Stream::MODE_WRITE))
+		{
+			TFE_System::logWrite(LOG_ERROR, "AudioRecorder", "Cannot open '%s' for writing.", path);
+			return false;
+		}
+		// With a tempo of one quarter note per second, the division is the number of ticks per second.
+		s_midiDivision = std::min(sampleRate, u32(MIDI_MAX_DIVISION));
+		s_midiTickScale = f64(s_midiDivision) / f64(sampleRate);
+		s_midiEvents.clear();
+		return true;
+	}
+
+	void midiWrite(u64 frame, const u8* msg, u32 size)
+	{
+		if (!s_midiFile.isOpen() || !size || msg[0] < 0x80 || msg[0] >= MID_EXCLUSIVE_START) { return; }
+
+		// Program change and channel pressure only have one data byte.
+		const u8 type = msg[0] & 0xf0;
+		const u32 length = (type == MID_PROGRAM_CHANGE || type == MID_CHANNEL_PRESSURE) ? 2u : 3u;
+
+		MidiEvent midiEvent = {};
+		midiEvent.frame = frame;
+		midiEvent.size = u8(std::min(size, length));
+		memcpy(midiEvent.data, msg, midiEvent.size);
+		s_midiEvents.push_back(midiEvent);
+	}
+
+	static void writeVarLen(std::vector<u8>& dst, u32 value)
+	{
+		u8 bytes[5];
+		s32 count = 0;
+		do
+		{
+			bytes[count++] = value & 0x7f;
+			value >>= 7u;
+		} while (value);
+
+		for (s32 i = count - 1; i >= 0; i--)
+		{
+			dst.push_back(bytes[i] | (i ? 0x80 : 0x00));
+		}
+	}
+
+	void midiEnd()
+	{
+		if (!s_midiFile.isOpen()) { return; }
+
+		// Tempo: 1,000,000 microseconds per quarter note.
+		std::vector<u8> track = { 0x00, 0xff, META_TEMPO, 0x03, 0x0f, 0x42, 0x40 };
+		u64 prevTick = 0;
+		for (size_t i = 0; i < s_midiEvents.size(); i++)
+		{
+			const MidiEvent& midiEvent = s_midiEvents[i];
+			const u64 tick = std::max(prevTick, u64(f64(midiEvent.frame) * s_midiTickScale));
+			writeVarLen(track, u32(std::min(tick - prevTick, u64(0x0fffffff))));
+			track.insert(track.end(), midiEvent.data, midiEvent.data + midiEvent.size);
+			prevTick = tick;
+		}
+		const u8 endOfTrack[] = { 0x00, 0xff, META_END_OF_TRACK, 0x00 };
+		track.insert(track.end(), endOfTrack, endOfTrack + sizeof(endOfTrack));
+
+		std::vector<u8> file = { 'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 1, u8(s_midiDivision >> 8u), u8(s_midiDivision) };
+		file.insert(file.end(), { 'M', 'T', 'r', 'k' });
+		writeU32BE(file, u32(track.size()));
+		file.insert(file.end(), track.begin(), track.end());
+
+		s_midiFile.writeBuffer(file.data(), u32(file.size()));
+		s_midiFile.close();
+		s_midiEvents.clear();
+	}
+}
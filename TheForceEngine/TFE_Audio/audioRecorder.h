@@ -0,0 +1,21 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Audio Recorder
+// Writes the offline audio render to disk: the mix as a 32-bit float
+// WAV file, so renders from different builds can be compared exactly,
+// and the MIDI output as a Standard MIDI File.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+
+namespace TFE_AudioRecorder
+{
+	// Interleaved stereo frames.
+	bool wavBegin(const char* path, u32 sampleRate);
+	void wavWrite(const f32* frames, u32 frameCount);
+	void wavEnd();
+
+	// Format 0 MIDI file, events are timestamped in frames at 'sampleRate' (at most 32767).
+	bool midiBegin(const char* path, u32 sampleRate);
+	void midiWrite(u64 frame, const u8* msg, u32 size);
+	void midiEnd();
+}
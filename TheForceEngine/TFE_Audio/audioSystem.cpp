@@ -2,13 +2,19 @@
 
 #include "audioSystem.h"
 #include "audioDevice.h"
+#include "mixKernels.h"
+#include "resampler.h"
+#include "audioRecorder.h"
 #include <TFE_System/system.h>
 #include <TFE_System/math.h>
 #include <TFE_Settings/settings.h>
+#include <TFE_FileSystem/paths.h>
 #include <TFE_FrontEndUI/console.h>
 #include <TFE_System/profiler.h>
+#include <TFE_System/spscQueue.h>
 #include <assert.h>
 #include <algorithm>
+#include <thread>
 
 // Comment out the desired sigmoid function and comment all of the others.
 //#define AUDIO_SIGMOID_CLIP 1
@@ -18,9 +24,6 @@
 // Volume level below which sound processing can be skipped.
 #define SND_CULL_VOLUME 0.0001f
 
-// Set to 1 to enable audio timing counters.
-#define AUDIO_TIMING 0
-
 enum SoundSourceFlags
 {
 	SND_FLAG_ONE_SHOT = (1 << 0),
@@ -51,41 +54,112 @@ namespace TFE_Audio
 {
 	static const f32 c_channelLimit  = 1.0f;
 	static const f32 c_soundHeadroom = 0.7f;
+	// Sample rate of the mix, the iMuse digital audio is mixed at this rate.
+	static const u32 c_mixRate = 11025u;
+	// The largest number of frames mixed at once when resampling, clients (such as iMuse) expect at most 256 frames.
+	static const u32 c_mixBlockSize = 256u;
+
+	// Commands sent from the main thread to the audio thread.
+	enum AudioCommandType
+	{
+		ACMD_PLAY = 0,
+		ACMD_STOP,
+		ACMD_FREE,
+		ACMD_SET_BUFFER,
+		ACMD_STOP_ALL,
+	};
+
+	struct AudioCommand
+	{
+		AudioCommandType type;
+		s32 slot;
+		u32 flags;
+		const SoundBuffer* buffer;
+	};
 
 	// Client volume controls, ranging from [0, 1]
 	static f32 s_soundFxVolume = 1.0f;
 
+	// The sources are owned by the audio thread, the main thread only allocates a slot and fills it in
+	// before the first command that references it. The audio thread releases the slot once it is done with it.
 	static u32 s_sourceCount;
 	static SoundSource s_sources[MAX_SOUND_SOURCES];
-	static Mutex s_mutex;
+	static atomic_bool s_sourceInUse[MAX_SOUND_SOURCES];
+	static SpscQueue<AudioCommand, 256> s_commands;
 	static bool s_paused = false;
 	static bool s_nullDevice = false;
 
-	static AudioThreadCallback s_audioThreadCallback = nullptr;
+	static std::atomic<AudioThreadCallback> s_audioThreadCallback[AUDIO_CALLBACK_COUNT];
+	static atomic_bool s_audioThreadCallbackActive[AUDIO_CALLBACK_COUNT];
+
+	// TFE: The mix is resampled to the native device rate internally, instead of relying on the backend.
+	// The music is synthesized at the device rate and added after the resampler.
+	static bool s_resampling = false;
+	static Resampler s_resampler;
+	static f32 s_mixBuffer[c_mixBlockSize * 2];
+
+	// TFE: Offline rendering, the mix is pulled from the game loop instead of the audio thread and written to a file.
+	static bool s_offline = false;
+	static char s_renderPath[TFE_MAX_PATH];
+	static f64 s_offlineFrameAccum = 0.0;
+	static u64 s_offlineFrames = 0;
+	static u64 s_offlineMixTicks = 0;
 
 	s32 audioCallback(void *outputBuffer, void* inputBuffer, u32 bufferSize, f64 streamTime, u32 status, void* userData);
+	bool startOutputStream(TFE_ResampleQuality quality);
 	void setSoundVolumeConsole(const ConsoleArgList& args);
 	void getSoundVolumeConsole(const ConsoleArgList& args);
+	void audioResamplerConsole(const ConsoleArgList& args);
 
-#if AUDIO_TIMING == 1
-	static f64 s_soundIterMaxF = 0.0;
-	static f64 s_soundIterAveF = 0.0;
-	static s32 s_soundIterMax = 0;
-	static s32 s_soundIterAve = 0;
-#endif
+	void audioStatsConsole(const ConsoleArgList& args);
+	static void recordCallbackTime(u64 ticks, u32 bufferSize, u32 status);
 
-	bool init(bool useNullDevice/*=false*/)
+	// TFE: Audio thread statistics, the audio thread accumulates a window and publishes it once per second.
+	struct AudioTimingWindow
+	{
+		u64 start;
+		u32 count;
+		u64 totalTicks;
+		u64 minTicks;
+		u64 maxTicks;
+		u32 histogram[AUDIO_TIMING_BINS];
+	};
+	static AudioTimingWindow s_timingWindow;
+	static AudioThreadStats s_threadStats[2];
+	static std::atomic<u32> s_threadStatsIndex(0);
+	static std::atomic<u32> s_underruns(0);
+	static std::atomic<u64> s_lockWaitTicks(0);
+	static std::atomic<u32> s_lockMisses(0);
+	static std::atomic<s32> s_voiceCount[AUDIO_VOICES_COUNT];
+	// Profiler counters.
+	static s32 s_callbackAveUs = 0;
+	static s32 s_callbackP99Us = 0;
+	static s32 s_callbackMaxUs = 0;
+	static s32 s_underrunCount = 0;
+	static s32 s_lockWaitUs = 0;
+	static s32 s_waveVoices = 0;
+	static s32 s_midiVoices = 0;
+
+	bool init(bool useNullDevice/*=false*/, const char* renderPath/*=nullptr*/)
 	{
 		TFE_System::logWrite(LOG_MSG, "Startup", "TFE_AudioSystem::init");
 		s_sourceCount = 0u;
 
 		CCMD("setSoundVolume", setSoundVolumeConsole, 1, "Sets the sound volume, range is 0.0 to 1.0");
 		CCMD("getSoundVolume", getSoundVolumeConsole, 0, "Get the current sound volume.");
+		CCMD("audioBenchmark", mixKernelBenchmark, 0, "Checks and times the audio mixing kernels, mixing 32 and 64 sounds.");
+		CCMD("audioResampler", audioResamplerConsole, 0, "Shows the output sample rate and resampler quality.");
+		CCMD("resamplerBenchmark", resamplerBenchmark, 0, "Times each resampler quality level, optionally pass the output rate (default 48000).");
+
+		CCMD("audioStats", audioStatsConsole, 0, "Shows the audio callback timing, underruns, lock waits and voice counts for the last second.");
 
-	#if AUDIO_TIMING == 1
-		TFE_COUNTER(s_soundIterMax, "SoundIterMax-MicroSec");
-		TFE_COUNTER(s_soundIterAve, "SoundIterAve-MicroSec");
-	#endif
+		TFE_COUNTER(s_callbackAveUs, "AudioCallbackAve-MicroSec");
+		TFE_COUNTER(s_callbackP99Us, "AudioCallbackP99-MicroSec");
+		TFE_COUNTER(s_callbackMaxUs, "AudioCallbackMax-MicroSec");
+		TFE_COUNTER(s_underrunCount, "AudioUnderruns");
+		TFE_COUNTER(s_lockWaitUs, "AudioLockWait-MicroSec");
+		TFE_COUNTER(s_waveVoices, "AudioWaveVoices");
+		TFE_COUNTER(s_midiVoices, "AudioMidiVoices");
 
 		TFE_Settings_Sound* soundSettings = TFE_Settings::getSoundSettings();
 		setVolume(soundSettings->soundFxVolume);
@@ -94,6 +168,43 @@ namespace TFE_Audio
 		for (s32 i = 0; i < MAX_SOUND_SOURCES; i++)
 		{
 			s_sources[i].slot = i;
+			s_sourceInUse[i] = false;
+		}
+		for (s32 i = 0; i < AUDIO_CALLBACK_COUNT; i++)
+		{
+			s_audioThreadCallback[i].store(nullptr);
+			s_audioThreadCallbackActive[i].store(false);
+		}
+		s_commands.clear();
+
+		memset(&s_timingWindow, 0, sizeof(AudioTimingWindow));
+		memset(s_threadStats, 0, sizeof(AudioThreadStats) * 2);
+		s_timingWindow.start = TFE_System::getCurrentTimeInTicks();
+		s_threadStatsIndex.store(0);
+		s_underruns.store(0);
+		s_lockWaitTicks.store(0);
+		s_lockMisses.store(0);
+		for (s32 i = 0; i < AUDIO_VOICES_COUNT; i++)
+		{
+			s_voiceCount[i].store(0);
+		}
+
+		if (renderPath)
+		{
+			char wavPath[TFE_MAX_PATH];
+			snprintf(s_renderPath, TFE_MAX_PATH, "%s", renderPath);
+			snprintf(wavPath, TFE_MAX_PATH, "%s.wav", renderPath);
+			s_offline = TFE_AudioRecorder::wavBegin(wavPath, c_mixRate);
+			s_offlineFrameAccum = 0.0;
+			s_offlineFrames = 0;
+			s_offlineMixTicks = 0;
+			s_resampling = false;
+			s_nullDevice = !s_offline;
+			if (s_offline)
+			{
+				TFE_System::logWrite(LOG_MSG, "Audio", "Rendering audio offline to '%s' at %u Hz.", wavPath, c_mixRate);
+			}
+			return s_offline;
 		}
 
 		bool audDev = TFE_AudioDevice::init(256u, -1, useNullDevice);
@@ -104,42 +215,76 @@ namespace TFE_Audio
 			return false;
 		}
 
-		bool audStream = TFE_AudioDevice::startOutput(audioCallback, nullptr, 2u, 11025u);
+		s_nullDevice = false;
+		bool audStream = startOutputStream(soundSettings->resampleQuality);
 		if (!audStream)
 		{
 			TFE_System::logWrite(LOG_ERROR, "Audio", "Cannot start audio stream.");
 			s_nullDevice = true;
 			return false;
 		}
-
-		MUTEX_INITIALIZE(&s_mutex);
-		s_nullDevice = false;
 		return true;
 	}
 
+	bool startOutputStream(TFE_ResampleQuality quality)
+	{
+		// Open the device at its native rate and resample internally if possible.
+		u32 deviceRate = TFE_AudioDevice::getPreferredSampleRate();
+		if (!deviceRate) { deviceRate = 48000u; }
+		if (quality != TFE_RESAMPLE_BACKEND && deviceRate != c_mixRate)
+		{
+			// The resampler must be ready before the stream starts calling audioCallback().
+			s_resampling = resampler_init(&s_resampler, c_mixRate, deviceRate, ResampleQuality(quality - TFE_RESAMPLE_LOW));
+			if (s_resampling)
+			{
+				if (TFE_AudioDevice::startOutput(audioCallback, nullptr, 2u, deviceRate))
+				{
+					TFE_System::logWrite(LOG_MSG, "Audio", "Resampling from %u Hz to %u Hz, quality '%s'.", c_mixRate, deviceRate, c_tfeResampleQualityStrings[quality]);
+					return true;
+				}
+				TFE_System::logWrite(LOG_WARNING, "Audio", "Cannot open the device at %u Hz, falling back to %u Hz.", deviceRate, c_mixRate);
+				s_resampling = false;
+			}
+		}
+
+		s_resampling = false;
+		return TFE_AudioDevice::startOutput(audioCallback, nullptr, 2u, c_mixRate);
+	}
+
 	void shutdown()
 	{
 		TFE_System::logWrite(LOG_MSG, "Audio", "Shutdown");
 		if (s_nullDevice) { return; }
+		if (s_offline)
+		{
+			TFE_AudioRecorder::wavEnd();
+			s_offline = false;
+
+			// Report the mixing cost, so it can be compared between builds.
+			const f64 audioTime = f64(s_offlineFrames) / f64(c_mixRate);
+			const f64 mixTime = TFE_System::convertFromTicksToSeconds(s_offlineMixTicks);
+			TFE_System::logWrite(LOG_MSG, "Audio", "Offline render: %0.2f seconds of audio mixed in %0.3f seconds (%0.1f us per second of audio).",
+				audioTime, mixTime, audioTime > 0.0 ? mixTime * 1000000.0 / audioTime : 0.0);
+			return;
+		}
 
 		stopAllSounds();
 
 		TFE_AudioDevice::destroy();
-		MUTEX_DESTROY(&s_mutex);
 	}
 
-	void stopAllSounds()
+	static void pushCommand(AudioCommandType type, s32 slot, u32 flags = 0, const SoundBuffer* buffer = nullptr)
 	{
-		if (s_nullDevice) { return; }
-
-		MUTEX_LOCK(&s_mutex);
-		s_sourceCount = 0u;
-		memset(s_sources, 0, sizeof(SoundSource) * MAX_SOUND_SOURCES);
-		for (s32 i = 0; i < MAX_SOUND_SOURCES; i++)
+		if (!s_commands.push({ type, slot, flags, buffer }))
 		{
-			s_sources[i].slot = i;
+			TFE_System::logWrite(LOG_WARNING, "Audio", "The audio command queue is full, command %d for source %d is dropped.", type, slot);
 		}
-		MUTEX_UNLOCK(&s_mutex);
+	}
+
+	void stopAllSounds()
+	{
+		if (s_nullDevice) { return; }
+		pushCommand(ACMD_STOP_ALL, -1);
 	}
 
 	void setVolume(f32 volume)
@@ -162,25 +307,44 @@ namespace TFE_Audio
 		s_paused = false;
 	}
 		
-	void setAudioThreadCallback(AudioThreadCallback callback)
+	u32 getSampleRate(AudioThreadCallbackSlot slot)
 	{
-		if (s_nullDevice) { return; }
+		return (slot == AUDIO_CALLBACK_MUSIC && s_resampling) ? TFE_AudioDevice::getOutputSampleRate() : c_mixRate;
+	}
 
-		MUTEX_LOCK(&s_mutex);
-		s_audioThreadCallback = callback;
-		MUTEX_UNLOCK(&s_mutex);
+	const char* getOfflineRenderPath()
+	{
+		return s_offline ? s_renderPath : nullptr;
 	}
 
-	void lock()
+	bool setAudioThreadCallback(AudioThreadCallback callback, AudioThreadCallbackSlot slot)
 	{
-		if (s_nullDevice) { return; }
-		MUTEX_LOCK(&s_mutex);
+		if (s_nullDevice) { return false; }
+
+		s_audioThreadCallback[slot].store(callback);
+		if (!callback)
+		{
+			// Make sure the previous callback has returned before the client cleans up after it.
+			while (s_audioThreadCallbackActive[slot].load())
+			{
+				std::this_thread::yield();
+			}
+		}
+		return true;
 	}
 
-	void unlock()
+	// Find a free slot, the audio thread releases slots once they are freed or a one shot has finished.
+	static SoundSource* allocateSource()
 	{
-		if (s_nullDevice) { return; }
-		MUTEX_UNLOCK(&s_mutex);
+		for (s32 i = 0; i < MAX_SOUND_SOURCES; i++)
+		{
+			if (!s_sourceInUse[i].load(std::memory_order_acquire))
+			{
+				s_sourceInUse[i].store(true, std::memory_order_relaxed);
+				return &s_sources[i];
+			}
+		}
+		return nullptr;
 	}
 
 	// One shot, play and forget. Only do this if the client needs no control until stopAllSounds() is called.
@@ -189,41 +353,18 @@ namespace TFE_Audio
 	{
 		if (!buffer || s_nullDevice) { return false; }
 
-		MUTEX_LOCK(&s_mutex);
-		// Find the first inactive source.
-		SoundSource* snd = s_sources;
-		SoundSource* newSource = nullptr;
-		for (u32 s = 0; s < s_sourceCount; s++, snd++)
-		{
-			if (!(snd->flags&SND_FLAG_ACTIVE))
-			{
-				newSource = snd;
-				break;
-			}
-		}
-		if (!newSource && s_sourceCount < MAX_SOUND_SOURCES)
-		{
-			newSource = &s_sources[s_sourceCount];
-			s_sourceCount++;
-		}
-
+		SoundSource* newSource = allocateSource();
 		if (newSource)
 		{
 			newSource->type = type;
-			newSource->flags = SND_FLAG_ACTIVE | SND_FLAG_PLAYING | SND_FLAG_ONE_SHOT;
-			if (looping)
-			{
-				newSource->flags |= SND_FLAG_LOOPING;
-			}
 			newSource->volume = type == SOUND_3D ? 0.0f : volume;
 			newSource->buffer = buffer;
 			newSource->sampleIndex = 0u;
 			newSource->finishedCallback = finishedCallback;
 			newSource->finishedUserData = cbUserData;
 			newSource->finishedArg = cbArg;
+			pushCommand(ACMD_PLAY, newSource->slot, SND_FLAG_ONE_SHOT | (looping ? SND_FLAG_LOOPING : 0u));
 		}
-		MUTEX_UNLOCK(&s_mutex);
-
 		return newSource != nullptr;
 	}
 
@@ -233,36 +374,16 @@ namespace TFE_Audio
 		if (!buffer || s_nullDevice) { return nullptr; }
 		assert(volume >= 0.0f && volume <= 1.0f);
 
-		MUTEX_LOCK(&s_mutex);
-		// Find the first inactive source.
-		SoundSource* snd = s_sources;
-		SoundSource* newSource = nullptr;
-		for (u32 s = 0; s < s_sourceCount; s++, snd++)
-		{
-			if (!(snd->flags&SND_FLAG_ACTIVE))
-			{
-				newSource = snd;
-				break;
-			}
-		}
-		if (!newSource && s_sourceCount < MAX_SOUND_SOURCES)
-		{
-			newSource = &s_sources[s_sourceCount];
-			s_sourceCount++;
-		}
-
+		SoundSource* newSource = allocateSource();
 		if (newSource)
 		{
 			newSource->type = type;
-			newSource->flags = SND_FLAG_ACTIVE;
 			newSource->volume = volume;
 			newSource->buffer = buffer;
 			newSource->sampleIndex = 0u;
 			newSource->finishedCallback = callback;
 			newSource->finishedUserData = userData;
 		}
-		MUTEX_UNLOCK(&s_mutex);
-
 		return newSource;
 	}
 
@@ -280,7 +401,7 @@ namespace TFE_Audio
 		{
 			return nullptr;
 		}
-		if (!(s_sources[slot].flags & SND_FLAG_ACTIVE))
+		if (!s_sourceInUse[slot].load(std::memory_order_acquire))
 		{
 			return nullptr;
 		}
@@ -294,30 +415,19 @@ namespace TFE_Audio
 		{
 			return;
 		}
-		
-		MUTEX_LOCK(&s_mutex);
-			source->flags |= SND_FLAG_PLAYING;
-			if (looping) { source->flags |= SND_FLAG_LOOPING; }
-			source->sampleIndex = 0u;
-		MUTEX_UNLOCK(&s_mutex);
+		pushCommand(ACMD_PLAY, source->slot, looping ? SND_FLAG_LOOPING : 0u);
 	}
 
 	void stopSource(SoundSource* source)
 	{
 		if (!source || s_nullDevice) { return; }
-		MUTEX_LOCK(&s_mutex);
-			source->flags &= ~SND_FLAG_PLAYING;
-		MUTEX_UNLOCK(&s_mutex);
+		pushCommand(ACMD_STOP, source->slot);
 	}
 	
 	void freeSource(SoundSource* source)
 	{
 		if (!source || s_nullDevice) { return; }
-		MUTEX_LOCK(&s_mutex);
-			source->flags &= ~SND_FLAG_PLAYING;
-			source->flags &= ~SND_FLAG_ACTIVE;
-			source->buffer = nullptr;
-		MUTEX_UNLOCK(&s_mutex);
+		pushCommand(ACMD_FREE, source->slot);
 	}
 
 	void setSourceVolume(SoundSource* source, f32 volume)
@@ -330,10 +440,7 @@ namespace TFE_Audio
 	void setSourceBuffer(SoundSource* source, const SoundBuffer* buffer)
 	{
 		if (s_nullDevice) { return; }
-		MUTEX_LOCK(&s_mutex);
-			source->sampleIndex = 0u;
-			source->buffer = buffer;
-		MUTEX_UNLOCK(&s_mutex);
+		pushCommand(ACMD_SET_BUFFER, source->slot, 0u, buffer);
 	}
 
 	bool isSourcePlaying(SoundSource* source)
@@ -352,6 +459,59 @@ namespace TFE_Audio
 	static const f32 c_scale[] = { 2.0f / 255.0f, 2.0f / 65535.0f, 1.0f };
 	static const f32 c_offset[] = { -1.0f, -1.0f, 0.0f };
 
+	// Audio thread: releases a source slot so the main thread can reuse it.
+	static void releaseSource(SoundSource* snd)
+	{
+		snd->flags = 0;
+		snd->buffer = nullptr;
+		snd->sampleIndex = 0u;
+		s_sourceInUse[snd->slot].store(false, std::memory_order_release);
+	}
+
+	// Audio thread: apply the commands queued by the main thread since the last buffer.
+	static void processCommands()
+	{
+		AudioCommand cmd;
+		while (s_commands.pop(&cmd))
+		{
+			SoundSource* snd = (cmd.slot >= 0 && cmd.slot < MAX_SOUND_SOURCES) ? &s_sources[cmd.slot] : nullptr;
+			switch (cmd.type)
+			{
+				case ACMD_PLAY:
+				{
+					snd->flags = SND_FLAG_ACTIVE | SND_FLAG_PLAYING | cmd.flags;
+					snd->sampleIndex = 0u;
+					s_sourceCount = std::max(s_sourceCount, u32(cmd.slot + 1));
+				} break;
+				case ACMD_STOP:
+				{
+					snd->flags &= ~SND_FLAG_PLAYING;
+				} break;
+				case ACMD_FREE:
+				{
+					releaseSource(snd);
+				} break;
+				case ACMD_SET_BUFFER:
+				{
+					snd->sampleIndex = 0u;
+					snd->buffer = cmd.buffer;
+				} break;
+				case ACMD_STOP_ALL:
+				{
+					// Sources that have been allocated but not played yet still belong to the main thread.
+					for (u32 s = 0; s < s_sourceCount; s++)
+					{
+						if (s_sources[s].flags & SND_FLAG_ACTIVE)
+						{
+							releaseSource(&s_sources[s]);
+						}
+					}
+					s_sourceCount = 0u;
+				} break;
+			}
+		}
+	}
+
 	void cleanupSources()
 	{
 		// call any finished callbacks.
@@ -359,11 +519,13 @@ namespace TFE_Audio
 		{
 			if (s_sources[s].flags&SND_FLAG_FINISHED)
 			{
-				s_sources[s].flags = 0;
-				s_sources[s].buffer = nullptr;
-				if (s_sources[s].finishedCallback)
+				SoundFinishedCallback finishedCallback = s_sources[s].finishedCallback;
+				void* finishedUserData = s_sources[s].finishedUserData;
+				s32 finishedArg = s_sources[s].finishedArg;
+				releaseSource(&s_sources[s]);
+				if (finishedCallback)
 				{
-					s_sources[s].finishedCallback(s_sources[s].finishedUserData, s_sources[s].finishedArg);
+					finishedCallback(finishedUserData, finishedArg);
 				}
 			}
 		}
@@ -380,36 +542,61 @@ namespace TFE_Audio
 		}
 	}
 		
-	f32 sampleBuffer(u32 index, SoundDataType type, const u8* data)
+	static void runAudioThreadCallback(AudioThreadCallbackSlot slot, f32* buffer, u32 bufferSize)
 	{
-		f32 sampleValue = 0.0f;
-		switch (type)
+		s_audioThreadCallbackActive[slot].store(true);
+		AudioThreadCallback callback = s_audioThreadCallback[slot].load();
+		if (callback)
 		{
-			case SOUND_DATA_8BIT:  { sampleValue = (f32)data[index]; } break;
-			case SOUND_DATA_16BIT: { sampleValue = (f32)(*((u16*)data + index)); } break;
-			case SOUND_DATA_FLOAT: { sampleValue = *((f32*)data + index); } break;
-		};
-
-		return sampleValue * c_scale[type] + c_offset[type];
+			callback(buffer, s_paused ? 0u : bufferSize, s_soundFxVolume * c_soundHeadroom);
+		}
+		s_audioThreadCallbackActive[slot].store(false);
 	}
 
-	// Audio callback
-	s32 audioCallback(void *outputBuffer, void* inputBuffer, u32 bufferSize, f64 streamTime, u32 status, void* userData)
+	// Keep the mix within [-1, 1].
+	static void limitFrames(f32* outputBuffer, u32 bufferSize)
 	{
-		f32* buffer = (f32*)outputBuffer;
+		f32* buffer = outputBuffer;
+		for (u32 i = 0; i < bufferSize; i++, buffer += 2)
+		{
+			const f32 valueLeft  = buffer[0];
+			const f32 valueRight = buffer[1];
+
+			// Audio outside of the [-1, 1] range will cause overflow, which is a major artifact.
+			// Instead the audio needs to be limited in range, which can be done in several ways.
+			// Sigmoid functions map an arbitrary range into [-1, 1] generall along an S-Curve, allowing us to avoid overflow.
+		#if defined(AUDIO_SIGMOID_CLIP)		// Not really a Sigmoid function but acts in a similar way, naively mapping to the required range.
+			buffer[0] = std::max(-c_channelLimit, std::min(valueLeft,  c_channelLimit));
+			buffer[1] = std::max(-c_channelLimit, std::min(valueRight, c_channelLimit));
+		#elif defined(AUDIO_SIGMOID_TANH)	// Considered one of the most "musical sounding" sigmoid functions, it avoids hard clipping.
+			// Note the usable range is approximately -4.8 to 4.8 so the volumes should be adjusted to stay within those ranges when possible.
+			// Still much better than the effect -1 to 1 range with hard clipping and cheaper than the more accurate library tanh(). :)
+			buffer[0] = TFE_Math::tanhf_series(valueLeft);
+			buffer[1] = TFE_Math::tanhf_series(valueRight);
+		#elif defined(AUDIO_SIGMOID_RCP_SQRT)
+			buffer[0] = valueLeft  / sqrtf(1.0f + valueLeft * valueLeft);
+			buffer[1] = valueRight / sqrtf(1.0f + valueRight * valueRight);
+		#endif
+		}
+	}
 
-	#if AUDIO_TIMING == 1
-		u64 soundIterStart = TFE_System::getCurrentTimeInTicks();
-	#endif
+	// Mix bufferSize frames at c_mixRate.
+	// When resampling, the music and the limiter are left to resampleFrames() since they run at the device rate.
+	static void mixFrames(f32* outputBuffer, u32 bufferSize)
+	{
+		f32* buffer = outputBuffer;
 
 		// First clear samples
 		memset(buffer, 0, sizeof(f32)*bufferSize*2);
 			   
-		MUTEX_LOCK(&s_mutex);
-		// Then call the audio thread callback
-		if (s_audioThreadCallback && !s_paused)
+		// Apply the commands from the main thread.
+		processCommands();
+
+		// Then call the audio thread callbacks, these are still called while paused so they can process their own commands.
+		runAudioThreadCallback(AUDIO_CALLBACK_SOUND, buffer, bufferSize);
+		if (!s_resampling)
 		{
-			s_audioThreadCallback(buffer, bufferSize, s_soundFxVolume * c_soundHeadroom);
+			runAudioThreadCallback(AUDIO_CALLBACK_MUSIC, buffer, bufferSize);
 		}
 
 		// Then loop through the sources.
@@ -444,7 +631,7 @@ namespace TFE_Audio
 			}
 
 			// Sample loop.
-			buffer = (f32*)outputBuffer;
+			buffer = outputBuffer;
 			// The sound may be split into multiple iterations if it loops or the loop
 			// may end early, once we reach the end.
 			for (u32 i = 0; i < bufferSize;)
@@ -467,57 +654,195 @@ namespace TFE_Audio
 				const SoundDataType type = snd->buffer->type;
 				const u8* data = snd->buffer->data;
 				const u32 end = std::min(sndBufferSize, snd->sampleIndex + bufferSize - i);
-				u32 sIndex = snd->sampleIndex;
-				for (; sIndex < end; i++, sIndex++, buffer += 2)
-				{
-					const f32 sample = sampleBuffer(sIndex, type, data) * snd->volume;
-					buffer[0] += sample;
-					buffer[1] += sample;
-				}
-				snd->sampleIndex = sIndex;
+				const u32 count = end - snd->sampleIndex;
+				mixMonoToStereo(buffer, type, data, snd->sampleIndex, count, c_scale[type], c_offset[type], snd->volume);
+				buffer += count * 2;
+				i += count;
+				snd->sampleIndex += count;
 			}
 		}
-		// Cleanup sound sources while we are still in the mutex.
+		// Cleanup sound sources and release the slots of finished one shots.
 		cleanupSources();
-		MUTEX_UNLOCK(&s_mutex);
 
 		// Finally handle out of range audio samples.
-		buffer = (f32*)outputBuffer;
-		for (u32 i = 0; i < bufferSize; i++, buffer += 2)
+		if (!s_resampling)
 		{
-			const f32 valueLeft  = buffer[0];
-			const f32 valueRight = buffer[1];
+			limitFrames(outputBuffer, bufferSize);
+		}
+	}
 
-			// Audio outside of the [-1, 1] range will cause overflow, which is a major artifact.
-			// Instead the audio needs to be limited in range, which can be done in several ways.
-			// Sigmoid functions map an arbitrary range into [-1, 1] generall along an S-Curve, allowing us to avoid overflow.
-		#if defined(AUDIO_SIGMOID_CLIP)		// Not really a Sigmoid function but acts in a similar way, naively mapping to the required range.
-			buffer[0] = std::max(-c_channelLimit, std::min(valueLeft,  c_channelLimit));
-			buffer[1] = std::max(-c_channelLimit, std::min(valueRight, c_channelLimit));
-		#elif defined(AUDIO_SIGMOID_TANH)	// Considered one of the most "musical sounding" sigmoid functions, it avoids hard clipping.
-			// Note the usable range is approximately -4.8 to 4.8 so the volumes should be adjusted to stay within those ranges when possible.
-			// Still much better than the effect -1 to 1 range with hard clipping and cheaper than the more accurate library tanh(). :)
-			buffer[0] = TFE_Math::tanhf_series(valueLeft);
-			buffer[1] = TFE_Math::tanhf_series(valueRight);
-		#elif defined(AUDIO_SIGMOID_RCP_SQRT)
-			buffer[0] = valueLeft  / sqrtf(1.0f + valueLeft * valueLeft);
-			buffer[1] = valueRight / sqrtf(1.0f + valueRight * valueRight);
-		#endif
+	// Mix at c_mixRate and resample to the device rate, in blocks that the clients can handle.
+	// The music is then synthesized at the device rate, so it keeps its high frequencies.
+	static void resampleFrames(f32* outputBuffer, u32 bufferSize)
+	{
+		if (s_paused)
+		{
+			// Still process the commands while paused.
+			mixFrames(s_mixBuffer, 0);
+			runAudioThreadCallback(AUDIO_CALLBACK_MUSIC, outputBuffer, 0);
+			memset(outputBuffer, 0, sizeof(f32) * bufferSize * 2);
+			return;
 		}
 
-		// Timing
-	#if AUDIO_TIMING == 1
-		u64 soundIterEnd = TFE_System::getCurrentTimeInTicks();
-		f64 soundIterDeltaMS = 1000000.0 * TFE_System::convertFromTicksToSeconds(soundIterEnd - soundIterStart);
-		s_soundIterAveF = soundIterDeltaMS * 0.01 + s_soundIterAveF * 0.99;
-		s_soundIterMaxF = std::max(s_soundIterMaxF, soundIterDeltaMS);
-		s_soundIterAve = s32(s_soundIterAveF);
-		s_soundIterMax = s32(s_soundIterMaxF);
-	#endif
-		
+		u32 inputFrames = resampler_getInputFrames(&s_resampler, bufferSize);
+		do
+		{
+			const u32 count = std::min(inputFrames, c_mixBlockSize);
+			mixFrames(s_mixBuffer, count);
+			resampler_write(&s_resampler, s_mixBuffer, count);
+			inputFrames -= count;
+		} while (inputFrames);
+		resampler_read(&s_resampler, outputBuffer, bufferSize);
+
+		runAudioThreadCallback(AUDIO_CALLBACK_MUSIC, outputBuffer, bufferSize);
+		limitFrames(outputBuffer, bufferSize);
+	}
+
+	void renderOffline(f64 seconds)
+	{
+		if (!s_offline || seconds <= 0.0) { return; }
+
+		s_offlineFrameAccum += seconds * f64(c_mixRate);
+		u32 frames = u32(s_offlineFrameAccum);
+		s_offlineFrameAccum -= f64(frames);
+		while (frames)
+		{
+			const u32 count = std::min(frames, c_mixBlockSize);
+			const u64 start = TFE_System::getCurrentTimeInTicks();
+			mixFrames(s_mixBuffer, count);
+			const u64 mixTicks = TFE_System::getCurrentTimeInTicks() - start;
+			s_offlineMixTicks += mixTicks;
+			recordCallbackTime(mixTicks, count, 0);
+
+			TFE_AudioRecorder::wavWrite(s_mixBuffer, count);
+			s_offlineFrames += count;
+			frames -= count;
+		}
+	}
+
+	// Audio callback
+	s32 audioCallback(void *outputBuffer, void* inputBuffer, u32 bufferSize, f64 streamTime, u32 status, void* userData)
+	{
+		const u64 start = TFE_System::getCurrentTimeInTicks();
+		if (s_resampling)
+		{
+			resampleFrames((f32*)outputBuffer, bufferSize);
+		}
+		else
+		{
+			mixFrames((f32*)outputBuffer, bufferSize);
+		}
+		recordCallbackTime(TFE_System::getCurrentTimeInTicks() - start, bufferSize, status);
 		return 0;
 	}
-		
+
+	//////////////////////////////////////////
+	// Statistics
+	//////////////////////////////////////////
+	f32 getTimingBinUs(u32 bin)
+	{
+		return powf(2.0f, f32(bin) * 0.25f);
+	}
+
+	static u32 getTimingBin(f64 us)
+	{
+		if (us < 1.0) { return 0; }
+		return std::min(u32(4.0 * log2(us)), u32(AUDIO_TIMING_BINS - 1));
+	}
+
+	// Called on the audio thread (or the game thread when rendering offline).
+	static void publishThreadStats(u64 now, u32 bufferSize)
+	{
+		const AudioTimingWindow& window = s_timingWindow;
+		const u32 index = s_threadStatsIndex.load(std::memory_order_relaxed) ^ 1u;
+		AudioThreadStats* stats = &s_threadStats[index];
+
+		const f64 ticksToUs = 1000000.0 * TFE_System::convertFromTicksToSeconds(1);
+		stats->callbackCount = window.count;
+		stats->callbackMinUs = window.count ? f32(f64(window.minTicks) * ticksToUs) : 0.0f;
+		stats->callbackAveUs = window.count ? f32(f64(window.totalTicks) * ticksToUs / f64(window.count)) : 0.0f;
+		stats->callbackMaxUs = f32(f64(window.maxTicks) * ticksToUs);
+
+		// The 99th percentile is the upper edge of the bin it falls in, which may be larger than the actual maximum.
+		stats->callbackP99Us = 0.0f;
+		const u32 target = window.count - window.count / 100u;
+		u32 total = 0;
+		for (u32 i = 0; i < AUDIO_TIMING_BINS && window.count; i++)
+		{
+			total += window.histogram[i];
+			if (total >= target)
+			{
+				stats->callbackP99Us = std::min(getTimingBinUs(i + 1), stats->callbackMaxUs);
+				break;
+			}
+		}
+		memcpy(stats->histogram, window.histogram, sizeof(u32) * AUDIO_TIMING_BINS);
+
+		const u32 sampleRate = (s_offline || s_nullDevice) ? c_mixRate : TFE_AudioDevice::getOutputSampleRate();
+		stats->bufferUs = sampleRate ? 1000000.0f * f32(bufferSize) / f32(sampleRate) : 0.0f;
+		stats->underruns = s_underruns.load(std::memory_order_relaxed);
+		stats->lockWaitUs = f32(f64(s_lockWaitTicks.exchange(0, std::memory_order_relaxed)) * ticksToUs);
+		stats->lockMisses = s_lockMisses.load(std::memory_order_relaxed);
+		for (s32 i = 0; i < AUDIO_VOICES_COUNT; i++)
+		{
+			stats->voices[i] = s_voiceCount[i].load(std::memory_order_relaxed);
+		}
+		s_threadStatsIndex.store(index, std::memory_order_release);
+
+		s_callbackAveUs = s32(stats->callbackAveUs);
+		s_callbackP99Us = s32(stats->callbackP99Us);
+		s_callbackMaxUs = s32(stats->callbackMaxUs);
+		s_underrunCount = s32(stats->underruns);
+		s_lockWaitUs = s32(stats->lockWaitUs);
+		s_waveVoices = stats->voices[AUDIO_VOICES_WAVE];
+		s_midiVoices = stats->voices[AUDIO_VOICES_MIDI];
+
+		memset(&s_timingWindow, 0, sizeof(AudioTimingWindow));
+		s_timingWindow.start = now;
+	}
+
+	static void recordCallbackTime(u64 ticks, u32 bufferSize, u32 status)
+	{
+		if (status & AUDIO_STATUS_OUTPUT_UNDERFLOW)
+		{
+			s_underruns.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		AudioTimingWindow& window = s_timingWindow;
+		window.minTicks = window.count ? std::min(window.minTicks, ticks) : ticks;
+		window.maxTicks = std::max(window.maxTicks, ticks);
+		window.totalTicks += ticks;
+		window.count++;
+		window.histogram[getTimingBin(1000000.0 * TFE_System::convertFromTicksToSeconds(ticks))]++;
+
+		const u64 now = TFE_System::getCurrentTimeInTicks();
+		if (TFE_System::convertFromTicksToSeconds(now - window.start) >= 1.0)
+		{
+			publishThreadStats(now, bufferSize);
+		}
+	}
+
+	void getThreadStats(AudioThreadStats* stats)
+	{
+		// The audio thread only writes the other copy, a reader that takes longer than a second may see a partial update.
+		*stats = s_threadStats[s_threadStatsIndex.load(std::memory_order_acquire)];
+	}
+
+	void reportLockWait(u64 ticks)
+	{
+		s_lockWaitTicks.fetch_add(ticks, std::memory_order_relaxed);
+	}
+
+	void reportLockMiss()
+	{
+		s_lockMisses.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void setVoiceCount(AudioVoiceType type, s32 count)
+	{
+		s_voiceCount[type].store(count, std::memory_order_relaxed);
+	}
+
 	// Console functions.
 	void setSoundVolumeConsole(const ConsoleArgList& args)
 	{
@@ -536,4 +861,51 @@ namespace TFE_Audio
 		sprintf(res, "Sound Volume: %2.3f", s_soundFxVolume);
 		TFE_Console::addToHistory(res);
 	}
+
+	void audioResamplerConsole(const ConsoleArgList& args)
+	{
+		char res[256];
+		if (s_nullDevice)
+		{
+			sprintf(res, "Audio is disabled.");
+		}
+		else if (s_offline)
+		{
+			sprintf(res, "Rendering offline at %u Hz, %0.2f seconds rendered.", c_mixRate, f64(s_offlineFrames) / f64(c_mixRate));
+		}
+		else if (s_resampling)
+		{
+			sprintf(res, "Resampling from %u Hz to %u Hz, %u taps, latency %.2f ms.", c_mixRate, TFE_AudioDevice::getOutputSampleRate(), s_resampler.taps,
+				1000.0 * f64(resampler_getLatency(&s_resampler)) / f64(c_mixRate));
+		}
+		else
+		{
+			sprintf(res, "Output at %u Hz, resampling is done by the backend.", TFE_AudioDevice::getOutputSampleRate());
+		}
+		TFE_Console::addToHistory(res);
+	}
+
+	void audioStatsConsole(const ConsoleArgList& args)
+	{
+		AudioThreadStats stats;
+		getThreadStats(&stats);
+
+		char res[256];
+		sprintf(res, "Callbacks: %u in the last second, min %.1f us, ave %.1f us, p99 %.1f us, max %.1f us.", stats.callbackCount,
+			stats.callbackMinUs, stats.callbackAveUs, stats.callbackP99Us, stats.callbackMaxUs);
+		TFE_Console::addToHistory(res);
+		sprintf(res, "Buffer: %.1f us, underruns: %u.", stats.bufferUs, stats.underruns);
+		TFE_Console::addToHistory(res);
+		sprintf(res, "MIDI lock: waited %.1f us in the last second, %u skipped updates.", stats.lockWaitUs, stats.lockMisses);
+		TFE_Console::addToHistory(res);
+		sprintf(res, "Voices: %d wave, %d MIDI.", stats.voices[AUDIO_VOICES_WAVE], stats.voices[AUDIO_VOICES_MIDI]);
+		TFE_Console::addToHistory(res);
+
+		for (u32 i = 0; i < AUDIO_TIMING_BINS; i++)
+		{
+			if (!stats.histogram[i]) { continue; }
+			sprintf(res, "  %8.1f - %8.1f us: %u", getTimingBinUs(i), getTimingBinUs(i + 1), stats.histogram[i]);
+			TFE_Console::addToHistory(res);
+		}
+	}
 }
@@ -44,8 +44,45 @@ enum SoundType
 #define MAX_SOUND_SOURCES 128
 
 typedef void (*SoundFinishedCallback)(void* userData, s32 arg);
+// Called from the audio thread for every buffer. While paused bufferSize is 0, so the client can still process its commands.
 typedef void (*AudioThreadCallback)(f32* buffer, u32 bufferSize, f32 systemVolume);
 
+// The audio thread callbacks are called in this order. The sound callback writes the buffer, later callbacks add to it.
+// When the mix is resampled the music callback is called after the resampler, at the device rate (see getSampleRate()).
+enum AudioThreadCallbackSlot
+{
+	AUDIO_CALLBACK_SOUND = 0,	// Digital sound (iMuse).
+	AUDIO_CALLBACK_MUSIC,		// Software synthesized music.
+	AUDIO_CALLBACK_COUNT
+};
+
+// Voice counts reported by the audio clients.
+enum AudioVoiceType
+{
+	AUDIO_VOICES_WAVE = 0,	// iMuse digital sound voices.
+	AUDIO_VOICES_MIDI,		// Notes held by the MIDI player (synth voices or device notes).
+	AUDIO_VOICES_COUNT
+};
+
+// Callback durations are binned in quarter octaves starting at 1 microsecond, the last bin starts at about 55 ms.
+#define AUDIO_TIMING_BINS 64
+
+// TFE: Audio thread statistics, gathered over one second windows.
+struct AudioThreadStats
+{
+	u32 callbackCount;		// Callbacks in the last window.
+	f32 callbackMinUs;
+	f32 callbackAveUs;
+	f32 callbackP99Us;		// Upper edge of the histogram bin that holds the 99th percentile.
+	f32 callbackMaxUs;
+	f32 bufferUs;			// Duration of the last buffer, callbacks taking longer than this will underrun.
+	u32 underruns;			// Total buffer underruns reported by the device.
+	f32 lockWaitUs;			// Time spent waiting on the MIDI player lock in the last window.
+	u32 lockMisses;			// Total number of times the audio thread skipped MIDI processing because the lock was held.
+	s32 voices[AUDIO_VOICES_COUNT];
+	u32 histogram[AUDIO_TIMING_BINS];
+};
+
 namespace TFE_Audio
 {
 	// constants
@@ -55,7 +92,8 @@ namespace TFE_Audio
 	static const f32 c_clipDistance = 140.0f;
 
 	// functions
-	bool init(bool useNullDevice=false);
+	// If 'renderPath' is set no device is opened, the mix is rendered offline to 'renderPath'.wav instead.
+	bool init(bool useNullDevice=false, const char* renderPath=nullptr);
 	void shutdown();
 	void stopAllSounds();
 
@@ -64,11 +102,29 @@ namespace TFE_Audio
 	void pause();
 	void resume();
 
-	void lock();
-	void unlock();
+	// Sample rate of the buffers passed to the audio thread callback in 'slot'.
+	u32  getSampleRate(AudioThreadCallbackSlot slot = AUDIO_CALLBACK_SOUND);
+
+	// TFE: Offline rendering. There is no audio thread, instead the game loop calls renderOffline() to mix
+	// and write the audio for the game time that has passed, so a fast-forward run always renders the same audio.
+	// Returns the output path without the extension, or nullptr if not rendering offline.
+	const char* getOfflineRenderPath();
+	void renderOffline(f64 seconds);
+
+	// Returns false if there is no audio thread to call it (i.e. the null device is being used).
+	// Clearing the callback waits until the audio thread is no longer running it.
+	bool setAudioThreadCallback(AudioThreadCallback callback = nullptr, AudioThreadCallbackSlot slot = AUDIO_CALLBACK_SOUND);
 
-	void setAudioThreadCallback(AudioThreadCallback callback = nullptr);
+	// Statistics, these are always gathered and are published once per second.
+	void getThreadStats(AudioThreadStats* stats);
+	// Lower edge of a timing histogram bin in microseconds.
+	f32  getTimingBinUs(u32 bin);
+	// The reporting functions may be called from any thread.
+	void reportLockWait(u64 ticks);
+	void reportLockMiss();
+	void setVoiceCount(AudioVoiceType type, s32 count);
 
+	// Sources are owned by the audio thread, the functions below queue commands for it and must be called from the main thread.
 	// One shot, play and forget. Only do this if the client needs no control until stopAllSounds() is called.
 	// Note that looping one shots are valid though may generate too many sound sources if not used carefully.
 	bool playOneShot(SoundType type, f32 volume, const SoundBuffer* buffer, bool looping,
@@ -1,12 +1,19 @@
 #include "midiPlayer.h"
 #include "midiDevice.h"
+#include "midiSynth.h"
 #include "audioDevice.h"
+#include "audioSystem.h"
+#include "audioRecorder.h"
 #include <TFE_Asset/gmidAsset.h>
 #include <TFE_System/system.h>
 #include <TFE_System/Threads/thread.h>
+#include <TFE_System/Threads/signal.h>
+#include <TFE_System/spscQueue.h>
 #include <TFE_Settings/settings.h>
+#include <TFE_FileSystem/paths.h>
 #include <TFE_FrontEndUI/console.h>
 #include <algorithm>
+#include <mutex>
 #include <assert.h>
 
 #ifdef _WIN32
@@ -41,6 +48,8 @@ namespace TFE_MidiPlayer
 	struct MidiCallback
 	{
 		void(*callback)(void) = nullptr;	// callback function to call.
+		bool(*tryLock)(void) = nullptr;		// TFE: locks the client state used by the callback on the audio thread, see midiSetCallback().
+		void(*unlock)(void) = nullptr;
 		f64 timeStep = 0.0;					// delay between calls, this acts like an interrupt handler.
 		f64 accumulator = 0.0;				// current accumulator.
 	};
@@ -55,6 +64,39 @@ namespace TFE_MidiPlayer
 	static Mutex s_mutex;
 
 	static MidiCallback s_midiCallback = {};
+	static bool s_isPaused = false;
+	static u64 s_localTimeCallback = 0;
+
+	// TFE: With software synthesis, offline rendering or the audio clock the callback is run from the audio thread (or the offline render).
+	static bool s_audioThreadMidi = false;
+	static bool s_useSynth = false;
+	static bool s_recordMidi = false;
+	static s64 s_framesToCallback = 0;		// 32.32 fixed point frames until the next callback, negative if callbacks are owed.
+	static u64 s_curFrame = 0;				// Frames rendered by the audio thread function, the recorded events are timestamped with it.
+
+	// TFE: Audio clock mode, the callback is run from the audio thread and the MIDI device messages are timestamped
+	// with the sample clock. The MIDI thread only dispatches them to the device when they are due.
+	struct MidiEvent
+	{
+		u64 dueTicks;
+		u8  msg[3];
+		u8  size;
+	};
+	static bool s_dispatchMidi = false;
+	static SpscQueue<MidiEvent, 4096> s_midiEvents;	// Only the audio thread pushes events, stamped with the sample clock.
+	// Messages sent from other threads, stamped and moved to s_midiEvents by the audio thread.
+	static std::mutex s_pendingMutex;
+	static SpscQueue<MidiEvent, 1024> s_pendingEvents;
+	static thread_local bool s_isAudioThread = false;
+	static Signal* s_midiEventSignal = nullptr;
+	static u32 s_droppedEvents = 0;
+	static bool s_eventsQueued = false;
+	// Smoothed mapping from frames to system ticks, the audio callbacks do not run at perfectly regular intervals.
+	static f64 s_clockBaseTicks = 0.0;
+	static u64 s_clockBaseFrame = 0;
+	static f64 s_ticksPerFrame = 0.0;
+	static f64 s_clockLatencyTicks = 0.0;
+	static bool s_clockValid = false;
 
 	// Hanging note detection.
 	struct Instrument
@@ -66,6 +108,9 @@ namespace TFE_MidiPlayer
 	static f64 s_curNoteTime = 0.0;
 
 	TFE_THREADRET midiUpdateFunc(void* userData);
+	TFE_THREADRET midiDispatchFunc(void* userData);
+	void midiAudioThreadFunc(f32* buffer, u32 bufferSize, f32 systemVolume);
+	void midiSendMessage(u8 type, u8 arg1 = 0, u8 arg2 = 0);
 	void stopAllNotes();
 	void changeVolume();
 
@@ -80,10 +125,64 @@ namespace TFE_MidiPlayer
 		bool res = TFE_MidiDevice::init();
 		TFE_MidiDevice::selectDevice(devIndex);
 		s_runMusicThread.store(true);
+		s_isPaused = false;
+		s_localTimeCallback = 0;
+		s_framesToCallback = 0;
 
 		MUTEX_INITIALIZE(&s_mutex);
 
-		s_thread = Thread::create("MidiThread", midiUpdateFunc, nullptr);
+		// Use the software synth if requested or if there is no MIDI device to play on.
+		TFE_Settings_Sound* soundSettings = TFE_Settings::getSoundSettings();
+		const char* renderPath = TFE_Audio::getOfflineRenderPath();
+		s_useSynth = soundSettings->useSoftwareSynth || TFE_MidiDevice::getDeviceCount() == 0;
+		s_curFrame = 0;
+		s_thread = nullptr;
+		s_clockValid = false;
+		s_clockLatencyTicks = 0.0;
+		s_droppedEvents = 0;
+		s_midiEvents.clear();
+		s_pendingEvents.clear();
+		if (s_useSynth)
+		{
+			char soundFontPath[TFE_MAX_PATH];
+			TFE_Paths::appendPath(PATH_PROGRAM, soundSettings->soundFont, soundFontPath);
+			TFE_MidiSynth::init(soundFontPath, TFE_Audio::getSampleRate(AUDIO_CALLBACK_MUSIC));
+		}
+
+		// The synth, offline rendering and the audio clock need the audio thread, fall back to the MIDI device if there is none (i.e. the null audio device).
+		// The dispatch state is set up first, the audio thread may run the function as soon as it is set.
+		s_dispatchMidi = soundSettings->midiAudioClock && !s_useSynth && !renderPath;
+		if (s_dispatchMidi)
+		{
+			s_midiEventSignal = Signal::create();
+		}
+		s_audioThreadMidi = (s_useSynth || renderPath || s_dispatchMidi) && TFE_Audio::setAudioThreadCallback(midiAudioThreadFunc, AUDIO_CALLBACK_MUSIC);
+		if (s_dispatchMidi && !s_audioThreadMidi)
+		{
+			delete s_midiEventSignal;
+			s_midiEventSignal = nullptr;
+			s_dispatchMidi = false;
+		}
+		if (s_useSynth && !s_audioThreadMidi)
+		{
+			TFE_MidiSynth::destroy();
+			s_useSynth = false;
+		}
+		// When rendering offline the MIDI output is recorded, it only reaches the software synth.
+		if (renderPath && s_audioThreadMidi)
+		{
+			char midiPath[TFE_MAX_PATH];
+			snprintf(midiPath, TFE_MAX_PATH, "%s.mid", renderPath);
+			s_recordMidi = TFE_AudioRecorder::midiBegin(midiPath, TFE_Audio::getSampleRate(AUDIO_CALLBACK_MUSIC));
+		}
+		if (s_dispatchMidi)
+		{
+			s_thread = Thread::create("MidiThread", midiDispatchFunc, nullptr);
+		}
+		else if (!s_audioThreadMidi)
+		{
+			s_thread = Thread::create("MidiThread", midiUpdateFunc, nullptr);
+		}
 		if (s_thread)
 		{
 			s_thread->run();
@@ -91,26 +190,61 @@ namespace TFE_MidiPlayer
 
 		CCMD("setMusicVolume", setMusicVolumeConsole, 1, "Sets the music volume, range is 0.0 to 1.0");
 		CCMD("getMusicVolume", getMusicVolumeConsole, 0, "Get the current music volume where 0 = silent, 1 = maximum.");
+		CCMD("synthVoices", TFE_MidiSynth::setVoiceBudgetConsole, 0, "synthVoices [count] - shows the software synth voice usage and optionally sets the voice budget.");
 
-		TFE_Settings_Sound* soundSettings = TFE_Settings::getSoundSettings();
 		setVolume(soundSettings->musicVolume);
 		setMaximumNoteLength();
 
-		return res && s_thread;
+		return (s_audioThreadMidi && !s_dispatchMidi) || (res && s_thread);
 	}
 
 	void destroy()
 	{
 		TFE_System::logWrite(LOG_MSG, "MidiPlayer", "Shutdown");
+		if (s_audioThreadMidi)
+		{
+			// Waits until the audio thread is done with the synth and stops new events from being queued.
+			TFE_Audio::setAudioThreadCallback(nullptr, AUDIO_CALLBACK_MUSIC);
+			s_audioThreadMidi = false;
+		}
+
 		// Destroy the thread before shutting down the Midi Device.
 		s_runMusicThread.store(false);
-		if (s_thread->isPaused())
+		if (s_midiEventSignal)
 		{
-			s_thread->resume();
+			s_midiEventSignal->fire();
 		}
-		s_thread->waitOnExit();
+		if (s_thread)
+		{
+			if (s_thread->isPaused())
+			{
+				s_thread->resume();
+			}
+			s_thread->waitOnExit();
 
-		delete s_thread;
+			delete s_thread;
+			s_thread = nullptr;
+		}
+		if (s_midiEventSignal)
+		{
+			delete s_midiEventSignal;
+			s_midiEventSignal = nullptr;
+		}
+		if (s_dispatchMidi && s_droppedEvents)
+		{
+			TFE_System::logWrite(LOG_WARNING, "MidiPlayer", "%u MIDI events were dropped because the event queue was full.", s_droppedEvents);
+		}
+		s_dispatchMidi = false;
+		if (s_useSynth)
+		{
+			TFE_MidiSynth::destroy();
+			s_useSynth = false;
+		}
+		if (s_recordMidi)
+		{
+			TFE_AudioRecorder::midiEnd();
+			s_recordMidi = false;
+		}
 		TFE_MidiDevice::destroy();
 
 		MUTEX_DESTROY(&s_mutex);
@@ -191,12 +325,15 @@ namespace TFE_MidiPlayer
 		return s_masterVolume;
 	}
 
-	void midiSetCallback(void(*callback)(void), f64 timeStep)
+	void midiSetCallback(void(*callback)(void), f64 timeStep, bool(*tryLock)(void), void(*unlock)(void))
 	{
 		MUTEX_LOCK(&s_mutex);
 		s_midiCallback.callback = callback;
+		s_midiCallback.tryLock = tryLock;
+		s_midiCallback.unlock = unlock;
 		s_midiCallback.timeStep = timeStep;
 		s_midiCallback.accumulator = 0.0;
+		s_framesToCallback = 0;
 
 		for (u32 i = 0; i < MIDI_CHANNEL_COUNT; i++)
 		{
@@ -210,6 +347,8 @@ namespace TFE_MidiPlayer
 	{
 		MUTEX_LOCK(&s_mutex);
 		s_midiCallback.callback = nullptr;
+		s_midiCallback.tryLock = nullptr;
+		s_midiCallback.unlock = nullptr;
 		s_midiCallback.timeStep = 0.0;
 		s_midiCallback.accumulator = 0.0;
 		MUTEX_UNLOCK(&s_mutex);
@@ -218,11 +357,118 @@ namespace TFE_MidiPlayer
 	//////////////////////////////////////////////////
 	// Internal
 	//////////////////////////////////////////////////
+	// Called from the audio thread at the start of each buffer, keeps the frame to tick mapping close to the system clock.
+	static void updateAudioClock(u32 bufferSize)
+	{
+		const f64 now = f64(TFE_System::getCurrentTimeInTicks());
+		const u32 sampleRate = TFE_Audio::getSampleRate(AUDIO_CALLBACK_MUSIC);
+		if (!s_clockValid)
+		{
+			s_ticksPerFrame = 1.0 / (TFE_System::convertFromTicksToSeconds(1) * f64(sampleRate));
+		}
+
+		// The audio generated now is heard about one buffer later, the events are delayed by the same amount.
+		const f64 bufferTicks = s_ticksPerFrame * f64(std::max(bufferSize, 1u));
+		const f64 predicted = s_clockBaseTicks + f64(s_curFrame - s_clockBaseFrame) * s_ticksPerFrame;
+		const f64 error = now - predicted;
+		if (!s_clockValid || fabs(error) > 4.0 * bufferTicks)
+		{
+			// Start over after a stall or pause, the frame counter does not advance while paused.
+			s_clockBaseTicks = now;
+			s_clockBaseFrame = s_curFrame;
+			s_clockValid = true;
+		}
+		else
+		{
+			// Follow the system clock slowly, so the callback jitter does not reach the event times.
+			s_clockBaseTicks = predicted + error * (1.0 / 32.0);
+			s_clockBaseFrame = s_curFrame;
+		}
+		s_clockLatencyTicks = std::max(s_clockLatencyTicks * 0.99, bufferTicks);
+	}
+
+	// Audio thread: stamp the event with the current frame and queue it for the dispatch thread.
+	static void pushDeviceEvent(MidiEvent* midiEvent)
+	{
+		midiEvent->dueTicks = u64(s_clockBaseTicks + f64(s_curFrame - s_clockBaseFrame) * s_ticksPerFrame + s_clockLatencyTicks);
+		if (!s_midiEvents.push(*midiEvent))
+		{
+			s_droppedEvents++;
+		}
+		s_eventsQueued = true;
+	}
+
+	static void queueDeviceMessage(const u8* msg, u32 size)
+	{
+		MidiEvent midiEvent = {};
+		midiEvent.size = u8(std::min(size, 3u));
+		memcpy(midiEvent.msg, msg, midiEvent.size);
+		if (s_isAudioThread)
+		{
+			pushDeviceEvent(&midiEvent);
+			return;
+		}
+
+		// The clock and the event queue belong to the audio thread, so it stamps these when it picks them up.
+		std::lock_guard<std::mutex> lock(s_pendingMutex);
+		if (!s_pendingEvents.push(midiEvent))
+		{
+			TFE_System::logWrite(LOG_WARNING, "MidiPlayer", "The pending MIDI event queue is full, message 0x%02x is dropped.", msg[0]);
+		}
+	}
+
+	// Audio thread: move the messages sent from other threads to the device event queue.
+	static void queuePendingEvents()
+	{
+		MidiEvent midiEvent;
+		while (s_pendingEvents.pop(&midiEvent))
+		{
+			pushDeviceEvent(&midiEvent);
+		}
+	}
+
+	// Audio thread: wake up the dispatch thread if any events were queued.
+	static void signalDispatch()
+	{
+		if (s_eventsQueued)
+		{
+			s_midiEventSignal->fire();
+			s_eventsQueued = false;
+		}
+	}
+
+	static void midiOutput(const u8* msg, u32 size)
+	{
+		if (s_recordMidi)
+		{
+			TFE_AudioRecorder::midiWrite(s_curFrame, msg, size);
+		}
+
+		if (s_useSynth)
+		{
+			TFE_MidiSynth::sendMessage(msg, size);
+		}
+		else if (s_dispatchMidi)
+		{
+			queueDeviceMessage(msg, size);
+		}
+		else if (!s_audioThreadMidi)
+		{
+			TFE_MidiDevice::sendMessage(msg, size);
+		}
+	}
+
+	void midiSendMessage(u8 type, u8 arg1, u8 arg2)
+	{
+		const u8 msg[] = { type, arg1, arg2 };
+		midiOutput(msg, 3);
+	}
+
 	void changeVolume()
 	{
 		for (u32 i = 0; i < MIDI_CHANNEL_COUNT; i++)
 		{
-			TFE_MidiDevice::sendMessage(MID_CONTROL_CHANGE + i, MID_VOLUME_MSB, u8(s_channelSrcVolume[i] * s_masterVolumeScaled));
+			midiSendMessage(MID_CONTROL_CHANGE + i, MID_VOLUME_MSB, u8(s_channelSrcVolume[i] * s_masterVolumeScaled));
 		}
 	}
 
@@ -241,7 +487,7 @@ namespace TFE_MidiPlayer
 				if (s_instrOn[i].channelMask & channelMask)
 				{
 					// Turn off the note.
-					TFE_MidiDevice::sendMessage(MID_NOTE_OFF | c, i);
+					midiSendMessage(MID_NOTE_OFF | c, i);
 
 					// Reset the instrument channel information.
 					s_instrOn[i].channelMask &= ~channelMask;
@@ -253,7 +499,7 @@ namespace TFE_MidiPlayer
 		// Just in case
 		for (u32 c = 0; c < MIDI_CHANNEL_COUNT; c++)
 		{
-			TFE_MidiDevice::sendMessage(MID_CONTROL_CHANGE + c, MID_ALL_NOTES_OFF);
+			midiSendMessage(MID_CONTROL_CHANGE + c, MID_ALL_NOTES_OFF);
 		}
 		memset(s_instrOn, 0, sizeof(Instrument) * MIDI_INSTRUMENT_COUNT);
 		s_curNoteTime = 0.0;
@@ -269,7 +515,7 @@ namespace TFE_MidiPlayer
 			s_channelSrcVolume[channelIndex] = arg2;
 			msg[2] = u8(s_channelSrcVolume[channelIndex] * s_masterVolumeScaled);
 		}
-		TFE_MidiDevice::sendMessage(msg, 3);
+		midiOutput(msg, 3);
 
 		// Record currently playing instruments and the note-on times.
 		if (msgType == MID_NOTE_OFF || msgType == MID_NOTE_ON)
@@ -303,7 +549,7 @@ namespace TFE_MidiPlayer
 				if ((s_instrOn[i].channelMask & channelMask) && (s_curNoteTime - s_instrOn[i].time[c] > s_maxNoteLength))
 				{
 					// Turn off the note.
-					TFE_MidiDevice::sendMessage(MID_NOTE_OFF | c, i);
+					midiSendMessage(MID_NOTE_OFF | c, i);
 
 					// Reset the instrument channel information.
 					s_instrOn[i].channelMask &= ~channelMask;
@@ -313,58 +559,80 @@ namespace TFE_MidiPlayer
 		}
 	}
 
+	// Report the notes currently held, called with s_mutex held.
+	static void reportVoiceCount()
+	{
+		s32 voiceCount = 0;
+		if (s_useSynth)
+		{
+			voiceCount = TFE_MidiSynth::getActiveVoiceCount();
+		}
+		else
+		{
+			for (s32 i = 0; i < MIDI_INSTRUMENT_COUNT; i++)
+			{
+				for (u32 mask = s_instrOn[i].channelMask; mask; mask &= mask - 1)
+				{
+					voiceCount++;
+				}
+			}
+		}
+		TFE_Audio::setVoiceCount(AUDIO_VOICES_MIDI, voiceCount);
+	}
+
+	// Apply the commands from the command buffer, called with s_mutex held.
+	void processCommands()
+	{
+		MidiCmd* midiCmd = s_midiCmdBuffer;
+		for (u32 i = 0; i < s_midiCmdCount; i++, midiCmd++)
+		{
+			switch (midiCmd->cmd)
+			{
+				case MIDI_PAUSE:
+				{
+					s_localTimeCallback = 0;
+					s_isPaused = true;
+					stopAllNotes();
+				} break;
+				case MIDI_RESUME:
+				{
+					s_isPaused = false;
+				} break;
+				case MIDI_CHANGE_VOL:
+				{
+					s_masterVolume = midiCmd->newVolume;
+					s_masterVolumeScaled = s_masterVolume * c_musicVolumeScale;
+					changeVolume();
+				} break;
+				case MIDI_STOP_NOTES:
+				{
+					stopAllNotes();
+					// Reset callback time.
+					s_localTimeCallback = 0;
+					s_midiCallback.accumulator = 0.0;
+					s_framesToCallback = 0;
+				} break;
+			}
+		}
+		s_midiCmdCount = 0;
+	}
+
 	// Thread Function
 	TFE_THREADRET midiUpdateFunc(void* userData)
 	{
-		bool runThread  = true;
-		bool wasPlaying = false;
-		bool isPlaying  = false;
-		bool isPaused = false;
-		s32 loopStart = -1;
-		u64 localTime = 0;
-		u64 localTimeCallback = 0;
-		f64 dt = 0.0;
+		bool runThread = true;
 		while (runThread)
 		{
+			const u64 lockStart = TFE_System::getCurrentTimeInTicks();
 			MUTEX_LOCK(&s_mutex);
-						
+			TFE_Audio::reportLockWait(TFE_System::getCurrentTimeInTicks() - lockStart);
 			// Read from the command buffer.
-			MidiCmd* midiCmd = s_midiCmdBuffer;
-			for (u32 i = 0; i < s_midiCmdCount; i++, midiCmd++)
-			{
-				switch (midiCmd->cmd)
-				{
-					case MIDI_PAUSE:
-					{
-						localTimeCallback = 0;
-						isPaused = true;
-						stopAllNotes();
-					} break;
-					case MIDI_RESUME:
-					{
-						isPaused = false;
-					} break;
-					case MIDI_CHANGE_VOL:
-					{
-						s_masterVolume = midiCmd->newVolume;
-						s_masterVolumeScaled = s_masterVolume * c_musicVolumeScale;
-						changeVolume();
-					} break;
-					case MIDI_STOP_NOTES:
-					{
-						stopAllNotes();
-						// Reset callback time.
-						localTimeCallback = 0;
-						s_midiCallback.accumulator = 0.0;
-					} break;
-				}
-			}
-			s_midiCmdCount = 0;
+			processCommands();
 
 			// Process the midi callback, if it exists.
-			if (s_midiCallback.callback && !isPaused)
+			if (s_midiCallback.callback && !s_isPaused)
 			{
-				s_midiCallback.accumulator += TFE_System::updateThreadLocal(&localTimeCallback);
+				s_midiCallback.accumulator += TFE_System::updateThreadLocal(&s_localTimeCallback);
 				while (s_midiCallback.callback && s_midiCallback.accumulator >= s_midiCallback.timeStep)
 				{
 					s_midiCallback.callback();
@@ -375,6 +643,7 @@ namespace TFE_MidiPlayer
 				// Check for hanging notes.
 				detectHangingNotes();
 			}
+			reportVoiceCount();
 
 			MUTEX_UNLOCK(&s_mutex);
 			runThread = s_runMusicThread.load();
@@ -383,6 +652,132 @@ namespace TFE_MidiPlayer
 		return (TFE_THREADRET)0;
 	}
 
+	// TFE: Sends the events queued by the audio thread when they are due. The thread sleeps until the next event is due or
+	// the audio thread queues more, so it never spins.
+	TFE_THREADRET midiDispatchFunc(void* userData)
+	{
+		MidiEvent midiEvent;
+		bool hasEvent = false;
+		while (s_runMusicThread.load())
+		{
+			if (!hasEvent)
+			{
+				hasEvent = s_midiEvents.pop(&midiEvent);
+			}
+			if (!hasEvent)
+			{
+				s_midiEventSignal->wait();
+				continue;
+			}
+
+			// Without timestamps in the device API, events due within a millisecond are sent immediately.
+			const u64 now = TFE_System::getCurrentTimeInTicks();
+			if (midiEvent.dueTicks > now)
+			{
+				const u32 waitMs = u32(TFE_System::convertFromTicksToSeconds(midiEvent.dueTicks - now) * 1000.0);
+				if (waitMs > 0)
+				{
+					s_midiEventSignal->wait(waitMs);
+					continue;
+				}
+			}
+			TFE_MidiDevice::sendMessage(midiEvent.msg, midiEvent.size);
+			hasEvent = false;
+		}
+		return (TFE_THREADRET)0;
+	}
+
+	// Advance the MIDI output by 'frameCount' frames.
+	static void renderFrames(f32* buffer, u32 frameCount)
+	{
+		if (s_useSynth)
+		{
+			TFE_MidiSynth::render(buffer, frameCount);
+		}
+		s_curFrame += frameCount;
+	}
+
+	// Render a buffer without running the callback, the frames are owed and the callbacks run once the locks can be acquired.
+	static void skipCallbacks(f32* buffer, u32 bufferSize)
+	{
+		TFE_Audio::reportLockMiss();
+		if (s_midiCallback.callback && !s_isPaused)
+		{
+			s_framesToCallback -= s64(bufferSize) << 32ll;
+		}
+		renderFrames(buffer, bufferSize);
+	}
+
+	// TFE: Audio thread function used with the software synth, offline rendering and the audio clock. The callback is run at the frame
+	// it is due and the synth is rendered in between, so the timing does not depend on how a thread is scheduled.
+	void midiAudioThreadFunc(f32* buffer, u32 bufferSize, f32 systemVolume)
+	{
+		s_isAudioThread = true;
+		if (s_dispatchMidi)
+		{
+			updateAudioClock(bufferSize);
+			queuePendingEvents();
+		}
+
+		// Never block the audio thread. If the main thread holds the lock, or the callback cannot lock the client state,
+		// the elapsed frames are owed and the callbacks catch up once the locks are acquired.
+		if (!MUTEX_TRYLOCK(&s_mutex))
+		{
+			skipCallbacks(buffer, bufferSize);
+			signalDispatch();
+			return;
+		}
+		processCommands();
+
+		void(*clientUnlock)(void) = nullptr;
+		if (s_midiCallback.callback && !s_isPaused && s_midiCallback.tryLock)
+		{
+			if (!s_midiCallback.tryLock())
+			{
+				MUTEX_UNLOCK(&s_mutex);
+				skipCallbacks(buffer, bufferSize);
+				signalDispatch();
+				return;
+			}
+			clientUnlock = s_midiCallback.unlock;
+		}
+
+		u32 offset = 0;
+		if (s_midiCallback.callback && !s_isPaused)
+		{
+			const s64 framesPerCallback = std::max(s64(s_midiCallback.timeStep * f64(TFE_Audio::getSampleRate(AUDIO_CALLBACK_MUSIC)) * 4294967296.0), s64(1));
+			while (s_midiCallback.callback && offset < bufferSize)
+			{
+				// The callback is due within the current frame, or is owed from buffers that could not run it.
+				if (s_framesToCallback < (1ll << 32ll))
+				{
+					s_midiCallback.callback();
+					s_curNoteTime += s_midiCallback.timeStep;
+					s_framesToCallback += framesPerCallback;
+					continue;
+				}
+
+				const u32 frameCount = u32(std::min(s64(bufferSize - offset), s_framesToCallback >> 32ll));
+				renderFrames(buffer + offset * 2, frameCount);
+				s_framesToCallback -= s64(frameCount) << 32ll;
+				offset += frameCount;
+			}
+
+			// Check for hanging notes.
+			detectHangingNotes();
+		}
+		// Render the rest of the buffer, i.e. the note releases after the music stops.
+		renderFrames(buffer + offset * 2, bufferSize - offset);
+		reportVoiceCount();
+
+		if (clientUnlock)
+		{
+			clientUnlock();
+		}
+		MUTEX_UNLOCK(&s_mutex);
+		signalDispatch();
+	}
+
 	// Console Functions
 	void setMusicVolumeConsole(const ConsoleArgList& args)
 	{
@@ -22,7 +22,9 @@ namespace TFE_MidiPlayer
 	void sendMessageDirect(u8 type, u8 arg1=0, u8 arg2=0);
 
 	// Callback
-	void midiSetCallback(void(*callback)(void) = nullptr, f64 timeStep = 0.0);
+	// When the callback is run from the audio thread, 'tryLock' is called first and the callback is deferred
+	// (but not dropped) if it fails, so the audio thread never blocks on the client's locks.
+	void midiSetCallback(void(*callback)(void) = nullptr, f64 timeStep = 0.0, bool(*tryLock)(void) = nullptr, void(*unlock)(void) = nullptr);
 	void midiClearCallback();
 		
 	// Pause the midi player, which also stops all sound channels.
@@ -0,0 +1,1219 @@
+#include <cstring>
+
+#include "midiSynth.h"
+#include "midi.h"
+#include "mixKernels.h"
+#include <TFE_System/system.h>
+#include <TFE_System/spscQueue.h>
+#include <TFE_FileSystem/filestream.h>
+#include <algorithm>
+#include <assert.h>
+#include <math.h>
+#include <mutex>
+#include <vector>
+
+#ifdef TFE_AUDIO_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace TFE_MidiSynth
+{
+	enum SynthInternal
+	{
+		SYNTH_BLOCK_SIZE   = 32,	// Envelopes, volume and pan are updated per block and ramped within it.
+		SYNTH_DRUM_CHANNEL = 9,
+		SYNTH_DRUM_BANK    = 128,
+		SYNTH_TABLE_SIZE   = 256,	// Single cycle waveforms used by the built-in instruments.
+		SYNTH_FAMILY_COUNT = 16,	// General MIDI instrument families, 8 programs each.
+		SYNTH_OCTAVE_COUNT = 11,
+	};
+
+	enum LoopMode
+	{
+		LOOP_NONE       = 0,
+		LOOP_CONTINUOUS = 1,
+		LOOP_SUSTAIN    = 3,	// Loop until the note is released, then play to the end.
+	};
+
+	enum EnvelopeStage
+	{
+		ENV_DELAY = 0,
+		ENV_ATTACK,
+		ENV_HOLD,
+		ENV_DECAY,
+		ENV_SUSTAIN,
+		ENV_RELEASE,
+		ENV_DONE,
+	};
+
+	// An instrument zone with the preset and instrument generators already combined.
+	struct SynthRegion
+	{
+		u8  keyLo, keyHi;
+		u8  velLo, velHi;
+		u32 start, end;				// Sample data range, [start, end).
+		u32 loopStart, loopEnd;
+		s32 loopMode;
+		s32 rootKey;
+		f32 sampleRate;
+		f32 tune;					// Cents.
+		f32 scaleTuning;			// Cents per key.
+		f32 attenuation;			// Centibels.
+		f32 pan;					// [-0.5, 0.5]
+		f32 delay, attack, hold, decay, release;	// Seconds.
+		f32 sustain;				// Centibels of attenuation.
+		s32 exclusiveClass;
+	};
+
+	struct SynthPreset
+	{
+		u16 bank;
+		u16 program;
+		u32 regionStart;
+		u32 regionCount;
+	};
+
+	struct SynthVoice
+	{
+		const SynthRegion* region;	// nullptr if the voice is free.
+		u32 age;
+		u8  channel;
+		u8  key;
+		bool released;
+		bool sustained;				// Released while the sustain pedal was down.
+
+		u64 position;				// 32.32 fixed point sample position.
+		u64 step;
+		f64 baseStep;				// Step without the pitch bend.
+
+		EnvelopeStage stage;
+		f32 stageTime;
+		f32 envelope;				// Linear amplitude.
+		f32 releaseAtten;			// Attenuation at the start of the release, in centibels.
+		f32 releaseTime;
+		f32 baseAtten;				// Region and velocity attenuation, in centibels.
+		f32 gain[2];				// Left and right gains at the end of the previous block.
+	};
+
+	struct SynthChannel
+	{
+		const SynthPreset* preset;
+		u8  program;
+		u8  bankMsb;
+		u8  volume;
+		u8  expression;
+		u8  pan;
+		u8  rpnLsb;
+		u8  rpnMsb;
+		bool sustain;
+		f32 bendRange;				// Semitones.
+		f32 bend;					// Semitones.
+	};
+
+	struct SynthMessage
+	{
+		u8 data[3];
+		u8 size;
+	};
+
+	// Overall output level, leaves headroom for many voices.
+	static const f32 c_outputGain = 0.3f;
+	// Attenuation at which a voice is inaudible and can be freed.
+	static const f32 c_silentAtten = 960.0f;
+	// Release time used when a voice is cut off by an exclusive class.
+	static const f32 c_fastRelease = 0.005f;
+	static const f32 c_pi = 3.14159265358979f;
+
+	static std::vector<f32> s_sampleData;
+	static std::vector<SynthRegion> s_regions;
+	static std::vector<SynthPreset> s_presets;
+	static SynthVoice   s_voices[SYNTH_MAX_VOICES];
+	static SynthChannel s_channels[MIDI_CHANNEL_COUNT];
+	static f32 s_curveAtten[128];	// MIDI value -> attenuation (cB), amplitude follows (value/127)^2.
+
+	static s32 s_voiceBudget = SYNTH_DEFAULT_VOICE_BUDGET;
+	static u32 s_noteCounter = 0;
+	static u32 s_stolenVoices = 0;
+	static u32 s_sampleRate = 11025;
+	static f32 s_invSampleRate = 1.0f / 11025.0f;
+	static bool s_initialized = false;
+	static bool s_builtinBank = false;
+
+	// Messages from threads other than the render thread.
+	static std::mutex s_queueMutex;
+	static SpscQueue<SynthMessage, 1024> s_queue;
+	static thread_local bool s_isRenderThread = false;
+
+	bool loadSoundFont(const char* path);
+	void buildBuiltinBank();
+	void processMessage(const u8* msg, u32 size);
+	void resetChannels();
+
+	/////////////////////////////////////////////
+	// API
+	/////////////////////////////////////////////
+	bool init(const char* soundFontPath, u32 sampleRate)
+	{
+		s_sampleRate = sampleRate;
+		s_invSampleRate = 1.0f / f32(sampleRate);
+		for (s32 i = 0; i < 128; i++)
+		{
+			s_curveAtten[i] = i ? -400.0f * log10f(f32(i) / 127.0f) : c_silentAtten;
+		}
+
+		s_sampleData.clear();
+		s_regions.clear();
+		s_presets.clear();
+		s_builtinBank = !soundFontPath || !soundFontPath[0] || !loadSoundFont(soundFontPath);
+		if (s_builtinBank)
+		{
+			s_sampleData.clear();
+			s_regions.clear();
+			s_presets.clear();
+			buildBuiltinBank();
+			TFE_System::logWrite(LOG_MSG, "MidiSynth", "Using the built-in instruments.");
+		}
+
+		memset(s_voices, 0, sizeof(SynthVoice) * SYNTH_MAX_VOICES);
+		s_queue.clear();
+		s_noteCounter = 0;
+		s_stolenVoices = 0;
+		resetChannels();
+
+		s_initialized = true;
+		return true;
+	}
+
+	void destroy()
+	{
+		s_initialized = false;
+		s_sampleData.clear();
+		s_regions.clear();
+		s_presets.clear();
+		memset(s_voices, 0, sizeof(SynthVoice) * SYNTH_MAX_VOICES);
+	}
+
+	void setVoiceBudget(s32 budget)
+	{
+		s_voiceBudget = std::max(1, std::min(budget, s32(SYNTH_MAX_VOICES)));
+	}
+
+	s32 getVoiceBudget()
+	{
+		return s_voiceBudget;
+	}
+
+	void sendMessage(const u8* msg, u32 size)
+	{
+		if (s_isRenderThread)
+		{
+			processMessage(msg, size);
+			return;
+		}
+
+		SynthMessage message = {};
+		message.size = u8(std::min(size, 3u));
+		memcpy(message.data, msg, message.size);
+
+		std::lock_guard<std::mutex> lock(s_queueMutex);
+		if (!s_queue.push(message))
+		{
+			TFE_System::logWrite(LOG_WARNING, "MidiSynth", "The message queue is full, message 0x%02x is dropped.", msg[0]);
+		}
+	}
+
+	void reset()
+	{
+		const u8 msg[3] = { MID_CONTROL_CHANGE, MID_ALL_SOUND_OFF, 0 };
+		for (s32 c = 0; c < MIDI_CHANNEL_COUNT; c++)
+		{
+			u8 channelMsg[3] = { u8(msg[0] | c), msg[1], msg[2] };
+			sendMessage(channelMsg, 3);
+		}
+	}
+
+	/////////////////////////////////////////////
+	// Voices
+	/////////////////////////////////////////////
+	static f32 cbToGain(f32 cb)
+	{
+		return powf(10.0f, -cb / 200.0f);
+	}
+
+	static f32 timecentsToSeconds(s32 tc)
+	{
+		return tc <= -12000 ? 0.0f : powf(2.0f, f32(tc) / 1200.0f);
+	}
+
+	static void updateVoiceStep(SynthVoice* voice)
+	{
+		const f64 bend = f64(s_channels[voice->channel].bend);
+		voice->step = u64(voice->baseStep * pow(2.0, bend / 12.0) * 4294967296.0);
+	}
+
+	static void releaseVoice(SynthVoice* voice, f32 releaseTime)
+	{
+		voice->releaseAtten = voice->envelope > 0.0f ? -200.0f * log10f(voice->envelope) : c_silentAtten;
+		voice->releaseTime = releaseTime;
+		voice->stage = ENV_RELEASE;
+		voice->stageTime = 0.0f;
+		voice->released = true;
+		voice->sustained = false;
+	}
+
+	// Computes the envelope at the end of a block of 'dt' seconds.
+	static void advanceEnvelope(SynthVoice* voice, f32 dt)
+	{
+		const SynthRegion* region = voice->region;
+		voice->stageTime += dt;
+		for (;;)
+		{
+			switch (voice->stage)
+			{
+				case ENV_DELAY:
+				{
+					if (voice->stageTime < region->delay) { voice->envelope = 0.0f; return; }
+					voice->stageTime -= region->delay;
+					voice->stage = ENV_ATTACK;
+				} break;
+				case ENV_ATTACK:
+				{
+					if (voice->stageTime < region->attack) { voice->envelope = voice->stageTime / region->attack; return; }
+					voice->stageTime -= region->attack;
+					voice->stage = ENV_HOLD;
+				} break;
+				case ENV_HOLD:
+				{
+					if (voice->stageTime < region->hold) { voice->envelope = 1.0f; return; }
+					voice->stageTime -= region->hold;
+					voice->stage = ENV_DECAY;
+				} break;
+				case ENV_DECAY:
+				{
+					// The decay time is the time it would take to fall by 100 dB.
+					const f32 atten = region->decay > 0.0f ? 1000.0f * voice->stageTime / region->decay : region->sustain;
+					if (atten < region->sustain) { voice->envelope = cbToGain(atten); return; }
+					voice->stage = ENV_SUSTAIN;
+				} break;
+				case ENV_SUSTAIN:
+				{
+					if (region->sustain >= c_silentAtten) { voice->stage = ENV_DONE; break; }
+					voice->envelope = cbToGain(region->sustain);
+					return;
+				}
+				case ENV_RELEASE:
+				{
+					const f32 atten = voice->releaseTime > 0.0f ? voice->releaseAtten + 1000.0f * voice->stageTime / voice->releaseTime : c_silentAtten;
+					if (atten >= c_silentAtten) { voice->stage = ENV_DONE; break; }
+					voice->envelope = cbToGain(atten);
+					return;
+				}
+				case ENV_DONE:
+				{
+					voice->envelope = 0.0f;
+					return;
+				}
+			}
+		}
+	}
+
+	static void computeVoiceGains(const SynthVoice* voice, f32* gains)
+	{
+		const SynthChannel* channel = &s_channels[voice->channel];
+		const f32 atten = voice->baseAtten + s_curveAtten[channel->volume] + s_curveAtten[channel->expression];
+		const f32 gain = voice->envelope * cbToGain(atten) * c_outputGain;
+
+		const f32 pan = std::max(-0.5f, std::min(voice->region->pan + f32(s32(channel->pan) - 64) / 128.0f, 0.5f));
+		const f32 angle = (pan + 0.5f) * c_pi * 0.5f;
+		gains[0] = gain * cosf(angle);
+		gains[1] = gain * sinf(angle);
+	}
+
+	// Prefer free voices, then released voices, then the quietest voice.
+	static SynthVoice* allocateVoice()
+	{
+		SynthVoice* best = nullptr;
+		f32 bestScore = 0.0f;
+		for (s32 i = 0; i < s_voiceBudget; i++)
+		{
+			SynthVoice* voice = &s_voices[i];
+			if (!voice->region) { return voice; }
+
+			const f32 score = std::max(voice->gain[0], voice->gain[1]) * (voice->released ? 0.1f : 1.0f);
+			if (!best || score < bestScore || (score == bestScore && voice->age < best->age))
+			{
+				best = voice;
+				bestScore = score;
+			}
+		}
+		s_stolenVoices++;
+		return best;
+	}
+
+	static void noteOff(s32 channelId, s32 key)
+	{
+		const SynthChannel* channel = &s_channels[channelId];
+		SynthVoice* voice = s_voices;
+		for (s32 i = 0; i < SYNTH_MAX_VOICES; i++, voice++)
+		{
+			if (!voice->region || voice->released || voice->channel != channelId || voice->key != key) { continue; }
+			if (channel->sustain)
+			{
+				voice->sustained = true;
+			}
+			else
+			{
+				releaseVoice(voice, voice->region->release);
+			}
+		}
+	}
+
+	static void noteOn(s32 channelId, s32 key, s32 velocity)
+	{
+		const SynthChannel* channel = &s_channels[channelId];
+		const SynthPreset* preset = channel->preset;
+		if (!preset) { return; }
+
+		// Retriggering a key releases the previous note.
+		SynthVoice* voice = s_voices;
+		for (s32 i = 0; i < SYNTH_MAX_VOICES; i++, voice++)
+		{
+			if (voice->region && !voice->released && voice->channel == channelId && voice->key == key)
+			{
+				releaseVoice(voice, voice->region->release);
+			}
+		}
+
+		const SynthRegion* region = &s_regions[preset->regionStart];
+		for (u32 r = 0; r < preset->regionCount; r++, region++)
+		{
+			if (key < region->keyLo || key > region->keyHi || velocity < region->velLo || velocity > region->velHi) { continue; }
+
+			// Exclusive classes (i.e. open and closed hi-hats) cut each other off.
+			if (region->exclusiveClass)
+			{
+				voice = s_voices;
+				for (s32 i = 0; i < SYNTH_MAX_VOICES; i++, voice++)
+				{
+					if (voice->region && voice->channel == channelId && voice->region->exclusiveClass == region->exclusiveClass)
+					{
+						releaseVoice(voice, c_fastRelease);
+					}
+				}
+			}
+
+			voice = allocateVoice();
+			memset(voice, 0, sizeof(SynthVoice));
+			voice->region = region;
+			voice->age = s_noteCounter++;
+			voice->channel = u8(channelId);
+			voice->key = u8(key);
+			voice->position = u64(region->start) << 32u;
+
+			const f64 cents = f64(key - region->rootKey) * f64(region->scaleTuning) + f64(region->tune);
+			voice->baseStep = f64(region->sampleRate) / f64(s_sampleRate) * pow(2.0, cents / 1200.0);
+			updateVoiceStep(voice);
+
+			voice->stage = ENV_DELAY;
+			voice->baseAtten = region->attenuation + s_curveAtten[velocity];
+		}
+	}
+
+	static void renderVoice(SynthVoice* voice, f32* out, u32 count)
+	{
+		const SynthRegion* region = voice->region;
+		advanceEnvelope(voice, f32(count) * s_invSampleRate);
+
+		f32 target[2];
+		computeVoiceGains(voice, target);
+		const f32 scale = 1.0f / f32(count);
+		const f32 deltaL = (target[0] - voice->gain[0]) * scale;
+		const f32 deltaR = (target[1] - voice->gain[1]) * scale;
+		f32 gainL = voice->gain[0];
+		f32 gainR = voice->gain[1];
+
+		const f32* data = s_sampleData.data();
+		const bool looping = region->loopEnd > region->loopStart &&
+			(region->loopMode == LOOP_CONTINUOUS || (region->loopMode == LOOP_SUSTAIN && !voice->released));
+		const u64 loopStart = u64(region->loopStart) << 32u;
+		const u64 loopEnd   = u64(region->loopEnd) << 32u;
+		const u64 end       = u64(region->end) << 32u;
+		const f32 fracScale = 1.0f / 4294967296.0f;
+
+		bool finished = false;
+		u64 position = voice->position;
+		for (u32 i = 0; i < count && !finished;)
+		{
+			// Gather up to 4 interpolation pairs.
+			f32 s0[4] = { 0 }, s1[4] = { 0 }, frac[4] = { 0 };
+			u32 n = 0;
+			for (; n < 4 && i + n < count; n++)
+			{
+				if (!looping && position >= end)
+				{
+					finished = true;
+					break;
+				}
+				const u32 index = u32(position >> 32u);
+				u32 next = index + 1;
+				if (looping && next >= region->loopEnd) { next = region->loopStart + (next - region->loopEnd); }
+
+				s0[n] = data[index];
+				s1[n] = next < region->end ? data[next] : 0.0f;
+				frac[n] = f32(u32(position)) * fracScale;
+
+				position += voice->step;
+				if (looping && position >= loopEnd)
+				{
+					position = loopStart + (position - loopEnd) % (loopEnd - loopStart);
+				}
+			}
+
+		#ifdef TFE_AUDIO_SSE2
+			if (n == 4)
+			{
+				const __m128 a = _mm_loadu_ps(s0);
+				const __m128 b = _mm_loadu_ps(s1);
+				const __m128 sample = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_loadu_ps(frac)));
+				const __m128 ramp = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+				const __m128 left  = _mm_mul_ps(sample, _mm_add_ps(_mm_set1_ps(gainL), _mm_mul_ps(ramp, _mm_set1_ps(deltaL))));
+				const __m128 right = _mm_mul_ps(sample, _mm_add_ps(_mm_set1_ps(gainR), _mm_mul_ps(ramp, _mm_set1_ps(deltaR))));
+
+				f32* dst = out + i * 2;
+				_mm_storeu_ps(dst,     _mm_add_ps(_mm_loadu_ps(dst),     _mm_unpacklo_ps(left, right)));
+				_mm_storeu_ps(dst + 4, _mm_add_ps(_mm_loadu_ps(dst + 4), _mm_unpackhi_ps(left, right)));
+				gainL += deltaL * 4.0f;
+				gainR += deltaR * 4.0f;
+				i += 4;
+				continue;
+			}
+		#endif
+			for (u32 k = 0; k < n; k++, i++)
+			{
+				const f32 sample = s0[k] + (s1[k] - s0[k]) * frac[k];
+				out[i * 2 + 0] += sample * gainL;
+				out[i * 2 + 1] += sample * gainR;
+				gainL += deltaL;
+				gainR += deltaR;
+			}
+		}
+
+		voice->position = position;
+		voice->gain[0] = target[0];
+		voice->gain[1] = target[1];
+		if (finished || voice->stage == ENV_DONE)
+		{
+			voice->region = nullptr;
+		}
+	}
+
+	void render(f32* buffer, u32 frameCount)
+	{
+		s_isRenderThread = true;
+		SynthMessage message;
+		while (s_queue.pop(&message))
+		{
+			processMessage(message.data, message.size);
+		}
+		if (!s_initialized) { return; }
+
+		for (u32 offset = 0; offset < frameCount;)
+		{
+			const u32 count = std::min(u32(SYNTH_BLOCK_SIZE), frameCount - offset);
+			SynthVoice* voice = s_voices;
+			for (s32 i = 0; i < SYNTH_MAX_VOICES; i++, voice++)
+			{
+				if (voice->region)
+				{
+					renderVoice(voice, buffer + offset * 2, count);
+				}
+			}
+			offset += count;
+		}
+	}
+
+	s32 getActiveVoiceCount()
+	{
+		s32 activeVoices = 0;
+		for (s32 i = 0; i < SYNTH_MAX_VOICES; i++)
+		{
+			if (s_voices[i].region) { activeVoices++; }
+		}
+		return activeVoices;
+	}
+
+	/////////////////////////////////////////////
+	// Messages
+	/////////////////////////////////////////////
+	static const SynthPreset* findPreset(s32 bank, s32 program)
+	{
+		// Fall back to the same program in the General MIDI (or drum) bank, then to the first preset of that bank.
+		const s32 fallbackBank = bank == SYNTH_DRUM_BANK ? SYNTH_DRUM_BANK : 0;
+		const SynthPreset* sameProgram = nullptr;
+		const SynthPreset* firstInBank = nullptr;
+		for (size_t i = 0; i < s_presets.size(); i++)
+		{
+			const SynthPreset* preset = &s_presets[i];
+			if (preset->bank == bank && preset->program == program) { return preset; }
+			if (preset->bank != fallbackBank) { continue; }
+
+			if (!sameProgram && preset->program == program) { sameProgram = preset; }
+			if (!firstInBank) { firstInBank = preset; }
+		}
+		return sameProgram ? sameProgram : firstInBank;
+	}
+
+	static void updateChannelPreset(s32 channelId)
+	{
+		SynthChannel* channel = &s_channels[channelId];
+		const s32 bank = channelId == SYNTH_DRUM_CHANNEL ? SYNTH_DRUM_BANK : channel->bankMsb;
+		channel->preset = findPreset(bank, channel->program);
+	}
+
+	static void resetControllers(SynthChannel* channel)
+	{
+		channel->expression = 127;
+		channel->sustain = false;
+		channel->rpnLsb = 127;
+		channel->rpnMsb = 127;
+		channel->bend = 0.0f;
+	}
+
+	void resetChannels()
+	{
+		for (s32 c = 0; c < MIDI_CHANNEL_COUNT; c++)
+		{
+			SynthChannel* channel = &s_channels[c];
+			memset(channel, 0, sizeof(SynthChannel));
+			channel->volume = 100;
+			channel->pan = 64;
+			channel->bendRange = 2.0f;
+			resetControllers(channel);
+			updateChannelPreset(c);
+		}
+	}
+
+	static void controlChange(s32 channelId, s32 ctrl, s32 value)
+	{
+		SynthChannel* channel = &s_channels[channelId];
+		SynthVoice* voice = s_voices;
+		switch (ctrl)
+		{
+			case MID_BANK_SELECT_MSB: { channel->bankMsb = u8(value); } break;
+			case MID_VOLUME_MSB:      { channel->volume = u8(value); } break;
+			case MID_PAN_MSB:         { channel->pan = u8(value); } break;
+			case MID_EXPRESSION_MSB:  { channel->expression = u8(value); } break;
+			case MID_RPN_LSB:         { channel->rpnLsb = u8(value); } break;
+			case MID_RPN_MSB:         { channel->rpnMsb = u8(value); } break;
+			case MID_DATA_ENTRY_MSB:
+			{
+				// RPN 0: pitch bend range.
+				if (channel->rpnLsb == 0 && channel->rpnMsb == 0)
+				{
+					channel->bendRange = f32(value);
+				}
+			} break;
+			case MID_SUSTAIN_SWITCH:
+			{
+				channel->sustain = value >= 64;
+				if (!channel->sustain)
+				{
+					for (s32 i = 0; i < SYNTH_MAX_VOICES; i++, voice++)
+					{
+						if (voice->region && voice->sustained && voice->channel == channelId)
+						{
+							releaseVoice(voice, voice->region->release);
+						}
+					}
+				}
+			} break;
+			case MID_ALL_SOUND_OFF:
+			{
+				for (s32 i = 0; i < SYNTH_MAX_VOICES; i++, voice++)
+				{
+					if (voice->channel == channelId) { voice->region = nullptr; }
+				}
+			} break;
+			case MID_ALL_CTRL_OFF:
+			{
+				resetControllers(channel);
+			} break;
+			case MID_ALL_NOTES_OFF:
+			{
+				for (s32 i = 0; i < SYNTH_MAX_VOICES; i++, voice++)
+				{
+					if (voice->region && !voice->released && voice->channel == channelId)
+					{
+						releaseVoice(voice, voice->region->release);
+					}
+				}
+			} break;
+		}
+	}
+
+	void processMessage(const u8* msg, u32 size)
+	{
+		if (!size || msg[0] < 0x80) { return; }
+		const s32 type = msg[0] & 0xf0;
+		const s32 channelId = msg[0] & 0x0f;
+		const s32 data1 = size > 1 ? (msg[1] & 0x7f) : 0;
+		const s32 data2 = size > 2 ? (msg[2] & 0x7f) : 0;
+
+		switch (type)
+		{
+			case MID_NOTE_OFF:
+			{
+				noteOff(channelId, data1);
+			} break;
+			case MID_NOTE_ON:
+			{
+				if (data2) { noteOn(channelId, data1, data2); }
+				else { noteOff(channelId, data1); }
+			} break;
+			case MID_CONTROL_CHANGE:
+			{
+				controlChange(channelId, data1, data2);
+			} break;
+			case MID_PROGRAM_CHANGE:
+			{
+				s_channels[channelId].program = u8(data1);
+				updateChannelPreset(channelId);
+			} break;
+			case MID_PITCH_BEND:
+			{
+				SynthChannel* channel = &s_channels[channelId];
+				channel->bend = channel->bendRange * f32(((data2 << 7) | data1) - 8192) / 8192.0f;
+				SynthVoice* voice = s_voices;
+				for (s32 i = 0; i < SYNTH_MAX_VOICES; i++, voice++)
+				{
+					if (voice->region && voice->channel == channelId) { updateVoiceStep(voice); }
+				}
+			} break;
+		}
+	}
+
+	/////////////////////////////////////////////
+	// SoundFont 2 loading
+	/////////////////////////////////////////////
+	enum SfGenerator
+	{
+		GEN_START_OFFSET = 0,
+		GEN_END_OFFSET = 1,
+		GEN_LOOP_START_OFFSET = 2,
+		GEN_LOOP_END_OFFSET = 3,
+		GEN_START_COARSE_OFFSET = 4,
+		GEN_END_COARSE_OFFSET = 12,
+		GEN_PAN = 17,
+		GEN_DELAY_VOL_ENV = 33,
+		GEN_ATTACK_VOL_ENV = 34,
+		GEN_HOLD_VOL_ENV = 35,
+		GEN_DECAY_VOL_ENV = 36,
+		GEN_SUSTAIN_VOL_ENV = 37,
+		GEN_RELEASE_VOL_ENV = 38,
+		GEN_INSTRUMENT = 41,
+		GEN_KEY_RANGE = 43,
+		GEN_VEL_RANGE = 44,
+		GEN_LOOP_START_COARSE_OFFSET = 45,
+		GEN_INITIAL_ATTENUATION = 48,
+		GEN_LOOP_END_COARSE_OFFSET = 50,
+		GEN_COARSE_TUNE = 51,
+		GEN_FINE_TUNE = 52,
+		GEN_SAMPLE_ID = 53,
+		GEN_SAMPLE_MODES = 54,
+		GEN_SCALE_TUNING = 56,
+		GEN_EXCLUSIVE_CLASS = 57,
+		GEN_OVERRIDING_ROOT_KEY = 58,
+		GEN_COUNT = 61,
+	};
+
+	enum SfConstants
+	{
+		SF_PHDR_SIZE = 38,
+		SF_INST_SIZE = 22,
+		SF_BAG_SIZE  = 4,
+		SF_GEN_SIZE  = 4,
+		SF_SHDR_SIZE = 46,
+		SF_ROM_SAMPLE = 0x8000,
+	};
+
+	struct SfZone
+	{
+		s16  gen[GEN_COUNT];
+		bool set[GEN_COUNT];
+	};
+
+	struct SfChunk
+	{
+		const u8* data;
+		u32 size;
+	};
+
+	struct SfData
+	{
+		SfChunk smpl, phdr, pbag, pgen, inst, ibag, igen, shdr;
+	};
+
+	static u16 readU16(const u8* data) { u16 value; memcpy(&value, data, sizeof(u16)); return value; }
+	static u32 readU32(const u8* data) { u32 value; memcpy(&value, data, sizeof(u32)); return value; }
+
+	static void parseChunks(const u8* data, u32 size, SfData* sf)
+	{
+		u32 offset = 0;
+		while (offset + 8 <= size)
+		{
+			const u8* id = data + offset;
+			const u32 chunkSize = readU32(data + offset + 4);
+			const u8* chunkData = data + offset + 8;
+			if (chunkSize > size - offset - 8) { break; }
+
+			if (memcmp(id, "LIST", 4) == 0 && chunkSize >= 4)
+			{
+				parseChunks(chunkData + 4, chunkSize - 4, sf);
+			}
+			else
+			{
+				SfChunk chunk = { chunkData, chunkSize };
+				if      (memcmp(id, "smpl", 4) == 0) { sf->smpl = chunk; }
+				else if (memcmp(id, "phdr", 4) == 0) { sf->phdr = chunk; }
+				else if (memcmp(id, "pbag", 4) == 0) { sf->pbag = chunk; }
+				else if (memcmp(id, "pgen", 4) == 0) { sf->pgen = chunk; }
+				else if (memcmp(id, "inst", 4) == 0) { sf->inst = chunk; }
+				else if (memcmp(id, "ibag", 4) == 0) { sf->ibag = chunk; }
+				else if (memcmp(id, "igen", 4) == 0) { sf->igen = chunk; }
+				else if (memcmp(id, "shdr", 4) == 0) { sf->shdr = chunk; }
+			}
+			offset += 8 + chunkSize + (chunkSize & 1);
+		}
+	}
+
+	// Reads the generators of zone 'bag' in [bagChunk, genChunk] into 'zone'. Returns false if the indices are invalid.
+	static bool readZone(const SfChunk& bagChunk, const SfChunk& genChunk, u32 bag, SfZone* zone)
+	{
+		const u32 bagCount = bagChunk.size / SF_BAG_SIZE;
+		const u32 genCount = genChunk.size / SF_GEN_SIZE;
+		if (bag + 1 >= bagCount) { return false; }
+
+		const u32 genStart = readU16(bagChunk.data + bag * SF_BAG_SIZE);
+		const u32 genEnd   = readU16(bagChunk.data + (bag + 1) * SF_BAG_SIZE);
+		if (genStart > genEnd || genEnd > genCount) { return false; }
+
+		for (u32 g = genStart; g < genEnd; g++)
+		{
+			const u16 oper = readU16(genChunk.data + g * SF_GEN_SIZE);
+			if (oper >= GEN_COUNT) { continue; }
+			zone->gen[oper] = s16(readU16(genChunk.data + g * SF_GEN_SIZE + 2));
+			zone->set[oper] = true;
+		}
+		return true;
+	}
+
+	// Copies the generators set in 'global' but not in 'zone'.
+	static void applyGlobalZone(const SfZone& global, SfZone* zone)
+	{
+		for (s32 g = 0; g < GEN_COUNT; g++)
+		{
+			if (global.set[g] && !zone->set[g])
+			{
+				zone->gen[g] = global.gen[g];
+				zone->set[g] = true;
+			}
+		}
+	}
+
+	static s32 getGen(const SfZone& zone, s32 gen, s32 defaultValue)
+	{
+		return zone.set[gen] ? zone.gen[gen] : defaultValue;
+	}
+
+	static void getRange(const SfZone& zone, s32 gen, u8* lo, u8* hi)
+	{
+		if (zone.set[gen])
+		{
+			*lo = u8(zone.gen[gen]) & 0x7f;
+			*hi = u8(u16(zone.gen[gen]) >> 8u) & 0x7f;
+		}
+		else
+		{
+			*lo = 0;
+			*hi = 127;
+		}
+	}
+
+	// Builds the regions of instrument 'instIndex' as used by a preset zone, returns the number of ROM samples skipped.
+	static u32 addInstrumentRegions(const SfData& sf, u32 instIndex, const SfZone& presetZone)
+	{
+		const u32 instCount = sf.inst.size / SF_INST_SIZE;
+		const u32 sampleCount = sf.shdr.size / SF_SHDR_SIZE;
+		const u32 sampleDataSize = u32(s_sampleData.size());
+		if (instIndex + 1 >= instCount) { return 0; }
+
+		u8 presetKeyLo, presetKeyHi, presetVelLo, presetVelHi;
+		getRange(presetZone, GEN_KEY_RANGE, &presetKeyLo, &presetKeyHi);
+		getRange(presetZone, GEN_VEL_RANGE, &presetVelLo, &presetVelHi);
+
+		const u32 bagStart = readU16(sf.inst.data + instIndex * SF_INST_SIZE + 20);
+		const u32 bagEnd   = readU16(sf.inst.data + (instIndex + 1) * SF_INST_SIZE + 20);
+		SfZone global = {};
+		u32 romSamples = 0;
+		for (u32 bag = bagStart; bag < bagEnd; bag++)
+		{
+			SfZone zone = {};
+			if (!readZone(sf.ibag, sf.igen, bag, &zone)) { break; }
+			if (!zone.set[GEN_SAMPLE_ID])
+			{
+				// Only the first zone may be a global zone.
+				if (bag == bagStart) { global = zone; }
+				continue;
+			}
+			applyGlobalZone(global, &zone);
+
+			const u32 sampleId = u16(zone.gen[GEN_SAMPLE_ID]);
+			if (sampleId + 1 >= sampleCount) { continue; }
+			const u8* shdr = sf.shdr.data + sampleId * SF_SHDR_SIZE;
+			if (readU16(shdr + 44) & SF_ROM_SAMPLE)
+			{
+				romSamples++;
+				continue;
+			}
+
+			SynthRegion region = {};
+			getRange(zone, GEN_KEY_RANGE, &region.keyLo, &region.keyHi);
+			getRange(zone, GEN_VEL_RANGE, &region.velLo, &region.velHi);
+			region.keyLo = std::max(region.keyLo, presetKeyLo);
+			region.keyHi = std::min(region.keyHi, presetKeyHi);
+			region.velLo = std::max(region.velLo, presetVelLo);
+			region.velHi = std::min(region.velHi, presetVelHi);
+			if (region.keyLo > region.keyHi || region.velLo > region.velHi) { continue; }
+
+			const s64 start = s64(readU32(shdr + 20)) + getGen(zone, GEN_START_OFFSET, 0) + getGen(zone, GEN_START_COARSE_OFFSET, 0) * 32768;
+			const s64 end   = s64(readU32(shdr + 24)) + getGen(zone, GEN_END_OFFSET, 0) + getGen(zone, GEN_END_COARSE_OFFSET, 0) * 32768;
+			const s64 loopStart = s64(readU32(shdr + 28)) + getGen(zone, GEN_LOOP_START_OFFSET, 0) + getGen(zone, GEN_LOOP_START_COARSE_OFFSET, 0) * 32768;
+			const s64 loopEnd   = s64(readU32(shdr + 32)) + getGen(zone, GEN_LOOP_END_OFFSET, 0) + getGen(zone, GEN_LOOP_END_COARSE_OFFSET, 0) * 32768;
+			region.start = u32(std::max(s64(0), std::min(start, s64(sampleDataSize))));
+			region.end   = u32(std::max(s64(region.start), std::min(end, s64(sampleDataSize))));
+			region.loopStart = u32(std::max(s64(region.start), std::min(loopStart, s64(region.end))));
+			region.loopEnd   = u32(std::max(s64(region.loopStart), std::min(loopEnd, s64(region.end))));
+			if (region.end <= region.start) { continue; }
+
+			const s32 originalKey = shdr[40] <= 127 ? shdr[40] : 60;
+			region.rootKey = getGen(zone, GEN_OVERRIDING_ROOT_KEY, -1) >= 0 ? getGen(zone, GEN_OVERRIDING_ROOT_KEY, -1) : originalKey;
+			region.sampleRate = f32(std::max(1u, readU32(shdr + 36)));
+			region.loopMode = getGen(zone, GEN_SAMPLE_MODES, 0) & 3;
+			region.exclusiveClass = getGen(zone, GEN_EXCLUSIVE_CLASS, 0);
+
+			// Preset generators are added to the instrument generators.
+			region.tune = f32((getGen(zone, GEN_COARSE_TUNE, 0) + getGen(presetZone, GEN_COARSE_TUNE, 0)) * 100 +
+				getGen(zone, GEN_FINE_TUNE, 0) + getGen(presetZone, GEN_FINE_TUNE, 0) + s8(shdr[41]));
+			region.scaleTuning = f32(getGen(zone, GEN_SCALE_TUNING, 100) + getGen(presetZone, GEN_SCALE_TUNING, 0));
+			// Most SoundFonts are authored for the EMU hardware, which applies 40% of the specified attenuation.
+			region.attenuation = 0.4f * f32(std::max(0, getGen(zone, GEN_INITIAL_ATTENUATION, 0) + getGen(presetZone, GEN_INITIAL_ATTENUATION, 0)));
+			region.pan = std::max(-0.5f, std::min(f32(getGen(zone, GEN_PAN, 0) + getGen(presetZone, GEN_PAN, 0)) / 1000.0f, 0.5f));
+			region.delay   = timecentsToSeconds(getGen(zone, GEN_DELAY_VOL_ENV,   -12000) + getGen(presetZone, GEN_DELAY_VOL_ENV,   0));
+			region.attack  = timecentsToSeconds(getGen(zone, GEN_ATTACK_VOL_ENV,  -12000) + getGen(presetZone, GEN_ATTACK_VOL_ENV,  0));
+			region.hold    = timecentsToSeconds(getGen(zone, GEN_HOLD_VOL_ENV,    -12000) + getGen(presetZone, GEN_HOLD_VOL_ENV,    0));
+			region.decay   = timecentsToSeconds(getGen(zone, GEN_DECAY_VOL_ENV,   -12000) + getGen(presetZone, GEN_DECAY_VOL_ENV,   0));
+			region.release = timecentsToSeconds(getGen(zone, GEN_RELEASE_VOL_ENV, -12000) + getGen(presetZone, GEN_RELEASE_VOL_ENV, 0));
+			region.sustain = f32(std::max(0, std::min(getGen(zone, GEN_SUSTAIN_VOL_ENV, 0) + getGen(presetZone, GEN_SUSTAIN_VOL_ENV, 0), 1440)));
+			s_regions.push_back(region);
+		}
+		return romSamples;
+	}
+
+	bool loadSoundFont(const char* path)
+	{
+		FileStream file;
+		if (!file.open(path, Stream::MODE_READ))
+		{
+			TFE_System::logWrite(LOG_ERROR, "MidiSynth", "Cannot open SoundFont '%s'.", path);
+			return false;
+		}
+		const u32 size = u32(file.getSize());
+		std::vector<u8> fileData(size);
+		file.readBuffer(fileData.data(), size);
+		file.close();
+
+		const u8* data = fileData.data();
+		if (size < 12 || memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "sfbk", 4) != 0)
+		{
+			TFE_System::logWrite(LOG_ERROR, "MidiSynth", "'%s' is not a SoundFont 2 file.", path);
+			return false;
+		}
+		SfData sf = {};
+		parseChunks(data + 12, std::min(readU32(data + 4), size - 8) - 4, &sf);
+		if (!sf.phdr.size || !sf.pbag.size || !sf.pgen.size || !sf.inst.size || !sf.ibag.size || !sf.igen.size || !sf.shdr.size)
+		{
+			TFE_System::logWrite(LOG_ERROR, "MidiSynth", "SoundFont '%s' is missing preset data.", path);
+			return false;
+		}
+
+		// 16-bit sample data.
+		const u32 sampleCount = sf.smpl.size / 2;
+		s_sampleData.resize(sampleCount);
+		for (u32 i = 0; i < sampleCount; i++)
+		{
+			s_sampleData[i] = f32(s16(readU16(sf.smpl.data + i * 2))) / 32768.0f;
+		}
+
+		// Combine the preset and instrument zones into regions.
+		const u32 presetCount = sf.phdr.size / SF_PHDR_SIZE;
+		u32 romSamples = 0;
+		for (u32 p = 0; p + 1 < presetCount; p++)
+		{
+			const u8* phdr = sf.phdr.data + p * SF_PHDR_SIZE;
+			SynthPreset preset = {};
+			preset.program = readU16(phdr + 20);
+			preset.bank = readU16(phdr + 22);
+			preset.regionStart = u32(s_regions.size());
+
+			const u32 bagStart = readU16(phdr + 24);
+			const u32 bagEnd = readU16(phdr + SF_PHDR_SIZE + 24);
+			SfZone global = {};
+			for (u32 bag = bagStart; bag < bagEnd; bag++)
+			{
+				SfZone zone = {};
+				if (!readZone(sf.pbag, sf.pgen, bag, &zone)) { break; }
+				if (!zone.set[GEN_INSTRUMENT])
+				{
+					if (bag == bagStart) { global = zone; }
+					continue;
+				}
+				applyGlobalZone(global, &zone);
+				romSamples += addInstrumentRegions(sf, u16(zone.gen[GEN_INSTRUMENT]), zone);
+			}
+
+			preset.regionCount = u32(s_regions.size()) - preset.regionStart;
+			if (preset.regionCount)
+			{
+				s_presets.push_back(preset);
+			}
+		}
+
+		if (s_presets.empty())
+		{
+			if (romSamples)
+			{
+				TFE_System::logWrite(LOG_WARNING, "MidiSynth", "SoundFont '%s' only references ROM samples, which are not included in the file.", path);
+			}
+			else
+			{
+				TFE_System::logWrite(LOG_ERROR, "MidiSynth", "SoundFont '%s' has no usable instruments.", path);
+			}
+			return false;
+		}
+		TFE_System::logWrite(LOG_MSG, "MidiSynth", "Loaded SoundFont '%s': %u presets, %u regions, %u samples.", path, u32(s_presets.size()), u32(s_regions.size()), sampleCount);
+		return true;
+	}
+
+	/////////////////////////////////////////////
+	// Built-in instruments
+	// One band-limited single cycle waveform per
+	// octave for each General MIDI family and
+	// generated one shot drum sounds.
+	/////////////////////////////////////////////
+	struct BuiltinFamily
+	{
+		f32 rolloff;		// Harmonic n has an amplitude of 1/n^rolloff.
+		bool oddOnly;
+		f32 attack, decay, sustain, release;
+	};
+
+	static const BuiltinFamily c_builtinFamilies[SYNTH_FAMILY_COUNT] =
+	{
+		{ 1.6f, false, 0.002f, 6.0f, 1440.0f, 0.25f },	// Piano
+		{ 2.5f, false, 0.001f, 2.5f, 1440.0f, 0.30f },	// Chromatic Percussion
+		{ 1.5f, true,  0.005f, 0.0f,    0.0f, 0.05f },	// Organ
+		{ 1.4f, false, 0.002f, 3.0f, 1440.0f, 0.20f },	// Guitar
+		{ 1.8f, false, 0.003f, 2.5f,  300.0f, 0.10f },	// Bass
+		{ 1.0f, false, 0.080f, 0.0f,    0.0f, 0.30f },	// Strings
+		{ 1.1f, false, 0.120f, 0.0f,    0.0f, 0.40f },	// Ensemble
+		{ 0.9f, false, 0.040f, 1.0f,   60.0f, 0.15f },	// Brass
+		{ 1.0f, true,  0.030f, 1.0f,   40.0f, 0.10f },	// Reed
+		{ 3.0f, false, 0.040f, 0.0f,    0.0f, 0.10f },	// Pipe
+		{ 1.0f, true,  0.005f, 0.0f,    0.0f, 0.10f },	// Synth Lead
+		{ 1.5f, false, 0.300f, 0.0f,    0.0f, 0.80f },	// Synth Pad
+		{ 1.3f, false, 0.100f, 2.0f,  200.0f, 0.60f },	// Synth Effects
+		{ 1.5f, false, 0.002f, 2.0f, 1440.0f, 0.20f },	// Ethnic
+		{ 2.0f, false, 0.001f, 1.0f, 1440.0f, 0.10f },	// Percussive
+		{ 0.8f, false, 0.050f, 1.0f,  200.0f, 0.30f },	// Sound Effects
+	};
+
+	static f32 keyToFrequency(s32 key)
+	{
+		return 440.0f * powf(2.0f, f32(key - 69) / 12.0f);
+	}
+
+	static u32 s_noiseSeed = 1;
+	static f32 noise()
+	{
+		s_noiseSeed = s_noiseSeed * 1664525u + 1013904223u;
+		return f32(s32(s_noiseSeed >> 8) - (1 << 23)) / f32(1 << 23);
+	}
+
+	// Appends a one shot drum sound for 'key' at the output rate, returns its length.
+	static u32 generateDrum(s32 key)
+	{
+		const f32 rate = f32(s_sampleRate);
+		f32 duration = 0.2f, toneStart = 0.0f, toneEnd = 0.0f, toneDecay = 0.1f, toneLevel = 0.0f;
+		f32 noiseDecay = 0.05f, noiseLevel = 0.0f;
+		bool highPass = true;
+		switch (key)
+		{
+			case 35: case 36: { duration = 0.4f; toneStart = 150.0f; toneEnd = 45.0f; toneDecay = 0.15f; toneLevel = 1.0f; noiseLevel = 0.1f; noiseDecay = 0.01f; } break;	// Kick
+			case 37:          { duration = 0.1f; toneStart = toneEnd = 1000.0f; toneDecay = 0.02f; toneLevel = 0.4f; noiseLevel = 0.5f; noiseDecay = 0.02f; } break;		// Side stick
+			case 38: case 40: { duration = 0.3f; toneStart = 220.0f; toneEnd = 180.0f; toneDecay = 0.05f; toneLevel = 0.6f; noiseLevel = 0.7f; noiseDecay = 0.08f; highPass = false; } break;	// Snare
+			case 39:          { duration = 0.3f; noiseLevel = 0.8f; noiseDecay = 0.07f; } break;	// Clap
+			case 41: case 43: case 45: case 47: case 48: case 50:	// Toms
+			{
+				const f32 freq = 80.0f + f32(key - 41) * 14.0f;
+				duration = 0.5f; toneStart = freq * 1.5f; toneEnd = freq; toneDecay = 0.2f; toneLevel = 0.9f; noiseLevel = 0.1f; noiseDecay = 0.02f;
+			} break;
+			case 42: case 44: { duration = 0.1f; noiseLevel = 0.5f; noiseDecay = 0.03f; } break;	// Closed and pedal hi-hat
+			case 46:          { duration = 0.5f; noiseLevel = 0.5f; noiseDecay = 0.2f; } break;		// Open hi-hat
+			case 49: case 52: case 55: case 57: { duration = 1.5f; noiseLevel = 0.6f; noiseDecay = 0.6f; } break;	// Crash
+			case 51: case 53: case 59: { duration = 1.0f; toneStart = toneEnd = 3200.0f; toneDecay = 0.3f; toneLevel = 0.1f; noiseLevel = 0.3f; noiseDecay = 0.4f; } break;	// Ride
+			case 54:          { duration = 0.2f; noiseLevel = 0.5f; noiseDecay = 0.06f; } break;	// Tambourine
+			case 56:          { duration = 0.3f; toneStart = toneEnd = 560.0f; toneDecay = 0.08f; toneLevel = 0.6f; } break;	// Cowbell
+			default:
+			{
+				// Generic pitched percussion.
+				toneStart = toneEnd = std::min(keyToFrequency(key), 4000.0f);
+				toneDecay = 0.08f; toneLevel = 0.6f; noiseLevel = 0.15f; noiseDecay = 0.02f;
+			}
+		}
+
+		const u32 length = u32(duration * rate);
+		f32 phase = 0.0f, prevNoise = 0.0f;
+		for (u32 i = 0; i < length; i++)
+		{
+			const f32 t = f32(i) / rate;
+			const f32 freq = toneEnd + (toneStart - toneEnd) * expf(-t / 0.03f);
+			phase += 2.0f * c_pi * freq / rate;
+
+			f32 value = 0.0f;
+			if (toneLevel > 0.0f)
+			{
+				value += toneLevel * sinf(phase) * expf(-t / toneDecay);
+			}
+			if (noiseLevel > 0.0f)
+			{
+				const f32 n = noise();
+				value += noiseLevel * (highPass ? (n - prevNoise) * 0.5f : n) * expf(-t / noiseDecay);
+				prevNoise = n;
+			}
+			// Short fade out to avoid clicks.
+			const f32 fade = std::min(1.0f, f32(length - i) / (0.01f * rate));
+			s_sampleData.push_back(value * fade);
+		}
+		return length;
+	}
+
+	void buildBuiltinBank()
+	{
+		// Melodic families.
+		for (s32 f = 0; f < SYNTH_FAMILY_COUNT; f++)
+		{
+			const BuiltinFamily& family = c_builtinFamilies[f];
+			const u32 regionStart = u32(s_regions.size());
+			for (s32 octave = 0; octave < SYNTH_OCTAVE_COUNT; octave++)
+			{
+				const s32 keyLo = octave * 12;
+				const s32 keyHi = std::min(keyLo + 11, 127);
+
+				// Keep the harmonics below the output Nyquist frequency, for the highest key in the octave.
+				const f32 maxFreq = 0.45f * f32(s_sampleRate);
+				const s32 harmonics = std::max(1, std::min(s32(SYNTH_TABLE_SIZE / 2 - 1), s32(maxFreq / keyToFrequency(keyHi))));
+
+				const u32 start = u32(s_sampleData.size());
+				s_sampleData.resize(start + SYNTH_TABLE_SIZE, 0.0f);
+				f32* table = &s_sampleData[start];
+				f32 peak = 0.0f;
+				for (s32 i = 0; i < SYNTH_TABLE_SIZE; i++)
+				{
+					f32 value = 0.0f;
+					for (s32 h = 1; h <= harmonics; h += family.oddOnly ? 2 : 1)
+					{
+						value += sinf(2.0f * c_pi * f32(h * i) / f32(SYNTH_TABLE_SIZE)) / powf(f32(h), family.rolloff);
+					}
+					table[i] = value;
+					peak = std::max(peak, fabsf(value));
+				}
+				for (s32 i = 0; i < SYNTH_TABLE_SIZE; i++)
+				{
+					table[i] /= peak;
+				}
+
+				SynthRegion region = {};
+				region.keyLo = u8(keyLo);
+				region.keyHi = u8(keyHi);
+				region.velHi = 127;
+				region.start = start;
+				region.end = start + SYNTH_TABLE_SIZE;
+				region.loopStart = start;
+				region.loopEnd = start + SYNTH_TABLE_SIZE;
+				region.loopMode = LOOP_CONTINUOUS;
+				region.rootKey = keyLo;
+				region.sampleRate = keyToFrequency(keyLo) * f32(SYNTH_TABLE_SIZE);
+				region.scaleTuning = 100.0f;
+				region.attack = family.attack;
+				region.decay = family.decay;
+				region.sustain = family.sustain;
+				region.release = family.release;
+				s_regions.push_back(region);
+			}
+
+			for (s32 p = 0; p < 8; p++)
+			{
+				SynthPreset preset = {};
+				preset.bank = 0;
+				preset.program = u16(f * 8 + p);
+				preset.regionStart = regionStart;
+				preset.regionCount = SYNTH_OCTAVE_COUNT;
+				s_presets.push_back(preset);
+			}
+		}
+
+		// Drum kit, General MIDI keys 27 - 87.
+		s_noiseSeed = 1;
+		SynthPreset drums = {};
+		drums.bank = SYNTH_DRUM_BANK;
+		drums.regionStart = u32(s_regions.size());
+		for (s32 key = 27; key <= 87; key++)
+		{
+			const u32 start = u32(s_sampleData.size());
+			const u32 length = generateDrum(key);
+
+			SynthRegion region = {};
+			region.keyLo = region.keyHi = u8(key);
+			region.velHi = 127;
+			region.start = start;
+			region.end = start + length;
+			region.loopMode = LOOP_NONE;
+			region.rootKey = key;
+			region.sampleRate = f32(s_sampleRate);
+			region.scaleTuning = 100.0f;
+			// Drum sounds play to the end.
+			region.release = 1.0f;
+			// The hi-hats cut each other off.
+			region.exclusiveClass = (key == 42 || key == 44 || key == 46) ? 1 : 0;
+			s_regions.push_back(region);
+		}
+		drums.regionCount = u32(s_regions.size()) - drums.regionStart;
+		s_presets.push_back(drums);
+	}
+
+	/////////////////////////////////////////////
+	// Console
+	/////////////////////////////////////////////
+	void setVoiceBudgetConsole(const ConsoleArgList& args)
+	{
+		if (args.size() >= 2)
+		{
+			setVoiceBudget(s32(TFE_Console::getFloatArg(args[1])));
+		}
+
+		char res[256];
+		sprintf(res, "Synth voices: budget %d, active %d, stolen %u, %s instruments.", s_voiceBudget, getActiveVoiceCount(), s_stolenVoices,
+			s_builtinBank ? "built-in" : "SoundFont");
+		TFE_Console::addToHistory(res);
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine MIDI Software Synthesizer
+// Renders MIDI messages with SoundFont 2 instruments inside the audio
+// callback, so music does not need a MIDI device.
+//
+// SoundFonts that only reference ROM samples (such as SYNTHGM.sf2,
+// which expects the AWE32 ROM) cannot be rendered, the built-in
+// General MIDI instruments are used instead.
+//
+// Voices are rendered with SSE2 when available. The number of voices
+// is limited by a budget, the quietest voices are stolen when a new
+// note needs one.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include <TFE_FrontEndUI/console.h>
+
+namespace TFE_MidiSynth
+{
+	enum SynthConstants
+	{
+		SYNTH_MAX_VOICES = 64,
+		SYNTH_DEFAULT_VOICE_BUDGET = 32,
+	};
+
+	// Loads the SoundFont, falling back to the built-in instruments if it cannot be used.
+	bool init(const char* soundFontPath, u32 sampleRate);
+	void destroy();
+
+	// Messages sent from the thread that renders the synth are applied immediately (sample accurate),
+	// messages from other threads are queued until the next render.
+	void sendMessage(const u8* msg, u32 size);
+	void setVoiceBudget(s32 budget);
+	s32  getVoiceBudget();
+
+	// Adds 'frameCount' interleaved stereo frames to 'buffer'.
+	void render(f32* buffer, u32 frameCount);
+	// Voices that are playing or releasing, only valid on the thread that renders the synth.
+	s32  getActiveVoiceCount();
+	// Stops all voices immediately and resets the channels.
+	void reset();
+
+	void setVoiceBudgetConsole(const ConsoleArgList& args);
+}
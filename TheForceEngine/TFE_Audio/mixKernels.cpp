@@ -0,0 +1,337 @@
+#include <cstring>
+
+#include "mixKernels.h"
+#include <TFE_System/system.h>
+#include <algorithm>
+#include <vector>
+
+#ifdef TFE_AUDIO_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace TFE_Audio
+{
+	////////////////////////////////////////////////////
+	// Sample loads, specialized by type.
+	////////////////////////////////////////////////////
+	template <SoundDataType Type>
+	static inline f32 loadSample(const u8* data, u32 index);
+
+	template <>
+	inline f32 loadSample<SOUND_DATA_8BIT>(const u8* data, u32 index)
+	{
+		return (f32)data[index];
+	}
+
+	template <>
+	inline f32 loadSample<SOUND_DATA_16BIT>(const u8* data, u32 index)
+	{
+		u16 value;
+		memcpy(&value, data + index * sizeof(u16), sizeof(u16));
+		return (f32)value;
+	}
+
+	template <>
+	inline f32 loadSample<SOUND_DATA_FLOAT>(const u8* data, u32 index)
+	{
+		f32 value;
+		memcpy(&value, data + index * sizeof(f32), sizeof(f32));
+		return value;
+	}
+
+#ifdef TFE_AUDIO_SSE2
+	template <SoundDataType Type>
+	static inline __m128 loadSamples4(const u8* data, u32 index);
+
+	template <>
+	inline __m128 loadSamples4<SOUND_DATA_8BIT>(const u8* data, u32 index)
+	{
+		s32 packed;
+		memcpy(&packed, data + index, sizeof(s32));
+		const __m128i zero = _mm_setzero_si128();
+		__m128i value = _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero);
+		value = _mm_unpacklo_epi16(value, zero);
+		return _mm_cvtepi32_ps(value);
+	}
+
+	template <>
+	inline __m128 loadSamples4<SOUND_DATA_16BIT>(const u8* data, u32 index)
+	{
+		const __m128i value = _mm_loadl_epi64((const __m128i*)(data + index * sizeof(u16)));
+		return _mm_cvtepi32_ps(_mm_unpacklo_epi16(value, _mm_setzero_si128()));
+	}
+
+	template <>
+	inline __m128 loadSamples4<SOUND_DATA_FLOAT>(const u8* data, u32 index)
+	{
+		return _mm_loadu_ps((const f32*)(data + index * sizeof(f32)));
+	}
+#endif
+
+	////////////////////////////////////////////////////
+	// Kernels
+	////////////////////////////////////////////////////
+	template <SoundDataType Type>
+	static void mixMonoToStereoT(f32* out, const u8* data, u32 start, u32 count, f32 scale, f32 offset, f32 volume)
+	{
+		u32 i = 0;
+	#ifdef TFE_AUDIO_SSE2
+		const __m128 vScale  = _mm_set1_ps(scale);
+		const __m128 vOffset = _mm_set1_ps(offset);
+		const __m128 vVolume = _mm_set1_ps(volume);
+		for (; i + 4 <= count; i += 4, out += 8)
+		{
+			// Same operations, in the same order, as the scalar loop below.
+			__m128 sample = loadSamples4<Type>(data, start + i);
+			sample = _mm_add_ps(_mm_mul_ps(sample, vScale), vOffset);
+			sample = _mm_mul_ps(sample, vVolume);
+
+			_mm_storeu_ps(out,     _mm_add_ps(_mm_loadu_ps(out),     _mm_unpacklo_ps(sample, sample)));
+			_mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_unpackhi_ps(sample, sample)));
+		}
+	#endif
+		for (; i < count; i++, out += 2)
+		{
+			const f32 sample = (loadSample<Type>(data, start + i) * scale + offset) * volume;
+			out[0] += sample;
+			out[1] += sample;
+		}
+	}
+
+	void mixMonoToStereo(f32* out, SoundDataType type, const u8* data, u32 start, u32 count, f32 scale, f32 offset, f32 volume)
+	{
+		switch (type)
+		{
+			case SOUND_DATA_8BIT:  { mixMonoToStereoT<SOUND_DATA_8BIT>(out, data, start, count, scale, offset, volume);  } break;
+			case SOUND_DATA_16BIT: { mixMonoToStereoT<SOUND_DATA_16BIT>(out, data, start, count, scale, offset, volume); } break;
+			case SOUND_DATA_FLOAT: { mixMonoToStereoT<SOUND_DATA_FLOAT>(out, data, start, count, scale, offset, volume); } break;
+		}
+	}
+
+	void mixPairTable(s16* out, const u8* data, const u32* pairTable, u32 count)
+	{
+		u32 i = 0;
+	#ifdef TFE_AUDIO_SSE2
+		// 16-bit adds wrap around, just like the scalar version.
+		for (; i + 4 <= count; i += 4, out += 8)
+		{
+			const __m128i pairs = _mm_set_epi32(s32(pairTable[data[i + 3]]), s32(pairTable[data[i + 2]]), s32(pairTable[data[i + 1]]), s32(pairTable[data[i]]));
+			_mm_storeu_si128((__m128i*)out, _mm_add_epi16(_mm_loadu_si128((const __m128i*)out), pairs));
+		}
+	#endif
+		for (; i < count; i++, out += 2)
+		{
+			const u32 pair = pairTable[data[i]];
+			out[0] += s16(pair & 0xffffu);
+			out[1] += s16(pair >> 16u);
+		}
+	}
+
+	void convertS16ToF32(f32* out, const s16* in, const f32* table, u32 count, f32 scale)
+	{
+		// The table lookups dominate here, gathering them into SSE registers is no faster than the plain loop.
+		for (u32 i = 0; i < count; i++)
+		{
+			out[i] = table[in[i]] * scale;
+		}
+	}
+
+	////////////////////////////////////////////////////
+	// Benchmark
+	// The reference loops are the scalar code that the
+	// kernels replaced.
+	////////////////////////////////////////////////////
+	enum BenchmarkConstants
+	{
+		BENCH_FRAMES     = 256,
+		BENCH_ITERATIONS = 200,
+	};
+
+	static const f32 c_benchScale[]  = { 2.0f / 255.0f, 2.0f / 65535.0f, 1.0f };
+	static const f32 c_benchOffset[] = { -1.0f, -1.0f, 0.0f };
+	static const char* c_benchTypeName[] = { "8-bit", "16-bit", "float" };
+	static u32 s_benchSeed = 1;
+
+	static u32 benchRandom()
+	{
+		s_benchSeed = s_benchSeed * 1664525u + 1013904223u;
+		return s_benchSeed >> 8;
+	}
+
+	static f32 referenceSample(u32 index, SoundDataType type, const u8* data)
+	{
+		f32 sampleValue = 0.0f;
+		switch (type)
+		{
+			case SOUND_DATA_8BIT:  { sampleValue = (f32)data[index]; } break;
+			case SOUND_DATA_16BIT: { sampleValue = (f32)(*((u16*)data + index)); } break;
+			case SOUND_DATA_FLOAT: { sampleValue = *((f32*)data + index); } break;
+		};
+		return sampleValue * c_benchScale[type] + c_benchOffset[type];
+	}
+
+	static void benchmarkResult(const char* name, s32 soundCount, f64 refTime, f64 kernelTime, bool exact)
+	{
+		char res[256];
+		sprintf(res, "%-18s %2d sounds: scalar %7.3f us, kernel %7.3f us (x%.2f), %s", name, soundCount,
+			refTime * 1000000.0 / f64(BENCH_ITERATIONS), kernelTime * 1000000.0 / f64(BENCH_ITERATIONS),
+			kernelTime > 0.0 ? refTime / kernelTime : 0.0, exact ? "bit-exact" : "MISMATCH");
+		TFE_Console::addToHistory(res);
+		TFE_System::logWrite(exact ? LOG_MSG : LOG_ERROR, "Audio Benchmark", "%s", res);
+	}
+
+	static f64 elapsed(u64 start)
+	{
+		return TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - start);
+	}
+
+	static void benchmarkSoundCount(s32 soundCount)
+	{
+		std::vector<f32> refOut(BENCH_FRAMES * 2), out(BENCH_FRAMES * 2);
+		std::vector<f32> volume(soundCount);
+		for (s32 s = 0; s < soundCount; s++)
+		{
+			volume[s] = f32(benchRandom() & 1023) / 1023.0f;
+		}
+
+		// TFE_Audio source mixing, per sample type.
+		for (s32 t = SOUND_DATA_8BIT; t <= SOUND_DATA_FLOAT; t++)
+		{
+			const SoundDataType type = SoundDataType(t);
+			const u32 sampleSize = type == SOUND_DATA_8BIT ? 1 : (type == SOUND_DATA_16BIT ? 2 : 4);
+			std::vector<u8> data(soundCount * BENCH_FRAMES * sampleSize);
+			if (type == SOUND_DATA_FLOAT)
+			{
+				f32* samples = (f32*)data.data();
+				for (size_t i = 0; i < data.size() / 4; i++) { samples[i] = f32(s32(benchRandom() & 0xffff) - 32768) / 32768.0f; }
+			}
+			else
+			{
+				for (size_t i = 0; i < data.size(); i++) { data[i] = u8(benchRandom()); }
+			}
+
+			u64 start = TFE_System::getCurrentTimeInTicks();
+			for (s32 it = 0; it < BENCH_ITERATIONS; it++)
+			{
+				memset(refOut.data(), 0, sizeof(f32) * refOut.size());
+				for (s32 s = 0; s < soundCount; s++)
+				{
+					const u8* sndData = data.data() + s * BENCH_FRAMES * sampleSize;
+					f32* buffer = refOut.data();
+					for (u32 i = 0; i < BENCH_FRAMES; i++, buffer += 2)
+					{
+						const f32 sample = referenceSample(i, type, sndData) * volume[s];
+						buffer[0] += sample;
+						buffer[1] += sample;
+					}
+				}
+			}
+			const f64 refTime = elapsed(start);
+
+			start = TFE_System::getCurrentTimeInTicks();
+			for (s32 it = 0; it < BENCH_ITERATIONS; it++)
+			{
+				memset(out.data(), 0, sizeof(f32) * out.size());
+				for (s32 s = 0; s < soundCount; s++)
+				{
+					const u8* sndData = data.data() + s * BENCH_FRAMES * sampleSize;
+					mixMonoToStereo(out.data(), type, sndData, 0, BENCH_FRAMES, c_benchScale[type], c_benchOffset[type], volume[s]);
+				}
+			}
+			const f64 kernelTime = elapsed(start);
+
+			char name[64];
+			sprintf(name, "Mix %s", c_benchTypeName[type]);
+			benchmarkResult(name, soundCount, refTime, kernelTime, memcmp(refOut.data(), out.data(), sizeof(f32) * out.size()) == 0);
+		}
+
+		// iMuse digital output: two 8-bit mapping tables per sound vs. a single packed table.
+		{
+			std::vector<u8> data(soundCount * BENCH_FRAMES);
+			for (size_t i = 0; i < data.size(); i++) { data[i] = u8(benchRandom()); }
+			std::vector<s8> mapping(soundCount * 2 * 256);
+			for (size_t i = 0; i < mapping.size(); i++) { mapping[i] = s8(benchRandom()); }
+			std::vector<u32> pairTable(soundCount * 256);
+			for (s32 s = 0; s < soundCount; s++)
+			{
+				const s8* left  = &mapping[s * 512];
+				const s8* right = &mapping[s * 512 + 256];
+				for (s32 i = 0; i < 256; i++)
+				{
+					pairTable[s * 256 + i] = u32(u16(s16(left[i]))) | (u32(u16(s16(right[i]))) << 16u);
+				}
+			}
+
+			std::vector<s16> refMix(BENCH_FRAMES * 2), mix(BENCH_FRAMES * 2);
+			u64 start = TFE_System::getCurrentTimeInTicks();
+			for (s32 it = 0; it < BENCH_ITERATIONS; it++)
+			{
+				memset(refMix.data(), 0, sizeof(s16) * refMix.size());
+				for (s32 s = 0; s < soundCount; s++)
+				{
+					const u8* sndData = &data[s * BENCH_FRAMES];
+					const s8* leftMapping  = &mapping[s * 512];
+					const s8* rightMapping = &mapping[s * 512 + 256];
+					s16* audioOut = refMix.data();
+					for (s32 i = 0; i < BENCH_FRAMES; i++, sndData++, audioOut += 2)
+					{
+						const u8 sample = *sndData;
+						audioOut[0] += (s16)leftMapping[sample];
+						audioOut[1] += (s16)rightMapping[sample];
+					}
+				}
+			}
+			f64 refTime = elapsed(start);
+
+			start = TFE_System::getCurrentTimeInTicks();
+			for (s32 it = 0; it < BENCH_ITERATIONS; it++)
+			{
+				memset(mix.data(), 0, sizeof(s16) * mix.size());
+				for (s32 s = 0; s < soundCount; s++)
+				{
+					mixPairTable(mix.data(), &data[s * BENCH_FRAMES], &pairTable[s * 256], BENCH_FRAMES);
+				}
+			}
+			f64 kernelTime = elapsed(start);
+			benchmarkResult("iMuse mix", soundCount, refTime, kernelTime, memcmp(refMix.data(), mix.data(), sizeof(s16) * mix.size()) == 0);
+
+			// Conversion of the mixed output to floating point.
+			std::vector<f32> tableMem(65536);
+			for (size_t i = 0; i < tableMem.size(); i++) { tableMem[i] = f32(s32(i) - 32768) / 32768.0f; }
+			const f32* table = &tableMem[32768];
+			const f32 systemVolume = 0.7f;
+
+			start = TFE_System::getCurrentTimeInTicks();
+			for (s32 it = 0; it < BENCH_ITERATIONS; it++)
+			{
+				const s16* audioOut = refMix.data();
+				f32* driverOut = refOut.data();
+				for (s32 i = 0; i < BENCH_FRAMES * 2; i++, audioOut++, driverOut++)
+				{
+					*driverOut = table[*audioOut] * systemVolume;
+				}
+			}
+			refTime = elapsed(start);
+
+			start = TFE_System::getCurrentTimeInTicks();
+			for (s32 it = 0; it < BENCH_ITERATIONS; it++)
+			{
+				convertS16ToF32(out.data(), mix.data(), table, BENCH_FRAMES * 2, systemVolume);
+			}
+			kernelTime = elapsed(start);
+			benchmarkResult("iMuse to driver", soundCount, refTime, kernelTime, memcmp(refOut.data(), out.data(), sizeof(f32) * out.size()) == 0);
+		}
+	}
+
+	void mixKernelBenchmark(const ConsoleArgList& args)
+	{
+		s_benchSeed = 1;
+	#ifdef TFE_AUDIO_SSE2
+		TFE_Console::addToHistory("Audio mixing kernels: SSE2");
+	#else
+		TFE_Console::addToHistory("Audio mixing kernels: scalar");
+	#endif
+		benchmarkSoundCount(32);
+		benchmarkSoundCount(64);
+	}
+}
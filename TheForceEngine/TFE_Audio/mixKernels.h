@@ -0,0 +1,34 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Audio Mixing Kernels
+// Inner loops used by the sound mixers, specialized by sample type and
+// vectorized with SSE2 when available.
+//
+// The results are bit-exact with the scalar loops they replace, the
+// same floating point operations are done in the same order. This can
+// be checked (and timed) with the "audioBenchmark" console command.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include <TFE_FrontEndUI/console.h>
+#include "audioSystem.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TFE_AUDIO_SSE2 1
+#endif
+
+namespace TFE_Audio
+{
+	// Mix 'count' mono samples, starting at data[start], into an interleaved stereo buffer:
+	//   out[2i] += (sample * scale + offset) * volume, out[2i+1] += the same value.
+	void mixMonoToStereo(f32* out, SoundDataType type, const u8* data, u32 start, u32 count, f32 scale, f32 offset, f32 volume);
+
+	// Mix 'count' 8-bit samples into an interleaved stereo 16-bit buffer using a table that packs
+	// the left (low 16 bits) and right (high 16 bits) values for each sample value.
+	void mixPairTable(s16* out, const u8* data, const u32* pairTable, u32 count);
+
+	// out[i] = table[in[i]] * scale, where the table may be addressed with negative values.
+	void convertS16ToF32(f32* out, const s16* in, const f32* table, u32 count, f32 scale);
+
+	// Console command: compares the kernels against the scalar loops and times them, mixing 32 and 64 sounds.
+	void mixKernelBenchmark(const ConsoleArgList& args);
+}
@@ -0,0 +1,265 @@
+#include <cstring>
+
+#include "resampler.h"
+#include "mixKernels.h"
+#include <TFE_System/system.h>
+#include <assert.h>
+#include <algorithm>
+#include <math.h>
+
+#ifdef TFE_AUDIO_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace TFE_Audio
+{
+	struct ResampleQualityParam
+	{
+		u32 taps;
+		f64 cutoff;		// Fraction of the input Nyquist frequency.
+		f64 beta;		// Kaiser window shape.
+	};
+
+	static const ResampleQualityParam c_resampleQuality[RESAMPLE_COUNT] =
+	{
+		{  8, 0.80, 5.0 },	// RESAMPLE_LOW
+		{ 16, 0.90, 7.0 },	// RESAMPLE_MEDIUM
+		{ 32, 0.95, 9.0 },	// RESAMPLE_HIGH
+	};
+	static const char* c_resampleQualityName[RESAMPLE_COUNT] = { "Low", "Medium", "High" };
+
+	// Odd rates produce very large phase counts (i.e. 11025 -> 192001 Hz), the ratio is kept exact but
+	// the filter is only built for this many phases and the nearest lower one is used.
+	static const u32 c_maxFilterPhases = 4096;
+	// Number of input frames to reserve space for, more is allocated if needed.
+	static const u32 c_reserveFrames = 4096;
+	// PI is single precision, the filter is computed in double precision.
+	static const f64 c_pi = 3.14159265358979323846;
+
+	static u32 gcd(u32 a, u32 b)
+	{
+		while (b)
+		{
+			const u32 t = a % b;
+			a = b;
+			b = t;
+		}
+		return a;
+	}
+
+	// Zeroth order modified Bessel function of the first kind, used by the Kaiser window.
+	static f64 besselI0(f64 x)
+	{
+		f64 sum = 1.0, term = 1.0;
+		const f64 halfX = x * 0.5;
+		for (s32 k = 1; k < 64; k++)
+		{
+			term *= (halfX / f64(k)) * (halfX / f64(k));
+			sum += term;
+			if (term < sum * 1e-12) { break; }
+		}
+		return sum;
+	}
+
+	static f64 sinc(f64 x)
+	{
+		if (fabs(x) < 1e-9) { return 1.0; }
+		const f64 px = c_pi * x;
+		return sin(px) / px;
+	}
+
+	bool resampler_init(Resampler* resampler, u32 inRate, u32 outRate, ResampleQuality quality)
+	{
+		if (!inRate || !outRate || quality < RESAMPLE_LOW || quality >= RESAMPLE_COUNT)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Resampler", "Invalid resampler parameters: %u Hz -> %u Hz, quality %d.", inRate, outRate, quality);
+			return false;
+		}
+
+		const ResampleQualityParam& param = c_resampleQuality[quality];
+		const u32 div = gcd(inRate, outRate);
+		const u32 phaseCount = outRate / div;
+		const u32 phaseStep = inRate / div;
+		const u32 filterPhases = std::min(phaseCount, c_maxFilterPhases);
+
+		resampler->taps = param.taps;
+		resampler->phaseCount = phaseCount;
+		resampler->phaseStep = phaseStep;
+		resampler->filterPhases = filterPhases;
+
+		// When downsampling the cutoff is relative to the output rate instead.
+		const f64 cutoff = param.cutoff * std::min(1.0, f64(phaseCount) / f64(phaseStep));
+		const f64 halfWidth = f64(param.taps / 2);
+		const f64 windowScale = 1.0 / besselI0(param.beta);
+
+		// Tap k of phase p is applied to input frame (position - taps/2 + 1 + k), the output lies p/L frames past 'position'.
+		resampler->filter.resize(filterPhases * param.taps * 2);
+		for (u32 p = 0; p < filterPhases; p++)
+		{
+			f32* coeff = &resampler->filter[p * param.taps * 2];
+			const f64 frac = f64(p) / f64(filterPhases);
+
+			f64 kernel[64];
+			f64 sum = 0.0;
+			for (u32 k = 0; k < param.taps; k++)
+			{
+				const f64 t = f64(s32(k) - s32(param.taps / 2) + 1) - frac;
+				const f64 x = t / halfWidth;
+				const f64 window = (fabs(x) < 1.0) ? besselI0(param.beta * sqrt(1.0 - x * x)) * windowScale : 0.0;
+				kernel[k] = cutoff * sinc(cutoff * t) * window;
+				sum += kernel[k];
+			}
+			// Normalize each phase to unity gain so a constant signal stays constant.
+			const f64 scale = (sum != 0.0) ? 1.0 / sum : 0.0;
+			for (u32 k = 0; k < param.taps; k++)
+			{
+				coeff[k * 2 + 0] = f32(kernel[k] * scale);
+				coeff[k * 2 + 1] = f32(kernel[k] * scale);
+			}
+		}
+
+		resampler->history.reserve((param.taps + c_reserveFrames) * 2);
+		resampler_reset(resampler);
+		return true;
+	}
+
+	void resampler_reset(Resampler* resampler)
+	{
+		// Start with silence in the part of the filter before the first input frame.
+		const u32 pre = resampler->taps / 2 - 1;
+		resampler->history.assign(pre * 2, 0.0f);
+		resampler->frameCount = pre;
+		resampler->position = pre;
+		resampler->phase = 0;
+	}
+
+	u32 resampler_getLatency(const Resampler* resampler)
+	{
+		return resampler->taps / 2;
+	}
+
+	u32 resampler_getInputFrames(const Resampler* resampler, u32 outFrames)
+	{
+		if (!outFrames) { return 0; }
+
+		// The last output frame needs input up to taps/2 frames past its position.
+		const u64 lastPosition = u64(resampler->position) + (u64(resampler->phase) + u64(outFrames - 1) * u64(resampler->phaseStep)) / u64(resampler->phaseCount);
+		const u64 required = lastPosition + resampler->taps / 2 + 1;
+		return required > resampler->frameCount ? u32(required - resampler->frameCount) : 0u;
+	}
+
+	void resampler_write(Resampler* resampler, const f32* input, u32 frames)
+	{
+		resampler->history.insert(resampler->history.end(), input, input + frames * 2);
+		resampler->frameCount += frames;
+	}
+
+	static inline void resampleFrame(const f32* x, const f32* h, u32 count, f32* out)
+	{
+	#ifdef TFE_AUDIO_SSE2
+		// x and h are [L0 R0 L1 R1 ...] and [h0 h0 h1 h1 ...], so the sums end up in lanes (0, 2) and (1, 3).
+		__m128 acc = _mm_setzero_ps();
+		for (u32 k = 0; k < count; k += 4)
+		{
+			acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(x + k), _mm_loadu_ps(h + k)));
+		}
+		acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+		_mm_storel_pi((__m64*)out, acc);
+	#else
+		f32 left = 0.0f, right = 0.0f;
+		for (u32 k = 0; k < count; k += 2)
+		{
+			left  += x[k + 0] * h[k + 0];
+			right += x[k + 1] * h[k + 1];
+		}
+		out[0] = left;
+		out[1] = right;
+	#endif
+	}
+
+	void resampler_read(Resampler* resampler, f32* output, u32 frames)
+	{
+		const u32 taps = resampler->taps;
+		const u32 pre = taps / 2 - 1;
+		const f32* history = resampler->history.data();
+		const f32* filter = resampler->filter.data();
+
+		u32 position = resampler->position;
+		u32 phase = resampler->phase;
+		for (u32 i = 0; i < frames; i++, output += 2)
+		{
+			assert(position + taps / 2 < resampler->frameCount);
+			const u32 filterPhase = (resampler->filterPhases == resampler->phaseCount) ? phase : u32(u64(phase) * resampler->filterPhases / resampler->phaseCount);
+			resampleFrame(&history[(position - pre) * 2], &filter[filterPhase * taps * 2], taps * 2, output);
+
+			phase += resampler->phaseStep;
+			while (phase >= resampler->phaseCount)
+			{
+				phase -= resampler->phaseCount;
+				position++;
+			}
+		}
+
+		// Discard the input that is no longer needed.
+		const u32 discard = std::min(position - pre, resampler->frameCount);
+		if (discard)
+		{
+			resampler->history.erase(resampler->history.begin(), resampler->history.begin() + discard * 2);
+			resampler->frameCount -= discard;
+			position -= discard;
+		}
+		resampler->position = position;
+		resampler->phase = phase;
+	}
+
+	////////////////////////////////////////////////////
+	// Benchmark
+	////////////////////////////////////////////////////
+	void resamplerBenchmark(const ConsoleArgList& args)
+	{
+		const u32 inRate = 11025;
+		const u32 outRate = args.size() >= 2 ? u32(TFE_Console::getFloatArg(args[1])) : 48000u;
+		const u32 bufferFrames = 256;
+		const u32 seconds = 4;
+
+		// One second of a 1 kHz test tone.
+		std::vector<f32> tone(inRate);
+		for (u32 i = 0; i < inRate; i++)
+		{
+			tone[i] = 0.5f * f32(sin(2.0 * c_pi * 1000.0 * f64(i) / f64(inRate)));
+		}
+		std::vector<f32> input(bufferFrames * 2 * 8);
+		std::vector<f32> output(bufferFrames * 2);
+		for (s32 q = RESAMPLE_LOW; q < RESAMPLE_COUNT; q++)
+		{
+			Resampler resampler;
+			if (!resampler_init(&resampler, inRate, outRate, ResampleQuality(q)))
+			{
+				return;
+			}
+
+			u32 inPhase = 0;
+			const u64 start = TFE_System::getCurrentTimeInTicks();
+			const u32 bufferCount = outRate * seconds / bufferFrames;
+			for (u32 b = 0; b < bufferCount; b++)
+			{
+				u32 inFrames = resampler_getInputFrames(&resampler, bufferFrames);
+				if (inFrames * 2 > input.size()) { input.resize(inFrames * 2); }
+				for (u32 i = 0; i < inFrames; i++, inPhase++)
+				{
+					input[i * 2 + 0] = input[i * 2 + 1] = tone[inPhase % inRate];
+				}
+				resampler_write(&resampler, input.data(), inFrames);
+				resampler_read(&resampler, output.data(), bufferFrames);
+			}
+			const f64 time = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - start);
+
+			char res[256];
+			sprintf(res, "Resample %-6s (%2u taps, %4u phases) %u -> %u Hz: %6.2f us per %u frames, %.3f%% of a core, latency %.2f ms",
+				c_resampleQualityName[q], resampler.taps, resampler.filterPhases, inRate, outRate, time * 1000000.0 / f64(bufferCount), bufferFrames,
+				100.0 * time / f64(seconds), 1000.0 * f64(resampler_getLatency(&resampler)) / f64(inRate));
+			TFE_Console::addToHistory(res);
+			TFE_System::logWrite(LOG_MSG, "Audio Benchmark", "%s", res);
+		}
+	}
+}
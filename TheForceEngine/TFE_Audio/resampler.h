@@ -0,0 +1,51 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Audio Resampler
+// Polyphase windowed-sinc resampler, used to convert the 11025 Hz mix
+// to the native rate of the output device so the quality and latency
+// do not depend on the audio backend.
+//
+// The ratio is reduced to L/M (output/input) and a filter is built for
+// each of the L phases. Samples are interleaved stereo floats.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include <TFE_FrontEndUI/console.h>
+#include <vector>
+
+enum ResampleQuality
+{
+	RESAMPLE_LOW = 0,	//  8 taps per phase.
+	RESAMPLE_MEDIUM,	// 16 taps per phase.
+	RESAMPLE_HIGH,		// 32 taps per phase.
+	RESAMPLE_COUNT
+};
+
+namespace TFE_Audio
+{
+	struct Resampler
+	{
+		u32 taps;
+		u32 phaseCount;		// L
+		u32 phaseStep;		// M
+		u32 filterPhases;	// Number of phases in 'filter', L unless L is very large.
+		u32 phase;			// Current phase, [0, L)
+		u32 position;		// Current input frame in 'history'.
+		u32 frameCount;		// Number of input frames in 'history'.
+
+		std::vector<f32> filter;	// filterPhases * taps * 2, each coefficient is duplicated for the left and right channels.
+		std::vector<f32> history;	// Interleaved stereo input frames.
+	};
+
+	bool resampler_init(Resampler* resampler, u32 inRate, u32 outRate, ResampleQuality quality);
+	void resampler_reset(Resampler* resampler);
+	// Latency added by the filter, in input frames.
+	u32  resampler_getLatency(const Resampler* resampler);
+
+	// Returns how many input frames have to be written before 'outFrames' frames can be read.
+	u32  resampler_getInputFrames(const Resampler* resampler, u32 outFrames);
+	void resampler_write(Resampler* resampler, const f32* input, u32 frames);
+	void resampler_read(Resampler* resampler, f32* output, u32 frames);
+
+	// Console command: times each quality level.
+	void resamplerBenchmark(const ConsoleArgList& args);
+}
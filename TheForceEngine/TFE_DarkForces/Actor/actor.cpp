@@ -29,6 +29,7 @@
 #include <TFE_Jedi/Memory/list.h>
 #include <TFE_Jedi/Memory/allocator.h>
 #include <TFE_Jedi/Serialization/serialization.h>
+#include <TFE_System/profiler.h>
 
 using namespace TFE_Jedi;
 
@@ -40,6 +41,31 @@ namespace TFE_DarkForces
 	ActorInternalState s_istate = { 0 };
 	List* s_physicsActors = nullptr;
 
+	// TFE: Per-tick line of sight cache, see actor_canSeeObject().
+	enum
+	{
+		LOS_CACHE_SIZE = 256,
+	};
+	struct LosCacheEntry
+	{
+		SecObject* actorObj;
+		SecObject* obj;
+		RSector* actorSector;
+		RSector* objSector;
+		vec3_fixed actorPos;
+		vec3_fixed objPos;
+		fixed16_16 objHeight;
+		Tick tick;
+		u32 geometryVersion;
+		JBool canSee;
+		JBool wallHit;
+	};
+	static LosCacheEntry s_losCache[LOS_CACHE_SIZE];
+	static Tick s_losCacheTick = 0;
+	static s32 s_losQueries = 0;
+	static s32 s_losHits = 0;
+	static s32 s_losHitRate = 0;
+
 	///////////////////////////////////////////
 	// Shared State
 	///////////////////////////////////////////
@@ -73,6 +99,15 @@ namespace TFE_DarkForces
 		// Clear specific actor state.
 		mousebot_clear();
 		welder_clear();
+
+		memset(s_losCache, 0, sizeof(s_losCache));
+		s_losCacheTick = 0;
+		s_losQueries = 0;
+		s_losHits = 0;
+		s_losHitRate = 0;
+		TFE_COUNTER(s_losQueries, "LOS Cache Queries");
+		TFE_COUNTER(s_losHits, "LOS Cache Hits");
+		TFE_COUNTER(s_losHitRate, "LOS Cache Hit Rate %");
 	}
 
 	void actor_exitState()
@@ -169,7 +204,7 @@ namespace TFE_DarkForces
 		
 	void actor_createTask()
 	{
-		s_istate.actorDispatch = allocator_create(sizeof(ActorDispatch));
+		s_istate.actorDispatch = allocator_create(sizeof(ActorDispatch), nullptr, ALLOC_STORAGE_PACKED);
 		s_istate.actorTask = createSubTask("actor", actorLogicTaskFunc, actorLogicMsgFunc);
 		s_istate.actorPhysicsTask = createSubTask("physics", actorPhysicsTaskFunc);
 	}
@@ -521,17 +556,13 @@ namespace TFE_DarkForces
 			}
 
 			SecObject** objList = sector->objectList;
-			for (s32 i = 0, idx = 0; i < sector->objectCount && idx < sector->objectCapacity; idx++)
+			for (s32 i = 0; i < sector->objectCount; i++)
 			{
-				SecObject* obj = objList[idx];
-				if (obj)
+				SecObject* obj = objList[i];
+				if ((obj->entityFlags & ETFLAG_CORPSE) && !(obj->entityFlags & ETFLAG_KEEP_CORPSE) && !actor_canSeeObject(obj, s_playerObject))
 				{
-					if ((obj->entityFlags & ETFLAG_CORPSE) && !(obj->entityFlags & ETFLAG_KEEP_CORPSE) && !actor_canSeeObject(obj, s_playerObject))
-					{
-						freeObject(obj);
-						return;
-					}
-					i++;
+					freeObject(obj);
+					return;
 				}
 			}
 		}
@@ -1563,21 +1594,68 @@ namespace TFE_DarkForces
 		obj->entityFlags |= ETFLAG_SMART_OBJ;
 	}
 
-	JBool actor_canSeeObject(SecObject* actorObj, SecObject* obj)
+	static JBool actor_canSeeObjectUncached(SecObject* actorObj, SecObject* obj, vec3_fixed p0)
 	{
-		vec3_fixed p0 = { actorObj->posWS.x, actorObj->posWS.y - actorObj->worldHeight, actorObj->posWS.z };
-		vec3_fixed p1 = { obj->posWS.x, obj->posWS.y, obj->posWS.z };
-		if (collision_canHitObject(actorObj->sector, obj->sector, p0, p1, 0))
+		// Test the object's feet and then its head; both rays share the same path through the sectors so they are cast together.
+		const fixed16_16 y1[] = { obj->posWS.y, obj->posWS.y - obj->worldHeight };
+		JBool canHit[2], wallHit[2];
+		collision_canHitObjectHeights(actorObj->sector, obj->sector, p0, obj->posWS.x, obj->posWS.z, y1, 2, 0, canHit, wallHit);
+		if (canHit[0])
 		{
+			s_collision_wallHit = JFALSE;
 			return JTRUE;
 		}
-		if (s_collision_wallHit)
+		if (wallHit[0])
 		{
+			s_collision_wallHit = JTRUE;
 			return JFALSE;
 		}
+		s_collision_wallHit = wallHit[1];
+		return canHit[1];
+	}
 
-		vec3_fixed p2 = { obj->posWS.x, obj->posWS.y - obj->worldHeight, obj->posWS.z };
-		return collision_canHitObject(actorObj->sector, obj->sector, p0, p2, 0);
+	// TFE: The same visibility question is often asked several times in a tick (thinker, attack and corpse cleanup),
+	// so the results are cached for the current tick. Entries are only reused if both objects are in the same
+	// sectors and positions and the level geometry has not changed since (see s_sectorGeometryVersion).
+	JBool actor_canSeeObject(SecObject* actorObj, SecObject* obj)
+	{
+		if (s_losCacheTick != s_curTick)
+		{
+			s_losHitRate = s_losQueries ? s_losHits * 100 / s_losQueries : 0;
+			s_losQueries = 0;
+			s_losHits = 0;
+			s_losCacheTick = s_curTick;
+		}
+		s_losQueries++;
+
+		vec3_fixed p0 = { actorObj->posWS.x, actorObj->posWS.y - actorObj->worldHeight, actorObj->posWS.z };
+		const u32 hash = u32((size_t(actorObj) >> 4) * 2654435761u) ^ u32((size_t(obj) >> 4) * 40503u);
+		LosCacheEntry* entry = &s_losCache[(hash ^ (hash >> 16)) & (LOS_CACHE_SIZE - 1)];
+		if (entry->tick == s_curTick && entry->actorObj == actorObj && entry->obj == obj &&
+			entry->geometryVersion == s_sectorGeometryVersion &&
+			entry->actorSector == actorObj->sector && entry->objSector == obj->sector &&
+			entry->actorPos.x == p0.x && entry->actorPos.y == p0.y && entry->actorPos.z == p0.z &&
+			entry->objPos.x == obj->posWS.x && entry->objPos.y == obj->posWS.y && entry->objPos.z == obj->posWS.z &&
+			entry->objHeight == obj->worldHeight)
+		{
+			s_losHits++;
+			s_collision_wallHit = entry->wallHit;
+			return entry->canSee;
+		}
+
+		const JBool canSee = actor_canSeeObjectUncached(actorObj, obj, p0);
+		entry->actorObj = actorObj;
+		entry->obj = obj;
+		entry->actorSector = actorObj->sector;
+		entry->objSector = obj->sector;
+		entry->actorPos = p0;
+		entry->objPos = obj->posWS;
+		entry->objHeight = obj->worldHeight;
+		entry->tick = s_curTick;
+		entry->geometryVersion = s_sectorGeometryVersion;
+		entry->canSee = canSee;
+		entry->wallHit = s_collision_wallHit;
+		return canSee;
 	}
 	   
 	JBool actor_canSeeObjFromDist(SecObject* actorObj, SecObject* obj)
@@ -217,24 +217,20 @@ namespace TFE_DarkForces
 	fixed16_16 turret_getZOffset(SecObject* srcObj)
 	{
 		RSector* sector = srcObj->sector;
-		for (s32 i = 0, objIdx = 0; i < sector->objectCapacity && objIdx < sector->objectCount; i++)
+		for (s32 i = 0; i < sector->objectCount; i++)
 		{
 			SecObject* obj = sector->objectList[i];
-			if (obj)
+			const JBool isOverlapping3D = obj->type == OBJ_TYPE_3D && obj->worldWidth > TURRET_OVERLAP_MIN && !obj->projectileLogic;
+			if (obj != srcObj && isOverlapping3D)
 			{
-				const JBool isOverlapping3D = obj->type == OBJ_TYPE_3D && obj->worldWidth > TURRET_OVERLAP_MIN && !obj->projectileLogic;
-				if (obj != srcObj && isOverlapping3D)
+				// Hack to make AT-ST turrets work in the Dark Tide mods.
+				// TODO: DOS shouldn't work in this case, figure out why it does (probably related to low framerate and cycles setting).
+				const fixed16_16 dx = obj->posWS.x - srcObj->posWS.x;
+				const fixed16_16 dz = obj->posWS.z - srcObj->posWS.z;
+				if (dx < ONE_16 && dz < ONE_16)
 				{
-					// Hack to make AT-ST turrets work in the Dark Tide mods.
-					// TODO: DOS shouldn't work in this case, figure out why it does (probably related to low framerate and cycles setting).
-					const fixed16_16 dx = obj->posWS.x - srcObj->posWS.x;
-					const fixed16_16 dz = obj->posWS.z - srcObj->posWS.z;
-					if (dx < ONE_16 && dz < ONE_16)
-					{
-						return TURRET_FIRE_ZMAX_OFFSET;
-					}
+					return TURRET_FIRE_ZMAX_OFFSET;
 				}
-				objIdx++;
 			}
 		}
 		return TURRET_FIRE_Z_OFFSET;
@@ -11,6 +11,7 @@
 #include <TFE_Jedi/Renderer/jediRenderer.h>
 #include <TFE_Jedi/Renderer/screenDraw.h>
 #include <TFE_Jedi/Serialization/serialization.h>
+#include <vector>
 
 using namespace TFE_Jedi;
 
@@ -40,6 +41,52 @@ namespace TFE_DarkForces
 		MOBJSPRITE_DRAW_LEN = FIXED(2)
 	};
 
+	// TFE: The visible walls and their projected lines are cached per sector, so that the map only rebuilds sectors that
+	// changed or were newly discovered (see RSector::mapVersion) and only re-projects everything when the view changes.
+	struct AutomapWall
+	{
+		RWall* wall;
+		u8 color;
+	};
+
+	struct AutomapLine
+	{
+		fixed16_16 x0, z0;
+		fixed16_16 x1, z1;
+		u8 color;
+	};
+
+	struct AutomapSector
+	{
+		u32 mapVersion;		// RSector::mapVersion when the walls were gathered.
+		u32 projVersion;	// s_mapProjVersion when the lines were projected.
+		JBool valid;
+		std::vector<AutomapWall> walls;
+		std::vector<AutomapLine> lines;
+	};
+
+	struct AutomapLayer
+	{
+		std::vector<s32> sectors;	// Sectors in the layer, in sector order.
+	};
+
+	// The view that the cached lines are projected with.
+	struct AutomapView
+	{
+		fixed16_16 x, z, scale;
+		s32 centerX, centerZ;
+		ScreenRect rect;
+	};
+
+	static std::vector<AutomapSector> s_mapSectorCache;
+	static std::vector<AutomapLayer> s_mapLayerCache;	// One per layer and a final entry for all layers.
+	static AutomapView s_mapProjView;
+	static u32 s_mapProjVersion = 0;
+	static RSector* s_mapCacheSectors = nullptr;
+	static u32 s_mapCacheSectorCount = 0;
+	static s32 s_mapCacheMinLayer = 0;
+	static s32 s_mapCacheSectorMode = -1;
+
 	static fixed16_16 s_screenScale = 0xc000;	// 0.75
 	static fixed16_16 s_scrLeftScaled;
 	static fixed16_16 s_scrRightScaled;
@@ -77,12 +124,15 @@ namespace TFE_DarkForces
 	void automap_drawLine(fixed16_16 px1, fixed16_16 pz1, fixed16_16 px2, fixed16_16 pz2, u8 color);
 	void automap_drawWall(RWall* wall, u8 color);
 	void automap_drawObject(SecObject* obj);
-	void automap_drawSector(RSector* sector);
 	void automap_drawPlayer(s32 layer);
 	void automap_drawSectors();
+	void automap_clearCache();
+	u8 automap_getWallColor(RWall* wall);
 
 	void automap_serialize(Stream* stream)
 	{
+		automap_clearCache();
+
 		SERIALIZE(SaveVersionInit, s_screenScale, 0xc000);
 		SERIALIZE(SaveVersionInit, s_scrLeftScaled, 0);
 		SERIALIZE(SaveVersionInit, s_scrRightScaled, 0);
@@ -335,6 +385,163 @@ namespace TFE_DarkForces
 		s_mapLayer = layer;
 	}
 
+	void automap_clearCache()
+	{
+		s_mapSectorCache.clear();
+		s_mapLayerCache.clear();
+		s_mapCacheSectors = nullptr;
+		s_mapCacheSectorCount = 0;
+		s_mapCacheSectorMode = -1;
+		s_mapProjVersion++;
+	}
+
+	static void automap_buildSector(RSector* sector, AutomapSector* cache)
+	{
+		cache->walls.clear();
+		cache->mapVersion = sector->mapVersion;
+		cache->valid = JTRUE;
+		if (!s_mapShowSectorMode && !(sector->flags1 & SEC_FLAGS1_RENDERED))
+		{
+			return;
+		}
+
+		RWall* wall = sector->walls;
+		for (s32 i = 0; i < sector->wallCount; i++, wall++)
+		{
+			if (!s_mapShowSectorMode && !wall->seen)
+			{
+				continue;
+			}
+
+			u8 color = automap_getWallColor(wall);
+			if (color != WCOLOR_INVISIBLE)
+			{
+				cache->walls.push_back({ wall, color });
+			}
+		}
+	}
+
+	static AutomapLayer* automap_getLayerCache()
+	{
+		if (!s_levelState.sectors || !s_levelState.sectorCount)
+		{
+			return nullptr;
+		}
+
+		// Rebuild the sector lists when the level changes.
+		if (s_mapCacheSectors != s_levelState.sectors || s_mapCacheSectorCount != s_levelState.sectorCount ||
+			s_mapCacheMinLayer != s_levelState.minLayer || s32(s_mapLayerCache.size()) != s_levelState.maxLayer - s_levelState.minLayer + 2)
+		{
+			automap_clearCache();
+			s_mapCacheSectors = s_levelState.sectors;
+			s_mapCacheSectorCount = s_levelState.sectorCount;
+			s_mapCacheMinLayer = s_levelState.minLayer;
+			s_mapSectorCache.resize(s_mapCacheSectorCount);
+			s_mapLayerCache.resize(s_levelState.maxLayer - s_levelState.minLayer + 2);
+
+			AutomapLayer* allLayers = &s_mapLayerCache.back();
+			RSector* sector = s_levelState.sectors;
+			for (u32 i = 0; i < s_mapCacheSectorCount; i++, sector++)
+			{
+				s_mapSectorCache[i].valid = JFALSE;
+				s_mapSectorCache[i].projVersion = s_mapProjVersion - 1;
+				const s32 layerIndex = sector->layer - s_levelState.minLayer;
+				if (layerIndex >= 0 && layerIndex < s32(s_mapLayerCache.size()) - 1)
+				{
+					s_mapLayerCache[layerIndex].sectors.push_back(s32(i));
+				}
+				allLayers->sectors.push_back(s32(i));
+			}
+		}
+		// The sector mode changes which walls are shown and their colors.
+		if (s_mapCacheSectorMode != s_mapShowSectorMode)
+		{
+			s_mapCacheSectorMode = s_mapShowSectorMode;
+			for (size_t i = 0; i < s_mapSectorCache.size(); i++)
+			{
+				s_mapSectorCache[i].valid = JFALSE;
+			}
+		}
+
+		if (s_mapShowAllLayers)
+		{
+			return &s_mapLayerCache.back();
+		}
+		const s32 layerIndex = s_mapLayer - s_levelState.minLayer;
+		if (layerIndex < 0 || layerIndex >= s32(s_mapLayerCache.size()) - 1)
+		{
+			return nullptr;
+		}
+		return &s_mapLayerCache[layerIndex];
+	}
+
+	static void automap_projectSector(AutomapSector* cache, const ScreenRect* screenRect)
+	{
+		cache->projVersion = s_mapProjVersion;
+		cache->lines.clear();
+
+		const s32 wallCount = s32(cache->walls.size());
+		for (s32 w = 0; w < wallCount; w++)
+		{
+			const AutomapWall* mapWall = &cache->walls[w];
+			AutomapLine line = { mapWall->wall->w0->x, mapWall->wall->w0->z, mapWall->wall->w1->x, mapWall->wall->w1->z, mapWall->color };
+			automap_projectPosition(&line.x0, &line.z0);
+			automap_projectPosition(&line.x1, &line.z1);
+
+			// Lines entirely off screen would be clipped away when drawn.
+			if ((line.x0 < screenRect->left && line.x1 < screenRect->left) || (line.x0 > screenRect->right && line.x1 > screenRect->right) ||
+				(line.z0 < screenRect->top && line.z1 < screenRect->top) || (line.z0 > screenRect->bot && line.z1 > screenRect->bot))
+			{
+				continue;
+			}
+			cache->lines.push_back(line);
+		}
+	}
+
+	static void automap_updateLayerCache(AutomapLayer* layer)
+	{
+		// All of the cached lines are stale once the view changes.
+		const ScreenRect* screenRect = vfb_getScreenRect(VFB_RECT_RENDER);
+		AutomapView* view = &s_mapProjView;
+		if (view->x != s_mapX0 || view->z != s_mapZ0 || view->scale != s_screenScale ||
+			view->centerX != s_mapXCenterInPixels || view->centerZ != s_mapZCenterInPixels ||
+			view->rect.left != screenRect->left || view->rect.right != screenRect->right ||
+			view->rect.top != screenRect->top || view->rect.bot != screenRect->bot)
+		{
+			view->x = s_mapX0;
+			view->z = s_mapZ0;
+			view->scale = s_screenScale;
+			view->centerX = s_mapXCenterInPixels;
+			view->centerZ = s_mapZCenterInPixels;
+			view->rect = *screenRect;
+			s_mapProjVersion++;
+		}
+
+		// Rebuild the sectors that changed or were discovered, then re-project only the sectors with stale lines.
+		const s32 sectorCount = s32(layer->sectors.size());
+		for (s32 i = 0; i < sectorCount; i++)
+		{
+			const s32 sectorIndex = layer->sectors[i];
+			RSector* sector = &s_levelState.sectors[sectorIndex];
+			AutomapSector* cache = &s_mapSectorCache[sectorIndex];
+
+			if (!cache->valid || cache->mapVersion != sector->mapVersion)
+			{
+				// Nothing to re-project if the sector had no visible walls before and still has none.
+				const bool hadWalls = !cache->walls.empty();
+				automap_buildSector(sector, cache);
+				if (hadWalls || !cache->walls.empty())
+				{
+					cache->projVersion = s_mapProjVersion - 1;
+				}
+			}
+			if (cache->projVersion != s_mapProjVersion)
+			{
+				automap_projectSector(cache, screenRect);
+			}
+		}
+	}
+
 	void automap_drawSectors()
 	{
 		if (s_automapAutoCenter && !s_pdaActive)
@@ -358,22 +565,34 @@ namespace TFE_DarkForces
 		s_mapTop   = s_scrTopScaled + s_mapZ0;
 
 		// Draw the sectors.
-		RSector* sector = s_levelState.sectors;
-		for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
+		AutomapLayer* layer = automap_getLayerCache();
+		if (layer)
 		{
-			if (!s_mapShowAllLayers)
+			automap_updateLayerCache(layer);
+			const s32 sectorCount = s32(layer->sectors.size());
+			for (s32 i = 0; i < sectorCount; i++)
 			{
-				s32 layer = sector->layer;
-				if (layer != s_mapLayer)
+				RSector* sector = &s_levelState.sectors[layer->sectors[i]];
+				const AutomapSector* cache = &s_mapSectorCache[layer->sectors[i]];
+				const s32 lineCount = s32(cache->lines.size());
+				const AutomapLine* line = cache->lines.data();
+				for (s32 l = 0; l < lineCount; l++, line++)
 				{
-					continue;
+					automap_drawLine(line->x0, line->z0, line->x1, line->z1, line->color);
+				}
+				if (s_mapShowSectorMode)
+				{
+					SecObject** objIter = sector->objectList;
+					for (s32 o = 0; o < sector->objectCount; o++, objIter++)
+					{
+						automap_drawObject(*objIter);
+					}
 				}
 			}
-			automap_drawSector(sector);
 		}
 
 		SecObject* player = s_playerObject;
-		sector = player->sector;
+		RSector* sector = player->sector;
 		if (!s_automapAutoCenter || s_mapLayer != sector->layer)
 		{
 			automap_drawPoint(s_mapX1, s_mapZ1, 6);
@@ -516,7 +735,7 @@ namespace TFE_DarkForces
 			fixed16_16 curFloorHeight = curSector->floorHeight;
 			fixed16_16 nextFloorHeight = nextSector->floorHeight;
 			fixed16_16 floorDelta = TFE_Jedi::abs(curFloorHeight - nextFloorHeight);
-			if (floorDelta >= 0x4000)	// 0.25 units
+			if (floorDelta >= SEC_MAP_LEDGE_HEIGHT)
 			{
 				color = WCOLOR_LEDGE;
 			}
@@ -529,47 +748,6 @@ namespace TFE_DarkForces
 		return color;
 	}
 
-	void automap_drawSector(RSector* sector)
-	{
-		if (!s_mapShowSectorMode && !(sector->flags1 & SEC_FLAGS1_RENDERED))
-		{
-			return;
-		}
-
-		RWall* wall = sector->walls;
-		for (s32 i = 0; i < sector->wallCount; i++, wall++)
-		{
-			if (!s_mapShowSectorMode && !wall->seen)
-			{
-				continue;
-			}
-
-			u8 color = automap_getWallColor(wall);
-			if (color != WCOLOR_INVISIBLE)
-			{
-				automap_drawWall(wall, color);
-			}
-		}
-		if (s_mapShowSectorMode)
-		{
-			SecObject** objIter = sector->objectList;
-			for (s32 i = 0; i < sector->objectCount; objIter++)
-			{
-				SecObject* obj = *objIter;
-				while (!obj)
-				{
-					objIter++;
-					obj = *objIter;
-				}
-				if (obj)
-				{
-					automap_drawObject(obj);
-					i++;
-				}
-			}
-		}
-	}
-		
 	void automap_drawObject(SecObject* obj)
 	{
 		u8 color = MOBJCOLOR_DEFAULT;
@@ -33,6 +33,7 @@
 #include <TFE_Memory/memoryRegion.h>
 #include <TFE_System/system.h>
 #include <TFE_System/tfeMessage.h>
+#include <TFE_Settings/settings.h>
 #include <TFE_FileSystem/paths.h>
 #include <TFE_FileSystem/fileutil.h>
 #include <TFE_FileSystem/filestream.h>
@@ -515,6 +516,12 @@ namespace TFE_DarkForces
 	****************************************************/
 	void DarkForces::loopGame()
 	{
+		// TFE: Fixed tick simulation, the world is then rendered interpolated between ticks in renderGame().
+		task_setFixedStep(TFE_Settings::getGraphicsSettings()->fixedTickInterpolation && !task_isFastForward() ? JTRUE : JFALSE, 1.0 / TIMER_FREQ);
+		if (s_runGameState.state == GSTATE_MISSION && task_getPendingSteps() > 0)
+		{
+			mission_beginFixedStep();
+		}
 		updateTime();
 				
 		switch (s_runGameState.state)
@@ -650,6 +657,14 @@ namespace TFE_DarkForces
 		}
 	}
 
+	void DarkForces::renderGame()
+	{
+		if (task_isFixedStep() && s_runGameState.state == GSTATE_MISSION)
+		{
+			mission_renderInterpolated();
+		}
+	}
+
 	void loadCutsceneList()
 	{
 		s_sharedState.cutsceneList = cutsceneList_load("cutscene.lst");
@@ -16,6 +16,7 @@ namespace TFE_DarkForces
 		void pauseSound(bool pause) override;
 		void exitGame() override;
 		void loopGame() override;
+		void renderGame() override;
 		bool serializeGameState(Stream* stream, const char* filename, bool writeState) override;
 		bool canSave() override;
 		void getLevelName(char* name) override;
@@ -87,6 +87,7 @@ namespace TFE_DarkForces
 	static s32 s_leftHudVertAnim;
 	static s32 s_leftHudShow;
 	static s32 s_leftHudMove;
+	static Tick s_hudMoveTick = 0;
 	static JBool s_forceHudPaletteUpdate = JFALSE;
 
 	static s32 s_prevEnergy = 0;
@@ -416,8 +417,16 @@ namespace TFE_DarkForces
 		}
 	}
 
-	void hud_drawGpu()
+	// TFE: The HUD can be drawn several times per tick with interpolated rendering,
+	// so the slide animation only advances when the simulation has advanced.
+	static void hud_advanceMoveAnim()
 	{
+		if (s_curTick == s_hudMoveTick)
+		{
+			return;
+		}
+		s_hudMoveTick = s_curTick;
+
 		if (s_rightHudMove)
 		{
 			s_rightHudMove--;
@@ -426,6 +435,11 @@ namespace TFE_DarkForces
 		{
 			s_leftHudMove--;
 		}
+	}
+
+	void hud_drawGpu()
+	{
+		hud_advanceMoveAnim();
 
 		// 1. Draw the base.
 		TFE_Settings_Hud* hudSettings = TFE_Settings::getHudSettings();
@@ -697,14 +711,7 @@ namespace TFE_DarkForces
 		// Clear the 3D view while the HUD positions are being animated.
 		if (s_rightHudMove || s_leftHudMove)
 		{
-			if (s_rightHudMove)
-			{
-				s_rightHudMove--;
-			}
-			if (s_leftHudMove)
-			{
-				s_leftHudMove--;
-			}
+			hud_advanceMoveAnim();
 			clear3DView(framebuffer);
 		}
 
@@ -23,6 +23,7 @@
 #include <TFE_Jedi/Level/rtexture.h>
 #include <TFE_Jedi/Level/level.h>
 #include <TFE_Jedi/Level/levelData.h>
+#include <TFE_Jedi/Level/objectInterp.h>
 #include <TFE_Jedi/InfSystem/infSystem.h>
 #include <TFE_Jedi/Renderer/rlimits.h>
 #include <TFE_Jedi/Renderer/jediRenderer.h>
@@ -34,6 +35,7 @@
 #include <TFE_FrontEndUI/console.h>
 #include <TFE_Settings/settings.h>
 #include <TFE_System/system.h>
+#include <TFE_System/profiler.h>
 #include <TFE_Input/inputMapping.h>
 
 using namespace TFE_Jedi;
@@ -399,9 +401,64 @@ namespace TFE_DarkForces
 		}
 	}
 		
+	// TFE: In fixed step mode the world and HUD are drawn after the tasks have run, by mission_renderInterpolated(),
+	// so that every frame can be drawn between the last two simulation states.
+	static JBool mission_isRenderDeferred()
+	{
+		return task_isFixedStep() && s_mainTask && s_missionMode == MISSION_MODE_MAIN && !escapeMenu_isOpen() && !pda_isOpen();
+	}
+
+	void mission_beginFixedStep()
+	{
+		// Only capture while the level is loaded and running.
+		if (task_isFixedStep() && s_mainTask && s_missionMode == MISSION_MODE_MAIN)
+		{
+			objInterp_capture();
+		}
+	}
+
+	void mission_renderInterpolated()
+	{
+		if (!s_playerEye || !mission_isRenderDeferred())
+		{
+			return;
+		}
+		TFE_ZONE("Interpolated Render");
+
+		s_framebuffer = vfb_getCpuBuffer();
+		TFE_Jedi::beginRender();
+
+		// Move the objects, including the player eye, between the previous and current simulation steps.
+		objInterp_apply(floatToFixed16(task_getStepAlpha()));
+		player_setupCamera();
+
+		updateScreensize();
+		drawWorld(s_framebuffer, s_playerEye->sector, s_levelColorMap, s_lightSourceRamp);
+		weapon_draw(s_framebuffer, (DrawRect*)vfb_getScreenRect(VFB_RECT_UI));
+		handleVisionFx();
+
+		// Restore the simulation state.
+		objInterp_restore();
+		player_setupCamera();
+
+		if (s_drawAutomap)
+		{
+			automap_draw(s_framebuffer);
+		}
+		hud_drawAndUpdate(s_framebuffer);
+		hud_drawMessage(s_framebuffer);
+
+		TFE_Jedi::endRender();
+		vfb_swap();
+	}
+		
 	void mission_mainTaskFunc(MessageType msg)
 	{
-		task_begin;
+		struct LocalContext
+		{
+			JBool deferRender;
+		};
+		task_begin_ctx;
 		blankScreen();
 
 		while (msg != MSG_FREE_TASK)
@@ -414,7 +471,12 @@ namespace TFE_DarkForces
 
 			// Grab the current framebuffer in case in changed.
 			s_framebuffer = vfb_getCpuBuffer();
-			TFE_Jedi::beginRender();
+			// TFE: Fast-forward mode only draws some of the frames.
+			taskCtx->deferRender = mission_isRenderDeferred() || task_isRenderSkipped();
+			if (!taskCtx->deferRender)
+			{
+				TFE_Jedi::beginRender();
+			}
 
 			// Handle delta time.
 			s_deltaTime = div16(intToFixed16(s_curTick - s_prevTick), FIXED(TICKS_PER_SECOND));
@@ -430,7 +492,7 @@ namespace TFE_DarkForces
 				{
 					blitLoadingScreen();
 				}
-				else if (s_missionMode == MISSION_MODE_MAIN)
+				else if (s_missionMode == MISSION_MODE_MAIN && !taskCtx->deferRender)
 				{
 					updateScreensize();
 					drawWorld(s_framebuffer, s_playerEye->sector, s_levelColorMap, s_lightSourceRamp);
@@ -442,12 +504,15 @@ namespace TFE_DarkForces
 			if (!escapeMenu_isOpen() && !pda_isOpen())
 			{
 				handleGeneralInput();
-				if (s_drawAutomap)
+				if (!taskCtx->deferRender)
 				{
-					automap_draw(s_framebuffer);
+					if (s_drawAutomap)
+					{
+						automap_draw(s_framebuffer);
+					}
+					hud_drawAndUpdate(s_framebuffer);
+					hud_drawMessage(s_framebuffer);
 				}
-				hud_drawAndUpdate(s_framebuffer);
-				hud_drawMessage(s_framebuffer);
 				handlePaletteFx();
 			}
 			
@@ -503,8 +568,11 @@ namespace TFE_DarkForces
 			}
 
 			// vgaSwapBuffers() in the DOS code.
-			TFE_Jedi::endRender();
-			vfb_swap();
+			if (!taskCtx->deferRender)
+			{
+				TFE_Jedi::endRender();
+				vfb_swap();
+			}
 
 			// Pump tasks and look for any with a different ID.
 			do
@@ -518,6 +586,7 @@ namespace TFE_DarkForces
 		}
 
 		s_mainTask = nullptr;
+		objInterp_clear();
 		task_makeActive(s_missionLoadTask);
 		task_end;
 	}
@@ -36,6 +36,10 @@ namespace TFE_DarkForces
 	void disableNightvision();
 
 	void mission_render(s32 rendererIndex = 0);
+	// TFE: Fixed step mode - capture the state before the simulation steps and then draw the world and HUD
+	// interpolated between the last two steps.
+	void mission_beginFixedStep();
+	void mission_renderInterpolated();
 
 	void mission_setupTasks();
 	void mission_serialize(Stream* stream);
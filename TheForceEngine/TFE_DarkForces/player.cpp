@@ -20,6 +20,7 @@
 #include <TFE_Jedi/Level/level.h>
 #include <TFE_Jedi/Level/levelData.h>
 #include <TFE_Jedi/InfSystem/infSystem.h>
+#include <TFE_Jedi/Collision/objectGrid.h>
 #include <TFE_Jedi/Renderer/rlimits.h>
 #include <TFE_Jedi/Serialization/serialization.h>
 // Internal types need to be included in this case.
@@ -1093,6 +1094,7 @@ namespace TFE_DarkForces
 				s_playerObject->posWS.y = floorHeight;
 				s_playerYPos = s_playerObject->posWS.y;
 				player_changeSector(sector);
+				objGrid_update(s_playerObject);
 
 				s_nextShieldDmgTick = s_curTick + 436;
 				if (s_invincibilityTask)
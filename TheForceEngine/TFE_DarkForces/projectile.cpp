@@ -852,6 +852,8 @@ namespace TFE_DarkForces
 	}
 
 	// The "standard" update function - projectiles travel in a straight line with a fixed velocity.
+	// TFE: The movement delta is computed here rather than in a separate batched pass because the velocity can change
+	// earlier in the same update (moving floors, hits handled for previous projectiles) and the collision tests dominate the cost.
 	ProjectileHitType stdProjectileUpdateFunc(ProjectileLogic* projLogic)
 	{
 		// Calculate how much the projectile moves this timeslice.
@@ -3,6 +3,7 @@
 #include "sound.h"
 #include "player.h"
 #include <TFE_DarkForces/Landru/lsound.h>
+#include <TFE_System/system.h>
 #include <TFE_Settings/settings.h>
 #include <TFE_Game/igame.h>
 #include <TFE_Asset/vocAsset.h>
@@ -13,6 +14,7 @@
 #include <TFE_Jedi/Memory/allocator.h>
 #include <TFE_Jedi/Serialization/serialization.h>
 #include <TFE_DarkForces/time.h>
+#include <vector>
 
 namespace TFE_DarkForces
 {
@@ -37,6 +39,14 @@ namespace TFE_DarkForces
 		s32 soundLevelStart = -1;
 	};
 
+	// TFE: Flattened sounds cached for the whole game session, see sound_getCachedVoc().
+	struct CachedSound
+	{
+		char name[13];
+		u8* data;
+		u32 size;
+	};
+
 	#define MAX_LEVEL_SOUNDS 300
 	#define CUE_RING1 FIXED(30)
 	#define CUE_RING2 FIXED(150)
@@ -50,6 +60,7 @@ namespace TFE_DarkForces
 	static const s32 s_tPan[32] = { 00,-06,-12,-18,-24,-30,-36,-42,-48,-42,-36,-30,-24,-18,-12,-06,00,06,12,18,24,30,36,42,48,42,36,30,24,18,12,06 };
 	
 	static SoundState s_state = {};
+	static std::vector<CachedSound> s_soundCache;
 	s32 s_lastMaintainVolume;
 
 	SoundEffectId soundInstance(SoundSourceId soundId, s32 instance);
@@ -58,6 +69,8 @@ namespace TFE_DarkForces
 	u8* sound_getResource(SoundEffectId id);
 	void sound_alwaysFree(GameSound* sound);
 	void sound_clearLevelSounds();
+	u8* sound_getCachedVoc(const char* fileName, u32* size);
+	void sound_freeCache();
 
 	// Called at game startup and shutdown.
 	void sound_open(MemoryRegion* memRegion)
@@ -78,6 +91,7 @@ namespace TFE_DarkForces
 		sound_levelStop();
 		allocator_free(s_state.gameSoundList);
 		ImTerminate();
+		sound_freeCache();
 		s_state = {};
 	}
 
@@ -191,7 +205,7 @@ namespace TFE_DarkForces
 		}
 
 		u32 size = 0;
-		u8* data = readVocFileData(fileName, &size);
+		u8* data = sound_getCachedVoc(fileName, &size);
 		if (data)
 		{
 			sound = (GameSound*)allocator_newItem(s_state.gameSoundList);
@@ -218,10 +232,7 @@ namespace TFE_DarkForces
 
 			if (sound->refCount == 0)
 			{
-				if (sound->data)
-				{
-					game_free(sound->data);
-				}
+				// The data is owned by the sound cache.
 				sound->data = nullptr;
 				allocator_deleteItem(s_state.gameSoundList, sound);
 			}
@@ -232,10 +243,6 @@ namespace TFE_DarkForces
 	{
 		if (sound)
 		{
-			if (sound->data)
-			{
-				game_free(sound->data);
-			}
 			sound->data = nullptr;
 			allocator_deleteItem(s_state.gameSoundList, sound);
 		}
@@ -429,4 +436,194 @@ namespace TFE_DarkForces
 		GameSound* sound = getSoundPtr(id);
 		return sound ? sound->data : nullptr;
 	}
-}  // TFE_DarkForces
\ No newline at end of file
+
+	/////////////////////////////////////////////////////////
+	// TFE: Sound cache
+	// Sounds are read and flattened once and then shared by every level, instead of being read from disk on every
+	// level load. The flattened VOC merges the sound data, continuation and silence blocks into as few data blocks
+	// as possible, so iMuse walks fewer chunks during playback. Markers and repeat blocks are kept as they are.
+	/////////////////////////////////////////////////////////
+	enum VocBlockType
+	{
+		VOC_BLOCK_TERMINATOR = 0,
+		VOC_BLOCK_SOUND_DATA,
+		VOC_BLOCK_SOUND_CONTINUE,
+		VOC_BLOCK_SILENCE,
+		VOC_BLOCK_MARKER,
+		VOC_BLOCK_ASCII,
+		VOC_BLOCK_REPEAT,
+		VOC_BLOCK_END_REPEAT,
+	};
+
+	enum VocConstants
+	{
+		VOC_HEADER_SIZE = 26,
+		// iMuse warns (mailbox 9) about larger data chunks.
+		VOC_MAX_CHUNK_SIZE = 200000,
+		// iMuse always copies 48 bytes when seeking to the next chunk.
+		VOC_CHUNK_PADDING = 48,
+	};
+
+	static const u8 c_vocHeader[VOC_HEADER_SIZE] =
+	{
+		'C', 'r', 'e', 'a', 't', 'i', 'v', 'e', ' ', 'V', 'o', 'i', 'c', 'e', ' ', 'F', 'i', 'l', 'e', 0x1a,
+		VOC_HEADER_SIZE, 0x00, 0x0a, 0x01, 0x29, 0x11
+	};
+
+	static void vocWriteBlockHeader(std::vector<u8>& dst, u8 type, u32 size)
+	{
+		dst.push_back(type);
+		dst.push_back(u8(size));
+		dst.push_back(u8(size >> 8u));
+		dst.push_back(u8(size >> 16u));
+	}
+
+	static void vocFlushSoundData(std::vector<u8>& dst, std::vector<u8>& pcm, u8 rateByte)
+	{
+		for (size_t offset = 0; offset < pcm.size(); offset += VOC_MAX_CHUNK_SIZE)
+		{
+			const u32 size = u32(std::min(pcm.size() - offset, size_t(VOC_MAX_CHUNK_SIZE)));
+			vocWriteBlockHeader(dst, VOC_BLOCK_SOUND_DATA, size + 2);
+			dst.push_back(rateByte);
+			dst.push_back(0);	// 8-bit unsigned PCM.
+			dst.insert(dst.end(), pcm.begin() + offset, pcm.begin() + offset + size);
+		}
+		pcm.clear();
+	}
+
+	// Returns false if 'src' is not a valid VOC file, in which case it should be used as is.
+	static bool vocFlatten(const u8* src, u32 srcSize, std::vector<u8>& dst)
+	{
+		if (srcSize < VOC_HEADER_SIZE || memcmp(src, c_vocHeader, 19) != 0) { return false; }
+		const u32 dataOffset = src[20] | (src[21] << 8u);
+
+		std::vector<u8> pcm;
+		u8 rateByte = 0;
+		bool hasRate = false;
+		dst.clear();
+		dst.insert(dst.end(), c_vocHeader, c_vocHeader + VOC_HEADER_SIZE);
+
+		u32 offset = dataOffset;
+		while (offset + 4 <= srcSize && src[offset] != VOC_BLOCK_TERMINATOR)
+		{
+			const u8 type = src[offset];
+			const u32 blockLen = src[offset + 1] | (src[offset + 2] << 8u) | (src[offset + 3] << 16u);
+			const u8* block = &src[offset + 4];
+			offset += 4 + blockLen;
+			if (offset > srcSize) { return false; }
+
+			switch (type)
+			{
+				case VOC_BLOCK_SOUND_DATA:
+				{
+					if (blockLen < 2) { return false; }
+					// Dark Forces does not change the sample rate between blocks, so only the first one is kept.
+					if (!hasRate)
+					{
+						rateByte = block[0];
+						hasRate = true;
+					}
+					pcm.insert(pcm.end(), block + 2, block + blockLen);
+				} break;
+				case VOC_BLOCK_SOUND_CONTINUE:
+				{
+					pcm.insert(pcm.end(), block, block + blockLen);
+				} break;
+				case VOC_BLOCK_SILENCE:
+				{
+					if (blockLen < 3) { return false; }
+					const u32 silenceLen = (block[0] | (block[1] << 8u)) + 1;
+					if (!hasRate)
+					{
+						rateByte = block[2];
+						hasRate = true;
+					}
+					pcm.insert(pcm.end(), silenceLen, 128);
+				} break;
+				case VOC_BLOCK_MARKER:
+				case VOC_BLOCK_REPEAT:
+				{
+					if (blockLen < 2) { return false; }
+					vocFlushSoundData(dst, pcm, rateByte);
+					vocWriteBlockHeader(dst, type, 2);
+					dst.push_back(block[0]);
+					dst.push_back(block[1]);
+				} break;
+				case VOC_BLOCK_END_REPEAT:
+				{
+					vocFlushSoundData(dst, pcm, rateByte);
+					vocWriteBlockHeader(dst, type, 0);
+				} break;
+				case VOC_BLOCK_ASCII:
+				{
+					// The string is not used.
+				} break;
+				default:
+				{
+					// Extended blocks are not used by Dark Forces.
+					return false;
+				}
+			}
+		}
+		vocFlushSoundData(dst, pcm, rateByte);
+		dst.push_back(VOC_BLOCK_TERMINATOR);
+		dst.insert(dst.end(), VOC_CHUNK_PADDING, 0);
+		return true;
+	}
+
+	u8* sound_getCachedVoc(const char* fileName, u32* size)
+	{
+		const size_t count = s_soundCache.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			if (!strcasecmp(fileName, s_soundCache[i].name))
+			{
+				*size = s_soundCache[i].size;
+				return s_soundCache[i].data;
+			}
+		}
+
+		u32 fileSize = 0;
+		u8* fileData = readVocFileData(fileName, &fileSize);
+		if (!fileData) { return nullptr; }
+
+		CachedSound cached = {};
+		strcpy_s(cached.name, 13, fileName);
+		std::vector<u8> flat;
+		if (vocFlatten(fileData, fileSize, flat))
+		{
+			cached.size = u32(flat.size());
+			cached.data = (u8*)malloc(cached.size);
+			if (cached.data)
+			{
+				memcpy(cached.data, flat.data(), cached.size);
+			}
+		}
+		else
+		{
+			TFE_System::logWrite(LOG_WARNING, "Sound", "Sound '%s' is not a valid VOC file, it is used as is.", fileName);
+			cached.size = fileSize;
+			cached.data = (u8*)malloc(fileSize);
+			if (cached.data)
+			{
+				memcpy(cached.data, fileData, fileSize);
+			}
+		}
+		game_free(fileData);
+		if (!cached.data) { return nullptr; }
+
+		s_soundCache.push_back(cached);
+		*size = cached.size;
+		return cached.data;
+	}
+
+	void sound_freeCache()
+	{
+		const size_t count = s_soundCache.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			free(s_soundCache[i].data);
+		}
+		s_soundCache.clear();
+	}
+}  // TFE_DarkForces
@@ -1,6 +1,8 @@
 #include "time.h"
 #include <TFE_System/system.h>
+#include <TFE_Audio/audioSystem.h>
 #include <TFE_Jedi/Serialization/serialization.h>
+#include <TFE_Jedi/Task/task.h>
 
 using namespace TFE_Jedi;
 
@@ -46,12 +48,31 @@ namespace TFE_DarkForces
 	{
 		if (!s_pauseTimeUpdate)
 		{
-			s_timeAccum += TFE_System::getDeltaTime() * TIMER_FREQ;
+			// TFE: In fast-forward mode, advance by exactly one tick per update regardless of real time.
+			if (task_isFastForward())
+			{
+				s_timeAccum += 1.0;
+			}
+			// TFE: In fixed step mode, advance by exactly one tick for each step the task system is about to run.
+			else if (task_isFixedStep())
+			{
+				s_timeAccum += f64(task_getPendingSteps());
+			}
+			else
+			{
+				s_timeAccum += TFE_System::getDeltaTime() * TIMER_FREQ;
+			}
 		}
 
 		Tick prevTick = s_curTick;
 		s_curTick = Tick(s_timeAccum);
 
+		// TFE: When rendering audio offline, the audio follows the game time so a fast-forward run renders the same audio every time.
+		if (s_curTick > prevTick)
+		{
+			TFE_Audio::renderOffline(f64(s_curTick - prevTick) / TIMER_FREQ);
+		}
+
 		fixed16_16 dt = div16(intToFixed16(s_curTick - prevTick), FIXED(TICKS_PER_SECOND));
 		for (s32 i = 0; i < 13; i++)
 		{
@@ -10,6 +10,7 @@
 #include <TFE_Jedi/Level/levelData.h>
 #include <TFE_Jedi/Level/rwall.h>
 #include <TFE_Jedi/Collision/collision.h>
+#include <TFE_Jedi/Collision/objectGrid.h>
 #include <TFE_System/system.h>
 #include <TFE_FileSystem/paths.h>
 #include <TFE_FileSystem/filestream.h>
@@ -532,6 +533,7 @@ namespace TFE_DarkForces
 							}
 
 							local(obj)->posWS = local(frame)->offset;
+							objGrid_update(local(obj));
 						task_localBlockEnd;
 
 						entity_yield(TASK_NO_DELAY);
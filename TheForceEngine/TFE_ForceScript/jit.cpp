@@ -1,26 +1,87 @@
+#include <cstring>
 #include "jit.h"
-#include "vm.h"
-#include <assert.h>
-#include <string>
+#include <TFE_System/system.h>
+#include <algorithm>
+#include <cstddef>
 #include <vector>
-#include <map>
 
-#ifdef VM_ENABLE
+#if defined(VM_ENABLE) && defined(VM_JIT_ENABLE)
 #include "asmjit/x86.h"
 
 using namespace asmjit;
-// Incomment to enable per-instruction validation at the assembler level.
-#define JIT_DEBUG 0
+// Uncomment to enable per-instruction validation at the assembler level.
+// #define JIT_DEBUG 1
 
 namespace TFE_ForceScript
 {
-	typedef std::map<std::string, ScriptJitFunc> ScriptJitMap;
-	typedef std::vector<ScriptJitFunc> ScriptJitList;
+	// Types known at compile time, so type guards can be skipped.
+	enum JitType
+	{
+		JIT_TYPE_UNKNOWN = 0,
+		JIT_TYPE_INT,
+		JIT_TYPE_FLOAT,
+	};
+
+	// The upper 32 bits of a plain (no type mod or flags) int or float value.
+	static const u32 c_tagInt   = u32(FST_INT)   << u32(FS_TypeDataShift - 32);
+	static const u32 c_tagFloat = u32(FST_FLOAT) << u32(FS_TypeDataShift - 32);
+	// The upper 16 bits of a struct reference (the rest is the pointer), see fsValue_createStruct().
+	static const u16 c_refTagStruct = u16(FST_STRUCT) | u16(FSF_REF << 8);
+
+	// We currently only support x64.
+	// The register window and state are kept in callee saved registers, everything else is a temporary.
+	static const x86::Gp c_regs  = x86::r12;
+	static const x86::Gp c_state = x86::r13;
+#if defined(_WIN32)
+	static const x86::Gp c_arg0 = x86::rcx;
+	static const x86::Gp c_arg1 = x86::rdx;
+	static const x86::Gp c_arg2 = x86::r8;
+#else
+	static const x86::Gp c_arg0 = x86::rdi;
+	static const x86::Gp c_arg1 = x86::rsi;
+	static const x86::Gp c_arg2 = x86::rdx;
+#endif
+	// Pushed registers + shadow space (Win64) + padding keep the stack 16 byte aligned for calls.
+	static const s32 c_frameSize = 40;
+
+	struct JitCacheEntry
+	{
+		u64 hash;
+		std::vector<Instruction> code;
+		VmJitFunc func;
+	};
+
+	struct JitContext
+	{
+		x86::Assembler* as;
+		s32 ip;
+		std::vector<Label> labels;		// Branch targets, one per instruction.
+		std::vector<Label> deoptLabels;	// Bail out stubs, created when an instruction first needs one.
+		std::vector<u8> isTarget;
+		std::vector<u8> knownType;		// JitType per register.
+		Label exitLabel;
+		Label epilogueLabel;
+	};
+
+	// Records the first error, code with errors is discarded.
+	class JitErrorHandler : public ErrorHandler
+	{
+	public:
+		Error error = kErrorOk;
+
+		void handleError(Error err, const char* message, BaseEmitter* origin) override
+		{
+			if (error == kErrorOk)
+			{
+				error = err;
+				TFE_System::logWrite(LOG_ERROR, "ForceScript", "JIT error: %s", message);
+			}
+		}
+	};
 
 	static JitRuntime s_runtime;
-	static ScriptJitMap s_jitFuncs;
-	static ScriptJitList s_jitFuncList;
-	
+	static std::vector<JitCacheEntry> s_jitCache;
+
 	bool jit_init()
 	{
 		return true;
@@ -28,299 +89,642 @@ namespace TFE_ForceScript
 
 	void jit_destroy()
 	{
-		const size_t count = s_jitFuncList.size();
-		ScriptJitFunc* func = s_jitFuncList.data();
+		const size_t count = s_jitCache.size();
 		for (size_t i = 0; i < count; i++)
 		{
-			s_runtime.release(func[i]);
+			s_runtime.release(s_jitCache[i].func);
 		}
-		s_jitFuncs.clear();
-		s_jitFuncList.clear();
+		s_jitCache.clear();
 	}
 
-	ScriptJitFunc jit_getScriptFunc(const char* funcName)
+	s32 jit_getCachedFuncCount()
 	{
-		ScriptJitMap::iterator it = s_jitFuncs.find(funcName);
-		return it == s_jitFuncs.end() ? nullptr : it->second;
+		return s32(s_jitCache.size());
 	}
 
-	enum IR_Type
-	{
-		IRT_INSTR = 0,
-		IRT_LABEL,
-		IRT_COUNT
-	};
+	//////////////////////////////////////////////////
+	// Code generation helpers
+	//////////////////////////////////////////////////
+	static x86::Mem jit_value(s32 reg) { return x86::qword_ptr(c_regs, reg * 8); }
+	static x86::Mem jit_data(s32 reg)  { return x86::dword_ptr(c_regs, reg * 8); }
+	static x86::Mem jit_tag(s32 reg)   { return x86::dword_ptr(c_regs, reg * 8 + 4); }
+	static x86::Mem jit_refTag(s32 reg) { return x86::word_ptr(c_regs, reg * 8 + 6); }
+	static x86::Mem jit_stateField(size_t offset) { return x86::dword_ptr(c_state, s32(offset)); }
 
-	struct IR_Jit
+	static Label jit_deoptLabel(JitContext* ctx)
 	{
-		IR_Type type;
-		Instruction it;
-		s32 index;
-	};
-	static std::vector<IR_Jit> s_jitIR;
-
-	#ifdef JIT_DEBUG
-		#define emit(x) ierr = as. ## x; assert(ierr == 0)
-	#else
-		#define emit(x) as. ## x
-	#endif
-
-	#define PTR0 8*I_ARG0(ir->it)
-	#define PTR1 8*I_ARG1(ir->it)
-	#define PTR2 8*I_ARG2(ir->it)
-
-	Label* s_labels;
-	s32 s_labelTarget[256];
-	s32 s_labelCount = 0;
+		Label& label = ctx->deoptLabels[ctx->ip];
+		if (!label.isValid())
+		{
+			label = ctx->as->newLabel();
+		}
+		return label;
+	}
 
-	void loadValueType(Error& ierr, x86::Assembler& as, x86::Gp dstReg, x86::Mem src)
+	// Values are written with a single 64-bit store, so later 64-bit loads (moves, calls, fields) can be forwarded
+	// from the store. 'value' must have been written as a 32-bit register (clearing the upper bits) and the type
+	// must be FST_INT or FST_FLOAT, which are a single bit.
+	static void jit_storeTagged(JitContext* ctx, s32 reg, const x86::Gp& value, FS_Type type)
 	{
-		// type = (src >> FS_TypeDataShift) & FS_TypeMask
-		emit(mov(dstReg, src));
-		emit(shr(dstReg,  FS_TypeDataShift));
-		emit(and_(dstReg, FS_TypeMask));
+		const x86::Gp value64 = value.r64();
+		ctx->as->bts(value64, u32(FS_TypeDataShift) + u32(type) - 1);
+		ctx->as->mov(jit_value(reg), value64);
 	}
 
-	void dynamicCastToFloat(Error& ierr, x86::Assembler& as, x86::Gp type, x86::Xmm dst, x86::Mem src)
+	static void jit_storeInt(JitContext* ctx, s32 reg, const x86::Gp& value)
 	{
-		// Create labels.
-		s32 labelElse = s_labelCount;
-		s32 labelEnd = s_labelCount + 1;
-		s_labelCount +=2;
-		s_labels[labelElse] = as.newLabel();
-		s_labels[labelEnd] = as.newLabel();
-
-		// Check to see if it is integer.
-		// TODO: Support NxM types.
-		// TODO: Default to 0 for invalid types.
-
-		// Zero out the floating point register so the upper bits aren't undefined (which can cause problems later).
-		emit(xorps(dst, dst));
-
-		emit(cmp(type, FST_INT)); // if r0 == FST_INT {
-		emit(jnz(s_labels[labelElse]));
-			emit(cvtsi2ss(dst, src));
-			emit(jmp(s_labels[labelEnd]));
-		emit(bind(s_labels[labelElse])); // } else {
-			emit(movss(dst, src));
-		emit(bind(s_labels[labelEnd]));  // }
+		jit_storeTagged(ctx, reg, value, FST_INT);
+		ctx->knownType[reg] = JIT_TYPE_INT;
 	}
 
-	ScriptJitFunc jit_compileScriptFunc(const char* funcName, Instruction* func, s32 funcSize)
+	static void jit_storeFloat(JitContext* ctx, s32 reg, const x86::Xmm& value)
 	{
-		s_jitIR.clear();
-
-		Error ierr;
-		CodeHolder code;
-		code.init(s_runtime.environment());
-		x86::Assembler as(&code);
-
-		// Enable strict validation.
-	#ifdef JIT_DEBUG
-		as.addDiagnosticOptions(DiagnosticOptions::kRADebugAll);
-	#endif
+		ctx->as->movd(x86::eax, value);
+		jit_storeTagged(ctx, reg, x86::eax, FST_FLOAT);
+		ctx->knownType[reg] = JIT_TYPE_FLOAT;
+	}
 
-		// We currently only support x64.
-	#if defined(_WIN32)
-		x86::Gp stackPtr = x86::rcx;
-	#else
-		x86::Gp stackPtr = x86::rdi;
-	#endif
+	static void jit_storeImmediate(JitContext* ctx, s32 reg, FsValue value)
+	{
+		ctx->as->mov(x86::rax, value);
+		ctx->as->mov(jit_value(reg), x86::rax);
+	}
 
-		x86::Gp retValue = x86::rax;
+	// fsValue_readAsFloat() for plain ints and floats, other types bail out to the interpreter.
+	static void jit_loadAsFloat(JitContext* ctx, s32 reg, const x86::Xmm& dst)
+	{
+		x86::Assembler* as = ctx->as;
+		if (ctx->knownType[reg] == JIT_TYPE_FLOAT)
+		{
+			as->movss(dst, jit_data(reg));
+			return;
+		}
+		// Zero the register first to break the dependency on its previous value.
+		as->xorps(dst, dst);
+		if (ctx->knownType[reg] == JIT_TYPE_INT)
+		{
+			as->cvtsi2ss(dst, jit_data(reg));
+			return;
+		}
 
-		x86::Gp r0 = x86::rbx;
-		x86::Gp r1 = x86::rdx;
-		x86::Gp r0_32 = x86::ebx;
-		x86::Gp r1_32 = x86::edx;
-		x86::Xmm f0 = x86::xmm0;
-		x86::Xmm f1 = x86::xmm1;
+		Label isFloat = as->newLabel();
+		Label done = as->newLabel();
+		as->cmp(jit_tag(reg), c_tagFloat);
+		as->je(isFloat);
+		as->cmp(jit_tag(reg), c_tagInt);
+		as->jne(jit_deoptLabel(ctx));
+		as->cvtsi2ss(dst, jit_data(reg));
+		as->jmp(done);
+		as->bind(isFloat);
+		as->movss(dst, jit_data(reg));
+		as->bind(done);
+	}
 
-		// Save the temporary registers.
-		emit(push(r0));
-		emit(push(r1));
+	// fsValue_readAsInt() for plain ints and floats, other types bail out to the interpreter.
+	static void jit_loadAsInt(JitContext* ctx, s32 reg, const x86::Gp& dst)
+	{
+		x86::Assembler* as = ctx->as;
+		if (ctx->knownType[reg] == JIT_TYPE_INT)
+		{
+			as->mov(dst, jit_data(reg));
+			return;
+		}
+		if (ctx->knownType[reg] == JIT_TYPE_FLOAT)
+		{
+			as->cvttss2si(dst, jit_data(reg));
+			return;
+		}
 
-		Label exitLabel = as.newLabel();
-		Label labels[256];
-		s_labels = labels;
-		s_labelCount = 0;
+		Label isFloat = as->newLabel();
+		Label done = as->newLabel();
+		as->cmp(jit_tag(reg), c_tagInt);
+		as->jne(isFloat);
+		as->mov(dst, jit_data(reg));
+		as->jmp(done);
+		as->bind(isFloat);
+		as->cmp(jit_tag(reg), c_tagFloat);
+		as->jne(jit_deoptLabel(ctx));
+		as->cvttss2si(dst, jit_data(reg));
+		as->bind(done);
+	}
 
-		// First go through and add instructions, noting any labels.
-		s_jitIR.reserve(funcSize * 2);
-		for (s32 i = 0; i < funcSize; i++)
+	// ADD, SUB and MUL: int op int = int, otherwise both values are read as float.
+	// The int path is only emitted if both values can be ints and the float path only if either can be a float.
+	static void jit_dynamicArith(JitContext* ctx, u32 op, s32 a, s32 b, s32 c)
+	{
+		x86::Assembler* as = ctx->as;
+		const u8 typeB = ctx->knownType[b];
+		const u8 typeC = ctx->knownType[c];
+		const bool intOnly = typeB == JIT_TYPE_INT && typeC == JIT_TYPE_INT;
+		const bool floatOnly = typeB == JIT_TYPE_FLOAT || typeC == JIT_TYPE_FLOAT;
+		Label floatPath = as->newLabel();
+		Label done = as->newLabel();
+
+		if (!floatOnly)
 		{
-			Instruction it = func[i];
-			IR_Jit ir = { IRT_INSTR, it, i };
-
-			if (I_OP(it) == FSF_OP_JMP)
+			if (typeB != JIT_TYPE_INT)
 			{
-				s32 offset = I_ARG0(it);
-				// Re-write the instruction to point to the label index.
-				ir.it = I_OP_ARG0(FSF_OP_JMP, s_labelCount);
-
-				// insert a label.
-				s_labels[s_labelCount] = as.newLabel();
-				s_labelTarget[s_labelCount] = offset;
-				s_labelCount++;
+				as->cmp(jit_tag(b), c_tagInt);
+				as->jne(floatPath);
 			}
-			else if (I_OP(it) == FSF_OP_JL)
+			if (typeC != JIT_TYPE_INT)
 			{
-				// TODO
+				as->cmp(jit_tag(c), c_tagInt);
+				as->jne(floatPath);
 			}
+			as->mov(x86::eax, jit_data(b));
+			switch (op)
+			{
+				case FSF_OP_ADD: as->add(x86::eax, jit_data(c)); break;
+				case FSF_OP_SUB: as->sub(x86::eax, jit_data(c)); break;
+				case FSF_OP_MUL: as->imul(x86::eax, jit_data(c)); break;
+			}
+			jit_storeTagged(ctx, a, x86::eax, FST_INT);
+			if (intOnly)
+			{
+				ctx->knownType[a] = JIT_TYPE_INT;
+				return;
+			}
+			as->jmp(done);
+		}
 
-			s_jitIR.push_back(ir);
+		as->bind(floatPath);
+		jit_loadAsFloat(ctx, b, x86::xmm0);
+		jit_loadAsFloat(ctx, c, x86::xmm1);
+		switch (op)
+		{
+			case FSF_OP_ADD: as->addss(x86::xmm0, x86::xmm1); break;
+			case FSF_OP_SUB: as->subss(x86::xmm0, x86::xmm1); break;
+			case FSF_OP_MUL: as->mulss(x86::xmm0, x86::xmm1); break;
 		}
+		as->movd(x86::eax, x86::xmm0);
+		jit_storeTagged(ctx, a, x86::eax, FST_FLOAT);
+		as->bind(done);
+		ctx->knownType[a] = floatOnly ? JIT_TYPE_FLOAT : JIT_TYPE_UNKNOWN;
+	}
+
+	static void jit_intCompare(JitContext* ctx, s32 a, s32 b, s32 c, x86::CondCode cond)
+	{
+		x86::Assembler* as = ctx->as;
+		as->mov(x86::eax, jit_data(b));
+		as->cmp(x86::eax, jit_data(c));
+		as->set(cond, x86::al);
+		as->movzx(x86::eax, x86::al);
+		jit_storeInt(ctx, a, x86::eax);
+	}
 
-		// Then go back and insert labels.
-		for (s32 lidx = 0; lidx < s_labelCount; lidx++)
+	// Unordered (NaN) compares are false, so 'less' is tested as 'greater' with the operands swapped.
+	static void jit_floatCompare(JitContext* ctx, s32 a, s32 b, s32 c, u32 op)
+	{
+		x86::Assembler* as = ctx->as;
+		if (op == FSF_OP_FEQ)
+		{
+			as->movss(x86::xmm0, jit_data(b));
+			as->ucomiss(x86::xmm0, jit_data(c));
+			as->sete(x86::al);
+			as->setnp(x86::cl);
+			as->and_(x86::al, x86::cl);
+		}
+		else
 		{
-			const s32 target = s_labelTarget[lidx];
+			as->movss(x86::xmm0, jit_data(c));
+			as->ucomiss(x86::xmm0, jit_data(b));
+			if (op == FSF_OP_FLT) { as->seta(x86::al); }
+			else { as->setae(x86::al); }
+		}
+		as->movzx(x86::eax, x86::al);
+		jit_storeInt(ctx, a, x86::eax);
+	}
 
-			// Start the loop at the target, since it cannot be found any earlier.
-			const size_t count = s_jitIR.size();
-			const IR_Jit* ir = s_jitIR.data() + target;
-			for (size_t i = target; i < count; i++, ir++)
+	static void jit_intBranch(JitContext* ctx, s32 a, s32 b, s32 target, x86::CondCode cond)
+	{
+		x86::Assembler* as = ctx->as;
+		as->mov(x86::eax, jit_data(a));
+		as->cmp(x86::eax, jit_data(b));
+		as->j(cond, ctx->labels[target]);
+	}
+
+	// The callee registers start at 'firstReg' and may overwrite anything from there on.
+	static void jit_forgetTypes(JitContext* ctx, s32 firstReg)
+	{
+		const size_t count = ctx->knownType.size();
+		for (size_t i = size_t(firstReg); i < count; i++)
+		{
+			ctx->knownType[i] = JIT_TYPE_UNKNOWN;
+		}
+	}
+
+	static bool jit_emitInstr(JitContext* ctx, Instruction instr)
+	{
+		x86::Assembler* as = ctx->as;
+		const u32 op = u32(I_OP(instr));
+		const s32 a = s32(I_ARG0(instr));
+		const s32 b = s32(I_ARG1(instr));
+		const s32 c = s32(I_ARG2(instr));
+		switch (op)
+		{
+			case FSF_OP_NOP:
+			{
+			} break;
+			case FSF_OP_MOVE:
+			{
+				as->mov(x86::rax, jit_value(b));
+				as->mov(jit_value(a), x86::rax);
+				ctx->knownType[a] = ctx->knownType[b];
+			} break;
+			case FSF_OP_LOAD:
+			case FSF_OP_LOADI:
+			{
+				const u32 value = op == FSF_OP_LOAD ? u32(b) : u32(I_ARG12(instr));
+				jit_storeImmediate(ctx, a, fsValue_createInt(s32(value)));
+				ctx->knownType[a] = JIT_TYPE_INT;
+			} break;
+			case FSF_OP_LOADF:
+			{
+				jit_storeImmediate(ctx, a, u64(u32(I_ARG12(instr))) | (u64(FST_FLOAT) << FS_TypeDataShift));
+				ctx->knownType[a] = JIT_TYPE_FLOAT;
+			} break;
+			case FSF_OP_LOADN:
+			{
+				as->mov(jit_value(a), 0);
+				ctx->knownType[a] = JIT_TYPE_UNKNOWN;
+			} break;
+			// Like the interpreter, INC and DEC only change the value and keep the type.
+			case FSF_OP_INC:
+			{
+				as->add(jit_data(a), 1);
+			} break;
+			case FSF_OP_DEC:
+			{
+				as->sub(jit_data(a), 1);
+			} break;
+			// Typed integer ops, the values are used as-is like the interpreter.
+			case FSF_OP_IADD:
+			case FSF_OP_ISUB:
+			case FSF_OP_IMUL:
+			case FSF_OP_IAND:
+			case FSF_OP_IOR:
+			case FSF_OP_IXOR:
+			{
+				as->mov(x86::eax, jit_data(b));
+				switch (op)
+				{
+					case FSF_OP_IADD: as->add(x86::eax, jit_data(c)); break;
+					case FSF_OP_ISUB: as->sub(x86::eax, jit_data(c)); break;
+					case FSF_OP_IMUL: as->imul(x86::eax, jit_data(c)); break;
+					case FSF_OP_IAND: as->and_(x86::eax, jit_data(c)); break;
+					case FSF_OP_IOR:  as->or_(x86::eax, jit_data(c)); break;
+					case FSF_OP_IXOR: as->xor_(x86::eax, jit_data(c)); break;
+				}
+				jit_storeInt(ctx, a, x86::eax);
+			} break;
+			case FSF_OP_IDIV:
+			case FSF_OP_IMOD:
+			{
+				// Division by zero results in zero and INT_MIN / -1 must not fault, see vm_execute().
+				Label zero = as->newLabel();
+				Label negate = as->newLabel();
+				Label store = as->newLabel();
+				as->mov(x86::eax, jit_data(b));
+				as->mov(x86::ecx, jit_data(c));
+				as->test(x86::ecx, x86::ecx);
+				as->jz(zero);
+				as->cmp(x86::ecx, -1);
+				as->je(op == FSF_OP_IDIV ? negate : zero);
+				as->cdq();
+				as->idiv(x86::ecx);
+				if (op == FSF_OP_IMOD) { as->mov(x86::eax, x86::edx); }
+				as->jmp(store);
+				as->bind(negate);
+				as->cmp(x86::eax, INT32_MIN);
+				as->je(zero);
+				as->neg(x86::eax);
+				as->jmp(store);
+				as->bind(zero);
+				as->xor_(x86::eax, x86::eax);
+				as->bind(store);
+				jit_storeInt(ctx, a, x86::eax);
+			} break;
+			case FSF_OP_ISHL:
+			case FSF_OP_ISHR:
+			{
+				// x86 masks the shift count to 5 bits, matching the interpreter.
+				as->mov(x86::ecx, jit_data(c));
+				as->mov(x86::eax, jit_data(b));
+				if (op == FSF_OP_ISHL) { as->shl(x86::eax, x86::cl); }
+				else { as->sar(x86::eax, x86::cl); }
+				jit_storeInt(ctx, a, x86::eax);
+			} break;
+			case FSF_OP_INEG:
+			{
+				as->mov(x86::eax, jit_data(b));
+				as->neg(x86::eax);
+				jit_storeInt(ctx, a, x86::eax);
+			} break;
+			case FSF_OP_IADDI:
+			{
+				as->mov(x86::eax, jit_data(b));
+				as->add(x86::eax, I_SARG2(instr));
+				jit_storeInt(ctx, a, x86::eax);
+			} break;
+			// Typed float ops.
+			case FSF_OP_FADD:
+			case FSF_OP_FSUB:
+			case FSF_OP_FMUL:
+			case FSF_OP_FDIV:
 			{
-				if (ir->index == target)
+				as->movss(x86::xmm0, jit_data(b));
+				switch (op)
 				{
-					// insert the label right *before* the target.
-					IR_Jit label = { IRT_LABEL, Instruction(lidx), -1 };
-					s_jitIR.insert(s_jitIR.begin() + i, label);
-					break;
+					case FSF_OP_FADD: as->addss(x86::xmm0, jit_data(c)); break;
+					case FSF_OP_FSUB: as->subss(x86::xmm0, jit_data(c)); break;
+					case FSF_OP_FMUL: as->mulss(x86::xmm0, jit_data(c)); break;
+					case FSF_OP_FDIV: as->divss(x86::xmm0, jit_data(c)); break;
 				}
+				jit_storeFloat(ctx, a, x86::xmm0);
+			} break;
+			case FSF_OP_FNEG:
+			{
+				as->mov(x86::eax, jit_data(b));
+				as->xor_(x86::eax, 0x80000000u);
+				jit_storeTagged(ctx, a, x86::eax, FST_FLOAT);
+				ctx->knownType[a] = JIT_TYPE_FLOAT;
+			} break;
+			// Dynamically typed ops, specialized with type guards.
+			case FSF_OP_CAST_TO_FLOAT:
+			{
+				jit_loadAsFloat(ctx, b, x86::xmm0);
+				jit_storeFloat(ctx, a, x86::xmm0);
+			} break;
+			case FSF_OP_CAST_TO_INT:
+			{
+				jit_loadAsInt(ctx, b, x86::eax);
+				jit_storeInt(ctx, a, x86::eax);
+			} break;
+			case FSF_OP_ADD:
+			case FSF_OP_SUB:
+			case FSF_OP_MUL:
+			{
+				jit_dynamicArith(ctx, op, a, b, c);
+			} break;
+			case FSF_OP_DIV:
+			{
+				jit_loadAsFloat(ctx, b, x86::xmm0);
+				jit_loadAsFloat(ctx, c, x86::xmm1);
+				as->divss(x86::xmm0, x86::xmm1);
+				jit_storeFloat(ctx, a, x86::xmm0);
+			} break;
+			// Compares.
+			case FSF_OP_IEQ: jit_intCompare(ctx, a, b, c, x86::CondCode::kEqual); break;
+			case FSF_OP_INE: jit_intCompare(ctx, a, b, c, x86::CondCode::kNotEqual); break;
+			case FSF_OP_ILT: jit_intCompare(ctx, a, b, c, x86::CondCode::kSignedLT); break;
+			case FSF_OP_ILE: jit_intCompare(ctx, a, b, c, x86::CondCode::kSignedLE); break;
+			case FSF_OP_FEQ:
+			case FSF_OP_FLT:
+			case FSF_OP_FLE:
+			{
+				jit_floatCompare(ctx, a, b, c, op);
+			} break;
+			// Branches.
+			case FSF_OP_LT:
+			{
+				// Skip the next instruction if the condition is not true.
+				jit_loadAsInt(ctx, a, x86::eax);
+				jit_loadAsInt(ctx, b, x86::ecx);
+				as->cmp(x86::eax, x86::ecx);
+				as->jge(ctx->labels[ctx->ip + 2]);
+			} break;
+			case FSF_OP_JMP:
+			{
+				as->jmp(ctx->labels[a]);
+			} break;
+			case FSF_OP_JZ:
+			case FSF_OP_JNZ:
+			{
+				as->cmp(jit_data(a), 0);
+				if (op == FSF_OP_JZ) { as->je(ctx->labels[b]); }
+				else { as->jne(ctx->labels[b]); }
+			} break;
+			case FSF_OP_JL:  jit_intBranch(ctx, a, b, c, x86::CondCode::kSignedLT); break;
+			case FSF_OP_JLE: jit_intBranch(ctx, a, b, c, x86::CondCode::kSignedLE); break;
+			case FSF_OP_JEQ: jit_intBranch(ctx, a, b, c, x86::CondCode::kEqual); break;
+			case FSF_OP_JNE: jit_intBranch(ctx, a, b, c, x86::CondCode::kNotEqual); break;
+			case FSF_OP_FJL:
+			{
+				// rA < rB is tested as rB > rA so NaN does not branch.
+				as->movss(x86::xmm0, jit_data(b));
+				as->ucomiss(x86::xmm0, jit_data(a));
+				as->ja(ctx->labels[c]);
+			} break;
+			// Calls.
+			case FSF_OP_CALL:
+			{
+				// Script calls go through the VM so the callee can be interpreted, compiled or both.
+				as->mov(c_arg0, c_state);
+				as->mov(c_arg1.r32(), u32(b));
+				as->lea(c_arg2, jit_value(c));
+				as->mov(x86::rax, u64(vm_jitCall));
+				as->call(x86::rax);
+				as->cmp(jit_stateField(offsetof(VmExecState, error)), 0);
+				as->jne(ctx->epilogueLabel);
+				as->mov(jit_value(a), x86::rax);
+				jit_forgetTypes(ctx, c);
+				ctx->knownType[a] = JIT_TYPE_UNKNOWN;
+			} break;
+			case FSF_OP_CALLN:
+			{
+				// The native is looked up at runtime since cached code is shared between modules.
+				as->mov(x86::rax, x86::qword_ptr(c_state, s32(offsetof(VmExecState, module))));
+				as->mov(x86::rax, x86::qword_ptr(x86::rax, s32(offsetof(VmModule, natives))));
+				as->mov(x86::rax, x86::qword_ptr(x86::rax, b * 8));
+				as->lea(c_arg0, jit_value(c));
+				as->call(x86::rax);
+				as->mov(jit_value(a), x86::rax);
+				jit_forgetTypes(ctx, c);
+				ctx->knownType[a] = JIT_TYPE_UNKNOWN;
+			} break;
+			// Fields.
+			case FSF_OP_GETF:
+			{
+				// Anything but a valid struct bails out, the interpreter then reports the error.
+				as->cmp(jit_refTag(b), c_refTagStruct);
+				as->jne(jit_deoptLabel(ctx));
+				as->mov(x86::rax, jit_value(b));
+				as->mov(x86::r10, FS_ValueMask);
+				as->and_(x86::rax, x86::r10);
+				as->jz(jit_deoptLabel(ctx));
+				as->mov(x86::rax, x86::qword_ptr(x86::rax, c * 8));
+				as->mov(jit_value(a), x86::rax);
+				ctx->knownType[a] = JIT_TYPE_UNKNOWN;
+			} break;
+			case FSF_OP_SETF:
+			{
+				as->cmp(jit_refTag(a), c_refTagStruct);
+				as->jne(jit_deoptLabel(ctx));
+				as->mov(x86::rax, jit_value(a));
+				as->mov(x86::r10, FS_ValueMask);
+				as->and_(x86::rax, x86::r10);
+				as->jz(jit_deoptLabel(ctx));
+				as->mov(x86::r11, jit_value(c));
+				as->mov(x86::qword_ptr(x86::rax, b * 8), x86::r11);
+			} break;
+			// Returns.
+			case FSF_OP_RET:
+			{
+				as->mov(x86::rax, jit_value(a));
+				as->jmp(ctx->exitLabel);
+			} break;
+			case FSF_OP_RETN:
+			{
+				as->xor_(x86::eax, x86::eax);
+				as->jmp(ctx->exitLabel);
+			} break;
+			default:
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static void jit_markTargets(JitContext* ctx, const VmFunction* func)
+	{
+		ctx->isTarget.assign(func->size + 1, 0);
+		for (s32 i = 0; i < func->size; i++)
+		{
+			const Instruction instr = func->code[i];
+			switch (I_OP(instr))
+			{
+				case FSF_OP_JMP: ctx->isTarget[I_ARG0(instr)] = 1; break;
+				case FSF_OP_JZ:
+				case FSF_OP_JNZ: ctx->isTarget[I_ARG1(instr)] = 1; break;
+				case FSF_OP_JL:
+				case FSF_OP_JLE:
+				case FSF_OP_JEQ:
+				case FSF_OP_JNE:
+				case FSF_OP_FJL: ctx->isTarget[I_ARG2(instr)] = 1; break;
+				case FSF_OP_LT:  ctx->isTarget[std::min(i + 2, func->size)] = 1; break;
 			}
 		}
-				
-		// Then insert each instruction and label.
-		const size_t count = s_jitIR.size();
-		const IR_Jit* ir = s_jitIR.data();
-		for (size_t i = 0; i < count; i++, ir++)
+	}
+
+	static VmJitFunc jit_generate(const VmFunction* func)
+	{
+		JitErrorHandler errorHandler;
+		CodeHolder code;
+		code.init(s_runtime.environment());
+		code.setErrorHandler(&errorHandler);
+		x86::Assembler as(&code);
+	#ifdef JIT_DEBUG
+		as.addDiagnosticOptions(DiagnosticOptions::kValidateAssembler);
+	#endif
+
+		JitContext ctx;
+		ctx.as = &as;
+		ctx.labels.resize(func->size + 1);
+		ctx.deoptLabels.resize(func->size);
+		ctx.knownType.assign(func->regCount, JIT_TYPE_UNKNOWN);
+		ctx.exitLabel = as.newLabel();
+		ctx.epilogueLabel = as.newLabel();
+		for (s32 i = 0; i <= func->size; i++)
+		{
+			ctx.labels[i] = as.newLabel();
+		}
+		jit_markTargets(&ctx, func);
+
+		// Prologue.
+		as.push(c_regs);
+		as.push(c_state);
+		as.sub(x86::rsp, c_frameSize);
+		as.mov(c_regs, c_arg0);
+		as.mov(c_state, c_arg1);
+
+		for (ctx.ip = 0; ctx.ip < func->size; ctx.ip++)
 		{
-			if (ir->type == IRT_LABEL)
+			as.bind(ctx.labels[ctx.ip]);
+			// Types are only tracked through straight-line code.
+			if (ctx.isTarget[ctx.ip])
 			{
-				as.bind(s_labels[ir->it]);
+				std::fill(ctx.knownType.begin(), ctx.knownType.end(), u8(JIT_TYPE_UNKNOWN));
 			}
-			else // IRT_INSTR
+			if (!jit_emitInstr(&ctx, func->code[ctx.ip]))
 			{
-				switch (I_OP(ir->it))
-				{
-					case FSF_OP_NOP:
-					{
-					} break;
-					case FSF_OP_MOVE:
-					{
-					} break;
-					case FSF_OP_LOAD:
-					{
-						// In x86_64 the only instruction that takes a 64-bit Immediate value is mov reg64, imm
-						// This means that storing 64-bit immediate values into memory takes two instructions.
-						uint64_t imm = fsValue_createInt(I_ARG1(ir->it));
-						emit(mov(x86::dword_ptr(stackPtr, PTR0), imm & 0xffffffffull));
-						emit(mov(x86::dword_ptr(stackPtr, PTR0 + 4), imm >> 32ull));
-					} break;
-					case FSF_OP_INC:
-					{
-						emit(add(x86::dword_ptr(stackPtr, PTR0), 1));
-					} break;
-					case FSF_OP_DEC:
-					{
-						emit(sub(x86::dword_ptr(stackPtr, PTR0), 1));
-					} break;
-					case FSF_OP_IADD:
-					{
-						x86::Mem arg1 = x86::dword_ptr(stackPtr, PTR1);
-						x86::Mem arg2 = x86::dword_ptr(stackPtr, PTR2);
-
-						// Load first argument and add memory value.
-						emit(mov(r0_32, arg1));
-						emit(add(r0_32, arg2));
-
-						// Write the value and type to memory.
-						emit(mov(x86::dword_ptr(stackPtr, PTR0), r0_32));
-						emit(mov(x86::dword_ptr(stackPtr, PTR0 + 4), FST_INT << 16u));
-					} break;
-					case FSF_OP_FADD:
-					{
-						x86::Mem arg1 = x86::dword_ptr(stackPtr, PTR1);
-						x86::Mem arg2 = x86::dword_ptr(stackPtr, PTR2);
-
-						// Load first argument and add memory value.
-						emit(xorps(f0, f0));  // Zero out the floating point register so the upper bits aren't undefined (which can cause problems later).
-						emit(movss(f0, arg1));
-						emit(addss(f0, arg2));
-
-						// Write the value and type to memory.
-						emit(movss(x86::dword_ptr(stackPtr, PTR0), f0));
-						emit(mov(x86::dword_ptr(stackPtr, PTR0 + 4), FST_FLOAT << 16u));
-					} break;
-					case FSF_OP_CAST_TO_FLOAT:
-					{
-						x86::Mem arg1_qw = x86::qword_ptr(stackPtr, PTR1);
-						x86::Mem arg1 = x86::dword_ptr(stackPtr, PTR1);
-
-						loadValueType(ierr, as, r0, arg1_qw);		// r0 = type of arg1.
-						dynamicCastToFloat(ierr, as, r0, f0, arg1); // f0 = float(r0)
-
-						// Save the value and type.
-						emit(movss(x86::dword_ptr(stackPtr, PTR0), f0));
-						emit(mov(x86::dword_ptr(stackPtr, PTR0 + 4), FST_FLOAT << 16u));
-					} break;
-					case FSF_OP_CAST_TO_INT:
-					{
-						// TODO
-					} break;
-					case FSF_OP_ADD:
-					{
-						// TODO
-					} break;
-					case FSF_OP_LT:
-					{
-						// If the next instruction is a jump, combine them here.
-						if ((ir + 1)->type == IRT_INSTR && I_OP((ir + 1)->it) == FSF_OP_JMP)
-						{
-							// Test here.
-							emit(mov(r0_32, x86::dword_ptr(stackPtr, PTR0)));
-							emit(cmp(r0_32, x86::dword_ptr(stackPtr, PTR1)));
-							emit(jl(s_labels[I_ARG0((ir+1)->it)]));
-
-							// Skip past the next instruction.
-							i++;
-							ir++;
-						}
-					} break;
-					case FSF_OP_JMP:
-					{
-						emit(jmp(s_labels[I_ARG0(ir->it)]));
-					} break;
-					case FSF_OP_JL:
-					{
-					} break;
-					case FSF_OP_RET:
-					{
-						x86::Mem arg0 = x86::qword_ptr(stackPtr, PTR0);
-						emit(mov(retValue, arg0));
-						emit(jmp(exitLabel));
-					} break;
-				}
+				TFE_System::logWrite(LOG_ERROR, "ForceScript", "JIT: unsupported opcode %u.", u32(I_OP(func->code[ctx.ip])));
+				return nullptr;
 			}
 		}
+		// Guard for the label past the last instruction, that an LT skip may target. vm_validateFunc() rejects such an LT,
+		// so this is never reached and traps instead of returning a made up value.
+		as.bind(ctx.labels[func->size]);
+		as.ud2();
+
+		as.bind(ctx.exitLabel);
+		as.mov(jit_stateField(offsetof(VmExecState, deoptIp)), -1);
+		as.bind(ctx.epilogueLabel);
+		as.add(x86::rsp, c_frameSize);
+		as.pop(c_state);
+		as.pop(c_regs);
+		as.ret();
+
+		// Bail out stubs, the interpreter resumes at the instruction that failed its type guard.
+		// All values live in the register window, so nothing else needs to be written back.
+		for (s32 i = 0; i < func->size; i++)
+		{
+			if (!ctx.deoptLabels[i].isValid()) { continue; }
+			as.bind(ctx.deoptLabels[i]);
+			as.mov(jit_stateField(offsetof(VmExecState, deoptIp)), i);
+			as.jmp(ctx.epilogueLabel);
+		}
 
-		emit(bind(exitLabel));
-		// Restore the temporary registers.
-		emit(pop(r1));
-		emit(pop(r0));
-		// Return from our function.
-		emit(ret());
-
-		ScriptJitFunc fn;
-		Error err = s_runtime.add(&fn, &code);
-		if (err)
+		if (errorHandler.error != kErrorOk)
 		{
 			return nullptr;
 		}
-		s_jitFuncs[funcName] = fn;
-		s_jitFuncList.push_back(fn);
+		VmJitFunc fn;
+		if (s_runtime.add(&fn, &code) != kErrorOk)
+		{
+			return nullptr;
+		}
+		return fn;
+	}
+
+	static u64 jit_hash(const Instruction* code, s32 size)
+	{
+		// FNV-1a
+		u64 hash = 14695981039346656037ull;
+		const u8* data = (const u8*)code;
+		const size_t byteCount = size_t(size) * sizeof(Instruction);
+		for (size_t i = 0; i < byteCount; i++)
+		{
+			hash = (hash ^ data[i]) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	VmJitFunc jit_compileFunc(const VmFunction* func)
+	{
+		const u64 hash = jit_hash(func->code, func->size);
+		const size_t count = s_jitCache.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			const JitCacheEntry& entry = s_jitCache[i];
+			if (entry.hash == hash && entry.code.size() == size_t(func->size) &&
+				memcmp(entry.code.data(), func->code, sizeof(Instruction) * func->size) == 0)
+			{
+				return entry.func;
+			}
+		}
+
+		VmJitFunc fn = jit_generate(func);
+		if (fn)
+		{
+			JitCacheEntry entry;
+			entry.hash = hash;
+			entry.code.assign(func->code, func->code + func->size);
+			entry.func = fn;
+			s_jitCache.push_back(entry);
+		}
 		return fn;
 	}
 }
-#endif
\ No newline at end of file
+#endif
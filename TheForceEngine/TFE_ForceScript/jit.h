@@ -1,21 +1,29 @@
 #pragma once
 //////////////////////////////////////////////////////////////////////
+// ForceScript JIT
+// Compiles register VM functions (see vm.h) to x64 code. The values
+// stay in the register window in memory, so the interpreter can take
+// over at any instruction: operations on dynamically typed values are
+// specialized for int and float and bail out to the interpreter
+// ("deoptimize") when a type guard fails.
 //////////////////////////////////////////////////////////////////////
 #include "vmConfig.h"
 
-#ifdef VM_ENABLE
+#if defined(VM_ENABLE) && defined(VM_JIT_ENABLE)
 #include <TFE_System/types.h>
 #include "value.h"
 #include "vmOps.h"
+#include "vm.h"
 
 namespace TFE_ForceScript
 {
-	typedef FsValue(*ScriptJitFunc)(FsValue*);
-
 	bool jit_init();
+	// Releases all compiled code, VmFuncTier::jitFunc pointers are no longer valid afterward.
 	void jit_destroy();
 
-	ScriptJitFunc jit_getScriptFunc(const char* funcName);
-	ScriptJitFunc jit_compileScriptFunc(const char* funcName, Instruction* func, s32 funcSize);
+	// Compiles a function that has passed vm_validateFunc(), returns null if it cannot be compiled.
+	// Compiled code is cached by the instructions, so identical functions (or reloaded modules) are only compiled once.
+	VmJitFunc jit_compileFunc(const VmFunction* func);
+	s32 jit_getCachedFuncCount();
 }
-#endif
\ No newline at end of file
+#endif
@@ -79,6 +79,13 @@ namespace TFE_ForceScript
 		return u64(*((u32*)&f)) | (valueData << FS_TypeDataShift);
 	}
 
+	// Structs are referenced by pointer, the fields are stored as an array of values.
+	inline FsValue fsValue_createStruct(FsValue* fields)
+	{
+		u64 valueData = FST_STRUCT;
+		return (u64(fields) & FS_ValueMask) | (valueData << FS_TypeDataShift) | (u64(FSF_REF) << 56ull);
+	}
+
 	inline s32 fsValue_readAsInt(const FsValue* const v)
 	{
 		const FS_Type type = fsValue_getType(*v);
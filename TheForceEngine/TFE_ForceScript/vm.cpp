@@ -1,3 +1,4 @@
+#include <cstring>
 #include "vmConfig.h"
 
 #ifdef VM_ENABLE
@@ -37,6 +38,7 @@ namespace TFE_ForceScript
 	{
 		for (s32 i = 0; i < funcSize; i++)
 		{
+			assert(I_OP(func[i]) < FSF_OP_LEGACY_COUNT);
 			s_funcOpt[i].func  = s_vmOpCalls[I_OP(func[i])];
 			s_funcOpt[i].instr = func[i];
 		}
@@ -60,6 +62,611 @@ namespace TFE_ForceScript
 		return s_retValue;
 	}
 
+	//////////////////////////////////////////////////
+	// Register VM
+	// The VM state is kept in locals so the compiler can keep it in registers. GCC and Clang dispatch with computed
+	// goto (one indirect jump per opcode), other compilers use a switch which compiles to a jump table.
+	// With the JIT enabled, functions that are called often are compiled (see jit.h). Compiled code uses the same
+	// register window, so when it bails out the interpreter continues from the same instruction.
+	//////////////////////////////////////////////////
+	enum VmLimits
+	{
+		VM_MAX_CALL_DEPTH = 256,
+		VM_JIT_THRESHOLD = 16,		// Calls before a function is compiled.
+		VM_JIT_MAX_DEOPTS = 64,		// Bail outs before a function goes back to the interpreter for good.
+	};
+
+	struct VmFrame
+	{
+		const VmFunction* func;
+		FsValue* regs;
+		s32 ip;
+		s32 retReg;		// Register in the caller that receives the return value.
+	};
+
+	static bool vm_validateInstr(const VmModule* module, const VmFunction* func, s32 index)
+	{
+		const Instruction instr = func->code[index];
+		const u32 op = u32(I_OP(instr));
+		const u32 regCount = u32(func->regCount);
+		const u32 size = u32(func->size);
+		const u32 a = u32(I_ARG0(instr)), b = u32(I_ARG1(instr)), c = u32(I_ARG2(instr));
+		switch (op)
+		{
+			case FSF_OP_NOP:
+			case FSF_OP_ADD:
+				return true;
+			case FSF_OP_LOAD:
+			case FSF_OP_LOADF:
+			case FSF_OP_LOADI:
+			case FSF_OP_LOADN:
+			case FSF_OP_INC:
+			case FSF_OP_DEC:
+			case FSF_OP_RET:
+				return a < regCount;
+			case FSF_OP_RETN:
+				return true;
+			case FSF_OP_MOVE:
+			case FSF_OP_CAST_TO_FLOAT:
+			case FSF_OP_CAST_TO_INT:
+			case FSF_OP_INEG:
+			case FSF_OP_FNEG:
+			case FSF_OP_IADDI:
+				return a < regCount && b < regCount;
+			case FSF_OP_LT:
+				// Skipping the next instruction must not run past the end of the function.
+				return a < regCount && b < regCount && u32(index) + 2u < size;
+			case FSF_OP_JMP:
+				return a < size;
+			case FSF_OP_JZ:
+			case FSF_OP_JNZ:
+				return a < regCount && b < size;
+			case FSF_OP_JL:
+			case FSF_OP_JLE:
+			case FSF_OP_JEQ:
+			case FSF_OP_JNE:
+			case FSF_OP_FJL:
+				return a < regCount && b < regCount && c < size;
+			case FSF_OP_CALL:
+				return a < regCount && b < u32(module->funcCount) && c < regCount;
+			case FSF_OP_CALLN:
+				return a < regCount && b < u32(module->nativeCount) && c < regCount;
+			case FSF_OP_GETF:
+				return a < regCount && b < regCount;
+			case FSF_OP_SETF:
+				return a < regCount && c < regCount;
+			default:
+				// Three register opcodes.
+				return op < FSF_OP_COUNT && a < regCount && b < regCount && c < regCount;
+		}
+	}
+
+	bool vm_validateFunc(const VmModule* module, s32 funcIndex)
+	{
+		if (funcIndex < 0 || funcIndex >= module->funcCount) { return false; }
+		const VmFunction* func = &module->funcs[funcIndex];
+		if (func->size <= 0 || func->regCount <= 0) { return false; }
+
+		for (s32 i = 0; i < func->size; i++)
+		{
+			if (!vm_validateInstr(module, func, i))
+			{
+				TFE_System::logWrite(LOG_ERROR, "ForceScript", "Invalid instruction %d (opcode %u) in function %d.", i, u32(I_OP(func->code[i])), funcIndex);
+				return false;
+			}
+		}
+		// Execution must not run past the end of the function.
+		const u32 lastOp = u32(I_OP(func->code[func->size - 1]));
+		if (lastOp != FSF_OP_RET && lastOp != FSF_OP_RETN && lastOp != FSF_OP_JMP)
+		{
+			TFE_System::logWrite(LOG_ERROR, "ForceScript", "Function %d does not end with a return or jump.", funcIndex);
+			return false;
+		}
+		return true;
+	}
+
+	static inline bool vm_isInt(FsValue v)
+	{
+		return fsValue_getType(v) == FST_INT && !fsValue_getTypeMod(v);
+	}
+
+	// Struct values are always references, see fsValue_createStruct().
+	static inline FsValue* vm_getStructFields(FsValue v)
+	{
+		if (fsValue_getValueData(v) != (u64(FST_STRUCT) | (u64(FSF_REF) << 8ull))) { return nullptr; }
+		return (FsValue*)fsValue_getVoidPointer(v);
+	}
+
+#if defined(__GNUC__) || defined(__clang__)
+	#define VM_COMPUTED_GOTO 1
+#endif
+
+	static bool vm_checkCall(VmExecState* state, const VmFunction* callee, FsValue* calleeRegs, s32 funcIndex)
+	{
+		if (state->depth >= VM_MAX_CALL_DEPTH || calleeRegs + callee->regCount > state->stackEnd)
+		{
+			TFE_System::logWrite(LOG_ERROR, "ForceScript", "Stack overflow calling function %d.", funcIndex);
+			state->error = 1;
+			return false;
+		}
+		return true;
+	}
+
+#ifdef VM_JIT_ENABLE
+	// Returns the compiled function, compiling it once it has been called often enough.
+	static VmJitFunc vm_getJitFunc(const VmModule* module, s32 funcIndex)
+	{
+		if (!module->tiers) { return nullptr; }
+		VmFuncTier* tier = &module->tiers[funcIndex];
+		if (tier->jitFunc || tier->jitDisabled || ++tier->callCount < VM_JIT_THRESHOLD)
+		{
+			return tier->jitFunc;
+		}
+		tier->jitFunc = jit_compileFunc(&module->funcs[funcIndex]);
+		tier->jitDisabled = !tier->jitFunc;
+		return tier->jitFunc;
+	}
+
+	// Returns false if the compiled code bailed out, the interpreter must then continue from state->deoptIp.
+	static bool vm_runJit(VmExecState* state, s32 funcIndex, VmJitFunc jitFunc, FsValue* regs, FsValue* result)
+	{
+		state->deoptIp = -1;
+		state->depth++;
+		*result = jitFunc(regs, state);
+		state->depth--;
+		if (state->error || state->deoptIp < 0) { return true; }
+
+		// A type guard keeps failing, stop paying for the bail out.
+		VmFuncTier* tier = &state->module->tiers[funcIndex];
+		tier->deoptCount++;
+		if (tier->deoptCount >= VM_JIT_MAX_DEOPTS)
+		{
+			tier->jitFunc = nullptr;
+			tier->jitDisabled = true;
+		}
+		return false;
+	}
+#endif
+
+	// Interprets the function from 'ip' until it returns, calls push frames onto state->frames.
+	static FsValue vm_run(VmExecState* state, s32 funcIndex, FsValue* regs, s32 ip)
+	{
+		const VmModule* module = state->module;
+		VmFrame* frames = state->frames;
+		const s32 baseDepth = state->depth;
+		const VmFunction* func = &module->funcs[funcIndex];
+		const Instruction* code = func->code;
+		Instruction instr;
+		FsValue retValue;
+
+		#define R(n)  regs[n]
+		#define RI(n) (*fsValue_getIntPtr(regs[n]))
+		#define RF(n) (*fsValue_getFloatPtr(regs[n]))
+		#define A  I_ARG0(instr)
+		#define B  I_ARG1(instr)
+		#define C  I_ARG2(instr)
+
+	#ifdef VM_COMPUTED_GOTO
+		// Must match the OpCode order.
+		static const void* const c_dispatch[] =
+		{
+			&&op_nop, &&op_move, &&op_load, &&op_inc, &&op_dec, &&op_iadd, &&op_fadd, &&op_castToFloat, &&op_castToInt, &&op_add,
+			&&op_lt, &&op_jmp, &&op_jl, &&op_ret,
+			&&op_loadf, &&op_loadi, &&op_loadn,
+			&&op_isub, &&op_imul, &&op_idiv, &&op_imod, &&op_iand, &&op_ior, &&op_ixor, &&op_ishl, &&op_ishr, &&op_ineg, &&op_iaddi,
+			&&op_fsub, &&op_fmul, &&op_fdiv, &&op_fneg,
+			&&op_sub, &&op_mul, &&op_div,
+			&&op_ieq, &&op_ine, &&op_ilt, &&op_ile, &&op_feq, &&op_flt, &&op_fle,
+			&&op_jz, &&op_jnz, &&op_jle, &&op_jeq, &&op_jne, &&op_fjl,
+			&&op_call, &&op_calln,
+			&&op_getf, &&op_setf,
+			&&op_retn,
+		};
+		static_assert(TFE_ARRAYSIZE(c_dispatch) == FSF_OP_COUNT, "The dispatch table does not match the opcodes.");
+
+		#define VM_OP(op, label) label:
+		#define VM_NEXT() instr = code[ip++]; goto *c_dispatch[I_OP(instr)]
+		VM_NEXT();
+	#else
+		#define VM_OP(op, label) case op:
+		#define VM_NEXT() goto vm_dispatch
+	vm_dispatch:
+		instr = code[ip++];
+		switch (I_OP(instr))
+		{
+	#endif
+		VM_OP(FSF_OP_NOP, op_nop)
+		{
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_MOVE, op_move)
+		{
+			R(A) = R(B);
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_LOAD, op_load)
+		{
+			R(A) = fsValue_createInt(s32(B));
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_INC, op_inc)
+		{
+			RI(A) = s32(u32(RI(A)) + 1u);
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_DEC, op_dec)
+		{
+			RI(A) = s32(u32(RI(A)) - 1u);
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_IADD, op_iadd)
+		{
+			R(A) = fsValue_createInt(s32(u32(RI(B)) + u32(RI(C))));
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_FADD, op_fadd)
+		{
+			R(A) = fsValue_createFloat(RF(B) + RF(C));
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_CAST_TO_FLOAT, op_castToFloat)
+		{
+			R(A) = fsValue_createFloat(fsValue_readAsFloat(&R(B)));
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_CAST_TO_INT, op_castToInt)
+		{
+			R(A) = fsValue_createInt(fsValue_readAsInt(&R(B)));
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_ADD, op_add)
+		{
+			if (vm_isInt(R(B)) && vm_isInt(R(C))) { R(A) = fsValue_createInt(s32(u32(RI(B)) + u32(RI(C)))); }
+			else { R(A) = fsValue_createFloat(fsValue_readAsFloat(&R(B)) + fsValue_readAsFloat(&R(C))); }
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_LT, op_lt)
+		{
+			// Skip the next instruction if the condition is not true.
+			if (!(fsValue_readAsInt(&R(A)) < fsValue_readAsInt(&R(B)))) { ip++; }
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_JMP, op_jmp)
+		{
+			ip = s32(A);
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_JL, op_jl)
+		{
+			if (RI(A) < RI(B)) { ip = s32(C); }
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_RET, op_ret)
+		{
+			retValue = R(A);
+			goto vm_return;
+		}
+		VM_OP(FSF_OP_LOADF, op_loadf)
+		{
+			R(A) = u64(u32(I_ARG12(instr))) | (u64(FST_FLOAT) << FS_TypeDataShift);
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_LOADI, op_loadi)
+		{
+			R(A) = fsValue_createInt(s32(u32(I_ARG12(instr))));
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_LOADN, op_loadn)
+		{
+			R(A) = fsValue_createNull();
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_ISUB, op_isub)
+		{
+			R(A) = fsValue_createInt(s32(u32(RI(B)) - u32(RI(C))));
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_IMUL, op_imul)
+		{
+			R(A) = fsValue_createInt(s32(u32(RI(B)) * u32(RI(C))));
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_IDIV, op_idiv)
+		{
+			const s32 divisor = RI(C);
+			R(A) = fsValue_createInt((divisor == 0 || (divisor == -1 && RI(B) == INT32_MIN)) ? 0 : RI(B) / divisor);
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_IMOD, op_imod)
+		{
+			const s32 divisor = RI(C);
+			R(A) = fsValue_createInt((divisor == 0 || divisor == -1) ? 0 : RI(B) % divisor);
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_IAND, op_iand)
+		{
+			R(A) = fsValue_createInt(RI(B) & RI(C));
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_IOR, op_ior)
+		{
+			R(A) = fsValue_createInt(RI(B) | RI(C));
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_IXOR, op_ixor)
+		{
+			R(A) = fsValue_createInt(RI(B) ^ RI(C));
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_ISHL, op_ishl)
+		{
+			R(A) = fsValue_createInt(s32(u32(RI(B)) << (RI(C) & 31)));
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_ISHR, op_ishr)
+		{
+			R(A) = fsValue_createInt(RI(B) >> (RI(C) & 31));
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_INEG, op_ineg)
+		{
+			R(A) = fsValue_createInt(s32(0u - u32(RI(B))));
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_IADDI, op_iaddi)
+		{
+			R(A) = fsValue_createInt(s32(u32(RI(B)) + u32(I_SARG2(instr))));
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_FSUB, op_fsub)
+		{
+			R(A) = fsValue_createFloat(RF(B) - RF(C));
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_FMUL, op_fmul)
+		{
+			R(A) = fsValue_createFloat(RF(B) * RF(C));
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_FDIV, op_fdiv)
+		{
+			R(A) = fsValue_createFloat(RF(B) / RF(C));
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_FNEG, op_fneg)
+		{
+			R(A) = fsValue_createFloat(-RF(B));
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_SUB, op_sub)
+		{
+			if (vm_isInt(R(B)) && vm_isInt(R(C))) { R(A) = fsValue_createInt(s32(u32(RI(B)) - u32(RI(C)))); }
+			else { R(A) = fsValue_createFloat(fsValue_readAsFloat(&R(B)) - fsValue_readAsFloat(&R(C))); }
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_MUL, op_mul)
+		{
+			if (vm_isInt(R(B)) && vm_isInt(R(C))) { R(A) = fsValue_createInt(s32(u32(RI(B)) * u32(RI(C)))); }
+			else { R(A) = fsValue_createFloat(fsValue_readAsFloat(&R(B)) * fsValue_readAsFloat(&R(C))); }
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_DIV, op_div)
+		{
+			// Division always produces a float, so 1 / 2 = 0.5.
+			R(A) = fsValue_createFloat(fsValue_readAsFloat(&R(B)) / fsValue_readAsFloat(&R(C)));
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_IEQ, op_ieq)
+		{
+			R(A) = fsValue_createInt(RI(B) == RI(C) ? 1 : 0);
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_INE, op_ine)
+		{
+			R(A) = fsValue_createInt(RI(B) != RI(C) ? 1 : 0);
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_ILT, op_ilt)
+		{
+			R(A) = fsValue_createInt(RI(B) < RI(C) ? 1 : 0);
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_ILE, op_ile)
+		{
+			R(A) = fsValue_createInt(RI(B) <= RI(C) ? 1 : 0);
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_FEQ, op_feq)
+		{
+			R(A) = fsValue_createInt(RF(B) == RF(C) ? 1 : 0);
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_FLT, op_flt)
+		{
+			R(A) = fsValue_createInt(RF(B) < RF(C) ? 1 : 0);
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_FLE, op_fle)
+		{
+			R(A) = fsValue_createInt(RF(B) <= RF(C) ? 1 : 0);
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_JZ, op_jz)
+		{
+			if (RI(A) == 0) { ip = s32(B); }
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_JNZ, op_jnz)
+		{
+			if (RI(A) != 0) { ip = s32(B); }
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_JLE, op_jle)
+		{
+			if (RI(A) <= RI(B)) { ip = s32(C); }
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_JEQ, op_jeq)
+		{
+			if (RI(A) == RI(B)) { ip = s32(C); }
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_JNE, op_jne)
+		{
+			if (RI(A) != RI(B)) { ip = s32(C); }
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_FJL, op_fjl)
+		{
+			if (RF(A) < RF(B)) { ip = s32(C); }
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_CALL, op_call)
+		{
+			const VmFunction* callee = &module->funcs[B];
+			FsValue* calleeRegs = regs + C;
+			if (!vm_checkCall(state, callee, calleeRegs, s32(B)))
+			{
+				return fsValue_createNull();
+			}
+			s32 calleeIp = 0;
+		#ifdef VM_JIT_ENABLE
+			const VmJitFunc jitFunc = vm_getJitFunc(module, s32(B));
+			if (jitFunc)
+			{
+				FsValue result;
+				if (vm_runJit(state, s32(B), jitFunc, calleeRegs, &result))
+				{
+					if (state->error) { return fsValue_createNull(); }
+					R(A) = result;
+					VM_NEXT();
+				}
+				calleeIp = state->deoptIp;
+				state->deoptIp = -1;
+			}
+		#endif
+			VmFrame* frame = &frames[state->depth];
+			frame->func = func;
+			frame->regs = regs;
+			frame->ip = ip;
+			frame->retReg = s32(A);
+			state->depth++;
+
+			func = callee;
+			code = callee->code;
+			regs = calleeRegs;
+			ip = calleeIp;
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_CALLN, op_calln)
+		{
+			R(A) = module->natives[B](&R(C));
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_GETF, op_getf)
+		{
+			const FsValue* fields = vm_getStructFields(R(B));
+			if (!fields)
+			{
+				TFE_System::logWrite(LOG_ERROR, "ForceScript", "GETF on a value that is not a struct.");
+				state->error = 1;
+				return fsValue_createNull();
+			}
+			R(A) = fields[C];
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_SETF, op_setf)
+		{
+			FsValue* fields = vm_getStructFields(R(A));
+			if (!fields)
+			{
+				TFE_System::logWrite(LOG_ERROR, "ForceScript", "SETF on a value that is not a struct.");
+				state->error = 1;
+				return fsValue_createNull();
+			}
+			fields[B] = R(C);
+			VM_NEXT();
+		}
+		VM_OP(FSF_OP_RETN, op_retn)
+		{
+			retValue = fsValue_createNull();
+			goto vm_return;
+		}
+	#ifndef VM_COMPUTED_GOTO
+			default:
+				// Invalid opcodes are rejected by vm_validateFunc().
+				return fsValue_createNull();
+		}
+	#endif
+
+	vm_return:
+		if (state->depth == baseDepth)
+		{
+			return retValue;
+		}
+		state->depth--;
+		func = frames[state->depth].func;
+		code = func->code;
+		regs = frames[state->depth].regs;
+		ip = frames[state->depth].ip;
+		R(frames[state->depth].retReg) = retValue;
+		VM_NEXT();
+
+		#undef R
+		#undef RI
+		#undef RF
+		#undef A
+		#undef B
+		#undef C
+		#undef VM_OP
+		#undef VM_NEXT
+	}
+
+	static FsValue vm_callFunc(VmExecState* state, s32 funcIndex, FsValue* regs)
+	{
+		s32 ip = 0;
+	#ifdef VM_JIT_ENABLE
+		const VmJitFunc jitFunc = vm_getJitFunc(state->module, funcIndex);
+		if (jitFunc)
+		{
+			FsValue result;
+			if (vm_runJit(state, funcIndex, jitFunc, regs, &result))
+			{
+				return result;
+			}
+			ip = state->deoptIp;
+			state->deoptIp = -1;
+		}
+	#endif
+		return vm_run(state, funcIndex, regs, ip);
+	}
+
+	FsValue vm_jitCall(VmExecState* state, s32 funcIndex, FsValue* regs)
+	{
+		if (!vm_checkCall(state, &state->module->funcs[funcIndex], regs, funcIndex))
+		{
+			return fsValue_createNull();
+		}
+		return vm_callFunc(state, funcIndex, regs);
+	}
+
+	FsValue vm_execute(const VmModule* module, s32 funcIndex, FsValue* stack, s32 stackSize)
+	{
+		if (module->funcs[funcIndex].regCount > stackSize) { return fsValue_createNull(); }
+
+		VmFrame frames[VM_MAX_CALL_DEPTH];
+		VmExecState state;
+		state.module = module;
+		state.stackEnd = stack + stackSize;
+		state.frames = frames;
+		state.depth = 0;
+		state.deoptIp = -1;
+		state.error = 0;
+
+		const FsValue result = vm_callFunc(&state, funcIndex, stack);
+		return state.error ? fsValue_createNull() : result;
+	}
+
 	f32 cversion(s32 arg0, s32 arg1, f32 arg2)
 	{
 		s32 r3i = arg0 + arg1;
@@ -88,22 +695,243 @@ namespace TFE_ForceScript
 		return *fsValue_getFloatPtr(s_retValue);
 	}
 
+	//////////////////////////////////////////////////
+	// Benchmarks
+	// Each program is run by every implementation that supports it: the function table dispatcher (legacy opcodes only),
+	// the register VM, the register VM with the JIT tier and the equivalent C code.
+	//////////////////////////////////////////////////
+	enum BenchImpl
+	{
+		BENCH_LEGACY = 0,
+		BENCH_VM,
+		BENCH_JIT,
+		BENCH_C,
+		BENCH_IMPL_COUNT
+	};
+	static const char* c_benchImplNames[BENCH_IMPL_COUNT] = { "Legacy", "VM", "JIT", "C" };
+
+	enum BenchFuncs
+	{
+		BENCH_FUNC_FLOAT_LOOP = 0,
+		BENCH_FUNC_INT_LOOP,
+		BENCH_FUNC_FIB,
+		BENCH_FUNC_FIELDS,
+		BENCH_FUNC_DYNAMIC,
+		BENCH_FUNC_COUNT
+	};
+
+	struct BenchContext
+	{
+		const VmModule* module;
+		const VmModule* jitModule;	// Same functions with the JIT tier enabled.
+		s32 legacySize;
+		FsValue fields[3];
+		FsValue stack[256];
+	};
+	typedef FsValue(*BenchRunFunc)(BenchContext* context);
+
+	static u32 floatBits(f32 value)
+	{
+		return *((u32*)&value);
+	}
+
+	static FsValue benchExecute(BenchContext* context, const VmModule* module, s32 funcIndex)
+	{
+		return vm_execute(module, funcIndex, context->stack, TFE_ARRAYSIZE(context->stack));
+	}
+
+	// Float loop: the original test function.
+	static void benchFloatLoopSetup(BenchContext* context)
+	{
+		context->stack[0] = fsValue_createInt(-237);
+		context->stack[1] = fsValue_createInt(101);
+		context->stack[2] = fsValue_createFloat(37.2f);
+	}
+	static FsValue benchFloatLoopLegacy(BenchContext* context)
+	{
+		benchFloatLoopSetup(context);
+		return callFunc(s_funcOpt, context->legacySize, context->stack);
+	}
+	static FsValue benchFloatLoopVm(BenchContext* context)
+	{
+		benchFloatLoopSetup(context);
+		return benchExecute(context, context->module, BENCH_FUNC_FLOAT_LOOP);
+	}
+	static FsValue benchFloatLoopJit(BenchContext* context)
+	{
+		benchFloatLoopSetup(context);
+		return benchExecute(context, context->jitModule, BENCH_FUNC_FLOAT_LOOP);
+	}
+	static FsValue benchFloatLoopC(BenchContext* context)
+	{
+		return fsValue_createFloat(cversion(-237, 101, 37.2f));
+	}
+
+	// Integer loop: sum of (i * i) ^ i for i in [0, 10000).
+	static FsValue benchIntLoopVm(BenchContext* context)
+	{
+		context->stack[0] = fsValue_createInt(10000);
+		return benchExecute(context, context->module, BENCH_FUNC_INT_LOOP);
+	}
+	static FsValue benchIntLoopJit(BenchContext* context)
+	{
+		context->stack[0] = fsValue_createInt(10000);
+		return benchExecute(context, context->jitModule, BENCH_FUNC_INT_LOOP);
+	}
+	static FsValue benchIntLoopC(BenchContext* context)
+	{
+		u32 sum = 0;
+		for (u32 i = 0; i < 10000; i++)
+		{
+			sum += (i * i) ^ i;
+		}
+		return fsValue_createInt(s32(sum));
+	}
+
+	// Recursive calls: fib(20).
+	static s32 fibC(s32 n)
+	{
+		return n < 2 ? n : fibC(n - 1) + fibC(n - 2);
+	}
+	static FsValue benchFibVm(BenchContext* context)
+	{
+		context->stack[0] = fsValue_createInt(20);
+		return benchExecute(context, context->module, BENCH_FUNC_FIB);
+	}
+	static FsValue benchFibJit(BenchContext* context)
+	{
+		context->stack[0] = fsValue_createInt(20);
+		return benchExecute(context, context->jitModule, BENCH_FUNC_FIB);
+	}
+	static FsValue benchFibC(BenchContext* context)
+	{
+		return fsValue_createInt(fibC(20));
+	}
+
+	// Field access: x += y * z; y += 0.5, 1000 times.
+	static void benchFieldsSetup(BenchContext* context)
+	{
+		context->fields[0] = fsValue_createFloat(1.0f);
+		context->fields[1] = fsValue_createFloat(0.25f);
+		context->fields[2] = fsValue_createFloat(0.001f);
+		context->stack[0] = fsValue_createStruct(context->fields);
+		context->stack[1] = fsValue_createInt(1000);
+	}
+	static FsValue benchFieldsVm(BenchContext* context)
+	{
+		benchFieldsSetup(context);
+		return benchExecute(context, context->module, BENCH_FUNC_FIELDS);
+	}
+	static FsValue benchFieldsJit(BenchContext* context)
+	{
+		benchFieldsSetup(context);
+		return benchExecute(context, context->jitModule, BENCH_FUNC_FIELDS);
+	}
+	static FsValue benchFieldsC(BenchContext* context)
+	{
+		f32 x = 1.0f, y = 0.25f;
+		const f32 z = 0.001f;
+		for (s32 i = 0; i < 1000; i++)
+		{
+			x = x + y * z;
+			y = y + 0.5f;
+		}
+		return fsValue_createFloat(x);
+	}
+
+	// Dynamic types: sum of i * 3 - bias for i in [0, 1000), then int(sum / 1000).
+	// With an int bias everything stays int, a null bias is read as 0.0 so the sum becomes a float and the JIT bails out.
+	static void benchDynamicSetup(BenchContext* context, FsValue bias)
+	{
+		context->stack[0] = fsValue_createInt(1000);
+		context->stack[1] = bias;
+	}
+	static FsValue benchDynamicIntVm(BenchContext* context)
+	{
+		benchDynamicSetup(context, fsValue_createInt(1));
+		return benchExecute(context, context->module, BENCH_FUNC_DYNAMIC);
+	}
+	static FsValue benchDynamicIntJit(BenchContext* context)
+	{
+		benchDynamicSetup(context, fsValue_createInt(1));
+		return benchExecute(context, context->jitModule, BENCH_FUNC_DYNAMIC);
+	}
+	static FsValue benchDynamicIntC(BenchContext* context)
+	{
+		s32 sum = 0;
+		for (s32 i = 0; i < 1000; i++)
+		{
+			sum += i * 3 - 1;
+		}
+		return fsValue_createInt(s32(f32(sum) / 1000.0f));
+	}
+	static FsValue benchDynamicNullVm(BenchContext* context)
+	{
+		benchDynamicSetup(context, fsValue_createNull());
+		return benchExecute(context, context->module, BENCH_FUNC_DYNAMIC);
+	}
+	static FsValue benchDynamicNullJit(BenchContext* context)
+	{
+		benchDynamicSetup(context, fsValue_createNull());
+		return benchExecute(context, context->jitModule, BENCH_FUNC_DYNAMIC);
+	}
+	static FsValue benchDynamicNullC(BenchContext* context)
+	{
+		f32 sum = 0.0f;
+		for (s32 i = 0; i < 1000; i++)
+		{
+			sum += f32(i * 3) - 0.0f;
+		}
+		return fsValue_createInt(s32(sum / 1000.0f));
+	}
+
+	static void benchRun(const char* name, BenchContext* context, const BenchRunFunc* runFuncs, s32 iterations)
+	{
+		char results[BENCH_IMPL_COUNT][256];
+		f64 timeMs[BENCH_IMPL_COUNT] = { 0 };
+		FsValue retValue[BENCH_IMPL_COUNT];
+		for (s32 impl = 0; impl < BENCH_IMPL_COUNT; impl++)
+		{
+			strcpy(results[impl], "-");
+			if (!runFuncs[impl]) { continue; }
+
+			const u64 start = TFE_System::getCurrentTimeInTicks();
+			for (s32 i = 0; i < iterations; i++)
+			{
+				retValue[impl] = runFuncs[impl](context);
+			}
+			const u64 dt = TFE_System::getCurrentTimeInTicks() - start;
+			timeMs[impl] = TFE_System::convertFromTicksToSeconds(dt) * 1000.0 / f64(iterations);
+			fsValue_toString(retValue[impl], results[impl]);
+		}
+
+		// Every implementation must produce the same value as the C version.
+		bool match = true;
+		for (s32 impl = 0; impl < BENCH_C; impl++)
+		{
+			if (runFuncs[impl] && retValue[impl] != retValue[BENCH_C]) { match = false; }
+		}
+
+		TFE_System::debugWrite("Test", "%s = [%s] %s, [%s] %s, [%s] %s, [%s] %s%s", name,
+			c_benchImplNames[BENCH_LEGACY], results[BENCH_LEGACY], c_benchImplNames[BENCH_VM], results[BENCH_VM],
+			c_benchImplNames[BENCH_JIT], results[BENCH_JIT], c_benchImplNames[BENCH_C], results[BENCH_C], match ? "" : " (MISMATCH)");
+		TFE_System::debugWrite("Test", "%s execution time = [%s] %fms, [%s] %fms, [%s] %fms, [%s] %fms", name,
+			c_benchImplNames[BENCH_LEGACY], timeMs[BENCH_LEGACY], c_benchImplNames[BENCH_VM], timeMs[BENCH_VM],
+			c_benchImplNames[BENCH_JIT], timeMs[BENCH_JIT], c_benchImplNames[BENCH_C], timeMs[BENCH_C]);
+	}
+
 	s32 test()
 	{
 		FsValue v0 = fsValue_createInt(-237);
 		FsValue v1 = fsValue_createFloat(3.141516f);
 
 		char outStr[256];
-		char outStr2[256];
 		fsValue_toString(v0, outStr);
 		TFE_System::debugWrite("Test", "v0 = %s", outStr);
 
 		fsValue_toString(v1, outStr);
 		TFE_System::debugWrite("Test", "v1 = %s", outStr);
 
-		s32* testCast0 = (s32*)&v0;
-		f32* testCast1 = (f32*)&v1;
-
 		/* -- TODO: Map rN to registers and have seperate load/store.
 		load r4, 0		-- load integer value into r4
 		load r5, 100	-- load integer value into r5
@@ -136,7 +964,7 @@ namespace TFE_ForceScript
 		ret r3
 		*/
 
-		Instruction testFunc[] =
+		Instruction floatLoopFunc[] =
 		{
 			/*0*/ I_OP_ARG0_1(FSF_OP_LOAD, 4, 0),		// load r4, 0
 			/*1*/ I_OP_ARG0_1(FSF_OP_LOAD, 5, 100),		// load r5, 100
@@ -151,54 +979,125 @@ namespace TFE_ForceScript
 			/*8*/ I_OP_ARG0(FSF_OP_RET, 3),				// return r3
 		};
 
-		jit_init();
-		ScriptJitFunc jitFunc = jit_compileScriptFunc("Test", testFunc, TFE_ARRAYSIZE(testFunc));
-		
-		f64 dtSec = 0.0;
-		f64 dtSecJit = 0.0;
-		f64 dtSecC = 0.0;
+		// r0 = count
+		const Instruction intLoopFunc[] =
+		{
+			/*0*/ I_OP_ARG0_12(FSF_OP_LOADI, 1, 0),			// sum = 0
+			/*1*/ I_OP_ARG0_12(FSF_OP_LOADI, 2, 0),			// i = 0
+			/*2*/ I_OP_ARG0_1_2(FSF_OP_JLE, 0, 2, 8),		// if (count <= i) goto 8
+			/*3*/ I_OP_ARG0_1_2(FSF_OP_IMUL, 3, 2, 2),		// r3 = i * i
+			/*4*/ I_OP_ARG0_1_2(FSF_OP_IXOR, 3, 3, 2),		// r3 = r3 ^ i
+			/*5*/ I_OP_ARG0_1_2(FSF_OP_IADD, 1, 1, 3),		// sum += r3
+			/*6*/ I_OP_ARG0_1_2(FSF_OP_IADDI, 2, 2, 1),		// i++
+			/*7*/ I_OP_ARG0(FSF_OP_JMP, 2),					// goto 2
+			/*8*/ I_OP_ARG0(FSF_OP_RET, 1),					// return sum
+		};
+
+		// r0 = n, the arguments for the calls are passed in r4.
+		const Instruction fibFunc[] =
+		{
+			/*0*/ I_OP_ARG0_1(FSF_OP_LOAD, 1, 2),							// r1 = 2
+			/*1*/ I_OP_ARG0_1_2(FSF_OP_JL, 0, 1, 8),						// if (n < 2) goto 8
+			/*2*/ I_OP_ARG0_1_2(FSF_OP_IADDI, 4, 0, -1),					// r4 = n - 1
+			/*3*/ I_OP_ARG0_1_2(FSF_OP_CALL, 2, BENCH_FUNC_FIB, 4),		// r2 = fib(r4)
+			/*4*/ I_OP_ARG0_1_2(FSF_OP_IADDI, 4, 0, -2),					// r4 = n - 2
+			/*5*/ I_OP_ARG0_1_2(FSF_OP_CALL, 3, BENCH_FUNC_FIB, 4),		// r3 = fib(r4)
+			/*6*/ I_OP_ARG0_1_2(FSF_OP_IADD, 2, 2, 3),						// r2 = r2 + r3
+			/*7*/ I_OP_ARG0(FSF_OP_RET, 2),									// return r2
+			/*8*/ I_OP_ARG0(FSF_OP_RET, 0),									// return n
+		};
 
-		optimizeFunc(testFunc, TFE_ARRAYSIZE(testFunc));
+		// r0 = struct {x, y, z}, r1 = count
+		const Instruction fieldsFunc[] =
+		{
+			/* 0*/ I_OP_ARG0_12(FSF_OP_LOADI, 2, 0),				// i = 0
+			/* 1*/ I_OP_ARG0_12(FSF_OP_LOADF, 6, floatBits(0.5f)),	// r6 = 0.5
+			/* 2*/ I_OP_ARG0_1_2(FSF_OP_JLE, 1, 2, 13),			// if (count <= i) goto 13
+			/* 3*/ I_OP_ARG0_1_2(FSF_OP_GETF, 3, 0, 0),			// r3 = x
+			/* 4*/ I_OP_ARG0_1_2(FSF_OP_GETF, 4, 0, 1),			// r4 = y
+			/* 5*/ I_OP_ARG0_1_2(FSF_OP_GETF, 5, 0, 2),			// r5 = z
+			/* 6*/ I_OP_ARG0_1_2(FSF_OP_FMUL, 5, 4, 5),			// r5 = y * z
+			/* 7*/ I_OP_ARG0_1_2(FSF_OP_FADD, 3, 3, 5),			// r3 = x + r5
+			/* 8*/ I_OP_ARG0_1_2(FSF_OP_SETF, 0, 0, 3),			// x = r3
+			/* 9*/ I_OP_ARG0_1_2(FSF_OP_FADD, 4, 4, 6),			// r4 = y + 0.5
+			/*10*/ I_OP_ARG0_1_2(FSF_OP_SETF, 0, 1, 4),			// y = r4
+			/*11*/ I_OP_ARG0_1_2(FSF_OP_IADDI, 2, 2, 1),			// i++
+			/*12*/ I_OP_ARG0(FSF_OP_JMP, 2),						// goto 2
+			/*13*/ I_OP_ARG0_1(FSF_OP_GETF, 3, 0),				// r3 = x
+			/*14*/ I_OP_ARG0(FSF_OP_RET, 3),						// return r3
+		};
 
-		FsValue retValue;
-		FsValue retValueJit;
-		f32 retValueC;
+		// r0 = count, r1 = bias
+		const Instruction dynamicFunc[] =
+		{
+			/*0*/ I_OP_ARG0_12(FSF_OP_LOADI, 2, 0),		// sum = 0
+			/*1*/ I_OP_ARG0_12(FSF_OP_LOADI, 3, 0),		// i = 0
+			/*2*/ I_OP_ARG0_12(FSF_OP_LOADI, 4, 3),		// r4 = 3
+			/*3*/ I_OP_ARG0_1_2(FSF_OP_JLE, 0, 3, 9),		// if (count <= i) goto 9
+			/*4*/ I_OP_ARG0_1_2(FSF_OP_MUL, 5, 3, 4),		// r5 = i * 3
+			/*5*/ I_OP_ARG0_1_2(FSF_OP_SUB, 5, 5, 1),		// r5 = r5 - bias
+			/*6*/ I_OP_ARG0_1_2(FSF_OP_ADD, 2, 2, 5),		// sum = sum + r5
+			/*7*/ I_OP_ARG0_1_2(FSF_OP_IADDI, 3, 3, 1),		// i++
+			/*8*/ I_OP_ARG0(FSF_OP_JMP, 3),					// goto 3
+			/*9*/ I_OP_ARG0_1_2(FSF_OP_DIV, 2, 2, 0),		// sum = sum / count
+			/*10*/ I_OP_ARG0_1(FSF_OP_CAST_TO_INT, 2, 2),	// sum = int(sum)
+			/*11*/ I_OP_ARG0(FSF_OP_RET, 2),				// return sum
+		};
 
-		FsValue stack[256];
-		for (s32 i = 0; i < 100000; i++)
-		{
-			// "push" values onto the stack.
-			u64 start = TFE_System::getCurrentTimeInTicks();
-				stack[0] = fsValue_createInt(-237);
-				stack[1] = fsValue_createInt(101);
-				stack[2] = fsValue_createFloat(37.2f);
-				retValue = callFunc(s_funcOpt, TFE_ARRAYSIZE(testFunc), stack);
-			u64 dt = TFE_System::getCurrentTimeInTicks() - start;
-			dtSec += TFE_System::convertFromTicksToSeconds(dt);
-
-			// "push" values onto the stack.
-			start = TFE_System::getCurrentTimeInTicks();
-				stack[0] = fsValue_createInt(-237);
-				stack[1] = fsValue_createInt(101);
-				stack[2] = fsValue_createFloat(37.2f);
-				retValueJit = jitFunc(stack);
-			dt = TFE_System::getCurrentTimeInTicks() - start;
-			dtSecJit += TFE_System::convertFromTicksToSeconds(dt);
-
-			start = TFE_System::getCurrentTimeInTicks();
-				retValueC = cversion(-237, 101, 37.2f);
-				//retValueC = cversion2(testFunc, stack);
-			dt = TFE_System::getCurrentTimeInTicks() - start;
-			dtSecC += TFE_System::convertFromTicksToSeconds(dt);
+		const VmFunction funcs[BENCH_FUNC_COUNT] =
+		{
+			{ floatLoopFunc, TFE_ARRAYSIZE(floatLoopFunc), 6 },
+			{ intLoopFunc,   TFE_ARRAYSIZE(intLoopFunc),   4 },
+			{ fibFunc,       TFE_ARRAYSIZE(fibFunc),       5 },
+			{ fieldsFunc,    TFE_ARRAYSIZE(fieldsFunc),    7 },
+			{ dynamicFunc,   TFE_ARRAYSIZE(dynamicFunc),   6 },
+		};
+		const VmModule module = { funcs, BENCH_FUNC_COUNT, nullptr, 0, nullptr };
+		VmFuncTier tiers[BENCH_FUNC_COUNT] = {};
+		const VmModule jitModule = { funcs, BENCH_FUNC_COUNT, nullptr, 0, tiers };
+		for (s32 i = 0; i < BENCH_FUNC_COUNT; i++)
+		{
+			if (!vm_validateFunc(&module, i))
+			{
+				return 0;
+			}
 		}
-		
-		fsValue_toString(retValue, outStr);
-		fsValue_toString(retValueJit, outStr2);
-		TFE_System::debugWrite("Test", "func(-237, 101, 37.2f) = [Interp] %s, [JIT] %s, [C] %f", outStr, outStr2, retValueC);
-		TFE_System::debugWrite("Test", "Execution time = [Interp] %fms, [JIT] %fms, [C] %fms", dtSec * 1000.0 / 100000.0, dtSecJit * 1000.0 / 100000.0, dtSecC * 1000.0 / 100000.0);
 
+	#ifdef VM_JIT_ENABLE
+		jit_init();
+	#endif
+		BenchContext* context = new BenchContext;
+		context->module = &module;
+		context->jitModule = &jitModule;
+		context->legacySize = TFE_ARRAYSIZE(floatLoopFunc);
+		optimizeFunc(floatLoopFunc, TFE_ARRAYSIZE(floatLoopFunc));
+
+		const BenchRunFunc floatLoop[]   = { benchFloatLoopLegacy, benchFloatLoopVm, benchFloatLoopJit, benchFloatLoopC };
+		const BenchRunFunc intLoop[]     = { nullptr, benchIntLoopVm,     benchIntLoopJit,     benchIntLoopC };
+		const BenchRunFunc fib[]         = { nullptr, benchFibVm,         benchFibJit,         benchFibC };
+		const BenchRunFunc fields[]      = { nullptr, benchFieldsVm,      benchFieldsJit,      benchFieldsC };
+		const BenchRunFunc dynamicInt[]  = { nullptr, benchDynamicIntVm,  benchDynamicIntJit,  benchDynamicIntC };
+		const BenchRunFunc dynamicNull[] = { nullptr, benchDynamicNullVm, benchDynamicNullJit, benchDynamicNullC };
+		benchRun("floatLoop(-237, 101, 37.2f)", context, floatLoop, 100000);
+		benchRun("intLoop(10000)", context, intLoop, 1000);
+		benchRun("fib(20)", context, fib, 100);
+		benchRun("fields(1000)", context, fields, 1000);
+		benchRun("dynamic(1000, 1)", context, dynamicInt, 1000);
+		benchRun("dynamic(1000, null)", context, dynamicNull, 1000);
+
+	#ifdef VM_JIT_ENABLE
+		s32 compiledCount = 0;
+		for (s32 i = 0; i < BENCH_FUNC_COUNT; i++)
+		{
+			if (tiers[i].jitFunc) { compiledCount++; }
+		}
+		TFE_System::debugWrite("Test", "JIT: %d of %d functions compiled, %d cached.", compiledCount, BENCH_FUNC_COUNT, jit_getCachedFuncCount());
+	#endif
+
+		delete context;
+	#ifdef VM_JIT_ENABLE
 		jit_destroy();
-				
+	#endif
 		return 1;
 	}
 }
@@ -6,11 +6,66 @@
 #include "vmConfig.h"
 
 #ifdef VM_ENABLE
+#include "value.h"
+#include "vmOps.h"
+
 namespace TFE_ForceScript
 {
+	// Each function uses a window of 'regCount' registers on the value stack, the arguments are passed in the first registers.
+	struct VmFunction
+	{
+		const Instruction* code;
+		s32 size;
+		s32 regCount;
+	};
+
+	typedef FsValue(*VmNativeFunc)(FsValue* args);
+
+	struct VmExecState;
+	typedef FsValue(*VmJitFunc)(FsValue* regs, VmExecState* state);
+
+	// JIT tier state for one function, zero initialized.
+	// A function is compiled once it has been called VM_JIT_THRESHOLD times, and goes back to the interpreter
+	// if the compiled code keeps bailing out.
+	struct VmFuncTier
+	{
+		u32 callCount;
+		u32 deoptCount;
+		VmJitFunc jitFunc;
+		bool jitDisabled;
+	};
+
+	struct VmModule
+	{
+		const VmFunction* funcs;
+		s32 funcCount;
+		const VmNativeFunc* natives;
+		s32 nativeCount;
+		VmFuncTier* tiers;	// One per function, the JIT tier is only used if this is set.
+	};
+
+	struct VmFrame;
+	// Execution state shared by the interpreter and compiled code.
+	struct VmExecState
+	{
+		const VmModule* module;
+		FsValue* stackEnd;
+		VmFrame* frames;
+		s32 depth;
+		s32 deoptIp;	// Instruction the interpreter resumes at when compiled code bails out, -1 otherwise.
+		s32 error;
+	};
+
 	bool init();
 	void destroy();
 
+	// Checks the registers, jump targets and call targets, vm_execute() does not check them at runtime.
+	bool vm_validateFunc(const VmModule* module, s32 funcIndex);
+	// Runs the function with the arguments in stack[0...], returns null on error.
+	FsValue vm_execute(const VmModule* module, s32 funcIndex, FsValue* stack, s32 stackSize);
+	// Called by compiled code, runs the function with its registers starting at 'regs'.
+	FsValue vm_jitCall(VmExecState* state, s32 funcIndex, FsValue* regs);
+
 	s32 test();
 }
 #endif
\ No newline at end of file
@@ -27,6 +27,57 @@ namespace TFE_ForceScript
 		FSF_OP_JMP,
 		FSF_OP_JL,	// Jump if less.
 		FSF_OP_RET,
+		FSF_OP_LEGACY_COUNT,	// The function table dispatcher (s_vmOpCalls) only handles the opcodes above.
+
+		// Register VM opcodes, see vm_execute().
+		// Loads and moves.
+		FSF_OP_LOADF = FSF_OP_LEGACY_COUNT,	// rA = float bits in Arg12.
+		FSF_OP_LOADI,	// rA = 32-bit integer in Arg12, LOAD only holds 18-bit positive values.
+		FSF_OP_LOADN,	// rA = null.
+		// Integer arithmetic, rA = rB op rC.
+		FSF_OP_ISUB,
+		FSF_OP_IMUL,
+		FSF_OP_IDIV,	// Division by zero results in zero.
+		FSF_OP_IMOD,
+		FSF_OP_IAND,
+		FSF_OP_IOR,
+		FSF_OP_IXOR,
+		FSF_OP_ISHL,
+		FSF_OP_ISHR,
+		FSF_OP_INEG,	// rA = -rB
+		FSF_OP_IADDI,	// rA = rB + signed 18-bit immediate in Arg2.
+		// Float arithmetic, rA = rB op rC.
+		FSF_OP_FSUB,
+		FSF_OP_FMUL,
+		FSF_OP_FDIV,
+		FSF_OP_FNEG,	// rA = -rB
+		// Dynamically typed arithmetic: int op int = int, otherwise both values are read as float.
+		FSF_OP_SUB,
+		FSF_OP_MUL,
+		FSF_OP_DIV,
+		// Compares, rA = int(rB op rC).
+		FSF_OP_IEQ,
+		FSF_OP_INE,
+		FSF_OP_ILT,
+		FSF_OP_ILE,
+		FSF_OP_FEQ,
+		FSF_OP_FLT,
+		FSF_OP_FLE,
+		// Branches, the target is an instruction index within the function.
+		FSF_OP_JZ,		// if (rA == 0) goto Arg1
+		FSF_OP_JNZ,		// if (rA != 0) goto Arg1
+		FSF_OP_JLE,		// if (rA <= rB) goto Arg2
+		FSF_OP_JEQ,		// if (rA == rB) goto Arg2
+		FSF_OP_JNE,		// if (rA != rB) goto Arg2
+		FSF_OP_FJL,		// if (float rA < float rB) goto Arg2
+		// Calls, the callee registers start at rC of the caller: rA = func[B](rC, rC+1, ...)
+		FSF_OP_CALL,
+		FSF_OP_CALLN,	// Native function.
+		// Field access, rA = rB->field[C] and rA->field[B] = rC. Struct values hold a pointer to an FsValue array.
+		FSF_OP_GETF,
+		FSF_OP_SETF,
+		FSF_OP_RETN,	// Return null.
+		FSF_OP_COUNT
 	};
 
 	// Instruction = 
@@ -39,16 +90,20 @@ namespace TFE_ForceScript
 	#define I_ARG_SIZE (1ull << 18ull)
 	#define I_ARG_MASK (I_ARG_SIZE - 1ull)
 	#define I_ARG2_MASK (I_ARG_SIZE*2 - 1ull)
+	#define I_ARG12_MASK ((1ull << 36ull) - 1ull)
 
 	#define I_OP(i)   ((i) & I_OP_MASK)
 	#define I_ARG0(i) (((i) >> 10ull) & I_ARG_MASK)
 	#define I_ARG1(i) (((i) >> 28ull) & I_ARG_MASK)
 	#define I_ARG2(i) (((i) >> 46ull) & I_ARG_MASK)
-	#define I_ARG12(i) (((i) >> 28ull) & I_ARG2_MASK)
+	#define I_ARG12(i) (((i) >> 28ull) & I_ARG12_MASK)
 
 	#define I_OP_ARG0(i, arg0)					(u64(i) | (u64(arg0) << 10ull))
 	#define I_OP_ARG0_1(i, arg0, arg1)			(u64(i) | (u64(arg0) << 10ull) | (u64(arg1) << 28ull))
 	#define I_OP_ARG0_1_2(i, arg0, arg1, arg2)	(u64(i) | (u64(arg0) << 10ull) | (u64(arg1) << 28ull) | (u64(arg2) << 46ull))
+	#define I_OP_ARG0_12(i, arg0, arg12)		(u64(i) | (u64(arg0) << 10ull) | ((u64(arg12) & I_ARG12_MASK) << 28ull))
+	// Signed 18-bit immediate in Arg2.
+	#define I_SARG2(i) (s32(u32(I_ARG2(i) << 14ull)) >> 14)
 
 	extern FsValue* s_stackPtr;
 	extern Instruction* s_func;
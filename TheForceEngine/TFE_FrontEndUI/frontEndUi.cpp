@@ -1949,6 +1949,8 @@ namespace TFE_FrontEndUI
 		{
 			fullscreen = !windowed;
 		}
+		ImGui::SameLine();
+		ImGui::Checkbox("Interpolate Frames", &graphics->fixedTickInterpolation);
 		if (fullscreen != window->fullscreen)
 		{
 			TFE_RenderBackend::enableFullscreen(fullscreen);
@@ -2232,6 +2234,11 @@ namespace TFE_FrontEndUI
 			sound->disableSoundInMenus = disableSoundInMenus;
 		}
 
+		ImGui::LabelText("##ConfigLabel", "Resample Quality:"); ImGui::SameLine(150*s_uiScale);
+		ImGui::SetNextItemWidth(196*s_uiScale);
+		ImGui::Combo("##ResampleQuality", (s32*)&sound->resampleQuality, c_tfeResampleQualityStrings, IM_ARRAYSIZE(c_tfeResampleQualityStrings));
+		ImGui::TextWrapped("NOTE: The resample quality takes effect when the game is restarted.");
+
 		TFE_Audio::setVolume(sound->soundFxVolume);
 		TFE_MidiPlayer::setVolume(sound->musicVolume);
 
@@ -2261,6 +2268,28 @@ namespace TFE_FrontEndUI
 			}
 		}
 
+		// The software synth is also used when there are no MIDI devices.
+		bool restartMidi = false;
+		if (ImGui::Checkbox("Use Software Synthesizer", &sound->useSoftwareSynth))
+		{
+			restartMidi = true;
+		}
+		ImGui::LabelText("##ConfigLabel", "SoundFont:"); ImGui::SameLine(150*s_uiScale);
+		ImGui::SetNextItemWidth(362*s_uiScale);
+		if (ImGui::InputText("##SoundFont", sound->soundFont, TFE_MAX_PATH, ImGuiInputTextFlags_EnterReturnsTrue))
+		{
+			restartMidi = sound->useSoftwareSynth || MIDI_DeviceCount == 0;
+		}
+		if (ImGui::Checkbox("Sequence MIDI on the Audio Clock", &sound->midiAudioClock))
+		{
+			restartMidi = !sound->useSoftwareSynth && MIDI_DeviceCount > 0;
+		}
+		if (restartMidi)
+		{
+			TFE_MidiPlayer::destroy();
+			TFE_MidiPlayer::init(MIDI_CurrentDevIndex);
+		}
+
 		ImGui::Dummy(ImVec2(0.0f, 20.0f));
 
 		ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.17f, 0.68f, 1.0f, 1.0f));
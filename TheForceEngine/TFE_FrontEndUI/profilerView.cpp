@@ -9,14 +9,24 @@
 #include <TFE_Ui/ui.h>
 #include <TFE_Ui/markdown.h>
 #include <TFE_System/parser.h>
+#include <TFE_Game/igame.h>
+#include <TFE_Audio/audioSystem.h>
+#include <TFE_Jedi/Level/rtexture.h>
 
 #include <TFE_Ui/imGUI/imgui.h>
 #include <algorithm>
 
 namespace TFE_ProfilerView
 {
+	enum
+	{
+		MEM_TOP_TAG_COUNT = 8,
+	};
 	static bool s_open = false;
 
+	void memoryRegionView(const char* name, MemoryRegion* region);
+	void audioThreadView();
+
 	bool init()
 	{
 		return true;
@@ -81,9 +91,89 @@ namespace TFE_ProfilerView
 		ImGui::Unindent();
 		ImGui::Unindent();
 
+		audioThreadView();
+
+		if (s_gameRegion && s_levelRegion)
+		{
+			ImGui::Spacing();
+			ImGui::LabelText("##Label", "Memory Regions");
+			ImGui::Separator();
+
+			bool tracking = TFE_Memory::region_isTrackingEnabled(s_gameRegion);
+			if (ImGui::Checkbox("Track Allocations", &tracking))
+			{
+				TFE_Memory::region_enableTracking(s_gameRegion, tracking);
+				TFE_Memory::region_enableTracking(s_levelRegion, tracking);
+			}
+
+			ImGui::Indent();
+			memoryRegionView("Game", s_gameRegion);
+			memoryRegionView("Level", s_levelRegion);
+
+			MemoryRegion* bitmapRegion = TFE_Jedi::bitmap_getAllocator();
+			ImGui::Text("Bitmap allocator: %s", bitmapRegion ? TFE_Memory::region_getName(bitmapRegion) : "none");
+			ImGui::Unindent();
+		}
+
 		ImGui::End();
 	}
 
+	void audioThreadView()
+	{
+		AudioThreadStats stats;
+		TFE_Audio::getThreadStats(&stats);
+
+		ImGui::Spacing();
+		ImGui::LabelText("##Label", "Audio Thread");
+		ImGui::Separator();
+		ImGui::Indent();
+		ImGui::Text("Callback: min %0.1fus, ave %0.1fus, p99 %0.1fus, max %0.1fus (%u per second)", stats.callbackMinUs, stats.callbackAveUs,
+			stats.callbackP99Us, stats.callbackMaxUs, stats.callbackCount);
+		ImGui::Text("Buffer: %0.1fus, underruns: %u", stats.bufferUs, stats.underruns);
+		ImGui::Text("MIDI lock: waited %0.1fus per second, %u skipped updates", stats.lockWaitUs, stats.lockMisses);
+		ImGui::Text("Voices: %d wave, %d MIDI", stats.voices[AUDIO_VOICES_WAVE], stats.voices[AUDIO_VOICES_MIDI]);
+
+		// Only show the bins up to the buffer duration or the slowest callback, whichever is larger.
+		s32 binCount = 1;
+		f32 histogram[AUDIO_TIMING_BINS];
+		for (s32 i = 0; i < AUDIO_TIMING_BINS; i++)
+		{
+			histogram[i] = f32(stats.histogram[i]);
+			if (stats.histogram[i] || TFE_Audio::getTimingBinUs(i) <= stats.bufferUs) { binCount = i + 1; }
+		}
+		char overlay[64];
+		sprintf(overlay, "1us - %0.0fus", TFE_Audio::getTimingBinUs(binCount));
+		ImGui::PlotHistogram("##AudioCallbackHistogram", histogram, binCount, 0, overlay, 0.0f, FLT_MAX, ImVec2(512.0f, 64.0f));
+		ImGui::Unindent();
+	}
+
+	void memoryRegionView(const char* name, MemoryRegion* region)
+	{
+		RegionStats stats;
+		TFE_Memory::region_getStats(region, &stats);
+
+		ImGui::Text("%s", name);
+		ImGui::Indent();
+		ImGui::Text("Used: %zu / %zu, High-Water Mark: %zu", stats.used, stats.capacity, stats.highWaterMark);
+		ImGui::Text("Largest Free Block: %zu, Fragmentation: %0.2f%%", stats.largestFreeBlock, stats.fragmentation * 100.0f);
+		if (TFE_Memory::region_isTrackingEnabled(region))
+		{
+			ImGui::Text("Live Allocations: %u, Total Allocs: %llu, Total Frees: %llu", stats.liveAllocCount, (unsigned long long)stats.totalAllocCount, (unsigned long long)stats.totalFreeCount);
+			ImGui::Text("Size Classes [<=32, <=64, <=128, <=256, <=512, >512]: %u, %u, %u, %u, %u, %u", stats.sizeClassLive[0], stats.sizeClassLive[1],
+				stats.sizeClassLive[2], stats.sizeClassLive[3], stats.sizeClassLive[4], stats.sizeClassLive[5]);
+
+			RegionTagStats tags[MEM_TOP_TAG_COUNT];
+			const u32 tagCount = TFE_Memory::region_getTopTags(region, tags, MEM_TOP_TAG_COUNT);
+			for (u32 t = 0; t < tagCount; t++)
+			{
+				ImGui::Text("%zu (%u)", tags[t].liveBytes, tags[t].liveCount);
+				ImGui::SameLine(f32(180));
+				ImGui::Text("%s", tags[t].tag);
+			}
+		}
+		ImGui::Unindent();
+	}
+
 	bool isEnabled()
 	{
 		return s_open;
@@ -0,0 +1,377 @@
+#include "batchRunner.h"
+#include "igame.h"
+#include <TFE_System/system.h>
+#include <TFE_System/parser.h>
+#include <TFE_System/Threads/thread.h>
+#include <TFE_FileSystem/filestream.h>
+#include <TFE_FileSystem/fileutil.h>
+#include <TFE_FileSystem/paths.h>
+#include <TFE_Jedi/Task/task.h>
+#include <TFE_Memory/memoryRegion.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+enum BatchConstants
+{
+	BATCH_MAX_WORKERS = 256,
+};
+
+struct BatchLevel
+{
+	std::string level;
+	std::string mod;
+};
+
+struct BatchWorkerReport
+{
+	std::string status;
+	u32 ticks;
+	u32 frames;
+	f64 seconds;
+	f64 worstFrame;
+	size_t gameMemory;
+	size_t levelMemory;
+};
+
+// Runner state.
+static std::vector<BatchLevel> s_levels;
+static std::atomic<s32> s_nextLevel;
+static std::chrono::steady_clock::time_point s_runnerStart;
+static const char* s_exePath = nullptr;
+static s32 s_tickCount = 0;
+static f64 s_timeBudget = 0.0;
+
+// Worker state.
+static bool s_isWorker = false;
+static s32  s_workerId = 0;
+static s32  s_workerTicks = 0;
+static f64  s_workerBudget = 0.0;
+static u64  s_workerStart = 0;
+static u32  s_workerFrames = 0;
+static f64  s_workerWorstFrame = 0.0;
+
+static void batch_getDirectory(char* dir)
+{
+	sprintf(dir, "%sBatch/", TFE_Paths::getPath(PATH_PROGRAM_DATA));
+}
+
+static void batch_getWorkerReportPath(s32 workerId, char* path)
+{
+	char dir[TFE_MAX_PATH];
+	batch_getDirectory(dir);
+	sprintf(path, "%sworker_%03d.txt", dir, workerId);
+}
+
+static f64 batch_getRunnerTime()
+{
+	return std::chrono::duration<f64>(std::chrono::steady_clock::now() - s_runnerStart).count();
+}
+
+//////////////////////////////////////////////////
+// Runner
+//////////////////////////////////////////////////
+static bool batch_readLevelList(const char* levelList)
+{
+	char* buffer = nullptr;
+	const u32 len = FileStream::readContents(levelList, (void**)&buffer);
+	if (!len)
+	{
+		free(buffer);
+		return false;
+	}
+
+	TFE_Parser parser;
+	parser.init(buffer, len);
+	parser.addCommentString(";");
+	parser.addCommentString("#");
+
+	size_t bufferPos = 0;
+	while (bufferPos < len)
+	{
+		const char* line = parser.readLine(bufferPos);
+		if (!line) { break; }
+
+		TokenList tokens;
+		parser.tokenizeLine(line, tokens);
+		if (tokens.empty()) { continue; }
+		s_levels.push_back({ tokens[0], tokens.size() > 1 ? tokens[1] : "" });
+	}
+	free(buffer);
+	return !s_levels.empty();
+}
+
+TFE_THREADRET TFE_STDCALL batchWorkerThreadFunc(void* userData)
+{
+	char programDir[TFE_MAX_PATH];
+	strcpy(programDir, TFE_Paths::getPath(PATH_PROGRAM));
+
+	while (true)
+	{
+		// Stop starting new workers once the time budget has been used up.
+		// The budget is checked before taking a level, so every level below s_nextLevel was started.
+		const f64 timeLeft = s_timeBudget - batch_getRunnerTime();
+		if (timeLeft <= 0.0) { break; }
+		const s32 index = s_nextLevel.fetch_add(1);
+		if (index >= (s32)s_levels.size()) { break; }
+
+		// The arguments are passed to the worker as-is, names from the level list are never parsed by a shell.
+		const BatchLevel& level = s_levels[index];
+		const std::string levelArg = "-l" + level.level;
+		const std::string modArg = "-u" + level.mod;
+		char indexArg[32], tickArg[32], budgetArg[32];
+		snprintf(indexArg, sizeof(indexArg), "%d", index);
+		snprintf(tickArg, sizeof(tickArg), "%d", s_tickCount);
+		snprintf(budgetArg, sizeof(budgetArg), "%0.1f", timeLeft);
+
+		const char* args[16];
+		s32 argCount = 0;
+		args[argCount++] = "-gDARK";
+		args[argCount++] = levelArg.c_str();
+		if (!level.mod.empty())
+		{
+			args[argCount++] = modArg.c_str();
+		}
+		args[argCount++] = "-c0";
+		args[argCount++] = "--nosound";
+		args[argCount++] = "--fastForward";
+		args[argCount++] = "0";
+		args[argCount++] = "--batchWorker";
+		args[argCount++] = indexArg;
+		args[argCount++] = tickArg;
+		args[argCount++] = budgetArg;
+		if (!TFE_System::osRunProcess(s_exePath, programDir, args, argCount, true))
+		{
+			TFE_System::logWrite(LOG_ERROR, "Batch", "Cannot start the worker for level '%s'.", level.level.c_str());
+		}
+	}
+	return (TFE_THREADRET)0;
+}
+
+static bool batch_readWorkerReport(s32 workerId, BatchWorkerReport* report)
+{
+	char path[TFE_MAX_PATH];
+	batch_getWorkerReportPath(workerId, path);
+
+	char* buffer = nullptr;
+	const u32 len = FileStream::readContents(path, (void**)&buffer);
+	if (!len)
+	{
+		free(buffer);
+		return false;
+	}
+
+	TFE_Parser parser;
+	parser.init(buffer, len);
+
+	size_t bufferPos = 0;
+	while (bufferPos < len)
+	{
+		const char* line = parser.readLine(bufferPos);
+		if (!line) { break; }
+
+		TokenList tokens;
+		parser.tokenizeLine(line, tokens);
+		if (tokens.size() < 2) { continue; }
+
+		const char* key = tokens[0].c_str();
+		const char* value = tokens[1].c_str();
+		if (strcasecmp(key, "status") == 0)           { report->status = value; }
+		else if (strcasecmp(key, "ticks") == 0)       { report->ticks = (u32)strtoul(value, nullptr, 10); }
+		else if (strcasecmp(key, "frames") == 0)      { report->frames = (u32)strtoul(value, nullptr, 10); }
+		else if (strcasecmp(key, "seconds") == 0)     { report->seconds = strtod(value, nullptr); }
+		else if (strcasecmp(key, "worstFrame") == 0)  { report->worstFrame = strtod(value, nullptr); }
+		else if (strcasecmp(key, "gameMemory") == 0)  { report->gameMemory = (size_t)strtoull(value, nullptr, 10); }
+		else if (strcasecmp(key, "levelMemory") == 0) { report->levelMemory = (size_t)strtoull(value, nullptr, 10); }
+	}
+	free(buffer);
+	return true;
+}
+
+static void batch_writeReport(FileStream& file, const char* line)
+{
+	TFE_System::logWrite(LOG_MSG, "Batch", "%s", line);
+	if (file.isOpen())
+	{
+		file.writeString("%s\r\n", line);
+	}
+}
+
+static void batch_aggregateReports()
+{
+	char dir[TFE_MAX_PATH], path[TFE_MAX_PATH];
+	batch_getDirectory(dir);
+	sprintf(path, "%sbatch_report.txt", dir);
+
+	FileStream file;
+	if (!file.open(path, Stream::MODE_WRITE))
+	{
+		TFE_System::logWrite(LOG_ERROR, "Batch", "Cannot write the report '%s'.", path);
+	}
+
+	char line[512];
+	snprintf(line, sizeof(line), "%-16s | %-9s | %8s | %8s | %10s | %15s | %13s | %14s", "Level", "Status", "Ticks", "Seconds", "Ticks/Sec", "Worst Frame(ms)", "Game Mem (KB)", "Level Mem (KB)");
+	batch_writeReport(file, line);
+
+	u64 totalTicks = 0;
+	s32 completed = 0;
+	const s32 levelCount = (s32)s_levels.size();
+	for (s32 i = 0; i < levelCount; i++)
+	{
+		BatchWorkerReport report = { "failed" };
+		if (!batch_readWorkerReport(i, &report) && i >= s_nextLevel.load())
+		{
+			report.status = "skipped";
+		}
+		if (report.status == "complete") { completed++; }
+		totalTicks += report.ticks;
+
+		snprintf(line, sizeof(line), "%-16s | %-9s | %8u | %8.2f | %10.1f | %15.2f | %13zu | %14zu", s_levels[i].level.c_str(), report.status.c_str(), report.ticks,
+			report.seconds, report.seconds > 0.0 ? f64(report.ticks) / report.seconds : 0.0, report.worstFrame * 1000.0, report.gameMemory >> 10, report.levelMemory >> 10);
+		batch_writeReport(file, line);
+	}
+
+	const f64 totalTime = batch_getRunnerTime();
+	snprintf(line, sizeof(line), "%d of %d levels completed, %llu ticks in %0.2f seconds (%0.1f ticks per second).", completed, levelCount,
+		(unsigned long long)totalTicks, totalTime, totalTime > 0.0 ? f64(totalTicks) / totalTime : 0.0);
+	batch_writeReport(file, line);
+	file.close();
+}
+
+bool batch_runWorkers(const char* exePath, const char* levelList, s32 workerCount, s32 tickCount, f64 timeBudget)
+{
+	s_levels.clear();
+	if (!batch_readLevelList(levelList))
+	{
+		TFE_System::logWrite(LOG_ERROR, "Batch", "Cannot read the level list '%s'.", levelList);
+		return false;
+	}
+
+	char dir[TFE_MAX_PATH];
+	batch_getDirectory(dir);
+	if (!FileUtil::directoryExits(dir))
+	{
+		FileUtil::makeDirectory(dir);
+	}
+	// Remove stale reports.
+	for (s32 i = 0; i < (s32)s_levels.size(); i++)
+	{
+		char path[TFE_MAX_PATH];
+		batch_getWorkerReportPath(i, path);
+		if (FileUtil::exists(path))
+		{
+			FileUtil::deleteFile(path);
+		}
+	}
+
+	s_exePath = exePath;
+	s_tickCount = std::max(1, tickCount);
+	s_timeBudget = timeBudget;
+	s_nextLevel.store(0);
+	s_runnerStart = std::chrono::steady_clock::now();
+
+	workerCount = std::max(1, std::min(std::min(workerCount, (s32)BATCH_MAX_WORKERS), (s32)s_levels.size()));
+	TFE_System::logWrite(LOG_MSG, "Batch", "Running %d levels with %d workers, %d ticks per level.", (s32)s_levels.size(), workerCount, s_tickCount);
+
+	std::vector<Thread*> threads;
+	for (s32 i = 0; i < workerCount; i++)
+	{
+		Thread* thread = Thread::create("BatchWorkerThread", batchWorkerThreadFunc, nullptr);
+		if (thread && thread->run())
+		{
+			threads.push_back(thread);
+		}
+		else
+		{
+			TFE_System::logWrite(LOG_ERROR, "Batch", "Cannot create worker thread %d.", i);
+			delete thread;
+		}
+	}
+	if (threads.empty())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		threads[i]->waitOnExit();
+		delete threads[i];
+	}
+
+	batch_aggregateReports();
+	return true;
+}
+
+//////////////////////////////////////////////////
+// Worker
+//////////////////////////////////////////////////
+void batch_beginWorker(s32 workerId, s32 tickCount, f64 timeBudget)
+{
+	s_isWorker = true;
+	s_workerId = workerId;
+	s_workerTicks = std::max(1, tickCount);
+	s_workerBudget = timeBudget;
+	s_workerStart = 0;
+	s_workerFrames = 0;
+	s_workerWorstFrame = 0.0;
+}
+
+bool batch_isWorker()
+{
+	return s_isWorker;
+}
+
+static void batch_writeWorkerReport(const char* status, u32 ticks, f64 seconds)
+{
+	char path[TFE_MAX_PATH];
+	batch_getWorkerReportPath(s_workerId, path);
+
+	FileStream file;
+	if (!file.open(path, Stream::MODE_WRITE))
+	{
+		TFE_System::logWrite(LOG_ERROR, "Batch", "Cannot write the worker report '%s'.", path);
+		return;
+	}
+
+	RegionStats gameStats, levelStats;
+	TFE_Memory::region_getStats(s_gameRegion, &gameStats);
+	TFE_Memory::region_getStats(s_levelRegion, &levelStats);
+
+	file.writeString("status=%s\r\n", status);
+	file.writeString("ticks=%u\r\n", ticks);
+	file.writeString("frames=%u\r\n", s_workerFrames);
+	file.writeString("seconds=%f\r\n", seconds);
+	file.writeString("worstFrame=%f\r\n", s_workerWorstFrame);
+	file.writeString("gameMemory=%zu\r\n", gameStats.highWaterMark);
+	file.writeString("levelMemory=%zu\r\n", levelStats.highWaterMark);
+	file.close();
+}
+
+bool batch_updateWorker()
+{
+	if (!s_isWorker) { return true; }
+
+	const u64 curTime = TFE_System::getCurrentTimeInTicks();
+	if (!s_workerStart)
+	{
+		s_workerStart = curTime;
+		return true;
+	}
+	s_workerFrames++;
+	s_workerWorstFrame = std::max(s_workerWorstFrame, TFE_System::getDeltaTime());
+
+	const u32 ticks = TFE_Jedi::task_getFastForwardRuns();
+	const f64 seconds = TFE_System::convertFromTicksToSeconds(curTime - s_workerStart);
+	if (ticks >= u32(s_workerTicks))
+	{
+		batch_writeWorkerReport("complete", ticks, seconds);
+		return false;
+	}
+	else if (seconds >= s_workerBudget)
+	{
+		batch_writeWorkerReport("timeout", ticks, seconds);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Batch Runner
+// TFE: Runs a list of levels for profiling and soak testing.
+//
+// All game state is global, so each level runs in its own worker
+// process - this executable started with "--batchWorker". Workers run
+// their level in fast-forward mode for a fixed number of ticks and write
+// a small report, which the runner then aggregates into a single report.
+// Workers use the headless render backend (WINFLAG_HEADLESS), so they
+// do not open a visible window or present frames.
+//
+// Runner:  --batch levelList.txt [workerCount] [tickCount] [timeBudgetInSec]
+// Worker:  --batchWorker workerId tickCount timeBudgetInSec
+//
+// The level list has one level per line, optionally followed by the
+// mod archive that contains it:
+//   SECBASE
+//   MYLEVEL mymod.zip
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+
+// Launches the workers and blocks until they are finished or the time budget runs out.
+bool batch_runWorkers(const char* exePath, const char* levelList, s32 workerCount, s32 tickCount, f64 timeBudget);
+
+// Worker
+void batch_beginWorker(s32 workerId, s32 tickCount, f64 timeBudget);
+bool batch_isWorker();
+// Called once per frame, returns false once the worker is finished and the program should exit.
+bool batch_updateWorker();
@@ -2,6 +2,9 @@
 #include <TFE_FrontEndUI/console.h>
 #include <TFE_DarkForces/darkForcesMain.h>
 #include <TFE_Outlaws/outlawsMain.h>
+#include <TFE_Jedi/Level/rtexture.h>
+#include <TFE_Jedi/Task/task.h>
+#include <algorithm>
 
 enum GameConstants
 {
@@ -31,12 +34,123 @@ void displayMemoryUsage(const ConsoleArgList& args)
 	TFE_Console::addToHistory("-------------------------------------------------------------------");
 }
 
+void enableMemoryTracking(const ConsoleArgList& args)
+{
+	const bool enable = TFE_Console::getBoolArg(args[1]);
+	region_enableTracking(s_gameRegion, enable);
+	region_enableTracking(s_levelRegion, enable);
+	TFE_Console::addToHistory(enable ? "Memory tracking enabled." : "Memory tracking disabled.");
+}
+
+void enableFastForward(const ConsoleArgList& args)
+{
+	const bool enable = TFE_Console::getBoolArg(args[1]);
+	if (args.size() > 2)
+	{
+		TFE_Jedi::task_setFastForward(enable ? JTRUE : JFALSE, atoi(args[2].c_str()));
+	}
+	else
+	{
+		TFE_Jedi::task_setFastForward(enable ? JTRUE : JFALSE);
+	}
+	TFE_Console::addToHistory(enable ? "Fast-forward enabled." : "Fast-forward disabled.");
+}
+
+void displayRegionStats(const char* name, MemoryRegion* region)
+{
+	char res[256];
+	RegionStats stats;
+	region_getStats(region, &stats);
+	sprintf(res, "%-8s | %11zu | %14zu | %12zu | %6.2f%% | %9u", name, stats.used, stats.highWaterMark, stats.largestFreeBlock, stats.fragmentation * 100.0f, stats.liveAllocCount);
+	TFE_Console::addToHistory(res);
+}
+
+void displayMemoryStats(const ConsoleArgList& args)
+{
+	char res[256];
+	TFE_Console::addToHistory("--------------------------------------------------------------------------------");
+	TFE_Console::addToHistory("Region   | Memory Used | High-Water Mark | Largest Free | Fragment | Live Allocs");
+	TFE_Console::addToHistory("--------------------------------------------------------------------------------");
+	displayRegionStats("Game", s_gameRegion);
+	displayRegionStats("Level", s_levelRegion);
+	TFE_Console::addToHistory("--------------------------------------------------------------------------------");
+	if (!region_isTrackingEnabled(s_gameRegion))
+	{
+		TFE_Console::addToHistory("Allocation tracking is disabled, use \"memTracking 1\" to enable it.");
+		return;
+	}
+
+	MemoryRegion* regions[] = { s_gameRegion, s_levelRegion };
+	const char* names[] = { "Game", "Level" };
+	TFE_Console::addToHistory("Live Allocations by Size Class:");
+	TFE_Console::addToHistory("Region   |   <=32 |   <=64 |  <=128 |  <=256 |  <=512 |   >512");
+	for (s32 r = 0; r < TFE_ARRAYSIZE(regions); r++)
+	{
+		RegionStats stats;
+		region_getStats(regions[r], &stats);
+		sprintf(res, "%-8s | %6u | %6u | %6u | %6u | %6u | %6u", names[r], stats.sizeClassLive[0], stats.sizeClassLive[1], stats.sizeClassLive[2],
+			stats.sizeClassLive[3], stats.sizeClassLive[4], stats.sizeClassLive[5]);
+		TFE_Console::addToHistory(res);
+	}
+
+	// The bitmap allocator points at either the game or level region.
+	MemoryRegion* bitmapRegion = TFE_Jedi::bitmap_getAllocator();
+	for (s32 r = 0; r < TFE_ARRAYSIZE(regions); r++)
+	{
+		RegionTagStats tagStats;
+		if (region_getTagStats(regions[r], "bitmap", &tagStats))
+		{
+			sprintf(res, "Bitmaps (%s)%s: %zu bytes in %u allocations, high-water mark %zu bytes.", names[r],
+				bitmapRegion == regions[r] ? " [active]" : "", tagStats.liveBytes, tagStats.liveCount, tagStats.highWaterMark);
+			TFE_Console::addToHistory(res);
+		}
+	}
+	TFE_Console::addToHistory("--------------------------------------------------------------------------------");
+}
+
+void displayMemoryTags(const ConsoleArgList& args)
+{
+	char res[256];
+	s32 maxCount = 10;
+	if (args.size() > 1)
+	{
+		maxCount = std::max(1, std::min(atoi(args[1].c_str()), (s32)REGION_MAX_TAGS));
+	}
+	if (!region_isTrackingEnabled(s_gameRegion))
+	{
+		TFE_Console::addToHistory("Allocation tracking is disabled, use \"memTracking 1\" to enable it.");
+		return;
+	}
+
+	MemoryRegion* regions[] = { s_gameRegion, s_levelRegion };
+	const char* names[] = { "Game", "Level" };
+	RegionTagStats tags[REGION_MAX_TAGS];
+	for (s32 r = 0; r < TFE_ARRAYSIZE(regions); r++)
+	{
+		const u32 count = region_getTopTags(regions[r], tags, u32(maxCount));
+		TFE_Console::addToHistory("--------------------------------------------------------------------------------");
+		sprintf(res, "%s Region - Tag                         | Live Bytes | Live Count | High-Water Mark", names[r]);
+		TFE_Console::addToHistory(res);
+		TFE_Console::addToHistory("--------------------------------------------------------------------------------");
+		for (u32 t = 0; t < count; t++)
+		{
+			sprintf(res, "%-40s | %10zu | %10u | %15zu", tags[t].tag, tags[t].liveBytes, tags[t].liveCount, tags[t].highWaterMark);
+			TFE_Console::addToHistory(res);
+		}
+	}
+	TFE_Console::addToHistory("--------------------------------------------------------------------------------");
+}
+
 void game_init()
 {
 	s_gameRegion  = region_create("game",  GAME_MEMORY_BASE);	// Region for "permanent" game allocations.
 	s_levelRegion = region_create("level", LEVEL_MEMORY_BASE);	// Region for "per-level" game allocations.
 
 	CCMD("displayMemoryUsage", displayMemoryUsage, 0, "Display memory usage.");
+	CCMD("memTracking", enableMemoryTracking, 1, "Enable or disable allocation tracking for the game and level regions - memTracking 1");
+	CCMD("memStats", displayMemoryStats, 0, "Display the high-water mark, fragmentation and allocation size classes for each memory region.");
+	CCMD("fastForward", enableFastForward, 1, "Run the simulation as fast as possible, rendering every Nth tick (0 = never) - fastForward 1 [renderInterval]");
+	CCMD("memTags", displayMemoryTags, 0, "Display the call-sites with the most live memory in each region (requires memTracking) - memTags [count]");
 }
 
 void game_destroy()
@@ -10,12 +10,12 @@
 extern MemoryRegion* s_gameRegion;
 extern MemoryRegion* s_levelRegion;
 
-#define game_alloc(size) TFE_Memory::region_alloc(s_gameRegion, size)
-#define game_realloc(ptr, size) TFE_Memory::region_realloc(s_gameRegion, ptr, size)
+#define game_alloc(size) TFE_Memory::region_alloc(s_gameRegion, size, __FUNCTION__)
+#define game_realloc(ptr, size) TFE_Memory::region_realloc(s_gameRegion, ptr, size, __FUNCTION__)
 #define game_free(ptr) TFE_Memory::region_free(s_gameRegion, ptr)
 
-#define level_alloc(size) TFE_Memory::region_alloc(s_levelRegion, size)
-#define level_realloc(ptr, size) TFE_Memory::region_realloc(s_levelRegion, ptr, size)
+#define level_alloc(size) TFE_Memory::region_alloc(s_levelRegion, size, __FUNCTION__)
+#define level_realloc(ptr, size) TFE_Memory::region_realloc(s_levelRegion, ptr, size, __FUNCTION__)
 #define level_free(ptr) TFE_Memory::region_free(s_levelRegion, ptr)
 
 struct IGame
@@ -25,6 +25,8 @@ struct IGame
 	virtual void pauseGame(bool pause) = 0;
 	virtual void pauseSound(bool pause) = 0;
 	virtual void loopGame() {};
+	// TFE: Called each frame after the tasks have run.
+	virtual void renderGame() {};
 	virtual bool serializeGameState(Stream* stream, const char* filename, bool writeState) { return false; };
 	virtual bool canSave() { return false; }
 	virtual void getLevelName(char* name) {};
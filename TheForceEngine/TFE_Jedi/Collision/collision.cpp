@@ -1,4 +1,6 @@
 #include "collision.h"
+#include "objectGrid.h"
+#include "wallGrid.h"
 #include <TFE_Jedi/Level/levelData.h>
 #include <TFE_Jedi/Level/rsector.h>
 #include <TFE_Jedi/Level/rwall.h>
@@ -154,50 +156,68 @@ namespace TFE_Jedi
 		return s_col_hitDist;
 	}
 
-	RWall* collision_pathWallCollision(RSector* sector)
+	static void collision_testPathWall(RWall* wall, RWall** hitWall)
 	{
-		RWall* wall = sector->walls;
-		s32 count = sector->wallCount;
-		RWall* hitWall = nullptr;
-		s_col_hitDist = c_maxCollisionDist;
-		for (s32 i = 0; i < sector->wallCount; i++, wall++)
+		if (s_collisionFrameWall == wall->collisionFrame)
 		{
-			if (s_collisionFrameWall == wall->collisionFrame)
+			return;
+		}
+
+		// returns INTERSECT if s_col_path intersects wall, else returns NO_INTERSECT
+		IntersectionResult intersect = pathIntersectsWall(&s_col_path, wall);
+		if (intersect == INTERSECT)
+		{
+			vec2_fixed* pos = computeIntersectPos();
+			if (pos->x != s_col_path.x0 || pos->z != s_col_path.z0)
 			{
-				continue;
-			}
+				fixed16_16 dx = s_col_path.x1 - s_col_path.x0;
+				fixed16_16 dz = s_col_path.z1 - s_col_path.z0;
 
-			// returns INTERSECT if s_col_path intersects wall, else returns NO_INTERSECT
-			IntersectionResult intersect = pathIntersectsWall(&s_col_path, wall);
+				// Essentially a dot product with the (negative) wall normal, which given the wall direction (dir), normal = (-dir.z, dir.x), negative = (dir.z, -dir.x)
+				// So (dx, dz).(dir.z, -dir.x) = dx*dir.z - dz*dir.x
+				// If the path and the wall are parallel or facing opposite directions (i.e. the object is moving away), then there is no intersection.
+				if (mul16(dx, wall->wallDir.z) - mul16(dz, wall->wallDir.x) >= 0)
+				{
+					intersect = NO_INTERSECT;
+				}
+			}
 			if (intersect == INTERSECT)
 			{
-				vec2_fixed* pos = computeIntersectPos();
-				if (pos->x != s_col_path.x0 || pos->z != s_col_path.z0)
+				fixed16_16 dist = distApprox(s_col_path.x0, s_col_path.z0, pos->x, pos->z);
+				if (dist < s_col_hitDist)
 				{
-					fixed16_16 dx = s_col_path.x1 - s_col_path.x0;
-					fixed16_16 dz = s_col_path.z1 - s_col_path.z0;
-
-					// Essentially a dot product with the (negative) wall normal, which given the wall direction (dir), normal = (-dir.z, dir.x), negative = (dir.z, -dir.x)
-					// So (dx, dz).(dir.z, -dir.x) = dx*dir.z - dz*dir.x
-					// If the path and the wall are parallel or facing opposite directions (i.e. the object is moving away), then there is no intersection.
-					if (mul16(dx, wall->wallDir.z) - mul16(dz, wall->wallDir.x) >= 0)
-					{
-						intersect = NO_INTERSECT;
-					}
-				}
-				if (intersect == INTERSECT)
-				{
-					fixed16_16 dist = distApprox(s_col_path.x0, s_col_path.z0, pos->x, pos->z);
-					if (dist < s_col_hitDist)
-					{
-						s_col_hitX = pos->x;
-						s_col_hitZ = pos->z;
-						s_col_hitDist = dist;
-						hitWall = wall;
-					}
+					s_col_hitX = pos->x;
+					s_col_hitZ = pos->z;
+					s_col_hitDist = dist;
+					*hitWall = wall;
 				}
 			}
 		}
+	}
+
+	RWall* collision_pathWallCollision(RSector* sector)
+	{
+		RWall* hitWall = nullptr;
+		s_col_hitDist = c_maxCollisionDist;
+
+		// TFE: Large sectors only test the walls near the path (see wallGrid.h), in the same order as the full wall list.
+		const s32* candidates = nullptr;
+		const s32 candidateCount = wallGrid_getCandidates(sector, s_col_path.x0, s_col_path.z0, s_col_path.x1, s_col_path.z1, &candidates);
+		if (candidateCount >= 0)
+		{
+			for (s32 i = 0; i < candidateCount; i++)
+			{
+				collision_testPathWall(&sector->walls[candidates[i]], &hitWall);
+			}
+		}
+		else
+		{
+			RWall* wall = sector->walls;
+			for (s32 i = 0; i < sector->wallCount; i++, wall++)
+			{
+				collision_testPathWall(wall, &hitWall);
+			}
+		}
 		if (hitWall)
 		{
 			hitWall->collisionFrame = s_collisionFrameWall;
@@ -353,6 +373,7 @@ namespace TFE_Jedi
 		{
 			obj->posWS.x = x1;
 			obj->posWS.z = z1;
+			objGrid_update(obj);
 			if (newSector != sector)
 			{
 				sector_addObject(newSector, obj);
@@ -454,66 +475,52 @@ namespace TFE_Jedi
 		fixed16_16 y1 = origin.y + radius;
 		fixed16_16 z1 = origin.z + radius;
 
-		fixed16_16 secHeightThreshold = origin.y - FIXED(2);
-		RSector* curSector = s_levelState.sectors;
-
-		for (u32 i = 0; i < s_levelState.sectorCount; i++, curSector++)
+		// TFE: The original code repeated these tests for every sector in the level, but they only depend on the start sector.
+		if (x0 > sector->boundsMax.x || x1 < sector->boundsMin.x || z0 > sector->boundsMax.z || z1 < sector->boundsMin.z)
 		{
-			///////////////////////////////////////////////
-			// These tests should only happen once I think,
-			// unless x0, x1, z0, z1 change over time.
-			///////////////////////////////////////////////
-			if (x0 > sector->boundsMax.x || x1 < sector->boundsMin.x || z0 > sector->boundsMax.z || z1 < sector->boundsMin.z)
-			{
-				continue;
-			}
+			return JFALSE;
+		}
+		fixed16_16 floorHeight, ceilHeight;
+		sector_calculateFloor(sector, origin.y, &floorHeight, &ceilHeight);
+		if (floorHeight < y0 || ceilHeight > y1)
+		{
+			return JFALSE;
+		}
 
-			fixed16_16 floorHeight, ceilHeight;
-			sector_calculateFloor(sector, origin.y, &floorHeight, &ceilHeight);
-			if (floorHeight < y0 || ceilHeight > y1)
+		// TFE: Use the object grid instead of walking the object lists of every sector in the level.
+		ObjGridQuery query;
+		objGrid_queryBegin(&query, x0, z0, x1, z1);
+		while (SecObject* obj = objGrid_queryNext(&query))
+		{
+			if (skipObj && skipObj == obj) { continue; }
+			if (!(obj->entityFlags & entityFlags)) { continue; }
+			if (obj->posWS.y < y0 || obj->posWS.y > y1)
 			{
 				continue;
 			}
-			/////////////////////////////////////////////
-			// End of checks to pull out of the loop.
-			/////////////////////////////////////////////
 
-			s32 objCapacity = curSector->objectCapacity;
-			s32 objCount = curSector->objectCount;
-			for (s32 objListIndex = 0, objIndex = 0; objIndex < objCount && objListIndex < objCapacity; objListIndex++)
+			RSector* curSector = sector;
+			RWall* hitWall = collision_wallCollisionFromPath(sector, origin.x, origin.z, obj->posWS.x, obj->posWS.z);
+			while (hitWall && curSector && curSector != obj->sector)
 			{
-				SecObject* obj = curSector->objectList[objListIndex];
-				if (!obj) { continue; }
-
-				objIndex++;
-				if (skipObj && skipObj == obj) { continue; }
-				if (!(obj->entityFlags & entityFlags)) { continue; }
-				if (obj->posWS.x < x0 || obj->posWS.x > x1 || obj->posWS.z < z0 || obj->posWS.z > z1 || obj->posWS.y < y0 || obj->posWS.y > y1)
-				{
-					continue;
-				}
-
-				RSector* curSector = sector;
-				RWall* hitWall = collision_wallCollisionFromPath(sector, origin.x, origin.z, obj->posWS.x, obj->posWS.z);
-				while (hitWall && curSector && curSector != obj->sector)
+				curSector = hitWall->nextSector;
+				if (curSector)
 				{
-					curSector = hitWall->nextSector;
-					if (curSector)
+					if (curSector->floorHeight - curSector->ceilingHeight < HALF_16)
 					{
-						if (curSector->floorHeight - curSector->ceilingHeight < HALF_16)
-						{
-							break;
-						}
-						hitWall = collision_pathWallCollision(curSector);
+						break;
 					}
+					hitWall = collision_pathWallCollision(curSector);
 				}
+			}
 
-				if (curSector == obj->sector)
-				{
-					return JTRUE;
-				}
+			if (curSector == obj->sector)
+			{
+				objGrid_queryEnd(&query);
+				return JTRUE;
 			}
 		}
+		objGrid_queryEnd(&query);
 		return JFALSE;
 	}
 		
@@ -529,47 +536,50 @@ namespace TFE_Jedi
 		const fixed16_16 y1 = origin.y + range;
 		const fixed16_16 z1 = origin.z + range;
 
-		const fixed16_16 secHeightThreshold = origin.y - FIXED(2);
-		RSector* sector = s_levelState.sectors;
-		for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
+		// TFE: The start sector check only needs to happen once.
+		if (x0 > startSector->boundsMax.x || x1 < startSector->boundsMin.x || z0 > startSector->boundsMax.z || z1 < startSector->boundsMin.z)
 		{
-			// Checks the start sector, should be pulled out of the loop.
-			if (x0 > startSector->boundsMax.x || x1 < startSector->boundsMin.x || z0 > startSector->boundsMax.z || z1 < startSector->boundsMin.z)
+			return;
+		}
+
+		// TFE: Use the object grid instead of walking the object lists of every sector in the level.
+		// Results are ordered by sector, so the floor check is only done when the sector changes.
+		RSector* sector = nullptr;
+		JBool sectorInRange = JFALSE;
+		ObjGridQuery query;
+		objGrid_queryBegin(&query, x0, z0, x1, z1);
+		while (SecObject* obj = objGrid_queryNext(&query))
+		{
+			if (obj->sector != sector)
 			{
-				continue;
+				sector = obj->sector;
+				fixed16_16 floor, ceil;
+				sector_calculateFloor(sector, origin.y, &floor, &ceil);
+				sectorInRange = (y0 > floor || y1 < ceil) ? JFALSE : JTRUE;
 			}
+			if (!sectorInRange) { continue; }
 
-			fixed16_16 floor, ceil;
-			sector_calculateFloor(sector, origin.y, &floor, &ceil);
-			if (y0 > floor || y1 < ceil) { continue; }
-			// End of start sector check.
-
-			for (s32 objIndex = 0, objListIndex = 0; objIndex < sector->objectCount && objListIndex < sector->objectCapacity; objListIndex++)
+			if (excludeObj && excludeObj == obj) { continue; }
+			if (!(obj->entityFlags & entityFlags)) { continue; }
+			if (obj->posWS.y < y0 || obj->posWS.y > y1)
 			{
-				SecObject* obj = sector->objectList[objListIndex];
-				if (!obj) { continue; }
-				objIndex++;
-
-				if (excludeObj && excludeObj == obj) { continue; }
-				if (!(obj->entityFlags & entityFlags)) { continue; }
-				if (obj->posWS.x < x0 || obj->posWS.x > x1 || obj->posWS.z < z0 || obj->posWS.z > z1 || obj->posWS.y < y0 || obj->posWS.y > y1)
-				{
-					continue;
-				}
+				continue;
+			}
 								
-				JBool canHit = collision_lineOfSight(startSector, obj->sector, origin, obj->posWS, WF3_CANNOT_FIRE_THROUGH);
-				if (!canHit)
-				{
-					vec3_fixed topPos = { obj->posWS.x, obj->posWS.y - obj->worldHeight, obj->posWS.z };
-					canHit = collision_lineOfSight(startSector, obj->sector, origin, topPos, WF3_CANNOT_FIRE_THROUGH);
-				}
-				// Finally the object can be hit, so call the effect function.
-				if (canHit)
-				{
-					effectFunc(obj);
-				}
-			}  // Object Loop.
-		}  // Sector loop.
+			JBool canHit = collision_lineOfSight(startSector, obj->sector, origin, obj->posWS, WF3_CANNOT_FIRE_THROUGH);
+			if (!canHit)
+			{
+				vec3_fixed topPos = { obj->posWS.x, obj->posWS.y - obj->worldHeight, obj->posWS.z };
+				canHit = collision_lineOfSight(startSector, obj->sector, origin, topPos, WF3_CANNOT_FIRE_THROUGH);
+			}
+			// Finally the object can be hit, so call the effect function.
+			// Objects removed by the effect function are skipped by the query.
+			if (canHit)
+			{
+				effectFunc(obj);
+			}
+		}
+		objGrid_queryEnd(&query);
 	}
 
 	// Call the effectFunc() for each object within 'range' of point (x,y,z). This will only be called for objects in range and that have a valid collision path.
@@ -589,71 +599,66 @@ namespace TFE_Jedi
 		const fixed16_16 y1 = origin.y + range;
 		const fixed16_16 z1 = origin.z + range;
 
-		const fixed16_16 secHeightThreshold = origin.y - FIXED(2);
-		RSector* sector = s_levelState.sectors;
-		for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
+		// TFE: The start sector checks only need to happen once.
+		if (x0 > startSector->boundsMax.x || x1 < startSector->boundsMin.x || z0 > startSector->boundsMax.z || z1 < startSector->boundsMin.z)
 		{
-			// Checks the start sector, should be pulled out of the loop.
-			if (x0 > startSector->boundsMax.x || x1 < startSector->boundsMin.x || z0 > startSector->boundsMax.z || z1 < startSector->boundsMin.z)
+			return;
+		}
+		fixed16_16 floor, ceil;
+		sector_calculateFloor(startSector, origin.y, &floor, &ceil);
+		if (y0 > floor || y1 < ceil)
+		{
+			return;
+		}
+
+		// TFE: Use the object grid instead of walking the object lists of every sector in the level.
+		ObjGridQuery query;
+		objGrid_queryBegin(&query, x0, z0, x1, z1);
+		while (SecObject* obj = objGrid_queryNext(&query))
+		{
+			if (excludeObj && excludeObj == obj) { continue; }
+			if (!(obj->entityFlags & entityFlags)) { continue; }
+			if (obj->posWS.y < y0 || obj->posWS.y > y1)
 			{
 				continue;
 			}
-			fixed16_16 floor, ceil;
-			sector_calculateFloor(startSector, origin.y, &floor, &ceil);
-			if (y0 > floor || y1 < ceil)
+
+			fixed16_16 dx = obj->posWS.x - origin.x;
+			fixed16_16 dz = obj->posWS.z - origin.z;
+			RWall* hitWall = nullptr;
+			if (dx || dz)
 			{
-				continue;
+				s_col_path.x0 = origin.x;
+				s_col_path.z0 = origin.z;
+				s_col_path.x1 = obj->posWS.x;
+				s_col_path.z1 = obj->posWS.z;
+				s_collisionFrameWall++;
+				hitWall = collision_pathWallCollision(startSector);
 			}
-			// End of start sector check.
 
-			for (s32 objIndex = 0, objListIndex = 0; objIndex < sector->objectCount && objListIndex < sector->objectCapacity; objListIndex++)
+			RSector* nextSector = startSector;
+			while (hitWall && nextSector && nextSector != obj->sector)
 			{
-				SecObject* obj = sector->objectList[objListIndex];
-				if (!obj) { continue; }
-				objIndex++;
-
-				if (excludeObj && excludeObj == obj) { continue; }
-				if (!(obj->entityFlags & entityFlags)) { continue; }
-				if (obj->posWS.x < x0 || obj->posWS.x > x1 || obj->posWS.z < z0 || obj->posWS.z > z1 || obj->posWS.y < y0 || obj->posWS.y > y1)
+				nextSector = hitWall->nextSector;
+				if (nextSector)
 				{
-					continue;
-				}
-
-				fixed16_16 dx = obj->posWS.x - origin.x;
-				fixed16_16 dz = obj->posWS.z - origin.z;
-				RWall* hitWall = nullptr;
-				if (dx || dz)
-				{
-					s_col_path.x0 = origin.x;
-					s_col_path.z0 = origin.z;
-					s_col_path.x1 = obj->posWS.x;
-					s_col_path.z1 = obj->posWS.z;
-					s_collisionFrameWall++;
-					hitWall = collision_pathWallCollision(startSector);
-				}
-
-				RSector* nextSector = startSector;
-				while (hitWall && nextSector && nextSector != obj->sector)
-				{
-					nextSector = hitWall->nextSector;
-					if (nextSector)
+					const fixed16_16 height = nextSector->floorHeight - nextSector->ceilingHeight;
+					if (height < c_minTraversableOpening)
 					{
-						const fixed16_16 height = nextSector->floorHeight - nextSector->ceilingHeight;
-						if (height < c_minTraversableOpening)
-						{
-							break;
-						}
-						hitWall = collision_pathWallCollision(nextSector);
+						break;
 					}
+					hitWall = collision_pathWallCollision(nextSector);
 				}
+			}
 
-				// If there is a clear path from the source position to the object in range, call the specified function.
-				if (nextSector == obj->sector)
-				{
-					effectFunc(obj);
-				}
-			}  // Object Loop.
-		}  // Sector Loop.
+			// If there is a clear path from the source position to the object in range, call the specified function.
+			// Objects removed by the effect function are skipped by the query.
+			if (nextSector == obj->sector)
+			{
+				effectFunc(obj);
+			}
+		}
+		objGrid_queryEnd(&query);
 	}
 		
 	static RSector*   s_hcolSector;
@@ -795,6 +800,7 @@ namespace TFE_Jedi
 		// Update the object XZ position.
 		s_hcolObj->posWS.x = s_hcolDstPos.x;
 		s_hcolObj->posWS.z = s_hcolDstPos.z;
+		objGrid_update(s_hcolObj);
 
 		// Determine the floor and ceiling height for the current sector based on the object position.
 		fixed16_16 floorHeight, ceilHeight;
@@ -959,8 +965,6 @@ namespace TFE_Jedi
 		for (; s_colObjCount > 0; s_colObjList++)
 		{
 			SecObject* obj = *s_colObjList;
-			if (!obj) { continue; }
-
 			s_colObjCount--;
 			if (!obj->worldWidth || obj == s_colObjPrev) { continue; }
 
@@ -1042,6 +1046,80 @@ namespace TFE_Jedi
 		return (sector == endSector) ? JTRUE : JFALSE;
 	}
 
+	// TFE: Casts several rays that share the same XZ path but end at different heights, walking the sectors only once.
+	// Each ray gets the same result as calling collision_canHitObject() with (x1, y1[i], z1).
+	s32 collision_canHitObjectHeights(RSector* startSector, RSector* endSector, vec3_fixed p0, fixed16_16 x1, fixed16_16 z1, const fixed16_16* y1, s32 count,
+		                              u32 exclWallFlags3, JBool* canHit, JBool* wallHit)
+	{
+		enum { MAX_RAYS = 8 };
+		assert(count > 0 && count <= MAX_RAYS);
+		fixed16_16 yStep[MAX_RAYS];
+		JBool active[MAX_RAYS];
+
+		const fixed16_16 approxDist = distApprox(p0.x, p0.z, x1, z1);
+		for (s32 i = 0; i < count; i++)
+		{
+			const fixed16_16 dy = y1[i] - p0.y;
+			yStep[i] = approxDist ? div16(dy, approxDist) : dy;
+			active[i] = JTRUE;
+			canHit[i] = JFALSE;
+			wallHit[i] = JFALSE;
+		}
+		s32 activeCount = count;
+
+		RSector* sector = startSector;
+		RWall* hitWall = nullptr;
+		if (x1 - p0.x != 0 || z1 - p0.z != 0)
+		{
+			s_col_path.x0 = p0.x;
+			s_col_path.z0 = p0.z;
+			s_col_path.x1 = x1;
+			s_col_path.z1 = z1;
+			s_collisionFrameWall++;
+			hitWall = collision_pathWallCollision(sector);
+		}
+		while (hitWall)
+		{
+			RSector* nextSector = hitWall->nextSector;
+			if (!nextSector || (hitWall->flags3 & exclWallFlags3))
+			{
+				for (s32 i = 0; i < count; i++)
+				{
+					wallHit[i] = (active[i] && !nextSector) ? JTRUE : JFALSE;
+				}
+				return 0;
+			}
+			RSector* hitSector = hitWall->sector;
+			for (s32 i = 0; i < count; i++)
+			{
+				if (!active[i]) { continue; }
+				fixed16_16 yHit = p0.y + mul16(s_col_hitDist, yStep[i]);
+				if (yHit < hitSector->ceilingHeight || yHit < nextSector->ceilingHeight || yHit > hitSector->floorHeight || yHit > nextSector->floorHeight)
+				{
+					active[i] = JFALSE;
+					activeCount--;
+				}
+			}
+			if (!activeCount)
+			{
+				return 0;
+			}
+			sector = nextSector;
+			hitWall = collision_pathWallCollision(nextSector);
+		}
+
+		s32 hitCount = 0;
+		if (sector == endSector)
+		{
+			for (s32 i = 0; i < count; i++)
+			{
+				canHit[i] = active[i];
+				hitCount += active[i] ? 1 : 0;
+			}
+		}
+		return hitCount;
+	}
+
 	JBool collision_propogateExplosion(RSector* sector)
 	{
 		message_sendToSector(sector, nullptr, INF_EVENT_EXPLOSION, MSG_TRIGGER);
@@ -83,6 +83,9 @@ namespace TFE_Jedi
 	RWall* collision_pathWallCollision(RSector* sector);
 	RWall* collision_wallCollisionFromPath(RSector* sector, fixed16_16 srcX, fixed16_16 srcZ, fixed16_16 dstX, fixed16_16 dstZ);
 	JBool collision_canHitObject(RSector* startSector, RSector* endSector, vec3_fixed p0, vec3_fixed p1, u32 exclWallFlags3);
+	// TFE: Batched version of collision_canHitObject() for up to 8 rays ending at (x1, y1[i], z1), returns the number of rays that can hit.
+	s32 collision_canHitObjectHeights(RSector* startSector, RSector* endSector, vec3_fixed p0, fixed16_16 x1, fixed16_16 z1, const fixed16_16* y1, s32 count,
+		                              u32 exclWallFlags3, JBool* canHit, JBool* wallHit);
 
 	SecObject* collision_getObjectCollision(RSector* sector, CollisionInterval* interval, SecObject* prevObj);
 	JBool collision_isAnyObjectInRange(RSector* sector, fixed16_16 radius, vec3_fixed origin, SecObject* skipObj, u32 entityFlags);
@@ -0,0 +1,234 @@
+#include <cstring>
+
+#include "objectGrid.h"
+#include <TFE_Jedi/Level/rsector.h>
+#include <TFE_Jedi/Level/robject.h>
+#include <TFE_System/system.h>
+#include <TFE_System/profiler.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <algorithm>
+
+namespace TFE_Jedi
+{
+	enum ObjGridConstants
+	{
+		OBJ_GRID_CELL_SHIFT   = 16 + 5,	// 32 DF units per cell.
+		OBJ_GRID_BUCKET_COUNT = 4096,
+		OBJ_GRID_BUCKET_MASK  = OBJ_GRID_BUCKET_COUNT - 1,
+		OBJ_GRID_MIN_RESULTS  = 256,
+	};
+
+	struct ObjGridEntry
+	{
+		SecObject* obj;
+		u32 id;
+	};
+
+	struct ObjGridState
+	{
+		SecObject* buckets[OBJ_GRID_BUCKET_COUNT];
+		u32 bucketStamp[OBJ_GRID_BUCKET_COUNT];
+		u32 stamp;
+		u32 nextId;
+
+		// Result stack, shared by all active queries.
+		ObjGridEntry* results;
+		s32 resultCapacity;
+		s32 resultTop;
+	};
+	static ObjGridState s_objGrid = {};
+	static s32 s_objGridCount = 0;
+
+	static inline s32 objGrid_cell(fixed16_16 v)
+	{
+		return v >> OBJ_GRID_CELL_SHIFT;
+	}
+
+	static inline u32 objGrid_key(s32 cx, s32 cz)
+	{
+		return u32(cx & 0xffff) | (u32(cz & 0xffff) << 16u);
+	}
+
+	static inline u32 objGrid_bucket(s32 cx, s32 cz)
+	{
+		return (u32(cx) * 73856093u ^ u32(cz) * 19349663u) & OBJ_GRID_BUCKET_MASK;
+	}
+
+	static void objGrid_link(SecObject* obj, u32 bucket)
+	{
+		SecObject* head = s_objGrid.buckets[bucket];
+		obj->gridPrev = nullptr;
+		obj->gridNext = head;
+		if (head) { head->gridPrev = obj; }
+		s_objGrid.buckets[bucket] = obj;
+	}
+
+	static void objGrid_unlink(SecObject* obj, u32 bucket)
+	{
+		if (obj->gridPrev) { obj->gridPrev->gridNext = obj->gridNext; }
+		else { s_objGrid.buckets[bucket] = obj->gridNext; }
+		if (obj->gridNext) { obj->gridNext->gridPrev = obj->gridPrev; }
+		obj->gridPrev = nullptr;
+		obj->gridNext = nullptr;
+	}
+
+	static inline u32 objGrid_keyToBucket(u32 key)
+	{
+		return objGrid_bucket(s16(key & 0xffff), s16(key >> 16u));
+	}
+
+	void objGrid_clear()
+	{
+		memset(s_objGrid.buckets, 0, sizeof(s_objGrid.buckets));
+		memset(s_objGrid.bucketStamp, 0, sizeof(s_objGrid.bucketStamp));
+		s_objGrid.stamp = 0;
+		s_objGrid.nextId = 0;
+		s_objGrid.resultTop = 0;
+		s_objGridCount = 0;
+
+		TFE_COUNTER(s_objGridCount, "Object Grid Count");
+	}
+
+	void objGrid_insert(SecObject* obj)
+	{
+		if (obj->gridId)
+		{
+			objGrid_update(obj);
+			return;
+		}
+		const s32 cx = objGrid_cell(obj->posWS.x);
+		const s32 cz = objGrid_cell(obj->posWS.z);
+		obj->gridKey = objGrid_key(cx, cz);
+
+		// Ids are never reused so that queries can detect objects that were removed and reallocated.
+		s_objGrid.nextId++;
+		if (!s_objGrid.nextId) { s_objGrid.nextId++; }
+		obj->gridId = s_objGrid.nextId;
+
+		objGrid_link(obj, objGrid_bucket(cx, cz));
+		s_objGridCount++;
+	}
+
+	void objGrid_remove(SecObject* obj)
+	{
+		if (!obj->gridId) { return; }
+		objGrid_unlink(obj, objGrid_keyToBucket(obj->gridKey));
+		obj->gridId = 0;
+		s_objGridCount--;
+	}
+
+	void objGrid_update(SecObject* obj)
+	{
+		if (!obj->gridId) { return; }
+		const s32 cx = objGrid_cell(obj->posWS.x);
+		const s32 cz = objGrid_cell(obj->posWS.z);
+		const u32 key = objGrid_key(cx, cz);
+		if (key == obj->gridKey) { return; }
+
+		const u32 bucket = objGrid_bucket(cx, cz);
+		const u32 prevBucket = objGrid_keyToBucket(obj->gridKey);
+		obj->gridKey = key;
+		if (bucket != prevBucket)
+		{
+			objGrid_unlink(obj, prevBucket);
+			objGrid_link(obj, bucket);
+		}
+	}
+
+	static void objGrid_pushResult(SecObject* obj)
+	{
+		if (s_objGrid.resultTop >= s_objGrid.resultCapacity)
+		{
+			s_objGrid.resultCapacity = std::max(s32(OBJ_GRID_MIN_RESULTS), s_objGrid.resultCapacity * 2);
+			s_objGrid.results = (ObjGridEntry*)realloc(s_objGrid.results, sizeof(ObjGridEntry) * s_objGrid.resultCapacity);
+			if (!s_objGrid.results)
+			{
+				TFE_System::logWrite(LOG_ERROR, "Object Grid", "Failed to allocate %d query results.", s_objGrid.resultCapacity);
+				assert(0);
+				return;
+			}
+		}
+		s_objGrid.results[s_objGrid.resultTop++] = { obj, obj->gridId };
+	}
+
+	static void objGrid_gatherBucket(u32 bucket, fixed16_16 x0, fixed16_16 z0, fixed16_16 x1, fixed16_16 z1, RSector* sector)
+	{
+		for (SecObject* obj = s_objGrid.buckets[bucket]; obj; obj = obj->gridNext)
+		{
+			if (sector && obj->sector != sector) { continue; }
+			if (obj->posWS.x < x0 || obj->posWS.x > x1 || obj->posWS.z < z0 || obj->posWS.z > z1) { continue; }
+			objGrid_pushResult(obj);
+		}
+	}
+
+	static bool objGrid_sortFunc(const ObjGridEntry& a, const ObjGridEntry& b)
+	{
+		const s32 sa = a.obj->sector->index, sb = b.obj->sector->index;
+		return (sa != sb) ? sa < sb : a.obj->index < b.obj->index;
+	}
+
+	s32 objGrid_queryBegin(ObjGridQuery* query, fixed16_16 x0, fixed16_16 z0, fixed16_16 x1, fixed16_16 z1, RSector* sector)
+	{
+		query->start = s_objGrid.resultTop;
+		query->pos = 0;
+
+		const s32 cx0 = objGrid_cell(x0), cx1 = objGrid_cell(x1);
+		const s32 cz0 = objGrid_cell(z0), cz1 = objGrid_cell(z1);
+		const s64 cellCount = s64(cx1 - cx0 + 1) * s64(cz1 - cz0 + 1);
+		if (cellCount >= OBJ_GRID_BUCKET_COUNT)
+		{
+			// The query covers more cells than there are buckets, so just visit every bucket.
+			for (u32 b = 0; b < OBJ_GRID_BUCKET_COUNT; b++)
+			{
+				objGrid_gatherBucket(b, x0, z0, x1, z1, sector);
+			}
+		}
+		else
+		{
+			// Different cells may map to the same bucket, make sure each bucket is only visited once.
+			s_objGrid.stamp++;
+			if (!s_objGrid.stamp)
+			{
+				memset(s_objGrid.bucketStamp, 0, sizeof(s_objGrid.bucketStamp));
+				s_objGrid.stamp++;
+			}
+			for (s32 cz = cz0; cz <= cz1; cz++)
+			{
+				for (s32 cx = cx0; cx <= cx1; cx++)
+				{
+					const u32 bucket = objGrid_bucket(cx, cz);
+					if (s_objGrid.bucketStamp[bucket] == s_objGrid.stamp) { continue; }
+					s_objGrid.bucketStamp[bucket] = s_objGrid.stamp;
+					objGrid_gatherBucket(bucket, x0, z0, x1, z1, sector);
+				}
+			}
+		}
+
+		query->count = s_objGrid.resultTop - query->start;
+		ObjGridEntry* results = s_objGrid.results + query->start;
+		std::sort(results, results + query->count, objGrid_sortFunc);
+		return query->count;
+	}
+
+	SecObject* objGrid_queryNext(ObjGridQuery* query)
+	{
+		while (query->pos < query->count)
+		{
+			// Re-read the result pointer each time, nested queries may have grown the buffer.
+			const ObjGridEntry* entry = &s_objGrid.results[query->start + query->pos];
+			query->pos++;
+			if (entry->obj->gridId == entry->id)
+			{
+				return entry->obj;
+			}
+		}
+		return nullptr;
+	}
+
+	void objGrid_queryEnd(ObjGridQuery* query)
+	{
+		assert(s_objGrid.resultTop == query->start + query->count);
+		s_objGrid.resultTop = query->start;
+	}
+}
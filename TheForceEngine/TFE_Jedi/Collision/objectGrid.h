@@ -0,0 +1,44 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Object Grid
+// TFE: Uniform grid (spatial hash) of all objects that belong to a
+// sector, used as a broadphase by the object range queries.
+//
+// Objects are added and removed along with their sector membership
+// (see sector_addObject() / sector_removeObject()), code that changes
+// an object's XZ position without changing sectors must call
+// objGrid_update().
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include <TFE_Jedi/Math/core_math.h>
+
+struct RSector;
+struct SecObject;
+
+// Query results are stored on a shared stack, so queries can be nested
+// (i.e. an effect function may start another query).
+struct ObjGridQuery
+{
+	s32 start;
+	s32 count;
+	s32 pos;
+};
+
+namespace TFE_Jedi
+{
+	void objGrid_clear();
+
+	void objGrid_insert(SecObject* obj);
+	void objGrid_remove(SecObject* obj);
+	// Call after changing the XZ position of an object.
+	void objGrid_update(SecObject* obj);
+
+	// Gather all objects with positions inside of the [x0,x1]x[z0,z1] rectangle.
+	// If 'sector' is not null, only objects in that sector are returned.
+	// Results are ordered by sector and then by the object index in the sector, matching the order of
+	// walking the sector object lists.
+	s32 objGrid_queryBegin(ObjGridQuery* query, fixed16_16 x0, fixed16_16 z0, fixed16_16 x1, fixed16_16 z1, RSector* sector = nullptr);
+	// Returns the next object, skipping objects that have been removed since the query began.
+	SecObject* objGrid_queryNext(ObjGridQuery* query);
+	void objGrid_queryEnd(ObjGridQuery* query);
+}
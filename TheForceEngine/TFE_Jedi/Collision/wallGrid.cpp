@@ -0,0 +1,305 @@
+#include <cstring>
+
+#include "wallGrid.h"
+#include <TFE_Jedi/Level/levelData.h>
+#include <TFE_Jedi/Level/rsector.h>
+#include <TFE_Jedi/Level/rwall.h>
+#include <TFE_System/system.h>
+#include <TFE_System/profiler.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <math.h>
+#include <climits>
+#include <algorithm>
+
+namespace TFE_Jedi
+{
+	enum WallGridConstants
+	{
+		WALL_GRID_MIN_WALLS  = 32,		// Smaller sectors just test every wall.
+		WALL_GRID_MIN_SHIFT  = 16,		// Cells are at least 1 DF unit in size.
+		WALL_GRID_MAX_CELLS  = 64,		// Maximum cells per axis.
+	};
+
+	struct WallGrid
+	{
+		fixed16_16 minX;
+		fixed16_16 minZ;
+		s32 shift;
+		s32 width;
+		s32 height;
+		// Static walls in each cell, cell i uses cellWalls[cellStart[i], cellStart[i + 1]).
+		s32* cellStart;
+		s32* cellWalls;
+		// Walls that may move, these are always candidates.
+		s32* dynamicWalls;
+		s32  dynamicCount;
+	};
+
+	static WallGrid** s_wallGrids = nullptr;
+	static JBool* s_wallGridBuilt = nullptr;
+	static u32 s_wallGridSectorCount = 0;
+
+	// Candidate gathering.
+	static u32* s_wallStamp = nullptr;
+	static s32  s_wallStampCapacity = 0;
+	static u32  s_stamp = 0;
+	static s32* s_candidates = nullptr;
+
+	static s32 s_wallGridCount = 0;
+
+	static void wallGrid_free(WallGrid* grid)
+	{
+		if (!grid) { return; }
+		free(grid->cellStart);
+		free(grid->cellWalls);
+		free(grid->dynamicWalls);
+		free(grid);
+	}
+
+	void wallGrid_clear()
+	{
+		for (u32 i = 0; i < s_wallGridSectorCount; i++)
+		{
+			wallGrid_free(s_wallGrids[i]);
+		}
+		free(s_wallGrids);
+		free(s_wallGridBuilt);
+		s_wallGrids = nullptr;
+		s_wallGridBuilt = nullptr;
+		s_wallGridSectorCount = 0;
+		s_wallGridCount = 0;
+
+		TFE_COUNTER(s_wallGridCount, "Wall Grid Sectors");
+	}
+
+	void wallGrid_invalidate(RSector* sector)
+	{
+		if (!sector || sector->index < 0 || u32(sector->index) >= s_wallGridSectorCount) { return; }
+		if (s_wallGrids[sector->index])
+		{
+			s_wallGridCount--;
+		}
+		wallGrid_free(s_wallGrids[sector->index]);
+		s_wallGrids[sector->index] = nullptr;
+		s_wallGridBuilt[sector->index] = JFALSE;
+	}
+
+	static inline s32 wallGrid_cellX(const WallGrid* grid, fixed16_16 x)
+	{
+		return std::max(0, std::min(grid->width - 1, s32((s64(x) - s64(grid->minX)) >> grid->shift)));
+	}
+
+	static inline s32 wallGrid_cellZ(const WallGrid* grid, fixed16_16 z)
+	{
+		return std::max(0, std::min(grid->height - 1, s32((s64(z) - s64(grid->minZ)) >> grid->shift)));
+	}
+
+	// A wall can move if it morphs or shares a vertex with a wall that morphs (only w0 of a morphing wall moves).
+	static bool wallGrid_isDynamic(RSector* sector, RWall* wall)
+	{
+		if (wall->flags1 & WF1_WALL_MORPHS) { return true; }
+		RWall* other = sector->walls;
+		for (s32 i = 0; i < sector->wallCount; i++, other++)
+		{
+			if ((other->flags1 & WF1_WALL_MORPHS) && (other->w0 == wall->w0 || other->w0 == wall->w1))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static WallGrid* wallGrid_build(RSector* sector)
+	{
+		const s32 wallCount = sector->wallCount;
+		bool* dynamic = (bool*)malloc(sizeof(bool) * wallCount);
+		if (!dynamic) { return nullptr; }
+
+		// Bounds of the static walls.
+		fixed16_16 minX = 0, minZ = 0, maxX = 0, maxZ = 0;
+		s32 staticCount = 0;
+		RWall* wall = sector->walls;
+		for (s32 i = 0; i < wallCount; i++, wall++)
+		{
+			dynamic[i] = wallGrid_isDynamic(sector, wall);
+			if (dynamic[i]) { continue; }
+
+			const fixed16_16 wx0 = std::min(wall->w0->x, wall->w1->x), wx1 = std::max(wall->w0->x, wall->w1->x);
+			const fixed16_16 wz0 = std::min(wall->w0->z, wall->w1->z), wz1 = std::max(wall->w0->z, wall->w1->z);
+			minX = staticCount ? std::min(minX, wx0) : wx0;
+			minZ = staticCount ? std::min(minZ, wz0) : wz0;
+			maxX = staticCount ? std::max(maxX, wx1) : wx1;
+			maxZ = staticCount ? std::max(maxZ, wz1) : wz1;
+			staticCount++;
+		}
+		if (staticCount < WALL_GRID_MIN_WALLS)
+		{
+			free(dynamic);
+			return nullptr;
+		}
+
+		WallGrid* grid = (WallGrid*)calloc(1, sizeof(WallGrid));
+		grid->minX = minX;
+		grid->minZ = minZ;
+
+		// Aim for roughly one static wall per cell.
+		const s64 extent = std::max(s64(maxX) - s64(minX), s64(maxZ) - s64(minZ));
+		const s32 cellsPerAxis = std::max(1, std::min(s32(WALL_GRID_MAX_CELLS), s32(sqrt(f64(staticCount)))));
+		grid->shift = WALL_GRID_MIN_SHIFT;
+		while ((extent >> grid->shift) >= cellsPerAxis) { grid->shift++; }
+		grid->width  = s32((s64(maxX) - s64(minX)) >> grid->shift) + 1;
+		grid->height = s32((s64(maxZ) - s64(minZ)) >> grid->shift) + 1;
+
+		// Count the walls in each cell, then fill the cells.
+		const s32 cellCount = grid->width * grid->height;
+		grid->cellStart = (s32*)calloc(cellCount + 1, sizeof(s32));
+		grid->dynamicWalls = (s32*)malloc(sizeof(s32) * std::max(1, wallCount - staticCount));
+		for (s32 pass = 0; pass < 2; pass++)
+		{
+			wall = sector->walls;
+			for (s32 i = 0; i < wallCount; i++, wall++)
+			{
+				if (dynamic[i])
+				{
+					if (pass == 0) { grid->dynamicWalls[grid->dynamicCount++] = i; }
+					continue;
+				}
+				const s32 cx0 = wallGrid_cellX(grid, std::min(wall->w0->x, wall->w1->x)), cx1 = wallGrid_cellX(grid, std::max(wall->w0->x, wall->w1->x));
+				const s32 cz0 = wallGrid_cellZ(grid, std::min(wall->w0->z, wall->w1->z)), cz1 = wallGrid_cellZ(grid, std::max(wall->w0->z, wall->w1->z));
+				for (s32 cz = cz0; cz <= cz1; cz++)
+				{
+					for (s32 cx = cx0; cx <= cx1; cx++)
+					{
+						const s32 cell = cz * grid->width + cx;
+						if (pass == 0) { grid->cellStart[cell + 1]++; }
+						else { grid->cellWalls[grid->cellStart[cell]++] = i; }
+					}
+				}
+			}
+
+			if (pass == 0)
+			{
+				for (s32 c = 0; c < cellCount; c++) { grid->cellStart[c + 1] += grid->cellStart[c]; }
+				grid->cellWalls = (s32*)malloc(sizeof(s32) * std::max(1, grid->cellStart[cellCount]));
+			}
+		}
+		// The fill pass advanced each start to the end of its cell, shift them back.
+		for (s32 c = cellCount; c > 0; c--) { grid->cellStart[c] = grid->cellStart[c - 1]; }
+		grid->cellStart[0] = 0;
+
+		free(dynamic);
+		s_wallGridCount++;
+		return grid;
+	}
+
+	static WallGrid* wallGrid_get(RSector* sector)
+	{
+		if (sector->wallCount < WALL_GRID_MIN_WALLS || sector->index < 0 || u32(sector->index) >= s_levelState.sectorCount)
+		{
+			return nullptr;
+		}
+		if (s_wallGridSectorCount != s_levelState.sectorCount)
+		{
+			wallGrid_clear();
+			s_wallGridSectorCount = s_levelState.sectorCount;
+			s_wallGrids = (WallGrid**)calloc(s_wallGridSectorCount, sizeof(WallGrid*));
+			s_wallGridBuilt = (JBool*)calloc(s_wallGridSectorCount, sizeof(JBool));
+		}
+		if (!s_wallGridBuilt[sector->index])
+		{
+			s_wallGrids[sector->index] = wallGrid_build(sector);
+			s_wallGridBuilt[sector->index] = JTRUE;
+		}
+		return s_wallGrids[sector->index];
+	}
+
+	static void wallGrid_addCandidate(s32 wallIndex, s32* count)
+	{
+		if (s_wallStamp[wallIndex] == s_stamp) { return; }
+		s_wallStamp[wallIndex] = s_stamp;
+		s_candidates[(*count)++] = wallIndex;
+	}
+
+	s32 wallGrid_getCandidates(RSector* sector, fixed16_16 x0, fixed16_16 z0, fixed16_16 x1, fixed16_16 z1, const s32** candidates)
+	{
+		WallGrid* grid = wallGrid_get(sector);
+		if (!grid) { return -1; }
+
+		const s32 wallCount = sector->wallCount;
+		if (wallCount > s_wallStampCapacity)
+		{
+			s_wallStampCapacity = std::max(wallCount, s_wallStampCapacity * 2);
+			s_wallStamp = (u32*)realloc(s_wallStamp, sizeof(u32) * s_wallStampCapacity);
+			s_candidates = (s32*)realloc(s_candidates, sizeof(s32) * s_wallStampCapacity);
+			if (!s_wallStamp || !s_candidates)
+			{
+				TFE_System::logWrite(LOG_ERROR, "Wall Grid", "Failed to allocate candidate buffers for %d walls.", wallCount);
+				assert(0);
+				s_wallStampCapacity = 0;
+				return -1;
+			}
+			memset(s_wallStamp, 0, sizeof(u32) * s_wallStampCapacity);
+			s_stamp = 0;
+		}
+		s_stamp++;
+		if (!s_stamp)
+		{
+			memset(s_wallStamp, 0, sizeof(u32) * s_wallStampCapacity);
+			s_stamp++;
+		}
+
+		s32 count = 0;
+		for (s32 i = 0; i < grid->dynamicCount; i++)
+		{
+			wallGrid_addCandidate(grid->dynamicWalls[i], &count);
+		}
+
+		// Walk the columns covered by the path, and the rows it covers within each column.
+		// Both are expanded by one cell so that walls that are nearly touching the path are still tested.
+		const fixed16_16 pathMinX = std::min(x0, x1), pathMaxX = std::max(x0, x1);
+		const s64 gridMaxX = s64(grid->minX) + (s64(grid->width) << grid->shift);
+		const s64 gridMaxZ = s64(grid->minZ) + (s64(grid->height) << grid->shift);
+		if (s64(pathMaxX) < s64(grid->minX) - (s64(1) << grid->shift) || s64(pathMinX) >= gridMaxX + (s64(1) << grid->shift) ||
+			s64(std::max(z0, z1)) < s64(grid->minZ) - (s64(1) << grid->shift) || s64(std::min(z0, z1)) >= gridMaxZ + (s64(1) << grid->shift))
+		{
+			*candidates = s_candidates;
+			std::sort(s_candidates, s_candidates + count);
+			return count;
+		}
+
+		const f64 dx = f64(x1) - f64(x0);
+		const f64 dz = f64(z1) - f64(z0);
+		const s32 cx0 = std::max(0, wallGrid_cellX(grid, pathMinX) - 1);
+		const s32 cx1 = std::min(grid->width - 1, wallGrid_cellX(grid, pathMaxX) + 1);
+		for (s32 cx = cx0; cx <= cx1; cx++)
+		{
+			// Z range of the path inside of this column, columns beyond the ends of the path use the nearest end point.
+			const s64 colStart = s64(grid->minX) + (s64(cx) << grid->shift);
+			const s64 colX0 = std::max(s64(pathMinX), std::min(s64(pathMaxX), colStart));
+			const s64 colX1 = std::max(s64(pathMinX), std::min(s64(pathMaxX), colStart + (s64(1) << grid->shift)));
+			f64 za = z0, zb = z1;
+			if (dx != 0.0)
+			{
+				za = f64(z0) + f64(colX0 - s64(x0)) * dz / dx;
+				zb = f64(z0) + f64(colX1 - s64(x0)) * dz / dx;
+			}
+			const fixed16_16 zMin = fixed16_16(std::max(f64(INT_MIN), std::min(za, zb)));
+			const fixed16_16 zMax = fixed16_16(std::min(f64(INT_MAX), std::max(za, zb)));
+			const s32 cz0 = std::max(0, wallGrid_cellZ(grid, zMin) - 1);
+			const s32 cz1 = std::min(grid->height - 1, wallGrid_cellZ(grid, zMax) + 1);
+			for (s32 cz = cz0; cz <= cz1; cz++)
+			{
+				const s32 cell = cz * grid->width + cx;
+				for (s32 i = grid->cellStart[cell]; i < grid->cellStart[cell + 1]; i++)
+				{
+					wallGrid_addCandidate(grid->cellWalls[i], &count);
+				}
+			}
+		}
+
+		std::sort(s_candidates, s_candidates + count);
+		*candidates = s_candidates;
+		return count;
+	}
+}
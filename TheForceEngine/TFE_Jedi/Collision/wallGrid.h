@@ -0,0 +1,27 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Wall Grid
+// TFE: Per-sector uniform grid over the walls of large sectors, used
+// by the path/wall collision queries so that a path only tests the
+// walls near it instead of every wall in the sector.
+//
+// Grids are built on demand. Walls that can move (WF1_WALL_MORPHS and
+// walls sharing a vertex with them) are kept out of the grid and are
+// always returned as candidates, so moving sectors never invalidate the
+// grid. Call wallGrid_invalidate() if the wall flags change.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include <TFE_Jedi/Math/core_math.h>
+
+struct RSector;
+
+namespace TFE_Jedi
+{
+	void wallGrid_clear();
+	void wallGrid_invalidate(RSector* sector);
+
+	// Gather the walls that the path from (x0,z0) to (x1,z1) may intersect, as wall indices in increasing order
+	// so that the walls are tested in the same order as walking the full wall list.
+	// Returns -1 if the sector does not use a grid, in which case all of the walls should be tested.
+	s32 wallGrid_getCandidates(RSector* sector, fixed16_16 x0, fixed16_16 z0, fixed16_16 x1, fixed16_16 z1, const s32** candidates);
+}
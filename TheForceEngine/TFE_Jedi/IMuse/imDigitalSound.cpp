@@ -8,16 +8,26 @@
 #include <TFE_System/system.h>
 #include <TFE_Audio/midi.h>
 #include <TFE_Audio/audioSystem.h>
+#include <TFE_Audio/mixKernels.h>
+#include <TFE_System/spscQueue.h>
 #include <assert.h>
+#include <mutex>
 
 namespace TFE_Jedi
 {
 	#define MAX_SOUND_CHANNELS 16
 	#define DEFAULT_SOUND_CHANNELS 8
 	#define AUDIO_BUFFER_SIZE 512
+	#define AUDIO_NORMALIZATION_SIZE (MAX_SOUND_CHANNELS * 256 + 4)
+	#define AUDIO_NORMALIZATION_TABLES 3
+	#define AUDIO_SYNC_TIMEOUT 0.5	// seconds
 
-	#define AUDIO_LOCK()   TFE_Audio::lock()
-	#define AUDIO_UNLOCK() TFE_Audio::unlock()
+	// TFE: The DOS code disabled interrupts while changing the sounds being mixed. Instead the wave sounds are split into
+	// the control state (ImWaveSound), used by the iMuse API on the game and iMuse threads, and the mixer state (ImWaveVoice)
+	// owned by the audio thread. Changes are sent to the audio thread through a lock-free command queue that it drains at
+	// the start of every buffer, and the audio thread reports back through an event queue - so it never waits on a lock.
+	// The game and iMuse threads both drive the wave API, so they are serialized by s_imWaveMutex which the audio thread never takes.
+	#define IM_WAVE_LOCK() std::lock_guard<std::recursive_mutex> imWaveLock(s_imWaveMutex); ImProcessWaveEvents()
 
 	////////////////////////////////////////////////////
 	// Structures
@@ -43,17 +53,63 @@ namespace TFE_Jedi
 
 		s32 detuneTrans;
 		s32 mailbox;
+		u32 generation;		// Identifies this use of the channel in commands and events.
 	};
 
 	struct ImWaveData
 	{
-		ImWaveSound* sound;
+		ImSoundId soundId;
+		u8* sndData;	// TFE: Resolved when the sound starts, so the audio thread never calls back into the game.
+		s32 channel;
+		u32 generation;
 		s32 offset;
 		s32 chunkSize;
 		s32 baseOffset;
 		s32 chunkIndex;
 	};
 
+	// Mixer state for a channel, owned by the audio thread.
+	struct ImWaveVoice
+	{
+		ImWaveData data;
+		s32 volume;
+		s32 pan;
+		JBool playing;
+	};
+
+	enum ImWaveCommandType
+	{
+		IM_WAVE_CMD_START = 0,
+		IM_WAVE_CMD_STOP,
+		IM_WAVE_CMD_SET_VOLUME_PAN,
+		IM_WAVE_CMD_SET_NORMALIZATION,
+		IM_WAVE_CMD_SYNC,
+	};
+
+	struct ImWaveCommand
+	{
+		ImWaveCommandType type;
+		s32 volume;
+		s32 pan;
+		ImWaveData data;	// The start state for IM_WAVE_CMD_START, otherwise only channel and generation are used.
+	};
+
+	enum ImWaveEventType
+	{
+		IM_WAVE_EVT_FINISHED = 0,
+		IM_WAVE_EVT_MAILBOX,
+		IM_WAVE_EVT_TRIGGER,
+	};
+
+	struct ImWaveEvent
+	{
+		ImWaveEventType type;
+		s32 channel;
+		u32 generation;
+		s32 value;
+		u8  marker[44];
+	};
+
 	/////////////////////////////////////////////////////
 	// Internal State
 	/////////////////////////////////////////////////////
@@ -62,18 +118,37 @@ namespace TFE_Jedi
 	static ImWaveSound* s_imWaveSoundList = nullptr;
 	static ImWaveSound  s_imWaveSound[MAX_SOUND_CHANNELS];
 	static ImWaveData   s_imWaveData[MAX_SOUND_CHANNELS];
+	static ImWaveVoice  s_imWaveVoice[MAX_SOUND_CHANNELS];
 	static u8  s_imWaveChunkData[48];
+	static u8  s_imWaveMixChunkData[48];
+	static std::recursive_mutex s_imWaveMutex;
+	static SpscQueue<ImWaveCommand, 256> s_imWaveCommands;
+	static SpscQueue<ImWaveEvent, 256> s_imWaveEvents;
+	static JBool s_imWaveAudioThread = JFALSE;
+	// Sync requests sent to the audio thread and the last one it has handled, see ImSyncWaveCommands().
+	static s32 s_imWaveSyncRequest = 0;
+	static atomic_s32 s_imWaveSyncDone(0);
+	static thread_local bool s_imWaveIsAudioThread = false;
 	static s32 s_imWaveMixCount = DEFAULT_SOUND_CHANNELS;
 	static s32 s_imWaveNanosecsPerSample;
 	static iMuseInitData* s_imDigitalData;
 
 	// In DOS these are 8-bit outputs since that is what the driver is accepting.
 	// For TFE, floating-point audio output is used, so these convert to floating-point.
-	static f32  s_audioNormalizationMem[MAX_SOUND_CHANNELS * 256 + 4];
+	// TFE: The table is rebuilt when the channel count changes, so new tables are built off to the side and then
+	// published to the audio thread, which may still be using the previous one.
+	static f32  s_audioNormalizationMem[AUDIO_NORMALIZATION_TABLES][AUDIO_NORMALIZATION_SIZE];
+	static s32  s_audioNormalizationPublished = 0;
+	static atomic_s32 s_audioNormalizationInUse(0);
 	// Normalizes the sum of all audio playback (16-bit) to a [-1,1) floating point value.
 	// The mapping can be addressed with negative values (i.e. s_audioNormalization[-16]), which is why
 	// it is built this way.
-	static f32* s_audioNormalization = &s_audioNormalizationMem[MAX_SOUND_CHANNELS * 128 + 4];
+	static f32* s_audioNormalization = &s_audioNormalizationMem[0][MAX_SOUND_CHANNELS * 128 + 4];
+
+	// TFE: The left and right mappings for each pair of channel volumes packed into a single table, so that mixing
+	// a sample takes one lookup instead of two. Entries are built by the audio thread the first time they are used.
+	static u32  s_audioStereoMapping[17 * 17][256];
+	static bool s_audioStereoMappingBuilt[17 * 17] = { 0 };
 
 	static f32* s_audioDriverOut;
 	static s16 s_audioOut[AUDIO_BUFFER_SIZE];
@@ -92,7 +167,11 @@ namespace TFE_Jedi
 	s32 ImGetWaveParamIntern(ImSoundId soundId, s32 param);
 	s32 ImFreeWaveSoundByIdIntern(ImSoundId soundId);
 	s32 ImStartDigitalSoundIntern(ImSoundId soundId, s32 priority, s32 chunkIndex);
-	s32 audioPlaySoundFrame(ImWaveSound* sound);
+	void ImProcessWaveEvents();
+	void ImProcessWaveCommands();
+	void ImSendWaveCommand(ImWaveCommandType type, ImWaveSound* sound);
+	void ImSyncWaveCommands();
+	s32 audioPlaySoundFrame(ImWaveVoice* voice);
 	s32 audioWriteToDriver(f32 systemVolume);
 		
 	/////////////////////////////////////////////////////////// 
@@ -130,11 +209,14 @@ namespace TFE_Jedi
 			sound->next = nullptr;
 			ImWaveData* data = ImGetWaveData(i);
 			sound->data = data;
-			data->sound = sound;
+			data->channel = i;
 			sound->soundId = IM_NULL_SOUNDID;
 		}
 
-		TFE_Audio::setAudioThreadCallback(ImUpdateWave);
+		memset(s_imWaveVoice, 0, sizeof(ImWaveVoice) * MAX_SOUND_CHANNELS);
+		s_imWaveCommands.clear();
+		s_imWaveEvents.clear();
+		s_imWaveAudioThread = TFE_Audio::setAudioThreadCallback(ImUpdateWave) ? JTRUE : JFALSE;
 
 		return ImComputeAudioNormalizationInit(initData);
 	}
@@ -143,7 +225,13 @@ namespace TFE_Jedi
 	{
 		ImFreeAllWaveSounds();
 		TFE_Audio::setAudioThreadCallback();
+		s_imWaveAudioThread = JFALSE;
 		s_imWaveSoundList = nullptr;
+
+		// The audio thread is no longer running the wave update.
+		memset(s_imWaveVoice, 0, sizeof(ImWaveVoice) * MAX_SOUND_CHANNELS);
+		s_imWaveCommands.clear();
+		s_imWaveEvents.clear();
 	}
 
 	s32 ImSetDigitalChannelCount(s32 count)
@@ -154,8 +242,8 @@ namespace TFE_Jedi
 		}
 		ImFreeAllWaveSounds();
 
-		AUDIO_LOCK();
 		{
+			IM_WAVE_LOCK();
 			s_imWaveMixCount = count;
 			ImWaveSound* sound = s_imWaveSound;
 			for (s32 i = 0; i < s_imWaveMixCount; i++, sound++)
@@ -164,33 +252,44 @@ namespace TFE_Jedi
 				sound->next = nullptr;
 				ImWaveData* data = ImGetWaveData(i);
 				sound->data = data;
-				data->sound = sound;
+				data->channel = i;
 				sound->soundId = IM_NULL_SOUNDID;
 			}
 		}
-		AUDIO_UNLOCK();
 
 		return ImComputeAudioNormalization(count);
 	}
 
 	s32 ImSetWaveParam(ImSoundId soundId, s32 param, s32 value)
 	{
+		IM_WAVE_LOCK();
 		s32 res = ImSetWaveParamInternal(soundId, param, value);
 		return res;
 	}
 
 	s32 ImGetWaveParam(ImSoundId soundId, s32 param)
 	{
+		IM_WAVE_LOCK();
 		return ImGetWaveParamIntern(soundId, param);
 	}
 
 	s32 ImStartDigitalSound(ImSoundId soundId, s32 priority)
 	{
+		IM_WAVE_LOCK();
 		return ImStartDigitalSoundIntern(soundId, priority, 0);
 	}
 		
+	// Called from the audio thread.
 	void ImUpdateWave(f32* buffer, u32 bufferSize, f32 systemVolume)
 	{
+		s_imWaveIsAudioThread = true;
+		// Apply the changes made by the game and iMuse threads since the last buffer.
+		ImProcessWaveCommands();
+		if (!bufferSize)
+		{
+			return;
+		}
+
 		// Prepare buffers.
 		s_audioDriverOut = buffer;
 		s_audioOutSize = bufferSize;
@@ -198,13 +297,17 @@ namespace TFE_Jedi
 		memset(s_audioOut, 0, 2 * bufferSize * sizeof(s16));
 
 		// Write sounds to s_audioOut.
-		ImWaveSound* sound = s_imWaveSoundList;
-		while (sound)
+		ImWaveVoice* voice = s_imWaveVoice;
+		s32 voiceCount = 0;
+		for (s32 i = 0; i < MAX_SOUND_CHANNELS; i++, voice++)
 		{
-			ImWaveSound* next = sound->next;
-			audioPlaySoundFrame(sound);
-			sound = next;
+			if (voice->playing)
+			{
+				audioPlaySoundFrame(voice);
+				voiceCount++;
+			}
 		}
+		TFE_Audio::setVoiceCount(AUDIO_VOICES_WAVE, voiceCount);
 
 		// Convert s_audioOut to "driver" buffer.
 		audioWriteToDriver(systemVolume);
@@ -222,6 +325,17 @@ namespace TFE_Jedi
 		return imSuccess;
 	}
 
+	// The lock is recursive, so the wave API called from the update takes it again without blocking.
+	bool ImTryLockWave()
+	{
+		return s_imWaveMutex.try_lock();
+	}
+
+	void ImUnlockWave()
+	{
+		s_imWaveMutex.unlock();
+	}
+
 	////////////////////////////////////
 	// Internal
 	////////////////////////////////////
@@ -231,8 +345,168 @@ namespace TFE_Jedi
 		return &s_imWaveData[index];
 	}
 
+	static void ImPushWaveCommand(const ImWaveCommand& cmd)
+	{
+		if (!s_imWaveCommands.push(cmd))
+		{
+			IM_LOG_ERR("The wave command queue is full, dropping command %d.", cmd.type);
+		}
+		// Without an audio thread (i.e. the null audio device), there is nothing to drain the queue.
+		if (!s_imWaveAudioThread)
+		{
+			ImProcessWaveCommands();
+		}
+	}
+
+	void ImSendWaveCommand(ImWaveCommandType type, ImWaveSound* sound)
+	{
+		ImWaveCommand cmd = {};
+		cmd.type = type;
+		cmd.volume = sound->volume;
+		cmd.pan = sound->pan;
+		cmd.data = *sound->data;
+		cmd.data.generation = sound->generation;
+		ImPushWaveCommand(cmd);
+	}
+
+	// Audio thread: apply the queued commands to the mixer state.
+	void ImProcessWaveCommands()
+	{
+		ImWaveCommand cmd;
+		while (s_imWaveCommands.pop(&cmd))
+		{
+			ImWaveVoice* voice = &s_imWaveVoice[cmd.data.channel];
+			switch (cmd.type)
+			{
+				case IM_WAVE_CMD_START:
+				{
+					voice->data = cmd.data;
+					voice->volume = cmd.volume;
+					voice->pan = cmd.pan;
+					voice->playing = JTRUE;
+				} break;
+				case IM_WAVE_CMD_STOP:
+				{
+					if (voice->data.generation == cmd.data.generation)
+					{
+						voice->playing = JFALSE;
+					}
+				} break;
+				case IM_WAVE_CMD_SET_VOLUME_PAN:
+				{
+					if (voice->data.generation == cmd.data.generation)
+					{
+						voice->volume = cmd.volume;
+						voice->pan = cmd.pan;
+					}
+				} break;
+				case IM_WAVE_CMD_SET_NORMALIZATION:
+				{
+					s_audioNormalization = &s_audioNormalizationMem[cmd.volume][MAX_SOUND_CHANNELS * 128 + 4];
+					s_audioNormalizationInUse.store(cmd.volume);
+				} break;
+				case IM_WAVE_CMD_SYNC:
+				{
+					// Every command queued before this one has been applied.
+					s_imWaveSyncDone.store(cmd.volume);
+				} break;
+			}
+		}
+	}
+
+	// Blocks until the audio thread has applied all of the commands queued so far, so that sounds that have been stopped
+	// are no longer being mixed. Must be called without holding s_imWaveMutex.
+	void ImSyncWaveCommands()
+	{
+		// The audio thread applies the commands before it mixes again, so it must not wait on itself.
+		if (s_imWaveIsAudioThread) { return; }
+
+		s32 request;
+		{
+			IM_WAVE_LOCK();
+			request = ++s_imWaveSyncRequest;
+			ImWaveCommand cmd = {};
+			cmd.type = IM_WAVE_CMD_SYNC;
+			cmd.volume = request;
+			ImPushWaveCommand(cmd);
+		}
+
+		const u64 start = TFE_System::getCurrentTimeInTicks();
+		while (s_imWaveSyncDone.load() - request < 0)
+		{
+			if (TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - start) > AUDIO_SYNC_TIMEOUT)
+			{
+				IM_LOG_ERR("Timed out waiting for the audio thread to stop the wave sounds.");
+				break;
+			}
+			TFE_System::sleep(1);
+		}
+	}
+
+	// Audio thread: report back to the game and iMuse threads.
+	static void ImPostWaveEvent(ImWaveEventType type, const ImWaveData* data, s32 value, const u8* marker)
+	{
+		ImWaveEvent evt;
+		evt.type = type;
+		evt.channel = data->channel;
+		evt.generation = data->generation;
+		evt.value = value;
+		if (marker)
+		{
+			memcpy(evt.marker, marker, sizeof(evt.marker));
+		}
+		if (!s_imWaveEvents.push(evt))
+		{
+			IM_LOG_ERR("The wave event queue is full, dropping event %d.", type);
+		}
+	}
+
+	// Handle the events posted by the audio thread, called with s_imWaveMutex held.
+	void ImProcessWaveEvents()
+	{
+		ImWaveEvent evt;
+		while (s_imWaveEvents.pop(&evt))
+		{
+			// Skip events for sounds that have already been freed, the channel may have been reused since.
+			ImWaveSound* sound = &s_imWaveSound[evt.channel];
+			if (!sound->soundId || sound->generation != evt.generation)
+			{
+				continue;
+			}
+
+			switch (evt.type)
+			{
+				case IM_WAVE_EVT_FINISHED:
+				{
+					ImFreeWaveSound(sound);
+				} break;
+				case IM_WAVE_EVT_MAILBOX:
+				{
+					if (sound->mailbox == 0)
+					{
+						sound->mailbox = evt.value;
+					}
+				} break;
+				case IM_WAVE_EVT_TRIGGER:
+				{
+					ImSetSoundTrigger((ImSoundId)sound, evt.marker);
+				} break;
+			}
+		}
+	}
+
 	s32 ImComputeAudioNormalization(s32 waveMixCount)
 	{
+		IM_WAVE_LOCK();
+		// Build the table in memory that the audio thread is not using and has not been sent.
+		s32 index = 0;
+		const s32 inUse = s_audioNormalizationInUse.load();
+		while (index == inUse || index == s_audioNormalizationPublished)
+		{
+			index++;
+		}
+		f32* normalization = &s_audioNormalizationMem[index][MAX_SOUND_CHANNELS * 128 + 4];
+
 		s32 volumeMidPoint = 128;
 		s32 tableSize = waveMixCount << 7;
 		for (s32 i = 0; i < tableSize; i++)
@@ -242,9 +516,15 @@ namespace TFE_Jedi
 			volumeOffset >>= 8;
 
 			// These values are 8-bit in DOS, but converted to floating point for TFE.
-			s_audioNormalization[i] = f32(volumeMidPoint + volumeOffset) / 128.0f - 1.0f;
-			s_audioNormalization[-i - 1] = f32(volumeMidPoint - volumeOffset - 1) / 128.0f - 1.0f;
+			normalization[i] = f32(volumeMidPoint + volumeOffset) / 128.0f - 1.0f;
+			normalization[-i - 1] = f32(volumeMidPoint - volumeOffset - 1) / 128.0f - 1.0f;
 		}
+
+		s_audioNormalizationPublished = index;
+		ImWaveCommand cmd = {};
+		cmd.type = IM_WAVE_CMD_SET_NORMALIZATION;
+		cmd.volume = index;
+		ImPushWaveCommand(cmd);
 		return imSuccess;
 	}
 
@@ -269,6 +549,7 @@ namespace TFE_Jedi
 					}
 					sound->volume = ((sound->baseVolume + 1) * ImGetGroupVolume(value)) >> 7;
 					sound->group = value;
+					ImSendWaveCommand(IM_WAVE_CMD_SET_VOLUME_PAN, sound);
 					return imSuccess;
 				}
 				else if (param == soundPriority)
@@ -288,6 +569,7 @@ namespace TFE_Jedi
 					}
 					sound->baseVolume = value;
 					sound->volume = ((sound->baseVolume + 1) * ImGetGroupVolume(sound->group)) >> 7;
+					ImSendWaveCommand(IM_WAVE_CMD_SET_VOLUME_PAN, sound);
 					return imSuccess;
 				}
 				else if (param == soundPan)
@@ -297,6 +579,7 @@ namespace TFE_Jedi
 						return imArgErr;
 					}
 					sound->pan = value;
+					ImSendWaveCommand(IM_WAVE_CMD_SET_VOLUME_PAN, sound);
 					return imSuccess;
 				}
 				else if (param == soundDetune)
@@ -407,7 +690,6 @@ namespace TFE_Jedi
 			}
 		}
 
-		AUDIO_LOCK();
 		IM_DBG_MSG("ERR: no spare tracks...");
 		s32 minPriority = 127;
 		ImWaveSound* minPrioritySound = nullptr;
@@ -431,8 +713,6 @@ namespace TFE_Jedi
 				newSound = minPrioritySound;
 			}
 		}
-
-		AUDIO_UNLOCK();
 		return newSound;
 	}
 
@@ -443,11 +723,25 @@ namespace TFE_Jedi
 		return nullptr;
 	}
 
-	s32 ImSeekToNextChunk(ImWaveData* data)
+	// Mailbox values are set directly by the game and iMuse threads but sent as events from the audio thread.
+	static void ImSetWaveMailbox(ImWaveData* data, ImWaveSound* sound, s32 value)
+	{
+		if (!sound)
+		{
+			ImPostWaveEvent(IM_WAVE_EVT_MAILBOX, data, value, nullptr);
+		}
+		else if (sound->mailbox == 0)
+		{
+			sound->mailbox = value;
+		}
+	}
+
+	// 'sound' is the control state when called from the game or iMuse threads, or null when called from the audio thread.
+	s32 ImSeekToNextChunk(ImWaveData* data, ImWaveSound* sound)
 	{
 		while (1)
 		{
-			u8* chunkData = s_imWaveChunkData;
+			u8* chunkData = sound ? s_imWaveChunkData : s_imWaveMixChunkData;
 			u8* sndData = nullptr;
 
 			if (data->chunkIndex)
@@ -464,14 +758,10 @@ namespace TFE_Jedi
 			}
 			else  // chunkIndex == 0
 			{
-				ImWaveSound* sound = data->sound;
-				sndData = ImInternalGetSoundData(sound->soundId);
+				sndData = data->sndData;
 				if (!sndData)
 				{
-					if (sound->mailbox == 0)
-					{
-						sound->mailbox = 8;
-					}
+					ImSetWaveMailbox(data, sound, 8);
 					IM_LOG_ERR("null sound addr in SeekToNextChunk()...");
 					return imFail;
 				}
@@ -493,11 +783,7 @@ namespace TFE_Jedi
 				data->chunkSize = chunkSize;
 				if (chunkSize > 220000)
 				{
-					ImWaveSound* sound = data->sound;
-					if (sound->mailbox == 0)
-					{
-						sound->mailbox = 9;
-					}
+					ImSetWaveMailbox(data, sound, 9);
 				}
 
 				data->offset += 6;
@@ -511,7 +797,14 @@ namespace TFE_Jedi
 			else if (id == 4)
 			{
 				chunkData += 3;
-				ImSetSoundTrigger((ImSoundId)data->sound, chunkData);
+				if (sound)
+				{
+					ImSetSoundTrigger((ImSoundId)sound, chunkData);
+				}
+				else
+				{
+					ImPostWaveEvent(IM_WAVE_EVT_TRIGGER, data, 0, chunkData);
+				}
 				data->offset += 6;
 			}
 			else if (id == 6)
@@ -537,7 +830,7 @@ namespace TFE_Jedi
 			{
 				if (chunkData[0] != 'r' || chunkData[1] != 'e' || chunkData[2] != 'a')
 				{
-					IM_LOG_ERR("ERR: Illegal chunk in sound %lu...", data->sound->soundId);
+					IM_LOG_ERR("ERR: Illegal chunk in sound %lu...", data->soundId);
 					return imFail;
 				}
 				data->offset += 26;
@@ -549,7 +842,7 @@ namespace TFE_Jedi
 			}
 			else
 			{
-				IM_LOG_ERR("ERR: Illegal chunk in sound %lu...", data->sound->soundId);
+				IM_LOG_ERR("ERR: Illegal chunk in sound %lu...", data->soundId);
 				return imFail;
 			}
 		}
@@ -559,6 +852,9 @@ namespace TFE_Jedi
 	s32 ImWaveSetupSoundData(ImWaveSound* sound, s32 chunkIndex)
 	{
 		ImWaveData* data = sound->data;
+		data->soundId = sound->soundId;
+		data->sndData = ImInternalGetSoundData(sound->soundId);
+		data->generation = sound->generation;
 		data->offset = 0;
 		data->chunkSize = 0;
 		data->baseOffset = 0;
@@ -570,7 +866,7 @@ namespace TFE_Jedi
 		}
 
 		data->chunkIndex = 0;
-		return ImSeekToNextChunk(data);
+		return ImSeekToNextChunk(data, sound);
 	}
 
 	s32 ImStartDigitalSoundIntern(ImSoundId soundId, s32 priority, s32 chunkIndex)
@@ -583,6 +879,7 @@ namespace TFE_Jedi
 		}
 
 		sound->soundId = soundId;
+		sound->generation++;
 		sound->marker = 0;
 		sound->group = 0;
 		sound->priority = priority;
@@ -600,11 +897,8 @@ namespace TFE_Jedi
 			return imFail;
 		}
 
-		AUDIO_LOCK();
-		{
-			IM_LIST_ADD(s_imWaveSoundList, sound);
-		}
-		AUDIO_UNLOCK();
+		IM_LIST_ADD(s_imWaveSoundList, sound);
+		ImSendWaveCommand(IM_WAVE_CMD_START, sound);
 
 		return imSuccess;
 	}
@@ -615,17 +909,19 @@ namespace TFE_Jedi
 		ImClearSoundFaders(sound->soundId, -1);
 		ImClearTrigger(sound->soundId, -1, -1);
 		sound->soundId = IM_NULL_SOUNDID;
+		ImSendWaveCommand(IM_WAVE_CMD_STOP, sound);
 	}
 
 	s32 ImFreeWaveSoundById(ImSoundId soundId)
 	{
+		IM_WAVE_LOCK();
 		return ImFreeWaveSoundByIdIntern(soundId);
 	}
 
 	s32 ImFreeAllWaveSounds()
 	{
-		AUDIO_LOCK();
 		{
+			IM_WAVE_LOCK();
 			ImWaveSound* sound = s_imWaveSoundList;
 			while (sound)
 			{
@@ -634,12 +930,15 @@ namespace TFE_Jedi
 				sound = next;
 			}
 		}
-		AUDIO_UNLOCK();
+		// TFE: Freeing only queues the stops, wait until the audio thread is no longer mixing the sounds
+		// so the caller can release the sound data.
+		ImSyncWaveCommands();
 		return imSuccess;
 	}
 
 	ImSoundId ImFindNextWaveSound(ImSoundId soundId)
 	{
+		IM_WAVE_LOCK();
 		ImSoundId nextSoundId = IM_NULL_SOUNDID;
 		ImWaveSound* sound = s_imWaveSoundList;
 		// Find the smallest ID that is greater than 'soundId' or NULL if soundId is the last one.
@@ -659,14 +958,27 @@ namespace TFE_Jedi
 	
 	// leftMapping:  map left channel samples to final values based on volume and pan.
 	// rightMapping: map right channel samples to final values based on volume and pan.
-	void digitalAudioOutput_Stereo(s16* audioOut, const u8* sndData, const s8* leftMapping, const s8* rightMapping, s32 size)
+	// TFE: The mappings are packed into a single table, see digitalAudioGetStereoMapping().
+	void digitalAudioOutput_Stereo(s16* audioOut, const u8* sndData, const u32* stereoMapping, s32 size)
 	{
-		for (s32 i = 0; i < size; i++, sndData++, audioOut+=2)
+		TFE_Audio::mixPairTable(audioOut, sndData, stereoMapping, u32(size));
+	}
+
+	const u32* digitalAudioGetStereoMapping(s32 leftVolume, s32 rightVolume)
+	{
+		const s32 index = leftVolume * 17 + rightVolume;
+		u32* stereoMapping = s_audioStereoMapping[index];
+		if (!s_audioStereoMappingBuilt[index])
 		{
-			const u8 sample = *sndData;
-			audioOut[0] += (s16)leftMapping[sample];
-			audioOut[1] += (s16)rightMapping[sample];
+			const s8* leftMapping  = (s8*)&s_audioVolumeToSignedMapping[leftVolume  << 8];
+			const s8* rightMapping = (s8*)&s_audioVolumeToSignedMapping[rightVolume << 8];
+			for (s32 i = 0; i < 256; i++)
+			{
+				stereoMapping[i] = u32(u16(s16(leftMapping[i]))) | (u32(u16(s16(rightMapping[i]))) << 16u);
+			}
+			s_audioStereoMappingBuilt[index] = true;
 		}
+		return stereoMapping;
 	}
 
 	void audioProcessFrame(u8* audioFrame, s32 size, s32 outOffset, s32 vol, s32 pan)
@@ -691,15 +1003,15 @@ namespace TFE_Jedi
 		s32 leftVolume  = s_audioPanVolumeTable[8 - panTop + vTop*17];
 		s32 rightVolume = s_audioPanVolumeTable[8 + panTop + vTop*17];
 		// Map [0,255] sample values to signed output values based on volume.
-		const s8* leftMapping  = (s8*)&s_audioVolumeToSignedMapping[leftVolume  << 8];
-		const s8* rightMapping = (s8*)&s_audioVolumeToSignedMapping[rightVolume << 8];
+		const u32* stereoMapping = digitalAudioGetStereoMapping(leftVolume, rightVolume);
 
-		digitalAudioOutput_Stereo(&s_audioOut[outOffset * 2], audioFrame, leftMapping, rightMapping, size);
+		digitalAudioOutput_Stereo(&s_audioOut[outOffset * 2], audioFrame, stereoMapping, size);
 	}
 
-	s32 audioPlaySoundFrame(ImWaveSound* sound)
+	// Called from the audio thread.
+	s32 audioPlaySoundFrame(ImWaveVoice* voice)
 	{
-		ImWaveData* data = sound->data;
+		ImWaveData* data = &voice->data;
 		s32 bufferSize = s_audioOutSize;
 		s32 offset = 0;
 		s32 res = imSuccess;
@@ -708,20 +1020,21 @@ namespace TFE_Jedi
 			res = imSuccess;
 			if (!data->chunkSize)
 			{
-				res = ImSeekToNextChunk(data);
+				res = ImSeekToNextChunk(data, nullptr);
 				if (res != imSuccess)
 				{
 					if (res == imFail)  // Sound has finished playing.
 					{
-						ImFreeWaveSound(sound);
+						voice->playing = JFALSE;
+						ImPostWaveEvent(IM_WAVE_EVT_FINISHED, data, 0, nullptr);
 					}
 					break;
 				}
 			}
 
 			s32 readSize = (bufferSize <= data->chunkSize) ? bufferSize : data->chunkSize;
-			s_audioData = ImInternalGetSoundData(sound->soundId) + data->offset;
-			audioProcessFrame(s_audioData, readSize, offset, sound->volume, sound->pan);
+			s_audioData = data->sndData + data->offset;
+			audioProcessFrame(s_audioData, readSize, offset, voice->volume, voice->pan);
 
 			offset += readSize;
 			bufferSize -= readSize;
@@ -738,36 +1051,24 @@ namespace TFE_Jedi
 			return imInvalidSound;
 		}
 
-		s32 bufferSize = s_audioOutSize * 2;
-		s16* audioOut  = s_audioOut;
-		f32* driverOut = s_audioDriverOut;
-		for (s32 i = 0; i < bufferSize; i++, audioOut++, driverOut++)
-		{
-			*driverOut = s_audioNormalization[*audioOut] * systemVolume;
-		}
+		TFE_Audio::convertS16ToF32(s_audioDriverOut, s_audioOut, s_audioNormalization, u32(s_audioOutSize * 2), systemVolume);
 		return imSuccess;
 	}
 
 	s32 ImFreeWaveSoundByIdIntern(ImSoundId soundId)
 	{
 		s32 result = imInvalidSound;
-
-		AUDIO_LOCK();
+		ImWaveSound* sound = s_imWaveSoundList;
+		while (sound)
 		{
-			ImWaveSound* sound = s_imWaveSoundList;
-			while (sound)
+			ImWaveSound* next = sound->next;
+			if (sound->soundId == soundId)
 			{
-				ImWaveSound* next = sound->next;
-				if (sound->soundId == soundId)
-				{
-					ImFreeWaveSound(sound);
-					result = imSuccess;
-				}
-				sound = next;
+				ImFreeWaveSound(sound);
+				result = imSuccess;
 			}
+			sound = next;
 		}
-		AUDIO_UNLOCK();
-
 		return result;
 	}
 
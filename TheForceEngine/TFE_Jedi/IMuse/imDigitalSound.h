@@ -40,4 +40,8 @@ namespace TFE_Jedi
 
 	s32 ImPauseDigitalSound();
 	s32 ImResumeDigitalSound();
+
+	// TFE: Used by the MIDI player to run ImUpdate() on the audio thread without blocking on the wave lock.
+	bool ImTryLockWave();
+	void ImUnlockWave();
 }  // namespace TFE_Jedi
\ No newline at end of file
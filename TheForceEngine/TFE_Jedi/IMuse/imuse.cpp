@@ -21,8 +21,8 @@ namespace TFE_Jedi
 	#define IM_MAX_SOUNDS 32
 	#define IM_MIDI_FILE_COUNT 6
 	#define IM_MIDI_PLAYER_COUNT 2
-	#define imuse_alloc(size) TFE_Memory::region_alloc(s_memRegion, size)
-	#define imuse_realloc(ptr, size) TFE_Memory::region_realloc(s_memRegion, ptr, size)
+	#define imuse_alloc(size) TFE_Memory::region_alloc(s_memRegion, size, "iMuse")
+	#define imuse_realloc(ptr, size) TFE_Memory::region_realloc(s_memRegion, ptr, size, "iMuse")
 	#define imuse_free(ptr) TFE_Memory::region_free(s_memRegion, ptr)
 	
 	////////////////////////////////////////////////////
@@ -2491,7 +2491,8 @@ namespace TFE_Jedi
 
 		// In the original code, the interrupt is setup here, TFE uses a thread to simulate this.
 		const f64 timeStep = TFE_System::microsecondsToSeconds((f64)s_iMuseTimestepMicrosec) / TFE_System::c_gameTimeScale;
-		TFE_MidiPlayer::midiSetCallback(ImUpdate, timeStep);
+		// TFE: ImUpdate() uses the wave API, which must not block when the update runs on the audio thread.
+		TFE_MidiPlayer::midiSetCallback(ImUpdate, timeStep, ImTryLockWave, ImUnlockWave);
 		TFE_MidiPlayer::setMaximumNoteLength(8.0f);
 
 		return imSuccess;
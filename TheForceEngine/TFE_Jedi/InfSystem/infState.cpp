@@ -32,6 +32,7 @@ namespace TFE_Jedi
 	void inf_computeElevValuePointer(InfElevator* elev);
 	extern void inf_deleteElevator(InfElevator* elev);
 	extern void inf_deleteTrigger(InfTrigger* trigger);
+	extern void inf_elevatorSchedRebuild();
 
 	/////////////////////////////////////////////
 	// Implementation
@@ -513,6 +514,7 @@ namespace TFE_Jedi
 				InfElevator* elev = (InfElevator*)allocator_newItem(s_infSerState.infElevators);
 				inf_serializeElevator(stream, elev);
 			}
+			inf_elevatorSchedRebuild();
 		}
 
 		// Teleports
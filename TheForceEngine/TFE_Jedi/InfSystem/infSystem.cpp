@@ -1,4 +1,5 @@
 #include <cstring>
+#include <algorithm>
 
 #include "infSystem.h"
 #include "infState.h"
@@ -14,8 +15,10 @@
 #include <TFE_Jedi/Memory/allocator.h>
 #include <TFE_Jedi/Level/level.h>
 #include <TFE_Jedi/Level/levelData.h>
+#include <TFE_Jedi/Collision/wallGrid.h>
 #include <TFE_System/parser.h>
 #include <TFE_System/system.h>
+#include <TFE_System/profiler.h>
 #include <TFE_System/memoryPool.h>
 #include <TFE_System/math.h>
 #include <TFE_Jedi/Level/rtexture.h>
@@ -89,6 +92,8 @@ namespace TFE_Jedi
 	void inf_handleMsgLights();
 	void inf_elevatorStart(InfElevator* elev);
 	vec3_fixed inf_getElevSoundPos(InfElevator* elev);
+	void inf_elevatorSchedReset();
+	void inf_elevatorSchedule(InfElevator* elev);
 
 	void inf_teleporterTaskLocal(MessageType msg);
 	void inf_elevatorTaskLocal(MessageType msg);
@@ -113,7 +118,8 @@ namespace TFE_Jedi
 
 	void inf_createElevatorTask()
 	{
-		s_infSerState.infElevators = allocator_create(sizeof(InfElevator));
+		s_infSerState.infElevators = allocator_create(sizeof(InfElevator), nullptr, ALLOC_STORAGE_PACKED);
+		inf_elevatorSchedReset();
 		s_infState.infElevTask = createSubTask("elevator", inf_elevatorTaskFunc, inf_elevatorTaskLocal);
 	}
 
@@ -121,7 +127,7 @@ namespace TFE_Jedi
 	{
 		s_infState.teleportTask = createSubTask("teleporter", inf_telelporterTaskFunc, inf_teleporterTaskLocal);
 		task_setNextTick(s_infState.teleportTask, TASK_SLEEP);
-		s_infSerState.infTeleports = allocator_create(sizeof(Teleport));
+		s_infSerState.infTeleports = allocator_create(sizeof(Teleport), nullptr, ALLOC_STORAGE_PACKED);
 	}
 
 	void inf_createTriggerTask()
@@ -129,7 +135,7 @@ namespace TFE_Jedi
 		s_infState.infTriggerTask = createSubTask("trigger", inf_triggerTaskFunc, inf_triggerTaskLocal);
 		s_infSerState.activeTriggerCount = 0;
 		// TFE: create a trigger allocator to make tracking easier.
-		s_infSerState.infTriggers = allocator_create(sizeof(InfTrigger));
+		s_infSerState.infTriggers = allocator_create(sizeof(InfTrigger), nullptr, ALLOC_STORAGE_PACKED);
 	}
 
 	InfLink* allocateLink(Allocator* infLinks, InfElevator* elev)
@@ -187,7 +193,11 @@ namespace TFE_Jedi
 	{
 		if (!elev || !elev->stops)
 		{
-			if (elev) { elev->nextTick = s_curTick; }
+			if (elev)
+			{
+				elev->nextTick = s_curTick;
+				inf_elevatorSchedule(elev);
+			}
 			return;
 		}
 
@@ -230,6 +240,7 @@ namespace TFE_Jedi
 
 		// Setup the next stop.
 		elev->nextStop = inf_advanceStops(elev->stops, 0, 1);
+		inf_elevatorSchedule(elev);
 	}
 		
 	InfElevator* inf_allocateElevItem(RSector* sector, InfElevatorType type)
@@ -258,6 +269,11 @@ namespace TFE_Jedi
 		elev->sound0 = NULL_SOUND;
 		elev->sound1 = NULL_SOUND;
 		elev->sound2 = NULL_SOUND;
+		// TFE: nextTick was left uninitialized, it is set when the elevator goes to its initial stop.
+		elev->nextTick = 0;
+		elev->schedOrder = 0;
+		elev->schedGen = 0;
+		inf_elevatorSchedule(elev);
 
 		switch (type)
 		{
@@ -1438,6 +1454,7 @@ namespace TFE_Jedi
 
 			// Flag the elevator as moving.
 			elev->updateFlags |= ELEV_MOVING;
+			inf_elevatorSchedule(elev);
 		}
 	}
 
@@ -1453,6 +1470,202 @@ namespace TFE_Jedi
 		}
 	}
 
+	/////////////////////////////////////////////////////
+	// TFE: Elevator scheduling
+	// The original code visited every elevator each frame, even though
+	// most are idle. Instead elevators waiting on 'nextTick' are kept
+	// in a min-heap keyed on that time, and moved to the "due" heap -
+	// keyed on allocation order - once they are ready to update. Idle
+	// elevators (master off, holding or deleted) are in neither heap.
+	//
+	// Elevators are updated in allocation order, and an elevator that
+	// becomes ready after the current pass has already moved past it
+	// waits until the next pass, just like the original loop.
+	//
+	// Any code that changes 'nextTick', turns the master on or
+	// creates an elevator must call inf_elevatorSchedule().
+	/////////////////////////////////////////////////////
+	struct ElevSchedEntry
+	{
+		Tick tick;
+		u32 order;
+		u32 gen;		// entries are stale once the elevator is rescheduled.
+		InfElevator* elev;
+	};
+
+	struct ElevScheduler
+	{
+		std::vector<ElevSchedEntry> wake;		// min-heap on tick.
+		std::vector<ElevSchedEntry> due;		// min-heap on order.
+		std::vector<ElevSchedEntry> deferred;	// ready, but the current pass has already moved past them.
+		u32 nextOrder;
+		u32 passOrder;	// order of the last elevator visited in the current pass.
+		JBool inPass;
+	};
+	static ElevScheduler s_elevSched;
+	static s32 s_elevSchedWaiting = 0;
+	static s32 s_elevSchedUpdated = 0;
+
+	static bool elevSched_wakeCmp(const ElevSchedEntry& a, const ElevSchedEntry& b)
+	{
+		return a.tick > b.tick;
+	}
+
+	static bool elevSched_dueCmp(const ElevSchedEntry& a, const ElevSchedEntry& b)
+	{
+		return a.order > b.order;
+	}
+
+	static void elevSched_pushDue(const ElevSchedEntry& entry)
+	{
+		if (s_elevSched.inPass && entry.order <= s_elevSched.passOrder)
+		{
+			s_elevSched.deferred.push_back(entry);
+			return;
+		}
+		s_elevSched.due.push_back(entry);
+		std::push_heap(s_elevSched.due.begin(), s_elevSched.due.end(), elevSched_dueCmp);
+	}
+
+	static void elevSched_pushWake(const ElevSchedEntry& entry)
+	{
+		std::vector<ElevSchedEntry>& wake = s_elevSched.wake;
+		// Drop stale entries if they start to pile up (i.e. elevators re-triggered while waiting).
+		if (wake.size() >= 64 && wake.size() >= 4 * size_t(s_elevSched.nextOrder))
+		{
+			size_t count = 0;
+			for (size_t i = 0; i < wake.size(); i++)
+			{
+				if (wake[i].gen == wake[i].elev->schedGen) { wake[count++] = wake[i]; }
+			}
+			wake.resize(count);
+			std::make_heap(wake.begin(), wake.end(), elevSched_wakeCmp);
+		}
+		wake.push_back(entry);
+		std::push_heap(wake.begin(), wake.end(), elevSched_wakeCmp);
+	}
+
+	// Move elevators whose time has come from the wake heap to the due heap.
+	static void elevSched_wakeElevators()
+	{
+		std::vector<ElevSchedEntry>& wake = s_elevSched.wake;
+		while (!wake.empty() && wake.front().tick < s_curTick)
+		{
+			std::pop_heap(wake.begin(), wake.end(), elevSched_wakeCmp);
+			const ElevSchedEntry entry = wake.back();
+			wake.pop_back();
+
+			if (entry.gen == entry.elev->schedGen)
+			{
+				elevSched_pushDue(entry);
+			}
+		}
+	}
+
+	void inf_elevatorSchedReset()
+	{
+		s_elevSched.wake.clear();
+		s_elevSched.due.clear();
+		s_elevSched.deferred.clear();
+		s_elevSched.nextOrder = 0;
+		s_elevSched.passOrder = 0;
+		s_elevSched.inPass = JFALSE;
+
+		TFE_COUNTER(s_elevSchedWaiting, "Elevator Wake Queue");
+		TFE_COUNTER(s_elevSchedUpdated, "Elevators Updated");
+	}
+
+	// Called after loading, elevators are restored in allocation order.
+	void inf_elevatorSchedRebuild()
+	{
+		inf_elevatorSchedReset();
+		InfElevator* elev = (InfElevator*)allocator_getHead(s_infSerState.infElevators);
+		while (elev)
+		{
+			elev->schedOrder = 0;
+			elev->schedGen = 0;
+			inf_elevatorSchedule(elev);
+			elev = (InfElevator*)allocator_getNext(s_infSerState.infElevators);
+		}
+	}
+
+	void inf_elevatorSchedule(InfElevator* elev)
+	{
+		if (!elev) { return; }
+		if (!elev->schedOrder)
+		{
+			elev->schedOrder = ++s_elevSched.nextOrder;
+		}
+		// Invalidate any existing entries.
+		elev->schedGen++;
+		if (elev->deleted || !(elev->updateFlags & ELEV_MASTER_ON) || elev->nextTick == DELAY_SLEEP)
+		{
+			return;
+		}
+
+		const ElevSchedEntry entry = { elev->nextTick, elev->schedOrder, elev->schedGen, elev };
+		if (elev->nextTick < s_curTick)
+		{
+			elevSched_pushDue(entry);
+		}
+		else
+		{
+			elevSched_pushWake(entry);
+		}
+	}
+
+	void inf_elevatorSchedBeginPass()
+	{
+		s_elevSched.inPass = JTRUE;
+		s_elevSched.passOrder = 0;
+		s_elevSchedUpdated = 0;
+	}
+
+	// Returns the next elevator to update in the current pass, or null if there are none left.
+	InfElevator* inf_elevatorSchedNext()
+	{
+		elevSched_wakeElevators();
+
+		std::vector<ElevSchedEntry>& due = s_elevSched.due;
+		while (!due.empty())
+		{
+			std::pop_heap(due.begin(), due.end(), elevSched_dueCmp);
+			const ElevSchedEntry entry = due.back();
+			due.pop_back();
+
+			InfElevator* elev = entry.elev;
+			if (entry.gen != elev->schedGen) { continue; }
+			s_elevSched.passOrder = entry.order;
+			// The entry has been consumed, the elevator is rescheduled after it is updated.
+			elev->schedGen++;
+			if (elev->deleted || !(elev->updateFlags & ELEV_MASTER_ON)) { continue; }
+			if (elev->nextTick >= s_curTick)
+			{
+				inf_elevatorSchedule(elev);
+				continue;
+			}
+
+			s_elevSchedUpdated++;
+			return elev;
+		}
+		return nullptr;
+	}
+
+	void inf_elevatorSchedEndPass()
+	{
+		s_elevSched.inPass = JFALSE;
+		for (size_t i = 0; i < s_elevSched.deferred.size(); i++)
+		{
+			const ElevSchedEntry& entry = s_elevSched.deferred[i];
+			if (entry.gen == entry.elev->schedGen)
+			{
+				elevSched_pushWake(entry);
+			}
+		}
+		s_elevSched.deferred.clear();
+		s_elevSchedWaiting = s32(s_elevSched.wake.size());
+	}
+
 	// Per frame update.
 	void inf_elevatorTaskFunc(MessageType msg)
 	{
@@ -1473,15 +1686,12 @@ namespace TFE_Jedi
 			}
 			else  // id == MSG_RUN_TASK
 			{
-				taskCtx->elev = (InfElevator*)allocator_getHead(s_infSerState.infElevators);
+				// TFE: Only elevators that are ready to update are visited, in the same order as the original loop
+				// over all elevators.
+				inf_elevatorSchedBeginPass();
+				taskCtx->elev = inf_elevatorSchedNext();
 				while (taskCtx->elev)
 				{
-					if (taskCtx->elev->deleted)
-					{
-						taskCtx->elev = (InfElevator*)allocator_getNext(s_infSerState.infElevators);
-						continue;
-					}
-
 					taskCtx->elevDeleted = 0;
 					if ((taskCtx->elev->updateFlags & ELEV_MASTER_ON) && taskCtx->elev->nextTick < s_curTick)
 					{
@@ -1568,9 +1778,11 @@ namespace TFE_Jedi
 						}
 					} // ((elev->updateFlags & ELEV_MASTER_ON) && elev->nextTick < s_curTick)
 
-					// Next elevator.
-					taskCtx->elev = (InfElevator*)allocator_getNext(s_infSerState.infElevators);
+					// Queue up the next update and then move on to the next elevator.
+					inf_elevatorSchedule(taskCtx->elev);
+					taskCtx->elev = inf_elevatorSchedNext();
 				} // while (elev)
+				inf_elevatorSchedEndPass();
 			}  // id == 0 (main elevator update loop)
 			task_yield(TASK_NO_DELAY);
 		}  // while (id != -1)
@@ -1613,43 +1825,39 @@ namespace TFE_Jedi
 				while (teleport)
 				{
 					RSector* sector = teleport->sector;
-					s32 objCount = sector->objectCount;
-					SecObject** objList = sector->objectList;
-
-					for (s32 i = 0; i < objCount; objList++)
+					for (s32 i = 0; i < sector->objectCount;)
 					{
-						SecObject* obj = *objList;
-						if (obj)
+						SecObject* obj = sector->objectList[i];
+						taskCtx->delay = TASK_NO_DELAY;
+						TeleportType type = teleport->type;
+						if (type <= TELEPORT_BASIC)
 						{
-							i++;
-							taskCtx->delay = TASK_NO_DELAY;
-							TeleportType type = teleport->type;
-							if (type <= TELEPORT_BASIC)
+							// So dstPosition is actually an absolute position.
+							obj->posWS = teleport->dstPosition;
+							obj->pitch = teleport->dstAngle[0];
+							obj->yaw   = teleport->dstAngle[1];
+							obj->roll  = teleport->dstAngle[2];
+							sector_addObject(teleport->target, obj);
+						}
+						else if (type == TELEPORT_CHUTE)
+						{
+							sector = teleport->sector;
+							fixed16_16 floorThreshold = sector->floorHeight - HALF_16;
+							// if the object is lower than 0.5 units above the floor.
+							if (floorThreshold < obj->posWS.y)
 							{
-								// So dstPosition is actually an absolute position.
-								obj->posWS = teleport->dstPosition;
-								obj->pitch = teleport->dstAngle[0];
-								obj->yaw   = teleport->dstAngle[1];
-								obj->roll  = teleport->dstAngle[2];
 								sector_addObject(teleport->target, obj);
 							}
-							else if (type == TELEPORT_CHUTE)
-							{
-								sector = teleport->sector;
-								fixed16_16 floorThreshold = sector->floorHeight - HALF_16;
-								// if the object is lower than 0.5 units above the floor.
-								if (floorThreshold < obj->posWS.y)
-								{
-									sector_addObject(teleport->target, obj);
-								}
-							}
+						}
 
-							if (obj->entityFlags & ETFLAG_PLAYER)
-							{
-								// automap_setLayer(obj->sector->layer);
-							}
-						}  // if (obj)
-					}  // for (s32 i = 0; i < objCount; objList++)
+						if (obj->entityFlags & ETFLAG_PLAYER)
+						{
+							// automap_setLayer(obj->sector->layer);
+						}
+
+						// Teleported objects are removed from the sector, which moves the last object into their slot.
+						if (i < sector->objectCount && sector->objectList[i] == obj) { i++; }
+					}
 					teleport = (Teleport*)allocator_getNext(s_infSerState.infTeleports);
 				}  // while (teleport)
 			}
@@ -2199,14 +2407,19 @@ namespace TFE_Jedi
 		u32 bits = s_msgArg2;
 		if (flagsIndex == 1)
 		{
-			wall->flags1 |= bits;
+			wall_setFlags1(wall, wall->flags1 | bits);
+			// TFE: Walls that can morph are kept out of the collision grid.
+			if (bits & WF1_WALL_MORPHS)
+			{
+				wallGrid_invalidate(wall->sector);
+			}
 
 			// If there is a mirror, also set some of the bits there.
 			RWall* mirror = wall->mirrorWall;
 			if (mirror)
 			{
 				const u32 allowedMirrorFlags = (WF1_HIDE_ON_MAP | WF1_SHOW_NORMAL_ON_MAP | WF1_DAMAGE_WALL | WF1_SHOW_AS_LEDGE_ON_MAP | WF1_SHOW_AS_DOOR_ON_MAP);
-				mirror->flags1 |= (bits & allowedMirrorFlags);
+				wall_setFlags1(mirror, mirror->flags1 | (bits & allowedMirrorFlags));
 			}
 		}
 		else if (flagsIndex == 2)
@@ -2234,14 +2447,18 @@ namespace TFE_Jedi
 		u32 bits = s_msgArg2;
 		if (flagsIndex == 1)
 		{
-			wall->flags1 &= ~bits;
+			wall_setFlags1(wall, wall->flags1 & ~bits);
+			if (bits & WF1_WALL_MORPHS)
+			{
+				wallGrid_invalidate(wall->sector);
+			}
 
 			// If there is a mirror, also clear some of the bits there.
 			RWall* mirror = wall->mirrorWall;
 			if (mirror)
 			{
 				const u32 allowedMirrorFlags = WF1_HIDE_ON_MAP | WF1_SHOW_NORMAL_ON_MAP | WF1_DAMAGE_WALL | WF1_SHOW_AS_LEDGE_ON_MAP | WF1_SHOW_AS_DOOR_ON_MAP;
-				mirror->flags1 &= ~(bits & allowedMirrorFlags);
+				wall_setFlags1(mirror, mirror->flags1 & ~(bits & allowedMirrorFlags));
 			}
 		}
 		else if (flagsIndex == 2)
@@ -2395,6 +2612,7 @@ namespace TFE_Jedi
 			}
 			elev->nextTick = s_curTick;
 			elev->updateFlags |= ELEV_MOVING;
+			inf_elevatorSchedule(elev);
 		}
 	}
 
@@ -2442,7 +2660,7 @@ namespace TFE_Jedi
 			RWall* wall = sector->walls;
 			for (s32 i = 0; i < sector->wallCount; i++, wall++)
 			{
-				wall->flags1 &= ~(WF1_HIDE_ON_MAP | WF1_SHOW_NORMAL_ON_MAP);
+				wall_setFlags1(wall, wall->flags1 & ~(WF1_HIDE_ON_MAP | WF1_SHOW_NORMAL_ON_MAP));
 			}
 		}
 	}
@@ -2726,6 +2944,8 @@ namespace TFE_Jedi
 			return;
 		}
 		infElevatorMessageInternal(msgType);
+		// TFE: The message may have turned the elevator on or changed its next update time.
+		inf_elevatorSchedule((InfElevator*)s_msgTarget);
 	}
 		
 	void infTriggerMsgFunc(MessageType msgType)
@@ -2942,6 +3162,9 @@ namespace TFE_Jedi
 
 				sector_setupWallDrawFlags(sector0);
 				sector_setupWallDrawFlags(sector1);
+				// TFE: Walls without an adjoin are shown differently on the automap.
+				sector0->mapVersion++;
+				sector1->mapVersion++;
 
 				cmd = (AdjoinCmd*)allocator_getNext(adjoinCmds);
 			}
@@ -2990,20 +3213,14 @@ namespace TFE_Jedi
 		{
 			case MSG_WAKEUP:
 			{
-				s32 objCount = sector->objectCount;
-				s32 objCapacity = sector->objectCapacity;
-				SecObject** objList = sector->objectList;
-
-				for (s32 i = 0; i < objCount && i < objCapacity; objList++)
+				for (s32 i = 0; i < sector->objectCount; i++)
 				{
-					SecObject* obj = *objList;
-					if (obj)
+					SecObject* obj = sector->objectList[i];
+					if (obj->entityFlags & ETFLAG_CAN_WAKE)
 					{
-						if (obj->entityFlags & ETFLAG_CAN_WAKE)
-						{
-							message_sendToObj(obj, MSG_WAKEUP, nullptr);
-						}
-						i++;
+						message_sendToObj(obj, MSG_WAKEUP, nullptr);
+						// The object may have been removed, in which case the last object was moved into its slot.
+						if (i < sector->objectCount && sector->objectList[i] != obj) { i--; }
 					}
 				}
 			}
@@ -3011,20 +3228,14 @@ namespace TFE_Jedi
 			case MSG_MASTER_ON:
 			case MSG_MASTER_OFF:
 			{
-				s32 objCount = sector->objectCount;
-				s32 objCapacity = sector->objectCapacity;
-				SecObject** objList = sector->objectList;
-
-				for (s32 i = 0; i < objCount && i < objCapacity; objList++)
+				for (s32 i = 0; i < sector->objectCount; i++)
 				{
-					SecObject* obj = *objList;
-					if (obj)
+					SecObject* obj = sector->objectList[i];
+					if (obj->entityFlags & ETFLAG_CAN_DISABLE)
 					{
-						if (obj->entityFlags & ETFLAG_CAN_DISABLE)
-						{
-							message_sendToObj(obj, msgType, nullptr);
-						}
-						i++;
+						message_sendToObj(obj, msgType, nullptr);
+						// The object may have been removed, in which case the last object was moved into its slot.
+						if (i < sector->objectCount && sector->objectList[i] != obj) { i--; }
 					}
 				}
 			} break;
@@ -3035,7 +3246,7 @@ namespace TFE_Jedi
 
 				if (flagsIndex == 1)
 				{
-					sector->flags1 |= bits;
+					sector_setFlags1(sector, sector->flags1 | bits);
 				}
 				else if (flagsIndex == 2)
 				{
@@ -3053,7 +3264,7 @@ namespace TFE_Jedi
 
 				if (flagsIndex == 1)
 				{
-					sector->flags1 &= ~bits;
+					sector_setFlags1(sector, sector->flags1 & ~bits);
 				}
 				else if (flagsIndex == 2)
 				{
@@ -3114,6 +3325,7 @@ namespace TFE_Jedi
 							if (msg != MSG_RUN_TASK)
 							{
 								infElevatorMessageInternal(msg);
+								inf_elevatorSchedule((InfElevator*)s_msgTarget);
 								task_yield(TASK_NO_DELAY);
 							}
 
@@ -3340,12 +3552,9 @@ namespace TFE_Jedi
 
 				s32 objCount = sector->objectCount;
 				SecObject** objList = sector->objectList;
-				for (; objCount > 0; objList++)
+				for (s32 i = 0; i < objCount; i++)
 				{
-					SecObject* obj = *objList;
-					if (!obj) { continue; }
-
-					objCount--;
+					SecObject* obj = objList[i];
 					fixed16_16 objHeight = obj->worldHeight + ONE_16;
 					if (obj->posWS.y > offsetHeight) // Object is below the second height
 					{
@@ -195,5 +195,7 @@ namespace TFE_Jedi
 		// TFE
 		fixed16_16 prevValue;
 		JBool deleted;
+		u32 schedOrder;		// update order, see inf_elevatorSchedule().
+		u32 schedGen;
 	};
 }
\ No newline at end of file
@@ -11,6 +11,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <ctype.h>
 #include <assert.h>
 #include <algorithm>
 
@@ -23,16 +24,91 @@ namespace TFE_Jedi
 	u32 s_msgArg2;
 	u32 s_msgEvent;
 
+	// TFE: Case-insensitive hash index over the address names, so name lookups do not need to
+	// walk every address in the level. Open addressing with linear probing.
+	struct MessageAddressIndex
+	{
+		MessageAddress** slots;
+		u32 capacity;	// always a power of 2.
+		u32 count;
+	};
+	static MessageAddressIndex s_addrIndex = {};
+
+	enum
+	{
+		MSG_ADDR_NAME_LEN   = 16,
+		MSG_ADDR_MIN_SLOTS  = 256,
+	};
+
+	// Matches the strncasecmp() compare used for names: case-insensitive and limited to the
+	// first 16 characters.
+	static u32 message_hashName(const char* name)
+	{
+		u32 hash = 2166136261u;
+		for (s32 i = 0; i < MSG_ADDR_NAME_LEN && name[i]; i++)
+		{
+			hash ^= u32(tolower(name[i]));
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	static void message_indexInsert(MessageAddress* msgAddr)
+	{
+		const u32 mask = s_addrIndex.capacity - 1;
+		u32 slot = message_hashName(msgAddr->name) & mask;
+		while (s_addrIndex.slots[slot])
+		{
+			// Keep the first address with a given name, which is what the linear search found.
+			if (strncasecmp(msgAddr->name, s_addrIndex.slots[slot]->name, MSG_ADDR_NAME_LEN) == 0)
+			{
+				return;
+			}
+			slot = (slot + 1) & mask;
+		}
+		s_addrIndex.slots[slot] = msgAddr;
+		s_addrIndex.count++;
+	}
+
+	static bool message_indexGrow()
+	{
+		MessageAddress** prevSlots = s_addrIndex.slots;
+		const u32 prevCapacity = s_addrIndex.capacity;
+		const u32 capacity = std::max(u32(MSG_ADDR_MIN_SLOTS), prevCapacity * 2);
+
+		MessageAddress** slots = (MessageAddress**)calloc(capacity, sizeof(MessageAddress*));
+		if (!slots)
+		{
+			TFE_System::logWrite(LOG_ERROR, "INF", "Failed to grow the message address index to %u slots.", capacity);
+			return false;
+		}
+		s_addrIndex.slots = slots;
+		s_addrIndex.capacity = capacity;
+		s_addrIndex.count = 0;
+		for (u32 i = 0; i < prevCapacity; i++)
+		{
+			if (prevSlots[i]) { message_indexInsert(prevSlots[i]); }
+		}
+		free(prevSlots);
+		return true;
+	}
+
 	void message_free()
 	{
 		s_messageAddr = nullptr;
+		// Keep the index memory around for the next level.
+		if (s_addrIndex.slots)
+		{
+			memset(s_addrIndex.slots, 0, sizeof(MessageAddress*) * s_addrIndex.capacity);
+		}
+		s_addrIndex.count = 0;
 	}
 
 	void message_addAddress(const char* name, s32 param0, s32 param1, RSector* sector)
 	{
 		if (!s_messageAddr)
 		{
-			s_messageAddr = allocator_create(sizeof(MessageAddress));
+			s_messageAddr = allocator_create(sizeof(MessageAddress), nullptr, ALLOC_STORAGE_PACKED);
 		}
 		MessageAddress* msgAddr = (MessageAddress*)allocator_newItem(s_messageAddr);
 
@@ -42,18 +118,29 @@ namespace TFE_Jedi
 		msgAddr->param0 = param0;
 		msgAddr->param1 = param1;
 		msgAddr->sector = sector;
+
+		// Keep the load factor at or below 1/2.
+		if ((s_addrIndex.count + 1) * 2 > s_addrIndex.capacity && !message_indexGrow())
+		{
+			return;
+		}
+		message_indexInsert(msgAddr);
 	}
 
 	MessageAddress* message_getAddress(const char* name)
 	{
-		MessageAddress* msgAddr = (MessageAddress*)allocator_getHead(s_messageAddr);
-		while (msgAddr)
+		if (s_addrIndex.count)
 		{
-			if (strncasecmp(name, msgAddr->name, 16) == 0)
+			const u32 mask = s_addrIndex.capacity - 1;
+			u32 slot = message_hashName(name) & mask;
+			while (MessageAddress* msgAddr = s_addrIndex.slots[slot])
 			{
-				return msgAddr;
+				if (strncasecmp(name, msgAddr->name, MSG_ADDR_NAME_LEN) == 0)
+				{
+					return msgAddr;
+				}
+				slot = (slot + 1) & mask;
 			}
-			msgAddr = (MessageAddress*)allocator_getNext(s_messageAddr);
 		}
 
 		TFE_System::logWrite(LOG_ERROR, "INF", "Message_GetAddress: ADDRESS NOT FOUND: %s", name);
@@ -5,10 +5,13 @@
 #include "rsector.h"
 #include "rwall.h"
 #include "robjData.h"
+#include "objectInterp.h"
 #include <TFE_Game/igame.h>
 #include <TFE_System/system.h>
 #include <TFE_Asset/spriteAsset_Jedi.h>
 #include <TFE_Jedi/Serialization/serialization.h>
+#include <TFE_Jedi/Collision/objectGrid.h>
+#include <TFE_Jedi/Collision/wallGrid.h>
 
 // TODO: coupling between Dark Forces and Jedi.
 using namespace TFE_DarkForces;
@@ -53,6 +56,9 @@ namespace TFE_Jedi
 		sector_clear(s_levelState.controlSector);
 
 		objData_clear();
+		objGrid_clear();
+		wallGrid_clear();
+		objInterp_clear();
 	}
 
 	void level_serializeFixupMirrors()
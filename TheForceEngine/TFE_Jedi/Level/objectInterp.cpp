@@ -0,0 +1,142 @@
+#include "objectInterp.h"
+#include "level.h"
+#include "levelData.h"
+#include "rsector.h"
+#include "robject.h"
+#include <TFE_System/profiler.h>
+#include <assert.h>
+#include <vector>
+
+namespace TFE_Jedi
+{
+	enum ObjInterpConstants
+	{
+		// Objects that moved further than this in a single step are assumed to have teleported.
+		OBJ_INTERP_MAX_DIST = FIXED(32),
+	};
+
+	struct ObjInterpEntry
+	{
+		SecObject* obj;
+		u32 gridId;		// Used to detect objects that were removed (and possibly reallocated) since the capture.
+		RSector* sector;
+		vec3_fixed prevPos;
+		angle14_16 prevPitch, prevYaw, prevRoll;
+
+		// Current transform, saved while the interpolated transform is applied.
+		vec3_fixed curPos;
+		angle14_16 curPitch, curYaw, curRoll;
+		JBool applied;
+	};
+	static std::vector<ObjInterpEntry> s_objInterp;
+	static JBool s_objInterpApplied = JFALSE;
+	static s32 s_objInterpCount = 0;
+
+	static inline fixed16_16 objInterp_lerp(fixed16_16 a, fixed16_16 b, fixed16_16 alpha)
+	{
+		return a + mul16(b - a, alpha);
+	}
+
+	static inline angle14_16 objInterp_lerpAngle(angle14_16 a, angle14_16 b, fixed16_16 alpha)
+	{
+		// Take the shortest path around the circle.
+		const s32 delta = ((s32(b) - s32(a) + 8192) & ANGLE_MASK) - 8192;
+		return angle14_16(a + mul16(delta, alpha));
+	}
+
+	void objInterp_clear()
+	{
+		assert(!s_objInterpApplied);
+		s_objInterp.clear();
+		s_objInterpApplied = JFALSE;
+		s_objInterpCount = 0;
+
+		TFE_COUNTER(s_objInterpCount, "Interpolated Objects");
+	}
+
+	void objInterp_capture()
+	{
+		assert(!s_objInterpApplied);
+		s_objInterp.clear();
+
+		RSector* sector = s_levelState.sectors;
+		for (u32 s = 0; s < s_levelState.sectorCount; s++, sector++)
+		{
+			SecObject** objList = sector->objectList;
+			for (s32 i = 0; i < sector->objectCount; i++)
+			{
+				SecObject* obj = objList[i];
+				if (!obj->gridId) { continue; }
+
+				ObjInterpEntry entry = {};
+				entry.obj = obj;
+				entry.gridId = obj->gridId;
+				entry.sector = sector;
+				entry.prevPos = obj->posWS;
+				entry.prevPitch = obj->pitch;
+				entry.prevYaw = obj->yaw;
+				entry.prevRoll = obj->roll;
+				s_objInterp.push_back(entry);
+			}
+		}
+	}
+
+	void objInterp_apply(fixed16_16 alpha)
+	{
+		assert(!s_objInterpApplied);
+		s_objInterpCount = 0;
+		if (alpha >= ONE_16) { return; }
+		alpha = max(alpha, 0);
+
+		const size_t count = s_objInterp.size();
+		ObjInterpEntry* entry = s_objInterp.data();
+		for (size_t i = 0; i < count; i++, entry++)
+		{
+			SecObject* obj = entry->obj;
+			entry->applied = JFALSE;
+			// Skip objects that were removed or changed sectors.
+			if (obj->gridId != entry->gridId || obj->sector != entry->sector) { continue; }
+
+			const vec3_fixed pos = obj->posWS;
+			if (TFE_Jedi::abs(pos.x - entry->prevPos.x) > OBJ_INTERP_MAX_DIST || TFE_Jedi::abs(pos.y - entry->prevPos.y) > OBJ_INTERP_MAX_DIST ||
+				TFE_Jedi::abs(pos.z - entry->prevPos.z) > OBJ_INTERP_MAX_DIST)
+			{
+				continue;
+			}
+
+			entry->curPos = pos;
+			entry->curPitch = obj->pitch;
+			entry->curYaw = obj->yaw;
+			entry->curRoll = obj->roll;
+			entry->applied = JTRUE;
+
+			obj->posWS.x = objInterp_lerp(entry->prevPos.x, pos.x, alpha);
+			obj->posWS.y = objInterp_lerp(entry->prevPos.y, pos.y, alpha);
+			obj->posWS.z = objInterp_lerp(entry->prevPos.z, pos.z, alpha);
+			obj->pitch = objInterp_lerpAngle(entry->prevPitch, entry->curPitch, alpha);
+			obj->yaw   = objInterp_lerpAngle(entry->prevYaw,   entry->curYaw,   alpha);
+			obj->roll  = objInterp_lerpAngle(entry->prevRoll,  entry->curRoll,  alpha);
+			s_objInterpCount++;
+		}
+		s_objInterpApplied = JTRUE;
+	}
+
+	void objInterp_restore()
+	{
+		if (!s_objInterpApplied) { return; }
+
+		const size_t count = s_objInterp.size();
+		ObjInterpEntry* entry = s_objInterp.data();
+		for (size_t i = 0; i < count; i++, entry++)
+		{
+			if (!entry->applied) { continue; }
+			SecObject* obj = entry->obj;
+			obj->posWS = entry->curPos;
+			obj->pitch = entry->curPitch;
+			obj->yaw   = entry->curYaw;
+			obj->roll  = entry->curRoll;
+			entry->applied = JFALSE;
+		}
+		s_objInterpApplied = JFALSE;
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Object Interpolation
+// TFE: Render interpolation of object transforms between simulation
+// steps, used when running the simulation at a fixed step.
+//
+// objInterp_capture() records the object transforms before a step,
+// objInterp_apply() then temporarily moves the objects between the
+// captured and current transforms for rendering, and
+// objInterp_restore() puts them back before the simulation continues.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include <TFE_Jedi/Math/core_math.h>
+
+namespace TFE_Jedi
+{
+	void objInterp_clear();
+
+	// Record the current transforms of all objects in the level.
+	void objInterp_capture();
+	// alpha = 0 -> captured transforms, alpha = ONE_16 -> current transforms.
+	void objInterp_apply(fixed16_16 alpha);
+	void objInterp_restore();
+}
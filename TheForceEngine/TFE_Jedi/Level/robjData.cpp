@@ -23,7 +23,15 @@ namespace TFE_Jedi
 		ChunkedArray* objectList = nullptr;
 	};
 	static SectorObjectData s_objData = {};
-		
+
+	static void objData_clearGridLinks(SecObject* obj)
+	{
+		obj->gridNext = nullptr;
+		obj->gridPrev = nullptr;
+		obj->gridKey = 0;
+		obj->gridId = 0;
+	}
+
 	void objData_clear()
 	{
 		s_objData = {};
@@ -35,7 +43,9 @@ namespace TFE_Jedi
 		{
 			s_objData.objectList = TFE_Memory::createChunkedArray(sizeof(SecObject), 256, 1, s_levelRegion);
 		}
-		return (SecObject*)TFE_Memory::allocFromChunkedArray(s_objData.objectList);
+		SecObject* obj = (SecObject*)TFE_Memory::allocFromChunkedArray(s_objData.objectList);
+		objData_clearGridLinks(obj);
+		return obj;
 	}
 
 	void objData_freeToArray(SecObject* obj)
@@ -201,6 +211,7 @@ namespace TFE_Jedi
 			for (u32 i = 0; i < writeCount; i++)
 			{
 				SecObject* obj = (SecObject*)TFE_Memory::allocFromChunkedArray(s_objData.objectList);
+				objData_clearGridLinks(obj);
 				objData_serializeObject(obj, stream);
 
 				if (obj->sector)
@@ -106,6 +106,11 @@ struct SecObject
 
 	// TFE
 	u32 serializeIndex;
+	// TFE: object grid links, see TFE_Jedi/Collision/objectGrid.h
+	SecObject* gridNext;
+	SecObject* gridPrev;
+	u32 gridKey;
+	u32 gridId;		// 0 if the object is not in the grid.
 };
 
 namespace TFE_Jedi
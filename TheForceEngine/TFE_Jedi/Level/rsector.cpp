@@ -11,6 +11,7 @@
 #include <TFE_DarkForces/player.h>
 #include <TFE_DarkForces/projectile.h>
 #include <TFE_Jedi/Collision/collision.h>
+#include <TFE_Jedi/Collision/objectGrid.h>
 #include <TFE_Jedi/InfSystem/infSystem.h>
 #include <TFE_Jedi/InfSystem/message.h>
 // TODO: Find a better way to handle this.
@@ -33,6 +34,8 @@ namespace TFE_Jedi
 	void sector_moveObjects(RSector* sector, u32 flags, fixed16_16 offsetX, fixed16_16 offsetZ);
 
 	f32 isLeft(Vec2f p0, Vec2f p1, Vec2f p2);
+
+	u32 s_sectorGeometryVersion = 0;
 	
 	/////////////////////////////////////////////////
 	// API Implementation
@@ -51,6 +54,49 @@ namespace TFE_Jedi
 		sector->verticesWS = nullptr;
 		sector->verticesVS = nullptr;
 		sector->self = sector;
+		sector->mapVersion = 0;
+	}
+
+	void sector_setFlags1(RSector* sector, u32 flags1)
+	{
+		// Door sectors change the map color of their own walls and the adjoining walls.
+		const u32 changed = sector->flags1 ^ flags1;
+		sector->flags1 = flags1;
+		if (!(changed & SEC_FLAGS1_DOOR))
+		{
+			return;
+		}
+
+		sector->mapVersion++;
+		RWall* wall = sector->walls;
+		for (s32 w = 0; w < sector->wallCount; w++, wall++)
+		{
+			if (wall->nextSector)
+			{
+				wall->nextSector->mapVersion++;
+			}
+		}
+	}
+
+	// TFE: Moving a floor only changes the automap when an adjoin starts or stops being a ledge.
+	static void sector_updateMapLedges(RSector* sector, fixed16_16 floorOffset)
+	{
+		const fixed16_16 prevFloorHeight = sector->floorHeight;
+		const fixed16_16 floorHeight = prevFloorHeight + floorOffset;
+		RWall* wall = sector->walls;
+		for (s32 w = 0; w < sector->wallCount; w++, wall++)
+		{
+			RSector* next = wall->nextSector;
+			if (!next) { continue; }
+
+			const JBool wasLedge = TFE_Jedi::abs(prevFloorHeight - next->floorHeight) >= SEC_MAP_LEDGE_HEIGHT;
+			const JBool isLedge = TFE_Jedi::abs(floorHeight - next->floorHeight) >= SEC_MAP_LEDGE_HEIGHT;
+			if (wasLedge != isLedge)
+			{
+				sector->mapVersion++;
+				next->mapVersion++;
+			}
+		}
 	}
 
 	void sector_setupWallDrawFlags(RSector* sector)
@@ -99,16 +145,19 @@ namespace TFE_Jedi
 	void sector_adjustHeights(RSector* sector, fixed16_16 floorOffset, fixed16_16 ceilOffset, fixed16_16 secondHeightOffset)
 	{
 		sector->dirtyFlags |= SDF_HEIGHTS;
+		s_sectorGeometryVersion++;
+		if (floorOffset)
+		{
+			sector_updateMapLedges(sector, floorOffset);
+		}
 
 		// Adjust objects.
 		if (sector->objectCount)
 		{
 			fixed16_16 heightOffset = secondHeightOffset + floorOffset;
-			for (s32 i = 0; i < sector->objectCapacity; i++)
+			for (s32 i = 0; i < sector->objectCount; i++)
 			{
 				SecObject* obj = sector->objectList[i];
-				if (!obj) { continue; }
-				
 				if (obj->posWS.y == sector->floorHeight)
 				{
 					obj->posWS.y += floorOffset;
@@ -218,20 +267,9 @@ namespace TFE_Jedi
 		s32 maxObjHeight = 0;
 		s32 count = sector->objectCount;
 		SecObject** objectList = sector->objectList;
-
-		if (!sector->objectCount)
+		for (s32 i = 0; i < count; i++)
 		{
-			return 0;
-		}
-
-		for (; count > 0; objectList++)
-		{
-			SecObject* obj = *objectList;
-			if (obj)
-			{
-				maxObjHeight = max(maxObjHeight, obj->worldHeight + ONE_16);
-				count--;
-			}
+			maxObjHeight = max(maxObjHeight, objectList[i]->worldHeight + ONE_16);
 		}
 		return maxObjHeight;
 	}
@@ -261,6 +299,8 @@ namespace TFE_Jedi
 		if (!sectorBlocked)
 		{
 			sector->dirtyFlags |= SDF_VERTICES;
+			s_sectorGeometryVersion++;
+			sector->mapVersion++;
 
 			wall = sector->walls;
 			for (s32 i = 0; i < wallCount; i++, wall++)
@@ -272,6 +312,7 @@ namespace TFE_Jedi
 					if (mirror && (mirror->flags1 & WF1_WALL_MORPHS))
 					{
 						mirror->sector->dirtyFlags |= SDF_VERTICES;
+						mirror->sector->mapVersion++;
 						sector_moveWallVertex(mirror, offsetX, offsetZ);
 					}
 				}
@@ -393,41 +434,32 @@ namespace TFE_Jedi
 
 	void sector_growObjectList(RSector* sector)
 	{
+		// TFE: The original code grew the list by 5 objects at a time, grow geometrically instead.
 		s32 objectCapacity = sector->objectCapacity;
 		if (sector->objectCount >= objectCapacity)
 		{
-			SecObject** list;
 			if (!objectCapacity)
 			{
-				list = (SecObject**)level_alloc(sizeof(SecObject*) * 5);
-				sector->objectList = list;
+				objectCapacity = SEC_MIN_OBJ_CAPACITY;
+				sector->objectList = (SecObject**)level_alloc(sizeof(SecObject*) * objectCapacity);
 			}
 			else
 			{
-				sector->objectList = (SecObject**)level_realloc(sector->objectList, sizeof(SecObject*) * (objectCapacity + 5));
-				list = sector->objectList + objectCapacity;
+				objectCapacity *= 2;
+				sector->objectList = (SecObject**)level_realloc(sector->objectList, sizeof(SecObject*) * objectCapacity);
 			}
-			memset(list, 0, sizeof(SecObject*) * 5);
-			sector->objectCapacity += 5;
+			sector->objectCapacity = objectCapacity;
 		}
 	}
 
 	void sector_addObjectToList(RSector* sector, SecObject* obj)
 	{
-		// Then add the object to the first free slot.
-		// Note that this scheme is optimized for deletion rather than addition.
-		SecObject** list = sector->objectList;
-		for (s32 i = 0; i < sector->objectCapacity; i++, list++)
-		{
-			if (!(*list))
-			{
-				*list = obj;
-				obj->index = i;
-				obj->sector = sector;
-				sector->objectCount++;
-				break;
-			}
-		}
+		// TFE: The list is kept dense, so the object is always added to the end.
+		// The original code added objects to the first free slot and left holes on removal.
+		obj->index = sector->objectCount;
+		obj->sector = sector;
+		sector->objectList[sector->objectCount++] = obj;
+		objGrid_insert(obj);
 	}
 
 	// Skips some of the checks and does not send messages.
@@ -477,6 +509,11 @@ namespace TFE_Jedi
 			// Then add the object to the first free slot.
 			sector_addObjectToList(sector, obj);
 		}
+		else
+		{
+			// TFE: The object may have moved within the sector.
+			objGrid_update(obj);
+		}
 	}
 
 	void sector_removeObject(SecObject* obj)
@@ -486,10 +523,19 @@ namespace TFE_Jedi
 		RSector* sector = obj->sector;
 		obj->sector = nullptr;
 		sector->dirtyFlags |= SDF_CHANGE_OBJ;
+		objGrid_remove(obj);
 
-		// Remove the object from the object list.
+		// Remove the object from the object list by moving the last object into its slot.
 		SecObject** objList = sector->objectList;
-		objList[obj->index] = nullptr;
+		s32 last = sector->objectCount - 1;
+		assert(obj->index >= 0 && obj->index <= last && objList[obj->index] == obj);
+		if (obj->index != last)
+		{
+			objList[obj->index] = objList[last];
+			objList[obj->index]->index = obj->index;
+		}
+		objList[last] = nullptr;
+		obj->index = -1;
 		sector->objectCount--;
 
 		if (!((obj->entityFlags & ETFLAG_PLAYER) && s_playerDying))
@@ -835,24 +881,20 @@ namespace TFE_Jedi
 		s32 freeCount = 0;
 		SecObject* freeList[128];
 
-		for (s32 i = 0, idx = 0; i < objectCount && idx < sector->objectCapacity; idx++)
+		for (s32 i = 0; i < objectCount; i++)
 		{
-			SecObject* obj = sector->objectList[idx];
-			if (obj)
-			{
-				i++;
+			SecObject* obj = sector->objectList[i];
 
-				JBool canRemove = (obj->entityFlags & ETFLAG_CORPSE) != 0;
-				canRemove |= ((obj->entityFlags & ETFLAG_PICKUP) && !(obj->flags & OBJ_FLAG_MISSION));
+			JBool canRemove = (obj->entityFlags & ETFLAG_CORPSE) != 0;
+			canRemove |= ((obj->entityFlags & ETFLAG_PICKUP) && !(obj->flags & OBJ_FLAG_MISSION));
 
-				const u32 projType = (obj->projectileLogic) ? ((TFE_DarkForces::ProjectileLogic*)obj->projectileLogic)->type : (0);
-				const JBool isLandMine = projType == PROJ_LAND_MINE || projType == PROJ_LAND_MINE_PROX || projType == PROJ_LAND_MINE_PLACED;
-				canRemove |= ((obj->entityFlags & ETFLAG_PROJECTILE) && isLandMine);
+			const u32 projType = (obj->projectileLogic) ? ((TFE_DarkForces::ProjectileLogic*)obj->projectileLogic)->type : (0);
+			const JBool isLandMine = projType == PROJ_LAND_MINE || projType == PROJ_LAND_MINE_PROX || projType == PROJ_LAND_MINE_PLACED;
+			canRemove |= ((obj->entityFlags & ETFLAG_PROJECTILE) && isLandMine);
 
-				if (canRemove && freeCount < 128)
-				{
-					freeList[freeCount++] = obj;
-				}
+			if (canRemove && freeCount < 128)
+			{
+				freeList[freeCount++] = obj;
 			}
 		}
 
@@ -965,6 +1007,8 @@ namespace TFE_Jedi
 		sinCosFixed(angle, &sinAngle, &cosAngle);
 
 		sector->dirtyFlags |= SDF_WALL_SHAPE;
+		s_sectorGeometryVersion++;
+		sector->mapVersion++;
 
 		s32 wallCount = sector->wallCount;
 		RWall* wall = sector->walls;
@@ -978,6 +1022,7 @@ namespace TFE_Jedi
 				if (mirror && (mirror->flags1 & WF1_WALL_MORPHS))
 				{
 					mirror->sector->dirtyFlags |= SDF_WALL_SHAPE;
+					mirror->sector->mapVersion++;
 					sector_rotateWall(mirror, cosAngle, sinAngle, centerX, centerZ);
 				}
 			}
@@ -1058,16 +1103,9 @@ namespace TFE_Jedi
 			moveCeil = JTRUE;
 		}
 
-		SecObject** objList = sector->objectList;
-		s32 objCount = sector->objectCount;
-		for (s32 i = 0; i < objCount; i++, objList++)
+		for (s32 i = 0; i < sector->objectCount;)
 		{
-			SecObject* obj = *objList;
-			while (!obj)
-			{
-				objList++;
-				obj = *objList;
-			}
+			SecObject* obj = sector->objectList[i];
 			// The first 3 conditionals can be collapsed since the resulting values are the same.
 			if ((moveFloor && obj->posWS.y == sector->floorHeight) ||
 				(moveSecHgt && sector->secHeight && sector->floorHeight + sector->secHeight == obj->posWS.y) ||
@@ -1075,6 +1113,8 @@ namespace TFE_Jedi
 			{
 				sector_rotateObj(obj, deltaAngle, cosdAngle, sindAngle, centerX, centerZ);
 			}
+			// The object may have moved to another sector.
+			if (sector->objectList[i] == obj) { i++; }
 		}
 	}
 
@@ -1285,23 +1325,20 @@ namespace TFE_Jedi
 		JBool offset   = (flags & INF_EFLAG_MOVE_SECHT)!=0 ? JTRUE : JFALSE;
 		JBool floor    = (flags & INF_EFLAG_MOVE_FLOOR)!=0 ? JTRUE : JFALSE;
 
-		SecObject** objList = sector->objectList;
-		for (s32 i = 0, idx = 0; i < sector->objectCount && idx < sector->objectCapacity; idx++)
+		for (s32 i = 0; i < sector->objectCount;)
 		{
-			SecObject* obj = objList[idx];
-			if (obj)
+			SecObject* obj = sector->objectList[i];
+			if ((obj->flags & OBJ_FLAG_MOVABLE) && (obj->entityFlags != ETFLAG_PLAYER))
 			{
-				i++;
-				if ((obj->flags & OBJ_FLAG_MOVABLE) && (obj->entityFlags != ETFLAG_PLAYER))
+				if ((floor   && obj->posWS.y == sector->floorHeight) ||
+					(offset  && sector->secHeight && sector->floorHeight + sector->secHeight == obj->posWS.y) ||
+					(ceiling && obj->posWS.y == sector->ceilingHeight))
 				{
-					if ((floor   && obj->posWS.y == sector->floorHeight) ||
-						(offset  && sector->secHeight && sector->floorHeight + sector->secHeight == obj->posWS.y) ||
-						(ceiling && obj->posWS.y == sector->ceilingHeight))
-					{
-						sector_moveObject(obj, offsetX, offsetZ);
-					}
+					sector_moveObject(obj, offsetX, offsetZ);
 				}
 			}
+			// The object may have moved to another sector.
+			if (sector->objectList[i] == obj) { i++; }
 		}
 	}
 		
@@ -38,6 +38,12 @@ enum SectorFlags1
 	SEC_FLAGS1_SECRET        = FLAG_BIT(19),
 };
 
+// TFE: Adjoining floors at least this far apart are shown as ledges on the automap.
+enum SectorMapConstants
+{
+	SEC_MAP_LEDGE_HEIGHT = 0x4000,	// 0.25 units
+};
+
 // Added for TFE to support floating point and GPU sub-renderers.
 // Floating point or GPU based sector data should be cached and only parts updated based
 // on these flags.
@@ -66,6 +72,7 @@ enum SectorDirtyFlags
 enum SectorConstants
 {
 	SEC_SKY_HEIGHT = FIXED(100),
+	SEC_MIN_OBJ_CAPACITY = 8,	// TFE: initial object list capacity, the list then grows geometrically.
 };
 
 struct RSector
@@ -109,6 +116,9 @@ struct RSector
 	vec2_fixed ceilOffset;
 
 	// Objects
+	// TFE: objectList is dense, objects [0, objectCount) are valid and obj->index is the slot of each object.
+	// Removing an object moves the last object into its slot, so loops that may remove objects should only
+	// advance when the current slot still holds the same object.
 	s32 objectCount;
 	SecObject** objectList;
 	s32 objectCapacity;
@@ -132,6 +142,9 @@ struct RSector
 
 	// Added for TFE, to support floating point and GPU sub-renderers.
 	u32 dirtyFlags;
+	// TFE: Incremented when anything the automap shows for the sector changes - the door flag, a ledge appearing
+	// or disappearing, vertices, wall map flags or newly seen walls (see sector_setFlags1() and wall_setFlags1()).
+	u32 mapVersion;
 };
 
 namespace TFE_Jedi
@@ -140,6 +153,8 @@ namespace TFE_Jedi
 	void sector_setupWallDrawFlags(RSector* sector);
 	void sector_adjustHeights(RSector* sector, fixed16_16 floorOffset, fixed16_16 ceilOffset, fixed16_16 secondHeightOffset);
 	void sector_computeBounds(RSector* sector);
+	// TFE: Sets flags1, invalidating the automap for the sector and its adjoining sectors if a flag shown on the map changed.
+	void sector_setFlags1(RSector* sector, u32 flags1);
 
 	fixed16_16 sector_getMaxObjectHeight(RSector* sector);
 	JBool sector_moveWalls(RSector* sector, fixed16_16 delta, fixed16_16 dirX, fixed16_16 dirZ, u32 flags);
@@ -167,4 +182,8 @@ namespace TFE_Jedi
 	JBool sector_canRotateWalls(RSector* sector, angle14_32 angle, fixed16_16 centerX, fixed16_16 centerZ);
 	void  sector_rotateWalls(RSector* sector, fixed16_16 centerX, fixed16_16 centerZ, angle14_32 angle);
 	void  sector_rotateObjects(RSector* sector, angle14_32 deltaAngle, fixed16_16 centerX, fixed16_16 centerZ, u32 flags);
+
+	// TFE: Incremented along with the geometry dirty flags (SDF_VERTICES, SDF_HEIGHTS, SDF_WALL_SHAPE).
+	// Unlike the dirty flags it is never reset by the renderer, so it can be used to invalidate cached collision queries.
+	extern u32 s_sectorGeometryVersion;
 }
\ No newline at end of file
@@ -80,7 +80,7 @@ namespace TFE_Jedi
 	void bitmap_setupAnimationTask()
 	{
 		s_texState.textureAnimTask = createSubTask("texture animation", textureAnimationTaskFunc);
-		s_texState.textureAnimAlloc = allocator_create(sizeof(AnimatedTexture));
+		s_texState.textureAnimAlloc = allocator_create(sizeof(AnimatedTexture), nullptr, ALLOC_STORAGE_PACKED);
 		s_texState.animTexIndex = 0;
 	}
 
@@ -224,7 +224,7 @@ namespace TFE_Jedi
 		file.readBuffer(s_buffer.data(), (u32)size);
 		file.close();
 
-		TextureData* texture = (TextureData*)region_alloc(s_texState.memoryRegion, sizeof(TextureData));
+		TextureData* texture = (TextureData*)region_alloc(s_texState.memoryRegion, sizeof(TextureData), "bitmap");
 		const u8* data = s_buffer.data();
 		const u8* fheader = data;
 		data += 3;
@@ -262,7 +262,7 @@ namespace TFE_Jedi
 			if (decompress & 1)
 			{
 				texture->dataSize = texture->width * texture->height;
-				texture->image = (u8*)region_alloc(s_texState.memoryRegion, texture->dataSize);
+				texture->image = (u8*)region_alloc(s_texState.memoryRegion, texture->dataSize, "bitmap");
 
 				const u8* inBuffer = data;
 				data += inSize;
@@ -294,11 +294,11 @@ namespace TFE_Jedi
 			else
 			{
 				texture->dataSize = inSize;
-				texture->image = (u8*)region_alloc(s_texState.memoryRegion, texture->dataSize);
+				texture->image = (u8*)region_alloc(s_texState.memoryRegion, texture->dataSize, "bitmap");
 				memcpy(texture->image, data, texture->dataSize);
 				data += texture->dataSize;
 
-				texture->columns = (u32*)region_alloc(s_texState.memoryRegion, texture->width * sizeof(u32));
+				texture->columns = (u32*)region_alloc(s_texState.memoryRegion, texture->width * sizeof(u32), "bitmap");
 				memcpy(texture->columns, data, texture->width * sizeof(u32));
 				data += texture->width * sizeof(u32);
 			}
@@ -314,7 +314,7 @@ namespace TFE_Jedi
 			data += 12;
 
 			// Allocate and read the BM image.
-			texture->image = (u8*)region_alloc(s_texState.memoryRegion, texture->dataSize);
+			texture->image = (u8*)region_alloc(s_texState.memoryRegion, texture->dataSize, "bitmap");
 			memcpy(texture->image, data, texture->dataSize);
 			data += texture->dataSize;
 		}
@@ -596,7 +596,8 @@ namespace TFE_Jedi
 		{
 			// No persistent state is required.
 			{
-				AnimatedTexture* animTex = (AnimatedTexture*)allocator_getHead(s_texState.textureAnimAlloc);
+				AllocatorIter iter;
+				AnimatedTexture* animTex = (AnimatedTexture*)allocator_iterBegin(s_texState.textureAnimAlloc, &iter);
 				while (animTex)
 				{
 					if (animTex->nextTick < s_curTick)
@@ -615,7 +616,7 @@ namespace TFE_Jedi
 						*animTex->texPtr = animTex->frameList[animTex->frame];
 						animTex->nextTick += animTex->delay;
 					}
-					animTex = (AnimatedTexture*)allocator_getNext(s_texState.textureAnimAlloc);
+					animTex = (AnimatedTexture*)allocator_iterNext(&iter);
 				}
 			}
 			task_yield(TASK_NO_DELAY);
@@ -37,9 +37,29 @@ namespace TFE_Jedi
 		}
 	}
 
+	void wall_markSeen(RWall* wall)
+	{
+		if (!wall->seen)
+		{
+			wall->seen = JTRUE;
+			wall->sector->mapVersion++;
+		}
+	}
+
+	void wall_setFlags1(RWall* wall, u32 flags1)
+	{
+		const u32 mapFlags = WF1_HIDE_ON_MAP | WF1_SHOW_NORMAL_ON_MAP | WF1_SHOW_AS_LEDGE_ON_MAP | WF1_SHOW_AS_DOOR_ON_MAP;
+		if ((wall->flags1 ^ flags1) & mapFlags)
+		{
+			wall->sector->mapVersion++;
+		}
+		wall->flags1 = flags1;
+	}
+
 	void wall_computeTexelHeights(RWall* wall)
 	{
 		wall->sector->dirtyFlags |= SDF_HEIGHTS;
+		s_sectorGeometryVersion++;
 
 		if (wall->nextSector)
 		{
@@ -95,6 +115,7 @@ namespace TFE_Jedi
 	fixed16_16 wall_computeDirectionVector(RWall* wall)
 	{
 		wall->sector->dirtyFlags |= SDF_WALL_SHAPE;
+		s_sectorGeometryVersion++;
 
 		// Calculate dx and dz
 		fixed16_16 dx = wall->w1->x - wall->w0->x;
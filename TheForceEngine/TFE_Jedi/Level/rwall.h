@@ -121,6 +121,10 @@ namespace TFE_Jedi
 	void wall_setupAdjoinDrawFlags(RWall* wall);
 	void wall_computeTexelHeights(RWall* wall);
 	fixed16_16 wall_computeDirectionVector(RWall* wall);
+	// TFE: Sets 'seen' and invalidates the automap for the wall's sector the first time the wall is seen.
+	void wall_markSeen(RWall* wall);
+	// TFE: Sets flags1, invalidating the automap for the wall's sector if a map display flag changed.
+	void wall_setFlags1(RWall* wall, u32 flags1);
 
 	void wall_getOpeningHeightRange(RWall* wall, fixed16_16* topRes, fixed16_16* botRes);
 }
\ No newline at end of file
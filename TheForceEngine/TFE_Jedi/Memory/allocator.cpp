@@ -1,5 +1,6 @@
 #include "allocator.h"
 #include <TFE_System/system.h>
+#include <TFE_Jedi/Math/core_math.h>
 #include <TFE_Memory/memoryRegion.h>
 #include <TFE_Game/igame.h>
 #include <assert.h>
@@ -10,6 +11,14 @@ struct AllocHeader
 	AllocHeader* next;
 };
 
+// Packed storage: a block of item slots, each slot is an AllocHeader followed by the item.
+struct AllocSlab
+{
+	AllocSlab* next;
+	s32 slotCount;
+	s32 pad;
+};
+
 struct Allocator
 {
 	Allocator*   self;
@@ -24,6 +33,20 @@ struct Allocator
 	// TFE
 	AllocHeader* iterSave;
 	AllocHeader* iterPrevSave;
+
+	// TFE: Packed storage.
+	AllocatorStorage storage;
+	s32 count;
+	s32 capacity;
+	AllocHeader** items;	// Indirection table, position -> item header in insertion order.
+	AllocSlab* slabs;
+	AllocHeader* freeSlots;
+	s32 slabSlotCount;
+	// Iterator positions, -1 = invalid.
+	s32 iterPos;
+	s32 iterPrevPos;
+	s32 iterSavePos;
+	s32 iterPrevSavePos;
 };
 
 namespace TFE_Jedi
@@ -35,8 +58,158 @@ namespace TFE_Jedi
 	#define ALLOC_INVALID_PTR ((AllocHeader*)c_invalidPtr)
 	#define MAX_ALLOC_SIZE (8*1024*1024)  // 8MB
 
+	enum PackedConst
+	{
+		PACKED_MIN_SLAB_SLOTS = 8,
+		PACKED_MAX_SLAB_SLOTS = 256,
+		PACKED_MAX_SLAB_SIZE  = 256 * 1024,
+		PACKED_MIN_CAPACITY   = 16,
+	};
+
+	/////////////////////////////////////////////////////
+	// Packed storage helpers
+	/////////////////////////////////////////////////////
+	static void* packed_getItem(Allocator* alloc, s32 pos)
+	{
+		if (pos < 0 || pos >= alloc->count) { return nullptr; }
+		return (u8*)alloc->items[pos] + sizeof(AllocHeader);
+	}
+
+	// Packed slots reuse the header: 'next' links the free slots and 'prev' holds the item position,
+	// so finding an item's position does not have to search the table.
+	static void packed_setPos(AllocHeader* header, s32 pos)
+	{
+		header->prev = (AllocHeader*)(intptr_t)pos;
+	}
+
+	static s32 packed_findPos(Allocator* alloc, AllocHeader* header)
+	{
+		const s32 pos = s32((intptr_t)header->prev);
+		if (pos < 0 || pos >= alloc->count || alloc->items[pos] != header) { return -1; }
+		return pos;
+	}
+
+	static bool packed_addSlab(Allocator* alloc)
+	{
+		// Grow the slab size with the item count so large lists end up in a few big blocks.
+		s32 slotCount = max((s32)PACKED_MIN_SLAB_SLOTS, min(alloc->slabSlotCount * 2, (s32)PACKED_MAX_SLAB_SLOTS));
+		slotCount = max(1, min(slotCount, (s32)PACKED_MAX_SLAB_SIZE / alloc->size));
+
+		AllocSlab* slab = (AllocSlab*)TFE_Memory::region_alloc(alloc->region, sizeof(AllocSlab) + size_t(slotCount) * alloc->size, "allocator");
+		if (!slab)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Allocator", "allocator_newItem - cannot allocate slab of %d items of size %d", slotCount, alloc->size);
+			return false;
+		}
+		slab->next = alloc->slabs;
+		slab->slotCount = slotCount;
+		alloc->slabs = slab;
+		alloc->slabSlotCount = slotCount;
+
+		// Push the slots in reverse order so they are handed out in memory order.
+		u8* slots = (u8*)slab + sizeof(AllocSlab);
+		for (s32 i = slotCount - 1; i >= 0; i--)
+		{
+			AllocHeader* header = (AllocHeader*)(slots + size_t(i) * alloc->size);
+			header->next = alloc->freeSlots;
+			alloc->freeSlots = header;
+		}
+		return true;
+	}
+
+	static void* packed_newItem(Allocator* alloc)
+	{
+		if (!alloc->freeSlots && !packed_addSlab(alloc))
+		{
+			assert(0);
+			return nullptr;
+		}
+		if (alloc->count >= alloc->capacity)
+		{
+			const s32 newCapacity = max((s32)PACKED_MIN_CAPACITY, alloc->capacity * 2);
+			AllocHeader** items = (AllocHeader**)TFE_Memory::region_realloc(alloc->region, alloc->items, sizeof(AllocHeader*) * newCapacity, "allocator");
+			if (!items)
+			{
+				TFE_System::logWrite(LOG_ERROR, "Allocator", "allocator_newItem - cannot grow the item table to %d entries", newCapacity);
+				assert(0);
+				return nullptr;
+			}
+			alloc->items = items;
+			alloc->capacity = newCapacity;
+		}
+
+		AllocHeader* header = alloc->freeSlots;
+		alloc->freeSlots = header->next;
+		header->next = nullptr;
+		packed_setPos(header, alloc->count);
+
+		alloc->items[alloc->count++] = header;
+		return (u8*)header + sizeof(AllocHeader);
+	}
+
+	// Adjust an iterator position after the item at 'pos' is removed.
+	// Matches the list behavior: the iterator moves to the previous item and the reverse iterator to the next item.
+	static void packed_fixupIter(s32* iter, s32 pos)
+	{
+		if (*iter >= pos) { (*iter)--; }
+	}
+
+	static void packed_fixupIterPrev(s32* iterPrev, s32 pos, s32 count)
+	{
+		if (*iterPrev > pos) { (*iterPrev)--; }
+		if (*iterPrev >= count) { *iterPrev = -1; }
+	}
+
+	static void packed_deleteItem(Allocator* alloc, void* item)
+	{
+		AllocHeader* header = (AllocHeader*)((u8*)item - sizeof(AllocHeader));
+		const s32 pos = packed_findPos(alloc, header);
+		if (pos < 0)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Allocator", "allocator_deleteItem - item does not belong to the allocator.");
+			assert(0);
+			return;
+		}
+
+		// Keep the insertion order, it is visible to game code and save games.
+		// This makes delete O(n) in the number of items after 'pos', so packed storage is meant for
+		// lists that are mostly iterated and rarely deleted from (see ALLOC_STORAGE_PACKED).
+		AllocHeader** items = alloc->items;
+		alloc->count--;
+		for (s32 i = pos; i < alloc->count; i++)
+		{
+			items[i] = items[i + 1];
+			packed_setPos(items[i], i);
+		}
+		packed_fixupIter(&alloc->iterPos, pos);
+		packed_fixupIter(&alloc->iterSavePos, pos);
+		packed_fixupIterPrev(&alloc->iterPrevPos, pos, alloc->count);
+		packed_fixupIterPrev(&alloc->iterPrevSavePos, pos, alloc->count);
+
+		packed_setPos(header, -1);
+		header->next = alloc->freeSlots;
+		alloc->freeSlots = header;
+	}
+
+	static void packed_free(Allocator* alloc)
+	{
+		AllocSlab* slab = alloc->slabs;
+		while (slab)
+		{
+			AllocSlab* next = slab->next;
+			TFE_Memory::region_free(alloc->region, slab);
+			slab = next;
+		}
+		TFE_Memory::region_free(alloc->region, alloc->items);
+		alloc->slabs = nullptr;
+		alloc->items = nullptr;
+		alloc->freeSlots = nullptr;
+		alloc->count = 0;
+		alloc->capacity = 0;
+	}
+
 	// Create and free an allocator.
-	Allocator* allocator_create(s32 allocSize, MemoryRegion* region)
+	Allocator* allocator_create(s32 allocSize, MemoryRegion* region, AllocatorStorage storage)
 	{
 		if (allocSize > MAX_ALLOC_SIZE || allocSize <= 0)
 		{
@@ -45,7 +218,7 @@ namespace TFE_Jedi
 			return nullptr;
 		}
 		region = region ? region : s_levelRegion;	// If a null region is passed in, assume we want the level region.
-		Allocator* res = (Allocator*)TFE_Memory::region_alloc(region, sizeof(Allocator));
+		Allocator* res = (Allocator*)TFE_Memory::region_alloc(region, sizeof(Allocator), "allocator");
 		if (!res)
 		{
 			TFE_System::logWrite(LOG_ERROR, "Allocator", "Could not allocate Allocator.");
@@ -62,6 +235,20 @@ namespace TFE_Jedi
 		res->iter = ALLOC_INVALID_PTR;
 		res->size = allocSize + sizeof(AllocHeader);
 		res->refCount = 0;
+		res->iterSave = ALLOC_INVALID_PTR;
+		res->iterPrevSave = ALLOC_INVALID_PTR;
+
+		res->storage = storage;
+		res->count = 0;
+		res->capacity = 0;
+		res->items = nullptr;
+		res->slabs = nullptr;
+		res->freeSlots = nullptr;
+		res->slabSlotCount = 0;
+		res->iterPos = -1;
+		res->iterPrevPos = -1;
+		res->iterSavePos = -1;
+		res->iterPrevSavePos = -1;
 
 		return res;
 	}
@@ -70,11 +257,18 @@ namespace TFE_Jedi
 	{
 		if (!alloc) { return; }
 
-		void* item = allocator_getHead(alloc);
-		while (item)
+		if (alloc->storage == ALLOC_STORAGE_PACKED)
 		{
-			allocator_deleteItem(alloc, item);
-			item = allocator_getNext(alloc);
+			packed_free(alloc);
+		}
+		else
+		{
+			void* item = allocator_getHead(alloc);
+			while (item)
+			{
+				allocator_deleteItem(alloc, item);
+				item = allocator_getNext(alloc);
+			}
 		}
 
 		alloc->self = (Allocator*)ALLOC_INVALID_PTR;
@@ -90,8 +284,9 @@ namespace TFE_Jedi
 	void* allocator_newItem(Allocator* alloc)
 	{
 		if (!alloc) { return nullptr; }
+		if (alloc->storage == ALLOC_STORAGE_PACKED) { return packed_newItem(alloc); }
 
-		AllocHeader* header = (AllocHeader*)TFE_Memory::region_alloc(alloc->region, alloc->size);
+		AllocHeader* header = (AllocHeader*)TFE_Memory::region_alloc(alloc->region, alloc->size, "allocator");
 		if (!header)
 		{
 			TFE_System::logWrite(LOG_ERROR, "Allocator", "allocator_newItem - cannot allocate header of size %d", alloc->size);
@@ -119,6 +314,11 @@ namespace TFE_Jedi
 	void allocator_deleteItem(Allocator* alloc, void* item)
 	{
 		if (!alloc) { return; }
+		if (alloc->storage == ALLOC_STORAGE_PACKED)
+		{
+			packed_deleteItem(alloc, item);
+			return;
+		}
 
 		AllocHeader* header = (AllocHeader*)((u8*)item - sizeof(AllocHeader));
 		AllocHeader* prev = header->prev;
@@ -146,6 +346,7 @@ namespace TFE_Jedi
 	s32 allocator_getCount(Allocator* alloc)
 	{
 		if (!alloc) { return 0; }
+		if (alloc->storage == ALLOC_STORAGE_PACKED) { return alloc->count; }
 
 		s32 count = 0;
 		AllocHeader* header = alloc->head;
@@ -160,6 +361,7 @@ namespace TFE_Jedi
 	s32 allocator_getCurPos(Allocator* alloc)
 	{
 		if (!alloc) { return -1; }
+		if (alloc->storage == ALLOC_STORAGE_PACKED) { return alloc->iterPos; }
 
 		s32 index = 0;
 		AllocHeader* iter = alloc->iter;
@@ -178,6 +380,12 @@ namespace TFE_Jedi
 
 	void allocator_setPos(Allocator* alloc, s32 pos)
 	{
+		if (alloc->storage == ALLOC_STORAGE_PACKED)
+		{
+			alloc->iterPos = (pos >= 0 && pos < alloc->count) ? pos : -1;
+			return;
+		}
+
 		s32 index = 0;
 		AllocHeader* header = alloc->head;
 		alloc->iter = ALLOC_INVALID_PTR;
@@ -196,6 +404,7 @@ namespace TFE_Jedi
 	s32 allocator_getPrevPos(Allocator* alloc)
 	{
 		if (!alloc) { return -1; }
+		if (alloc->storage == ALLOC_STORAGE_PACKED) { return alloc->iterPrevPos; }
 
 		s32 index = 0;
 		AllocHeader* iterPrev = alloc->iterPrev;
@@ -214,6 +423,12 @@ namespace TFE_Jedi
 
 	void allocator_setPrevPos(Allocator* alloc, s32 pos)
 	{
+		if (alloc->storage == ALLOC_STORAGE_PACKED)
+		{
+			if (pos >= 0 && pos < alloc->count) { alloc->iterPrevPos = pos; }
+			return;
+		}
+
 		s32 index = 0;
 		AllocHeader* header = alloc->head;
 		while (header != ALLOC_INVALID_PTR)
@@ -231,6 +446,10 @@ namespace TFE_Jedi
 	s32 allocator_getIndex(Allocator* alloc, void* item)
 	{
 		if (!item) { return -1; }
+		if (alloc->storage == ALLOC_STORAGE_PACKED)
+		{
+			return packed_findPos(alloc, (AllocHeader*)((u8*)item - sizeof(AllocHeader)));
+		}
 
 		AllocHeader* header = alloc->head;
 		s32 index = 0;
@@ -249,6 +468,15 @@ namespace TFE_Jedi
 	void* allocator_getByIndex(Allocator* alloc, s32 index)
 	{
 		if (!alloc) { return nullptr; }
+		if (alloc->storage == ALLOC_STORAGE_PACKED)
+		{
+			// Negative indices return the head, as with the list storage.
+			index = max(index, 0);
+			index = (index < alloc->count) ? index : -1;
+			alloc->iterPrevPos = index;
+			alloc->iterPos = index;
+			return packed_getItem(alloc, index);
+		}
 
 		AllocHeader* header = alloc->head;
 		while (index > 0 && header != ALLOC_INVALID_PTR)
@@ -268,6 +496,8 @@ namespace TFE_Jedi
 		if (!alloc) { return; }
 		alloc->iterPrevSave = alloc->iterPrev;
 		alloc->iterSave = alloc->iter;
+		alloc->iterPrevSavePos = alloc->iterPrevPos;
+		alloc->iterSavePos = alloc->iterPos;
 	}
 
 	void allocator_restoreIter(Allocator* alloc)
@@ -275,21 +505,35 @@ namespace TFE_Jedi
 		if (!alloc) { return; }
 		alloc->iterPrev = alloc->iterPrevSave;
 		alloc->iter = alloc->iterSave;
+		alloc->iterPrevPos = alloc->iterPrevSavePos;
+		alloc->iterPos = alloc->iterSavePos;
 	}
 
 	void* allocator_getIter(Allocator* alloc)
 	{
+		if (alloc->storage == ALLOC_STORAGE_PACKED) { return packed_getItem(alloc, alloc->iterPos); }
 		return (u8*)alloc->iter + sizeof(AllocHeader);
 	}
 
 	void allocator_setIter(Allocator* alloc, void* iter)
 	{
+		if (alloc->storage == ALLOC_STORAGE_PACKED)
+		{
+			alloc->iterPos = iter ? packed_findPos(alloc, (AllocHeader*)((u8*)iter - sizeof(AllocHeader))) : -1;
+			return;
+		}
 		alloc->iter = (AllocHeader*)((u8*)iter - sizeof(AllocHeader));
 	}
 
 	void* allocator_getHead(Allocator* alloc)
 	{
 		if (!alloc) { return nullptr; }
+		if (alloc->storage == ALLOC_STORAGE_PACKED)
+		{
+			alloc->iterPos = alloc->count ? 0 : -1;
+			alloc->iterPrevPos = alloc->iterPos;
+			return packed_getItem(alloc, alloc->iterPos);
+		}
 
 		alloc->iterPrev = alloc->head;
 		alloc->iter = alloc->head;
@@ -299,12 +543,19 @@ namespace TFE_Jedi
 	void* allocator_getHead_noIterUpdate(Allocator* alloc)
 	{
 		if (!alloc) { return nullptr; }
+		if (alloc->storage == ALLOC_STORAGE_PACKED) { return packed_getItem(alloc, 0); }
 		return (u8*)alloc->head + sizeof(AllocHeader);
 	}
 
 	void* allocator_getTail(Allocator* alloc)
 	{
 		if (!alloc) { return nullptr; }
+		if (alloc->storage == ALLOC_STORAGE_PACKED)
+		{
+			alloc->iterPos = alloc->count - 1;
+			alloc->iterPrevPos = alloc->iterPos;
+			return packed_getItem(alloc, alloc->iterPos);
+		}
 
 		alloc->iterPrev = alloc->tail;
 		alloc->iter = alloc->tail;
@@ -315,12 +566,22 @@ namespace TFE_Jedi
 	void* allocator_getTail_noIterUpdate(Allocator* alloc)
 	{
 		if (!alloc) { return nullptr; }
+		if (alloc->storage == ALLOC_STORAGE_PACKED) { return packed_getItem(alloc, alloc->count - 1); }
 		return (u8*)alloc->tail + sizeof(AllocHeader);
 	}
 
 	void* allocator_getNext(Allocator* alloc)
 	{
 		if (!alloc) { return nullptr; }
+		if (alloc->storage == ALLOC_STORAGE_PACKED)
+		{
+			// Once the end is reached, the iterator becomes invalid and the next call wraps around to the head.
+			s32 pos = alloc->iterPos + 1;
+			pos = (pos < alloc->count) ? pos : -1;
+			alloc->iterPos = pos;
+			alloc->iterPrevPos = pos;
+			return packed_getItem(alloc, pos);
+		}
 
 		AllocHeader* iter = alloc->iter;
 		if (iter != ALLOC_INVALID_PTR)
@@ -339,6 +600,13 @@ namespace TFE_Jedi
 	void* allocator_getPrev(Allocator* alloc)
 	{
 		if (!alloc) { return nullptr; }
+		if (alloc->storage == ALLOC_STORAGE_PACKED)
+		{
+			const s32 pos = (alloc->iterPrevPos >= 0) ? alloc->iterPrevPos - 1 : alloc->count - 1;
+			alloc->iterPos = pos;
+			alloc->iterPrevPos = pos;
+			return packed_getItem(alloc, pos);
+		}
 
 		AllocHeader* iterPrev = alloc->iterPrev;
 		if (iterPrev != ALLOC_INVALID_PTR)
@@ -354,6 +622,55 @@ namespace TFE_Jedi
 		return (u8*)alloc->tail + sizeof(AllocHeader);
 	}
 
+	// External iteration
+	void* allocator_iterBegin(Allocator* alloc, AllocatorIter* iter)
+	{
+		iter->alloc = alloc;
+		iter->cur = nullptr;
+		iter->next = nullptr;
+		iter->pos = -1;
+		if (!alloc) { return nullptr; }
+
+		if (alloc->storage == ALLOC_STORAGE_PACKED)
+		{
+			iter->pos = 0;
+			iter->cur = packed_getItem(alloc, 0);
+		}
+		else if (alloc->head != ALLOC_INVALID_PTR)
+		{
+			iter->cur = (u8*)alloc->head + sizeof(AllocHeader);
+			iter->next = (u8*)alloc->head->next + sizeof(AllocHeader);
+		}
+		return iter->cur;
+	}
+
+	void* allocator_iterNext(AllocatorIter* iter)
+	{
+		Allocator* alloc = iter->alloc;
+		if (!alloc || !iter->cur) { return nullptr; }
+
+		if (alloc->storage == ALLOC_STORAGE_PACKED)
+		{
+			// If the current item, or an item before it, was deleted then the following items have shifted down
+			// and the next item is already at the current position.
+			s32 pos = iter->pos;
+			AllocHeader* header = (AllocHeader*)((u8*)iter->cur - sizeof(AllocHeader));
+			if (pos < alloc->count && alloc->items[pos] == header) { pos++; }
+			iter->pos = pos;
+			iter->cur = packed_getItem(alloc, pos);
+		}
+		else
+		{
+			iter->cur = iter->next;
+			if (iter->cur)
+			{
+				AllocHeader* header = (AllocHeader*)((u8*)iter->cur - sizeof(AllocHeader));
+				iter->next = (u8*)header->next + sizeof(AllocHeader);
+			}
+		}
+		return iter->cur;
+	}
+
 	// Ref counting.
 	void allocator_addRef(Allocator* alloc)
 	{
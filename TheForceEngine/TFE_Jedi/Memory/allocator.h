@@ -7,10 +7,33 @@
 
 struct Allocator;
 
+enum AllocatorStorage
+{
+	// Items are individually allocated and linked together, as in the original code.
+	ALLOC_STORAGE_LIST = 0,
+	// TFE: Items are allocated from contiguous slabs and ordered by a dense table of item pointers.
+	// Item pointers stay valid until the item is deleted, so existing callers work unchanged,
+	// but iteration walks a contiguous array instead of chasing pointers.
+	// Lookups by item (allocator_getIndex(), allocator_setIter()) are O(1), but deleting an item shifts
+	// the items after it to keep insertion order, so do not use it for lists with frequent deletes.
+	ALLOC_STORAGE_PACKED,
+};
+
+// TFE: External iterator, allows several loops over the same allocator to be active at once
+// without using allocator_saveIter()/allocator_restoreIter().
+// It is safe to delete the current item while iterating.
+struct AllocatorIter
+{
+	Allocator* alloc;
+	void* cur;
+	void* next;	// List storage: the next item, read ahead so the current item can be deleted.
+	s32 pos;	// Packed storage: position of the current item.
+};
+
 namespace TFE_Jedi
 {
 	// Create and free an allocator.
-	Allocator* allocator_create(s32 allocSize, MemoryRegion* region = nullptr);
+	Allocator* allocator_create(s32 allocSize, MemoryRegion* region = nullptr, AllocatorStorage storage = ALLOC_STORAGE_LIST);
 	void allocator_free(Allocator* alloc);
 	bool allocator_validate(Allocator* alloc);
 
@@ -39,6 +62,10 @@ namespace TFE_Jedi
 	void allocator_restoreIter(Allocator* alloc);
 	void allocator_setIter(Allocator* alloc, void* iter);
 
+	// External (reentrant) iteration, these do not modify the allocator iterator.
+	void* allocator_iterBegin(Allocator* alloc, AllocatorIter* iter);
+	void* allocator_iterNext(AllocatorIter* iter);
+
 	// Ref counting.
 	void allocator_addRef(Allocator* alloc);
 	void allocator_release(Allocator* alloc);
@@ -77,13 +77,7 @@ namespace TFE_Jedi
 
 			for (s32 i = count - 1; i >= 0 && drawCount < MAX_VIEW_OBJ_COUNT; i--, obj++)
 			{
-				// Search for the next allocated object.
 				SecObject* curObj = *obj;
-				while (!curObj)
-				{
-					obj++;
-					curObj = *obj;
-				}
 
 				if (curObj->flags & OBJ_FLAG_NEEDS_TRANSFORM)
 				{
@@ -235,11 +229,6 @@ namespace TFE_Jedi
 				for (s32 i = s_curSector->objectCount - 1; i >= 0; i--, obj++)
 				{
 					SecObject* curObj = *obj;
-					while (!curObj)
-					{
-						obj++;
-						curObj = *obj;
-					}
 
 					if (curObj->flags & OBJ_FLAG_NEEDS_TRANSFORM)
 					{
@@ -520,7 +509,11 @@ namespace TFE_Jedi
 		}
 		TFE_ZONE_END(secDrawObjects);
 
-		s_curSector->flags1 |= SEC_FLAGS1_RENDERED;
+		if (!(s_curSector->flags1 & SEC_FLAGS1_RENDERED))
+		{
+			s_curSector->flags1 |= SEC_FLAGS1_RENDERED;
+			s_curSector->mapVersion++;
+		}
 		s_curSector->prevDrawFrame2 = s_drawFrame;
 	}
 		
@@ -870,7 +870,7 @@ namespace RClassic_Fixed
 			y0F += dYdXbot;
 		}
 
-		srcWall->seen = JTRUE;
+		wall_markSeen(srcWall);
 	}
 
 	void wall_drawTransparent(RWallSegmentFixed* wallSegment, EdgePairFixed* edge)
@@ -976,7 +976,7 @@ namespace RClassic_Fixed
 			}
 
 			srcWall->visible = 0;
-			srcWall->seen = JTRUE;
+			wall_markSeen(srcWall);
 			return;
 		}
 
@@ -1007,7 +1007,7 @@ namespace RClassic_Fixed
 				s_columnBot[x] = s_windowMinY_Pixels;
 			}
 			srcWall->visible = 0;
-			srcWall->seen = JTRUE;
+			wall_markSeen(srcWall);
 			return;
 		}
 
@@ -1055,7 +1055,7 @@ namespace RClassic_Fixed
 			}
 		}
 
-		srcWall->seen = JTRUE;
+		wall_markSeen(srcWall);
 	}
 
 	void wall_drawBottom(RWallSegmentFixed* wallSegment)
@@ -1098,7 +1098,7 @@ namespace RClassic_Fixed
 				s_rcfState.depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnTop[x] = s_windowMaxY_Pixels;
 			}
-			wall->seen = JTRUE;
+			wall_markSeen(wall);
 			return;
 		}
 
@@ -1124,7 +1124,7 @@ namespace RClassic_Fixed
 				s_rcfState.depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnBot[x] = s_windowMinY_Pixels;
 			}
-			wall->seen = JTRUE;
+			wall_markSeen(wall);
 			return;
 		}
 
@@ -1179,7 +1179,7 @@ namespace RClassic_Fixed
 				s_columnBot[x] = bot;
 				s_rcfState.depth1d[x] = solveForZ(wallSegment, x, num);
 			}
-			wall->seen = JTRUE;
+			wall_markSeen(wall);
 			return;
 		}
 
@@ -1288,7 +1288,7 @@ namespace RClassic_Fixed
 				yC += ceil_dYdX;
 			}
 		}
-		wall->seen = JTRUE;
+		wall_markSeen(wall);
 	}
 
 	void wall_drawTop(RWallSegmentFixed* wallSegment)
@@ -1326,7 +1326,7 @@ namespace RClassic_Fixed
 				s_rcfState.depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnTop[x] = s_windowMaxY_Pixels;
 			}
-			srcWall->seen = JTRUE;
+			wall_markSeen(srcWall);
 			return;
 		}
 
@@ -1353,7 +1353,7 @@ namespace RClassic_Fixed
 				s_rcfState.depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnBot[x] = s_windowMinY_Pixels;
 			}
-			srcWall->seen = JTRUE;
+			wall_markSeen(srcWall);
 			return;
 		}
 
@@ -1403,7 +1403,7 @@ namespace RClassic_Fixed
 				s_rcfState.depth1d[x] = solveForZ(wallSegment, x, num);
 				yF0 += floor_dYdX;
 			}
-			srcWall->seen = JTRUE;
+			wall_markSeen(srcWall);
 			return;
 		}
 
@@ -1504,7 +1504,7 @@ namespace RClassic_Fixed
 			yF0 += floor_dYdX;
 		}
 		
-		srcWall->seen = JTRUE;
+		wall_markSeen(srcWall);
 	}
 
 	void wall_drawTopAndBottom(RWallSegmentFixed* wallSegment)
@@ -1539,7 +1539,7 @@ namespace RClassic_Fixed
 				s_rcfState.depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnTop[x] = s_windowMaxY_Pixels;
 			}
-			srcWall->seen = JTRUE;
+			wall_markSeen(srcWall);
 			return;
 		}
 
@@ -1563,7 +1563,7 @@ namespace RClassic_Fixed
 				s_rcfState.depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnBot[x] = s_windowMinY_Pixels;
 			}
-			srcWall->seen = JTRUE;
+			wall_markSeen(srcWall);
 			return;
 		}
 
@@ -1801,12 +1801,12 @@ namespace RClassic_Fixed
 		s32 next_c1_pixel = round16(next_cProj1);
 		if ((next_f0_pixel <= s_windowMinY_Pixels && next_f1_pixel <= s_windowMinY_Pixels) || (next_c0_pixel >= s_windowMaxY_Pixels && next_c1_pixel >= s_windowMaxY_Pixels) || (nextSector->floorHeight <= nextSector->ceilingHeight))
 		{
-			srcWall->seen = JTRUE;
+			wall_markSeen(srcWall);
 			return;
 		}
 
 		wall_addAdjoinSegment(length, x0, next_floor_dYdX, next_fProj0 - ONE_16, next_ceil_dYdX, next_cProj0 + ONE_16, wallSegment);
-		srcWall->seen = JTRUE;
+		wall_markSeen(srcWall);
 	}
 
 	// Parts of the code inside 's_height == SKY_BASE_HEIGHT' are based on the original DOS exe.
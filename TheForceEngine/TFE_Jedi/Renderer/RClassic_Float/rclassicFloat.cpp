@@ -199,8 +199,6 @@ namespace RClassic_Float
 	{
 		s_rcfltState.depth1d_all = nullptr;
 		s_rcfltState.skyTable = nullptr;
-
-		free(s_rcfltState.adjoinEdgeList);
 		s_rcfltState.adjoinEdgeList = nullptr;
 	}
 
@@ -213,22 +211,13 @@ namespace RClassic_Float
 		setupProjectionParameters(f32(halfWidth), xc, yc);
 		setWidthFraction(1.0f);
 
-		EdgePairFloat* flatEdge = &s_rcfltState.flatEdgeList[s_flatCount];
-		s_rcfltState.flatEdge = flatEdge;
-		flat_addEdges(s_screenWidth, s_minScreenX_Pixels, 0, s_rcfltState.windowMaxY, 0, s_rcfltState.windowMinY);
-		
+		// Note: the initial flat edge is added in TFE_Sectors_Float::prepare() once the per-frame edge list is allocated.
 		s_columnTop = (s32*)game_realloc(s_columnTop, s_width * sizeof(s32));
 		s_columnBot = (s32*)game_realloc(s_columnBot, s_width * sizeof(s32));
 		s_rcfltState.depth1d_all = (f32*)game_realloc(s_rcfltState.depth1d_all, s_width * sizeof(f32) * (MAX_ADJOIN_DEPTH_EXT + 1));
 		s_windowTop_all = (s32*)game_realloc(s_windowTop_all, s_width * sizeof(s32) * (MAX_ADJOIN_DEPTH_EXT + 1));
 		s_windowBot_all = (s32*)game_realloc(s_windowBot_all, s_width * sizeof(s32) * (MAX_ADJOIN_DEPTH_EXT + 1));
 
-		// This table is giant with higher limits, so for now allocate directly from the heap (13 MB)
-		if (!s_rcfltState.adjoinEdgeList)
-		{
-			s_rcfltState.adjoinEdgeList = (EdgePairFloat*)malloc(sizeof(EdgePairFloat) * MAX_ADJOIN_SEG_EXT * MAX_ADJOIN_DEPTH_EXT);
-		}
-
 		memset(s_windowTop_all, s_minScreenY, s_width);
 		memset(s_windowBot_all, s_maxScreenY, s_width);
 
@@ -53,14 +53,16 @@ namespace TFE_Jedi
 		f32 windowMaxY;
 
 		// Flats
+		// The edge and segment lists are allocated from the frame arena each frame, sized by the current limits.
 		EdgePairFloat* flatEdge;
-		EdgePairFloat  flatEdgeList[MAX_SEG_EXT];
+		EdgePairFloat* flatEdgeList;	// [s_maxSegCount]
 		EdgePairFloat* adjoinEdge;
-		EdgePairFloat* adjoinEdgeList;
+		EdgePairFloat* adjoinEdgeList;	// [s_maxAdjoinSegCount]
 
-		RWallSegmentFloat   wallSegListDst[MAX_SEG_EXT];
-		RWallSegmentFloat   wallSegListSrc[MAX_SEG_EXT];
+		RWallSegmentFloat*  wallSegListDst;	// [s_maxSegCount]
+		RWallSegmentFloat*  wallSegListSrc;	// [s_maxSegCount]
 		RWallSegmentFloat** adjoinSegment;
+		RWallSegmentFloat** adjoinSegmentEnd;	// End of the current sector's adjoin list.
 	};
 	extern RClassicFloatState s_rcfltState;
 }  // TFE_Jedi
\ No newline at end of file
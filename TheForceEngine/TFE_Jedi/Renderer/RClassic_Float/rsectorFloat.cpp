@@ -3,6 +3,7 @@
 #include <TFE_System/profiler.h>
 #include <TFE_Asset/modelAsset_jedi.h>
 #include <TFE_Game/igame.h>
+#include <TFE_Memory/frameArena.h>
 #include <TFE_Jedi/Level/level.h>
 #include <TFE_Jedi/Level/levelData.h>
 #include <TFE_Jedi/Level/rsector.h>
@@ -86,15 +87,9 @@ namespace TFE_Jedi
 
 			const SectorCached* cached = &s_ctx->m_cachedSectors[sector->index];
 
-			for (s32 i = count - 1; i >= 0 && drawCount < MAX_VIEW_OBJ_COUNT; i--, obj++)
+			for (s32 i = count - 1; i >= 0 && drawCount < s_maxViewObjCount; i--, obj++)
 			{
-				// Search for the next allocated object.
 				SecObject* curObj = *obj;
-				while (!curObj)
-				{
-					obj++;
-					curObj = *obj;
-				}
 
 				if (curObj->flags & OBJ_FLAG_NEEDS_TRANSFORM)
 				{
@@ -181,6 +176,19 @@ namespace TFE_Jedi
 	{
 		allocateCachedData();
 
+		// Per-frame edge and segment lists, these are released when the next frame begins.
+		s_rcfltState.flatEdgeList   = frame_alloc(EdgePairFloat, s_maxSegCount);
+		s_rcfltState.adjoinEdgeList = frame_alloc(EdgePairFloat, s_maxAdjoinSegCount);
+		s_rcfltState.wallSegListDst = frame_alloc(RWallSegmentFloat, s_maxSegCount);
+		s_rcfltState.wallSegListSrc = frame_alloc(RWallSegmentFloat, s_maxSegCount);
+		if (!s_rcfltState.flatEdgeList || !s_rcfltState.adjoinEdgeList || !s_rcfltState.wallSegListDst || !s_rcfltState.wallSegListSrc)
+		{
+			// The frame arena could not grow, skip drawing sectors this frame (see draw()).
+			TFE_System::logWrite(LOG_ERROR, "Sector Render", "Cannot allocate the per-frame edge and segment lists.");
+			s_rcfltState.flatEdgeList = nullptr;
+			return;
+		}
+
 		EdgePairFloat* flatEdge = &s_rcfltState.flatEdgeList[s_flatCount];
 		s_rcfltState.flatEdge = flatEdge;
 		flat_addEdges(s_screenWidth, s_minScreenX_Pixels, 0, s_rcfltState.windowMaxY, 0, s_rcfltState.windowMinY);
@@ -201,6 +209,8 @@ namespace TFE_Jedi
 	
 	void TFE_Sectors_Float::draw(RSector* sector)
 	{
+		if (!s_rcfltState.flatEdgeList) { return; }
+
 		s_ctx = this;
 		s_curSector = sector;
 		s_sectorIndex++;
@@ -271,11 +281,6 @@ namespace TFE_Jedi
 				for (s32 i = s_curSector->objectCount - 1; i >= 0; i--, obj++)
 				{
 					SecObject* curObj = *obj;
-					while (!curObj)
-					{
-						obj++;
-						curObj = *obj;
-					}
 
 					if (curObj->flags & OBJ_FLAG_NEEDS_TRANSFORM)
 					{
@@ -313,10 +318,19 @@ namespace TFE_Jedi
 
 		s32 adjoinStart = s_adjoinSegCount;
 		EdgePairFloat* adjoinEdges = &s_rcfltState.adjoinEdgeList[adjoinStart];
-		RWallSegmentFloat* adjoinList[MAX_ADJOIN_DEPTH_EXT];
+		// Any adjoin segment added while drawing this sector's walls is stored here.
+		// Each wall segment with an adjoin adds at most one.
+		s32 maxAdjoinCount = 0;
+		for (s32 i = 0; i < drawSegCnt; i++)
+		{
+			if (wallSegment[i].srcWall->wall->nextSector) { maxAdjoinCount++; }
+		}
+		maxAdjoinCount = min(maxAdjoinCount, s_maxAdjoinSegCount - adjoinStart);
+		RWallSegmentFloat** adjoinList = maxAdjoinCount > 0 ? frame_alloc(RWallSegmentFloat*, maxAdjoinCount) : nullptr;
 
 		s_rcfltState.adjoinEdge = adjoinEdges;
 		s_rcfltState.adjoinSegment = adjoinList;
+		s_rcfltState.adjoinSegmentEnd = adjoinList ? adjoinList + maxAdjoinCount : nullptr;
 
 		// Draw each wall segment in the sector.
 		TFE_ZONE_BEGIN(secDrawWalls, "Draw Walls");
@@ -501,7 +515,8 @@ namespace TFE_Jedi
 
 		// Objects
 		TFE_ZONE_BEGIN(secDrawObjects, "Draw Objects");
-		const s32 objCount = cullObjects(s_curSector, s_objBuffer);
+		SecObject** objBuffer = frame_alloc(SecObject*, max(1, min(s_curSector->objectCount, s_maxViewObjCount)));
+		const s32 objCount = objBuffer ? cullObjects(s_curSector, objBuffer) : 0;
 		if (objCount > 0)
 		{
 			// Which top and bottom edges are we going to use to clip objects?
@@ -523,13 +538,13 @@ namespace TFE_Jedi
 			}
 
 			// Sort objects in viewspace (generally back to front but there are special cases).
-			qsort(s_objBuffer, objCount, sizeof(SecObject*), sortObjectsFloat);
+			qsort(objBuffer, objCount, sizeof(SecObject*), sortObjectsFloat);
 
 			// Draw objects in order.
 			vec3_float* cachedPosVS = cachedSector->objPosVS;
 			for (s32 i = 0; i < objCount; i++)
 			{
-				SecObject* obj = s_objBuffer[i];
+				SecObject* obj = objBuffer[i];
 				const s32 type = obj->type;
 				if (type == OBJ_TYPE_SPRITE)
 				{
@@ -557,7 +572,11 @@ namespace TFE_Jedi
 		}
 		TFE_ZONE_END(secDrawObjects);
 
-		s_curSector->flags1 |= SEC_FLAGS1_RENDERED;
+		if (!(s_curSector->flags1 & SEC_FLAGS1_RENDERED))
+		{
+			s_curSector->flags1 |= SEC_FLAGS1_RENDERED;
+			s_curSector->mapVersion++;
+		}
 		s_curSector->prevDrawFrame2 = s_drawFrame;
 	}
 		
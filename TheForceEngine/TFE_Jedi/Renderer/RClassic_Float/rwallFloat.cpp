@@ -905,7 +905,7 @@ namespace RClassic_Float
 			y0F += dYdXbot;
 		}
 
-		srcWall->seen = JTRUE;
+		wall_markSeen(srcWall);
 	}
 
 	void wall_drawTransparent(RWallSegmentFloat* wallSegment, EdgePairFloat* edge)
@@ -1018,7 +1018,7 @@ namespace RClassic_Float
 			}
 
 			srcWall->visible = 0;
-			srcWall->seen = JTRUE;
+			wall_markSeen(srcWall);
 			return;
 		}
 
@@ -1049,7 +1049,7 @@ namespace RClassic_Float
 				s_columnBot[x] = s_windowMinY_Pixels;
 			}
 			srcWall->visible = 0;
-			srcWall->seen = JTRUE;
+			wall_markSeen(srcWall);
 			return;
 		}
 
@@ -1097,7 +1097,7 @@ namespace RClassic_Float
 			}
 		}
 
-		srcWall->seen = JTRUE;
+		wall_markSeen(srcWall);
 	}
 
 	void wall_drawBottom(RWallSegmentFloat* wallSegment)
@@ -1143,7 +1143,7 @@ namespace RClassic_Float
 				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnTop[x] = s_windowMaxY_Pixels;
 			}
-			srcWall->seen = JTRUE;
+			wall_markSeen(srcWall);
 			return;
 		}
 
@@ -1168,7 +1168,7 @@ namespace RClassic_Float
 				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnBot[x] = s_windowMinY_Pixels;
 			}
-			srcWall->seen = JTRUE;
+			wall_markSeen(srcWall);
 			return;
 		}
 
@@ -1222,7 +1222,7 @@ namespace RClassic_Float
 				s_columnBot[x] = bot;
 				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
 			}
-			srcWall->seen = JTRUE;
+			wall_markSeen(srcWall);
 			return;
 		}
 
@@ -1333,7 +1333,7 @@ namespace RClassic_Float
 				yC += ceil_dYdX;
 			}
 		}
-		srcWall->seen = JTRUE;
+		wall_markSeen(srcWall);
 	}
 
 	void wall_drawTop(RWallSegmentFloat* wallSegment)
@@ -1373,7 +1373,7 @@ namespace RClassic_Float
 				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnTop[x] = s_windowMaxY_Pixels;
 			}
-			srcWall->seen = JTRUE;
+			wall_markSeen(srcWall);
 			return;
 		}
 
@@ -1401,7 +1401,7 @@ namespace RClassic_Float
 				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnBot[x] = s_windowMinY_Pixels;
 			}
-			srcWall->seen = JTRUE;
+			wall_markSeen(srcWall);
 			return;
 		}
 
@@ -1450,7 +1450,7 @@ namespace RClassic_Float
 				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
 				yF0 += floor_dYdX;
 			}
-			srcWall->seen = JTRUE;
+			wall_markSeen(srcWall);
 			return;
 		}
 
@@ -1552,7 +1552,7 @@ namespace RClassic_Float
 			yF0 += floor_dYdX;
 		}
 		
-		srcWall->seen = JTRUE;
+		wall_markSeen(srcWall);
 	}
 
 	void wall_drawTopAndBottom(RWallSegmentFloat* wallSegment)
@@ -1590,7 +1590,7 @@ namespace RClassic_Float
 				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnTop[x] = s_windowMaxY_Pixels;
 			}
-			srcWall->seen = JTRUE;
+			wall_markSeen(srcWall);
 			return;
 		}
 
@@ -1613,7 +1613,7 @@ namespace RClassic_Float
 				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnBot[x] = s_windowMinY_Pixels;
 			}
-			srcWall->seen = JTRUE;
+			wall_markSeen(srcWall);
 			return;
 		}
 
@@ -1853,12 +1853,12 @@ namespace RClassic_Float
 		s32 next_c1_pixel = roundFloat(next_cProj1);
 		if ((next_f0_pixel <= s_windowMinY_Pixels && next_f1_pixel <= s_windowMinY_Pixels) || (next_c0_pixel >= s_windowMaxY_Pixels && next_c1_pixel >= s_windowMaxY_Pixels) || (nextSector->floorHeight <= nextSector->ceilingHeight))
 		{
-			srcWall->seen = JTRUE;
+			wall_markSeen(srcWall);
 			return;
 		}
 
 		wall_addAdjoinSegment(length, x0, next_floor_dYdX, next_fProj0 - 1.0f, next_ceil_dYdX, next_cProj0 + 1.0f, wallSegment);
-		srcWall->seen = JTRUE;
+		wall_markSeen(srcWall);
 	}
 
 	// Parts of the code inside 's_height == SKY_BASE_HEIGHT' are based on the original DOS exe.
@@ -2194,7 +2194,7 @@ namespace RClassic_Float
 
 	void wall_addAdjoinSegment(s32 length, s32 x0, f32 top_dydx, f32 y1, f32 bot_dydx, f32 y0, RWallSegmentFloat* wallSegment)
 	{
-		if (s_adjoinSegCount < s_maxAdjoinSegCount)
+		if (s_adjoinSegCount < s_maxAdjoinSegCount && s_rcfltState.adjoinSegment < s_rcfltState.adjoinSegmentEnd)
 		{
 			f32 lengthFlt = f32(length - 1);
 			f32 y0End = y0;
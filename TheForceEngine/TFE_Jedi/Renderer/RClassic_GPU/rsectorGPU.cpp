@@ -4,6 +4,7 @@
 #include <TFE_System/math.h>
 #include <TFE_Asset/modelAsset_jedi.h>
 #include <TFE_Game/igame.h>
+#include <TFE_Memory/frameArena.h>
 #include <TFE_Jedi/Level/level.h>
 #include <TFE_Jedi/Level/levelData.h>
 #include <TFE_Jedi/Level/rsector.h>
@@ -103,10 +104,8 @@ namespace TFE_Jedi
 	static bool s_enableDebug = false;
 
 	static s32 s_gpuFrame;
-	static s32 s_portalListCount = 0;
 	static s32 s_rangeCount;
 
-	static Portal* s_portalList = nullptr;
 	static Vec2f  s_range[2];
 	static Vec2f  s_rangeSrc[2];
 
@@ -192,7 +191,6 @@ namespace TFE_Jedi
 
 	void TFE_Sectors_GPU::destroy()
 	{
-		free(s_portalList);
 		s_spriteShader.destroy();
 		s_wallShader[0].destroy();
 		s_wallShader[1].destroy();
@@ -201,7 +199,6 @@ namespace TFE_Jedi
 		s_wallGpuBuffer.destroy();
 		TFE_RenderBackend::freeTexture(s_colormapTex);
 		
-		s_portalList = nullptr;
 		s_cachedSectors = nullptr;
 		s_colormapTex = nullptr;
 
@@ -233,10 +230,6 @@ namespace TFE_Jedi
 			
 			m_gpuInit = true;
 			s_gpuFrame = 1;
-			if (!s_portalList)
-			{
-				s_portalList = (Portal*)malloc(sizeof(Portal) * MAX_DISP_ITEMS);
-			}
 
 			// Read the current graphics settings before compiling shaders.
 			TFE_Settings_Graphics* graphics = TFE_Settings::getGraphicsSettings();
@@ -529,12 +522,31 @@ namespace TFE_Jedi
 		srcSector->dirtyFlags = SDF_NONE;
 	}
 
-	s32 traversal_addPortals(RSector* curSector)
+	s32 traversal_addPortals(RSector* curSector, Portal** portalList)
 	{
-		// Add portals to the list to process for the sector.
+		// Count the potential portals so the list can be allocated from the frame arena.
 		SegmentClipped* segment = sbuffer_get();
 		s32 count = 0;
 		while (segment)
+		{
+			count += segment->seg->portal ? 1 : 0;
+			segment = segment->next;
+		}
+		if (!count)
+		{
+			*portalList = nullptr;
+			return 0;
+		}
+		*portalList = frame_alloc(Portal, count);
+		if (!*portalList)
+		{
+			return 0;
+		}
+
+		// Add portals to the list to process for the sector.
+		segment = sbuffer_get();
+		count = 0;
+		while (segment)
 		{
 			if (!segment->seg->portal)
 			{
@@ -555,8 +567,7 @@ namespace TFE_Jedi
 			Polygon clippedPortal;
 			if (frustum_clipQuadToFrustum(p0, p1, &clippedPortal, true/*ignoreNearPlane*/))
 			{
-				Portal* portalOut = &s_portalList[s_portalListCount];
-				s_portalListCount++;
+				Portal* portalOut = &(*portalList)[count];
 
 				frustum_buildFromPolygon(&clippedPortal, &portalOut->frustum);
 				portalOut->v0 = portal->v0;
@@ -677,10 +688,11 @@ namespace TFE_Jedi
 		return side0 <= 0.01f || side1 <= 0.01f;
 	}
 
-	static Segment s_wallSegments[2048];
-
 	void addPortalAsSky(RSector* curSector, RWall* wall)
 	{
+		// A wall produces at most two segments, when it is split at the modulus border.
+		Segment* wallSegments = frame_alloc(Segment, 2);
+		if (!wallSegments) { return; }
 		u32 segCount = 0;
 		GPUCachedSector* cached = &s_cachedSectors[curSector->index];
 		cached->builtFrame = s_gpuFrame;
@@ -695,7 +707,7 @@ namespace TFE_Jedi
 		f32 portalY0 = y0, portalY1 = y1;
 
 		// Add a new segment.
-		Segment* seg = &s_wallSegments[segCount];
+		Segment* seg = &wallSegments[segCount];
 		const Vec3f wallNormal = { -(z1 - z0), 0.0f, x1 - x0 };
 		Vec2f v0 = { x0, z0 }, v1 = { x1, z1 }, heights = { y0, y1 }, portalHeights = { portalY0, portalY1 };
 		if (!createNewSegment(seg, wall->id, false, v0, v1, heights, portalHeights, wallNormal))
@@ -707,7 +719,7 @@ namespace TFE_Jedi
 		// Split segments that cross the modulo boundary.
 		if (seg->x1 > 4.0f)
 		{
-			splitSegment(false, s_wallSegments, segCount, seg, s_range, s_rangeSrc, s_rangeCount);
+			splitSegment(false, wallSegments, segCount, seg, s_range, s_rangeSrc, s_rangeCount);
 		}
 		else if (!sbuffer_splitByRange(seg, s_range, s_rangeSrc, s_rangeCount))
 		{
@@ -719,7 +731,7 @@ namespace TFE_Jedi
 			assert(seg->x0 >= 0.0f && seg->x1 <= 4.0f);
 		}
 
-		buildSegmentBuffer(false, curSector, segCount, s_wallSegments, true/*forceTreatAsSolid*/);
+		buildSegmentBuffer(false, curSector, segCount, wallSegments, true/*forceTreatAsSolid*/);
 	}
 		
 	// Build world-space wall segments.
@@ -729,6 +741,13 @@ namespace TFE_Jedi
 		GPUCachedSector* cached = &s_cachedSectors[curSector->index];
 		cached->builtFrame = s_gpuFrame;
 
+		// Each wall produces at most two segments, the memory is released at the start of the next frame.
+		Segment* wallSegments = frame_alloc(Segment, max(2, 2 * curSector->wallCount));
+		if (!wallSegments)
+		{
+			return false;
+		}
+
 		// Portal range, all segments must be clipped to this.
 		// The actual clip vertices are p0 and p1.
 		s_rangeSrc[0] = p0;
@@ -852,7 +871,7 @@ namespace TFE_Jedi
 			}
 
 			// Add a new segment.
-			Segment* seg = &s_wallSegments[segCount];
+			Segment* seg = &wallSegments[segCount];
 			Vec2f v0 = { x0, z0 }, v1 = { x1, z1 }, heights = { y0, y1 }, portalHeights = { portalY0, portalY1 };
 			if (!createNewSegment(seg, w, isPortal, v0, v1, heights, portalHeights, wallNormal))
 			{
@@ -863,7 +882,7 @@ namespace TFE_Jedi
 			// Split segments that cross the modulo boundary.
 			if (seg->x1 > 4.0f)
 			{
-				splitSegment(initSector, s_wallSegments, segCount, seg, s_range, s_rangeSrc, s_rangeCount);
+				splitSegment(initSector, wallSegments, segCount, seg, s_range, s_rangeSrc, s_rangeCount);
 			}
 			else if (!initSector && !sbuffer_splitByRange(seg, s_range, s_rangeSrc, s_rangeCount))
 			{
@@ -876,7 +895,7 @@ namespace TFE_Jedi
 			}
 		}
 
-		buildSegmentBuffer(initSector, curSector, segCount, s_wallSegments, false/*forceTreatAsSolid*/);
+		buildSegmentBuffer(initSector, curSector, segCount, wallSegments, false/*forceTreatAsSolid*/);
 		return true;
 	}
 		
@@ -1029,11 +1048,9 @@ namespace TFE_Jedi
 		const Vec2f floorOffset = { fixed16ToFloat(curSector->floorOffset.x), fixed16ToFloat(curSector->floorOffset.z) };
 
 		SecObject** objIter = curSector->objectList;
-		for (s32 i = 0; i < curSector->objectCount; objIter++)
+		for (s32 i = 0; i < curSector->objectCount; i++, objIter++)
 		{
 			SecObject* obj = *objIter;
-			if (!obj) { continue; }
-			i++;
 
 			if ((obj->flags & OBJ_FLAG_NEEDS_TRANSFORM) && obj->ptr)
 			{
@@ -1084,7 +1101,11 @@ namespace TFE_Jedi
 		}
 		
 		// Mark sector as being rendered for the automap.
-		curSector->flags1 |= SEC_FLAGS1_RENDERED;
+		if (!(curSector->flags1 & SEC_FLAGS1_RENDERED))
+		{
+			curSector->flags1 |= SEC_FLAGS1_RENDERED;
+			curSector->mapVersion++;
+		}
 
 		// Build the world-space wall segments.
 		u32 segCount = 0;
@@ -1110,9 +1131,8 @@ namespace TFE_Jedi
 		// Traverse through visible portals.
 		s32 parentPortalId = s_displayCurrentPortalId;
 
-		const s32 portalStart = s_portalListCount;
-		const s32 portalCount = traversal_addPortals(curSector);
-		Portal* portal = &s_portalList[portalStart];
+		Portal* portal = nullptr;
+		const s32 portalCount = traversal_addPortals(curSector, &portal);
 		for (s32 p = 0; p < portalCount && s_portalsTraversed < s_maxPortals; p++, portal++)
 		{
 			frustum_push(portal->frustum);
@@ -1146,7 +1166,6 @@ namespace TFE_Jedi
 		s32 level = 0;
 		u32 uploadFlags = UPLOAD_NONE;
 		s_portalsTraversed = 0;
-		s_portalListCount = 0;
 		s_wallSegGenerated = 0;
 		Vec2f startView[] = { {0,0}, {0,0} };
 
@@ -325,7 +325,7 @@ namespace TFE_Jedi
 		s32 wallId = wallSeg->seg->id;
 		RWall* srcWall = &curSector->walls[wallId];
 		// Mark only visible walls as being rendered.
-		srcWall->seen = JTRUE;
+		wall_markSeen(srcWall);
 
 		// Limit 65536 walls **per sector**.
 		u32 wallGpuId = u32(wallId) << 16u;
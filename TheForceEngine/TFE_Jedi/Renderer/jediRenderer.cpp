@@ -23,6 +23,7 @@
 #include <TFE_Asset/spriteAsset_Jedi.h>
 #include <TFE_Asset/modelAsset_jedi.h>
 #include <TFE_FrontEndUI/console.h>
+#include <TFE_Memory/frameArena.h>
 
 namespace TFE_Jedi
 {
@@ -126,6 +127,7 @@ namespace TFE_Jedi
 	void renderer_destroy()
 	{
 		renderer_resetState();
+		TFE_Memory::frameArena_destroyThreadArena();
 	}
 
 	void renderer_reset()
@@ -144,15 +146,18 @@ namespace TFE_Jedi
 	{
 		if (TFE_Settings::getGraphicsSettings()->extendAjoinLimits)
 		{
-			s_maxSegCount = MAX_SEG_EXT;
-			s_maxAdjoinSegCount = MAX_ADJOIN_SEG_EXT;
+			// The buffers sized by these limits are allocated per-frame, so they can scale with the resolution.
+			s_maxSegCount = max(MAX_SEG_EXT, s_width * MAX_SEG_EXT / EXT_LIMIT_BASE_WIDTH);
+			s_maxAdjoinSegCount = max(MAX_ADJOIN_SEG_EXT, s_width * MAX_ADJOIN_SEG_EXT / EXT_LIMIT_BASE_WIDTH);
 			s_maxAdjoinDepthRecursion = MAX_ADJOIN_DEPTH_EXT;
+			s_maxViewObjCount = MAX_VIEW_OBJ_COUNT_EXT;
 		}
 		else
 		{
 			s_maxSegCount = MAX_SEG;
 			s_maxAdjoinSegCount = MAX_ADJOIN_SEG;
 			s_maxAdjoinDepthRecursion = MAX_ADJOIN_DEPTH;
+			s_maxViewObjCount = MAX_VIEW_OBJ_COUNT;
 		}
 	}
 
@@ -291,6 +296,8 @@ namespace TFE_Jedi
 			screen_enableGPU(true);
 			RClassic_GPU::changeResolution(width, height);
 		}
+		// Extended limits depend on the resolution.
+		renderer_setLimits();
 		return JTRUE;
 	}
 
@@ -391,6 +398,9 @@ namespace TFE_Jedi
 		
 	void beginRender()
 	{
+		// Per-frame renderer temporaries are released here.
+		TFE_Memory::frameArena_reset(TFE_Memory::frameArena_getThreadArena());
+
 		if (!s_sectorRenderer)
 		{
 			TFE_SubRenderer subRenderer = s_subRenderer;
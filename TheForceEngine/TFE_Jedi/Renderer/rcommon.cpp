@@ -80,6 +80,7 @@ namespace TFE_Jedi
 	s32 s_maxSegCount = MAX_SEG;
 	s32 s_maxAdjoinSegCount = MAX_ADJOIN_SEG;
 	s32 s_maxAdjoinDepthRecursion = MAX_ADJOIN_DEPTH;
+	s32 s_maxViewObjCount = MAX_VIEW_OBJ_COUNT;
 
 	// Debug
 	s32 s_maxWallCount;
@@ -83,6 +83,7 @@ namespace TFE_Jedi
 	extern s32 s_maxSegCount;
 	extern s32 s_maxAdjoinSegCount;
 	extern s32 s_maxAdjoinDepthRecursion;
+	extern s32 s_maxViewObjCount;
 
 	// Debug
 	extern s32 s_maxWallCount;
@@ -17,4 +17,8 @@ namespace TFE_Jedi
 	#define MAX_SEG_EXT	         2048 // Maximum number of wall segments with extended limits, this allows for ~1 wall/pixel column @1080p like vanilla @ 320x200
 	#define MAX_ADJOIN_SEG_EXT   1024 // Maximum number of adjoin segments with extended limits.
 	#define MAX_ADJOIN_DEPTH_EXT 255  // Maximum adjoin recursion depth with extended limits.
+	#define MAX_VIEW_OBJ_COUNT_EXT 65535 // Maximum number of rendered objects in a single sector with extended limits (effectively unlimited).
+	// With extended limits, the segment limits scale with the horizontal resolution - MAX_SEG_EXT and MAX_ADJOIN_SEG_EXT are the minimums.
+	// Per-frame buffers sized from these limits are allocated from the frame arena, see TFE_Memory/frameArena.h
+	#define EXT_LIMIT_BASE_WIDTH 1920
 }
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include <TFE_Jedi/Serialization/serialization.h>
 #include <stdarg.h>
 #include <tuple>
+#include <algorithm>
 #include <vector>
 
 using namespace TFE_DarkForces;
@@ -92,6 +93,23 @@ namespace TFE_Jedi
 	static JBool s_taskSystemPaused = JFALSE;
 	static Task* s_taskPauseTask = nullptr;
 
+	// TFE: Fixed step mode.
+	// Real time is accumulated and tasks run once whole steps are available, the remainder carries over
+	// to the next frame (instead of being dropped) and is used to interpolate rendering between steps.
+	enum FixedStepConstants
+	{
+		FIXED_STEP_MAX_CATCHUP = 16,	// Maximum number of steps to catch up in a single frame before dropping time.
+	};
+	static JBool s_fixedStep = JFALSE;
+	static f64 s_fixedStepInSec = 0.0;
+	static f64 s_fixedStepAccum = 0.0;
+
+	// TFE: Fast-forward mode.
+	static JBool s_fastForward = JFALSE;
+	static s32 s_fastForwardRenderInterval = 0;
+	static u32 s_fastForwardRuns = 0;
+	static u64 s_fastForwardStart = 0;
+
 	void selectNextTask();
 
 	void createRootTask()
@@ -300,6 +318,9 @@ namespace TFE_Jedi
 		s_frameActiveTaskCount = 0;
 		s_taskSystemPaused = JFALSE;
 		s_taskPauseTask = nullptr;
+		s_fixedStep = JFALSE;
+		s_fixedStepInSec = 0.0;
+		s_fixedStepAccum = 0.0;
 	}
 
 	void task_makeActive(Task* task)
@@ -519,8 +540,13 @@ namespace TFE_Jedi
 
 	JBool task_canRun()
 	{
-		if (s_taskCount)
+		if (s_taskCount && !s_fastForward)
 		{
+			if (s_fixedStep)
+			{
+				return task_getPendingSteps() > 0 ? JTRUE : JFALSE;
+			}
+
 			const f64 time = TFE_System::getTime();
 			if (time - s_prevTime < s_minIntervalInSec)
 			{
@@ -533,6 +559,69 @@ namespace TFE_Jedi
 	void task_updateTime()
 	{
 		s_prevTime = TFE_System::getTime();
+		s_fixedStepAccum = 0.0;
+	}
+
+	void task_setFixedStep(JBool enable, f64 stepInSec)
+	{
+		enable = (enable && stepInSec > 0.0) ? JTRUE : JFALSE;
+		if (enable == s_fixedStep && stepInSec == s_fixedStepInSec) { return; }
+		s_fixedStep = enable;
+		s_fixedStepInSec = stepInSec;
+		s_fixedStepAccum = 0.0;
+	}
+
+	JBool task_isFixedStep()
+	{
+		return s_fixedStep;
+	}
+
+	s32 task_getPendingSteps()
+	{
+		if (!s_fixedStep) { return 0; }
+		const f64 accum = s_fixedStepAccum + (TFE_System::getTime() - s_prevTime);
+		return min(s32(accum / s_fixedStepInSec), s32(FIXED_STEP_MAX_CATCHUP));
+	}
+
+	f32 task_getStepAlpha()
+	{
+		if (!s_fixedStep) { return 1.0f; }
+		const f64 accum = s_fixedStepAccum + (TFE_System::getTime() - s_prevTime);
+		return f32(std::min(std::max(accum / s_fixedStepInSec, 0.0), 1.0));
+	}
+
+	void task_setFastForward(JBool enable, s32 renderInterval)
+	{
+		if (!enable && s_fastForward)
+		{
+			// Report the raw simulation throughput.
+			const f64 elapsed = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - s_fastForwardStart);
+			TFE_System::logWrite(LOG_MSG, "Task System", "Fast-forward ran %u ticks in %0.2f seconds (%0.1f ticks per second).",
+				s_fastForwardRuns, elapsed, elapsed > 0.0 ? f64(s_fastForwardRuns) / elapsed : 0.0);
+		}
+		else if (enable && !s_fastForward)
+		{
+			s_fastForwardRuns = 0;
+			s_fastForwardStart = TFE_System::getCurrentTimeInTicks();
+		}
+		s_fastForward = enable;
+		s_fastForwardRenderInterval = max(0, renderInterval);
+	}
+
+	JBool task_isFastForward()
+	{
+		return s_fastForward;
+	}
+
+	u32 task_getFastForwardRuns()
+	{
+		return s_fastForwardRuns;
+	}
+
+	JBool task_isRenderSkipped()
+	{
+		if (!s_fastForward) { return JFALSE; }
+		return (s_fastForwardRenderInterval < 1 || (s_fastForwardRuns % u32(s_fastForwardRenderInterval)) != 0) ? JTRUE : JFALSE;
 	}
 
 	// Called once per frame to run all of the tasks.
@@ -548,7 +637,26 @@ namespace TFE_Jedi
 		// Limit the update rate by the minimum interval.
 		// Dark Forces uses discrete 'ticks' to track time and the game behavior is very odd with 0 tick frames.
 		const f64 time = TFE_System::getTime();
-		if (time - s_prevTime < s_minIntervalInSec)
+		if (s_fastForward)
+		{
+			s_fastForwardRuns++;
+		}
+		else if (s_fixedStep)
+		{
+			// Consume the whole steps (see task_getPendingSteps()), keeping the remainder.
+			const s32 steps = task_getPendingSteps();
+			if (steps < 1)
+			{
+				return JFALSE;
+			}
+			s_fixedStepAccum += (time - s_prevTime) - f64(steps) * s_fixedStepInSec;
+			// Drop any time beyond the catch-up limit.
+			if (s_fixedStepAccum >= s_fixedStepInSec)
+			{
+				s_fixedStepAccum = 0.0;
+			}
+		}
+		else if (time - s_prevTime < s_minIntervalInSec)
 		{
 			return JFALSE;
 		}
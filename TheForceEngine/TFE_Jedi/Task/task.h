@@ -76,6 +76,25 @@ namespace TFE_Jedi
 
 	void task_updateTime();
 	s32 task_getCount();
+
+	// TFE: Fixed step mode, where each call to task_run() consumes a whole number of fixed steps
+	// and the remainder carries over. The caller is responsible for advancing game time by the
+	// pending steps (see task_getPendingSteps()) before calling task_run().
+	void  task_setFixedStep(JBool enable, f64 stepInSec);
+	JBool task_isFixedStep();
+	s32   task_getPendingSteps();
+	// Fraction of the next step that has elapsed, in the range [0, 1] - used to interpolate rendering.
+	f32   task_getStepAlpha();
+
+	// TFE: Fast-forward mode, where task_run() ignores the minimum interval and fixed step so the tasks
+	// run every time they are called. The caller is responsible for advancing game time synthetically.
+	// Only every 'renderInterval' runs are rendered (0 = never), see task_isRenderSkipped().
+	// The default renders about once per second of game time.
+	void  task_setFastForward(JBool enable, s32 renderInterval = 145);
+	JBool task_isFastForward();
+	JBool task_isRenderSkipped();
+	// Number of times the tasks have run since fast-forward was enabled.
+	u32   task_getFastForwardRuns();
 }
 ////////////////////////////////////////////////////////////////////////
 // Task Function API:
@@ -60,21 +60,21 @@ namespace TFE_Memory
 	ChunkedArray* restore(FileStream* file, MemoryRegion* region)
 	{
 		assert(file && region);
-		ChunkedArray* arr = (ChunkedArray*)region_alloc(region, sizeof(ChunkedArray));
+		ChunkedArray* arr = (ChunkedArray*)region_alloc(region, sizeof(ChunkedArray), "chunkedArray");
 		memset(arr, 0, sizeof(ChunkedArray));
 
 		size_t size = size_t(&arr->chunks) - sizeof(arr);
 		file->readBuffer(arr, (u32)size);
 
-		arr->chunks = (u8**)region_realloc(region, arr->chunks, sizeof(u8*) * arr->chunkCount);
+		arr->chunks = (u8**)region_realloc(region, arr->chunks, sizeof(u8*) * arr->chunkCount, "chunkedArray");
 		const u32 chunkAllocSize = arr->elemPerChunk * arr->elemSize;
 		for (u32 i = 0; i < arr->chunkCount; i++)
 		{
-			arr->chunks[i] = (u8*)region_alloc(region, chunkAllocSize);
+			arr->chunks[i] = (u8*)region_alloc(region, chunkAllocSize, "chunkedArray");
 			file->read(arr->chunks[i], chunkAllocSize);
 		}
 
-		arr->freeSlots = (u8**)region_realloc(region, arr->freeSlots, sizeof(u8**) * arr->freeSlotCapacity);
+		arr->freeSlots = (u8**)region_realloc(region, arr->freeSlots, sizeof(u8**) * arr->freeSlotCapacity, "chunkedArray");
 		for (u32 i = 0; i < arr->freeSlotCount; i++)
 		{
 			s32 freeSlotIndex;
@@ -93,7 +93,7 @@ namespace TFE_Memory
 
 	ChunkedArray* createChunkedArray(u32 elemSize, u32 elemPerChunk, u32 initChunkCount, MemoryRegion* region)
 	{
-		ChunkedArray* arr = (ChunkedArray*)region_alloc(region, sizeof(ChunkedArray));
+		ChunkedArray* arr = (ChunkedArray*)region_alloc(region, sizeof(ChunkedArray), "chunkedArray");
 		memset(arr, 0, sizeof(ChunkedArray));
 		
 		arr->region = region;
@@ -102,7 +102,7 @@ namespace TFE_Memory
 				
 		arr->elemPerChunk = elemPerChunk;
 		arr->chunkCount = initChunkCount;
-		arr->chunks = (u8**)region_realloc(region, arr->chunks, sizeof(u8*) * initChunkCount);
+		arr->chunks = (u8**)region_realloc(region, arr->chunks, sizeof(u8*) * initChunkCount, "chunkedArray");
 		
 		arr->freeSlotCount = 0;
 		arr->freeSlotCapacity = 0;
@@ -111,7 +111,7 @@ namespace TFE_Memory
 		const u32 chunkAllocSize = elemPerChunk * elemSize;
 		for (u32 i = 0; i < initChunkCount; i++)
 		{
-			arr->chunks[i] = (u8*)region_alloc(region, chunkAllocSize);
+			arr->chunks[i] = (u8*)region_alloc(region, chunkAllocSize, "chunkedArray");
 		}
 
 		return arr;
@@ -144,12 +144,12 @@ namespace TFE_Memory
 		const u32 newChunkCount = newChunkIndex + 1;
 		if (newChunkCount > arr->chunkCount)
 		{
-			arr->chunks = (u8**)region_realloc(arr->region, arr->chunks, sizeof(u8*) * newChunkCount);
+			arr->chunks = (u8**)region_realloc(arr->region, arr->chunks, sizeof(u8*) * newChunkCount, "chunkedArray");
 
 			const u32 chunkAllocSize = arr->elemPerChunk * arr->elemSize;
 			for (u32 i = arr->chunkCount; i < newChunkCount; i++)
 			{
-				arr->chunks[i] = (u8*)region_alloc(arr->region, chunkAllocSize);
+				arr->chunks[i] = (u8*)region_alloc(arr->region, chunkAllocSize, "chunkedArray");
 			}
 			arr->chunkCount = newChunkCount;
 		}
@@ -225,7 +225,7 @@ namespace TFE_Memory
 		if (arr->freeSlotCount + 1 >= arr->freeSlotCapacity)
 		{
 			arr->freeSlotCapacity += FREE_SLOT_STEP;
-			arr->freeSlots = (u8**)region_realloc(arr->region, arr->freeSlots, sizeof(u8*) * arr->freeSlotCapacity);
+			arr->freeSlots = (u8**)region_realloc(arr->region, arr->freeSlots, sizeof(u8*) * arr->freeSlotCapacity, "chunkedArray");
 		}
 		arr->freeSlots[arr->freeSlotCount] = ptr;
 		arr->freeSlotCount++;
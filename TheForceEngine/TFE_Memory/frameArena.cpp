@@ -0,0 +1,182 @@
+#include <cstring>
+
+#include "frameArena.h"
+#include <TFE_System/system.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <algorithm>
+
+enum
+{
+	ARENA_ALIGNMENT = 16,
+	ARENA_DEFAULT_SIZE = 4 * 1024 * 1024,	// 4 MB
+};
+
+struct ArenaBlock
+{
+	ArenaBlock* next;
+	size_t size;
+	size_t used;
+	size_t pad;	// pad to 32 bytes so the data is aligned.
+};
+
+struct FrameArena
+{
+	char name[32];
+	ArenaBlock* head;
+	ArenaBlock* cur;
+
+	size_t used;		// used by previous (full) blocks in the chain.
+	size_t capacity;
+	size_t highWaterMark;
+};
+
+static_assert((sizeof(ArenaBlock) & (ARENA_ALIGNMENT - 1)) == 0, "ArenaBlock must be a multiple of the alignment.");
+
+namespace TFE_Memory
+{
+	static thread_local FrameArena* s_threadArena = nullptr;
+
+	ArenaBlock* allocateArenaBlock(FrameArena* arena, size_t size)
+	{
+		ArenaBlock* block = (ArenaBlock*)malloc(sizeof(ArenaBlock) + size);
+		if (!block)
+		{
+			TFE_System::logWrite(LOG_ERROR, "FrameArena", "Failed to allocate block of size %zu in arena '%s'.", size, arena->name);
+			return nullptr;
+		}
+		block->next = nullptr;
+		block->size = size;
+		block->used = 0;
+		arena->capacity += size;
+		return block;
+	}
+
+	void freeArenaBlocks(FrameArena* arena)
+	{
+		ArenaBlock* block = arena->head;
+		while (block)
+		{
+			ArenaBlock* next = block->next;
+			free(block);
+			block = next;
+		}
+		arena->head = nullptr;
+		arena->cur = nullptr;
+		arena->capacity = 0;
+	}
+
+	FrameArena* frameArena_create(const char* name, size_t initialSize)
+	{
+		FrameArena* arena = (FrameArena*)malloc(sizeof(FrameArena));
+		if (!arena)
+		{
+			TFE_System::logWrite(LOG_ERROR, "FrameArena", "Failed to allocate arena '%s'.", name);
+			return nullptr;
+		}
+		strncpy(arena->name, name, 31);
+		arena->name[31] = 0;
+		arena->used = 0;
+		arena->capacity = 0;
+		arena->highWaterMark = 0;
+
+		arena->head = allocateArenaBlock(arena, initialSize ? initialSize : size_t(ARENA_DEFAULT_SIZE));
+		arena->cur = arena->head;
+		if (!arena->head)
+		{
+			free(arena);
+			return nullptr;
+		}
+		return arena;
+	}
+
+	void frameArena_destroy(FrameArena* arena)
+	{
+		if (!arena) { return; }
+		freeArenaBlocks(arena);
+		free(arena);
+	}
+
+	void frameArena_reset(FrameArena* arena)
+	{
+		assert(arena);
+		const size_t used = arena->used + (arena->cur ? arena->cur->used : 0);
+		arena->highWaterMark = std::max(arena->highWaterMark, used);
+
+		// The previous frame spilled into additional blocks, merge them into a single block large enough for everything.
+		if (arena->head && arena->head->next)
+		{
+			const size_t newSize = arena->capacity;
+			freeArenaBlocks(arena);
+			arena->head = allocateArenaBlock(arena, newSize);
+			TFE_System::logWrite(LOG_MSG, "FrameArena", "Arena '%s' grown to %zu bytes.", arena->name, newSize);
+		}
+		arena->cur = arena->head;
+		arena->used = 0;
+		if (arena->cur)
+		{
+			arena->cur->used = 0;
+		}
+	}
+
+	void* frameArena_alloc(FrameArena* arena, size_t size)
+	{
+		// The thread arena is null if it could not be created.
+		if (!arena || !size) { return nullptr; }
+		size = (size + ARENA_ALIGNMENT - 1) & ~size_t(ARENA_ALIGNMENT - 1);
+
+		ArenaBlock* block = arena->cur;
+		if (!block || block->used + size > block->size)
+		{
+			// Chain on a new block, at least double the current capacity to limit the number of blocks in a frame.
+			ArenaBlock* newBlock = allocateArenaBlock(arena, std::max(size, arena->capacity));
+			if (!newBlock) { return nullptr; }
+
+			if (block)
+			{
+				arena->used += block->used;
+				block->next = newBlock;
+			}
+			else
+			{
+				arena->head = newBlock;
+			}
+			arena->cur = newBlock;
+			block = newBlock;
+		}
+
+		u8* mem = (u8*)block + sizeof(ArenaBlock) + block->used;
+		block->used += size;
+		return mem;
+	}
+
+	size_t frameArena_getMemoryUsed(FrameArena* arena)
+	{
+		return arena->used + (arena->cur ? arena->cur->used : 0);
+	}
+
+	size_t frameArena_getCapacity(FrameArena* arena)
+	{
+		return arena->capacity;
+	}
+
+	size_t frameArena_getHighWaterMark(FrameArena* arena)
+	{
+		return std::max(arena->highWaterMark, frameArena_getMemoryUsed(arena));
+	}
+
+	FrameArena* frameArena_getThreadArena()
+	{
+		if (!s_threadArena)
+		{
+			s_threadArena = frameArena_create("thread frame", ARENA_DEFAULT_SIZE);
+		}
+		return s_threadArena;
+	}
+
+	void frameArena_destroyThreadArena()
+	{
+		frameArena_destroy(s_threadArena);
+		s_threadArena = nullptr;
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Frame arena
+// Linear (bump) allocator for per-frame temporaries.
+// Allocations are never freed individually, instead the whole arena
+// is reset once per frame. If a frame needs more memory than is
+// available, new blocks are chained on and then merged into a single
+// block on the next reset - so after a few frames there is no heap
+// traffic at all.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+
+struct FrameArena;
+
+namespace TFE_Memory
+{
+	FrameArena* frameArena_create(const char* name, size_t initialSize);
+	void frameArena_destroy(FrameArena* arena);
+
+	// Release all allocations made since the last reset, the memory is kept for the next frame.
+	void  frameArena_reset(FrameArena* arena);
+	// Allocations are 16 byte aligned and uninitialized.
+	void* frameArena_alloc(FrameArena* arena, size_t size);
+
+	size_t frameArena_getMemoryUsed(FrameArena* arena);
+	size_t frameArena_getCapacity(FrameArena* arena);
+	size_t frameArena_getHighWaterMark(FrameArena* arena);
+
+	// Each thread gets its own arena, created on first use.
+	FrameArena* frameArena_getThreadArena();
+	void frameArena_destroyThreadArena();
+}
+
+#define frame_alloc(type, count) (type*)TFE_Memory::frameArena_alloc(TFE_Memory::frameArena_getThreadArena(), sizeof(type) * (count))
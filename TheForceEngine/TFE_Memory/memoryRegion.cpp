@@ -41,7 +41,8 @@ struct RegionAllocHeader
 	u8  free;
 	u8  bin;
 	u8  pad8[2];
-	u64 pad; // pad to 16 bytes.
+	u32 tag; // index into the region tag list, only valid for allocated memory when tracking is enabled.
+	u32 pad; // pad to 16 bytes.
 };
 
 // free structure is larger than header, because it fits within the
@@ -71,6 +72,32 @@ struct MemoryBlock
 	AllocHeaderFree* freeListBins[ALLOC_BIN_COUNT];
 };
 
+struct RegionTag
+{
+	const char* name;
+	u32 liveCount;
+	u64 totalCount;
+	size_t liveBytes;
+	size_t highWaterMark;
+};
+
+// Only allocated when tracking is enabled.
+struct RegionTracking
+{
+	size_t used;
+	size_t highWaterMark;
+	u32 liveAllocCount;
+	u64 totalAllocCount;
+	u64 totalFreeCount;
+	u32 sizeClassLive[ALLOC_BIN_COUNT];
+	u64 sizeClassTotal[ALLOC_BIN_COUNT];
+
+	// Tag 0 is reserved for untagged allocations.
+	RegionTag tags[REGION_MAX_TAGS];
+	u32 tagCount;
+	u32 lastTag;
+};
+
 struct MemoryRegion
 {
 	char name[32];
@@ -80,10 +107,13 @@ struct MemoryRegion
 	size_t blockCount;
 	size_t blockSize;
 	size_t maxBlocks;
+
+	RegionTracking* tracking;
 };
 
 static_assert(sizeof(RegionAllocHeader) == 16, "RegionAllocHeader is the wrong size.");
 static_assert(sizeof(AllocHeaderFree) == 24, "AllocHeaderFree is the wrong size.");
+static_assert(s32(REGION_SIZE_CLASS_COUNT) == s32(ALLOC_BIN_COUNT), "Region size classes must match the allocation bins.");
 
 namespace TFE_Memory
 {
@@ -98,6 +128,11 @@ namespace TFE_Memory
 	bool allocateNewBlock(MemoryRegion* region);
 	void removeHeaderFromFreelist(MemoryBlock* block, RegionAllocHeader* header);
 	void insertBlockIntoFreelist(MemoryBlock* block, RegionAllocHeader* header);
+	void trackAlloc(MemoryRegion* region, RegionAllocHeader* header, const char* tag);
+	void trackFree(MemoryRegion* region, RegionAllocHeader* header);
+	void trackResize(MemoryRegion* region, RegionAllocHeader* header, u32 prevSize);
+	void trackClear(MemoryRegion* region);
+	void trackRebuild(MemoryRegion* region);
 
 	void verifyMemory(MemoryRegion* region)
 	{
@@ -155,6 +190,7 @@ namespace TFE_Memory
 		region->blockCount = 0;
 		region->blockSize = blockSize;
 		region->maxBlocks = maxSize ? (maxSize + blockSize - 1) / blockSize : 0;
+		region->tracking = nullptr;
 		if (!allocateNewBlock(region))
 		{
 			free(region);
@@ -182,6 +218,7 @@ namespace TFE_Memory
 			insertBlockIntoFreelist(block, header);
 			VERIFY_MEMORY();
 		}
+		trackClear(region);
 	}
 
 	void region_destroy(MemoryRegion* region)
@@ -192,6 +229,7 @@ namespace TFE_Memory
 			free(region->memBlocks[i]);
 		}
 		free(region->memBlocks);
+		free(region->tracking);
 		free(region);
 	}
 		
@@ -226,7 +264,7 @@ namespace TFE_Memory
 		return (u8*)header + sizeof(RegionAllocHeader);
 	}
 
-	void* region_alloc(MemoryRegion* region, size_t size)
+	void* region_alloc(MemoryRegion* region, size_t size, const char* tag)
 	{
 		assert(region);
 		if (size == 0) { return nullptr; }
@@ -254,6 +292,7 @@ namespace TFE_Memory
 					{
 						VERIFY_MEMORY();
 						void* mem = allocFromHeader(block, (RegionAllocHeader*)header, (u32)size);
+						trackAlloc(region, (RegionAllocHeader*)header, tag);
 						VERIFY_MEMORY();
 						return mem;
 					}
@@ -267,7 +306,7 @@ namespace TFE_Memory
 			if (allocateNewBlock(region))
 			{
 				VERIFY_MEMORY();
-				void* mem = region_alloc(region, size);
+				void* mem = region_alloc(region, size, tag);
 				VERIFY_MEMORY();
 				return mem;
 			}
@@ -278,10 +317,10 @@ namespace TFE_Memory
 		return nullptr;
 	}
 
-	void* region_realloc(MemoryRegion* region, void* ptr, size_t size)
+	void* region_realloc(MemoryRegion* region, void* ptr, size_t size, const char* tag)
 	{
 		assert(region);
-		if (!ptr) { return region_alloc(region, size); }
+		if (!ptr) { return region_alloc(region, size, tag); }
 		if (size == 0) { return nullptr; }
 
 		size = alloc_align(size + sizeof(RegionAllocHeader));
@@ -323,6 +362,7 @@ namespace TFE_Memory
 					removeHeaderFromFreelist(block, nextHeader);
 
 					// Merge blocks.
+					const u32 prevHeaderSize = header->size;
 					block->sizeFree += header->size;
 					header->size += nextHeader->size;
 					block->count--;
@@ -348,6 +388,7 @@ namespace TFE_Memory
 						insertBlockIntoFreelist(block, next);
 					}
 					block->sizeFree -= header->size;
+					trackResize(region, header, prevHeaderSize);
 					VERIFY_MEMORY();
 					return (u8*)header + sizeof(RegionAllocHeader);
 				}
@@ -358,7 +399,7 @@ namespace TFE_Memory
 		}
 
 		// Allocate a new block of memory.
-		void* newMem = region_alloc(region, size);
+		void* newMem = region_alloc(region, size, tag);
 		if (!newMem) { return nullptr; }
 		// Copy over the contents from the previous block.
 		if (prevSize > sizeof(RegionAllocHeader))
@@ -396,6 +437,7 @@ namespace TFE_Memory
 				}
 
 				VERIFY_MEMORY();
+				trackFree(region, header);
 				freeSlot(header, nextHeader, block);
 				VERIFY_MEMORY();
 				return;
@@ -423,6 +465,111 @@ namespace TFE_Memory
 	{
 		return region->blockCount * region->blockSize;
 	}
+
+	const char* region_getName(MemoryRegion* region)
+	{
+		return region->name;
+	}
+
+	void region_enableTracking(MemoryRegion* region, bool enable)
+	{
+		assert(region);
+		if (enable && !region->tracking)
+		{
+			region->tracking = (RegionTracking*)malloc(sizeof(RegionTracking));
+			if (!region->tracking)
+			{
+				TFE_System::logWrite(LOG_ERROR, "MemoryRegion", "Failed to allocate tracking data for region '%s'.", region->name);
+				return;
+			}
+			trackRebuild(region);
+		}
+		else if (!enable && region->tracking)
+		{
+			free(region->tracking);
+			region->tracking = nullptr;
+		}
+	}
+
+	bool region_isTrackingEnabled(MemoryRegion* region)
+	{
+		return region->tracking != nullptr;
+	}
+
+	void region_getStats(MemoryRegion* region, RegionStats* stats)
+	{
+		assert(region && stats);
+		memset(stats, 0, sizeof(RegionStats));
+		stats->used = region_getMemoryUsed(region);
+		stats->capacity = region_getMemoryCapacity(region);
+		stats->freeBytes = stats->capacity - stats->used;
+
+		// The largest free block is found by walking the free lists, which only hold free memory.
+		for (s32 i = 0; i < (s32)region->blockCount; i++)
+		{
+			MemoryBlock* block = region->memBlocks[i];
+			for (s32 b = 0; b < ALLOC_BIN_COUNT; b++)
+			{
+				AllocHeaderFree* slot = block->freeListBins[b];
+				while (slot)
+				{
+					stats->largestFreeBlock = std::max(stats->largestFreeBlock, (size_t)slot->size);
+					slot = slot->binNext;
+				}
+			}
+		}
+		stats->fragmentation = stats->freeBytes ? 1.0f - f32(stats->largestFreeBlock) / f32(stats->freeBytes) : 0.0f;
+
+		RegionTracking* tracking = region->tracking;
+		if (!tracking)
+		{
+			stats->highWaterMark = stats->used;
+			return;
+		}
+		stats->highWaterMark = tracking->highWaterMark;
+		stats->liveAllocCount = tracking->liveAllocCount;
+		stats->totalAllocCount = tracking->totalAllocCount;
+		stats->totalFreeCount = tracking->totalFreeCount;
+		memcpy(stats->sizeClassLive, tracking->sizeClassLive, sizeof(u32) * ALLOC_BIN_COUNT);
+		memcpy(stats->sizeClassTotal, tracking->sizeClassTotal, sizeof(u64) * ALLOC_BIN_COUNT);
+	}
+
+	u32 region_getTopTags(MemoryRegion* region, RegionTagStats* tags, u32 maxCount)
+	{
+		RegionTracking* tracking = region->tracking;
+		if (!tracking || !tags || !maxCount) { return 0; }
+
+		RegionTagStats sorted[REGION_MAX_TAGS];
+		u32 count = 0;
+		for (u32 t = 0; t < tracking->tagCount; t++)
+		{
+			const RegionTag* tag = &tracking->tags[t];
+			if (!tag->totalCount) { continue; }
+			sorted[count++] = { tag->name, tag->liveCount, tag->totalCount, tag->liveBytes, tag->highWaterMark };
+		}
+		std::sort(sorted, sorted + count, [](const RegionTagStats& a, const RegionTagStats& b) { return a.liveBytes > b.liveBytes; });
+
+		count = std::min(count, maxCount);
+		memcpy(tags, sorted, sizeof(RegionTagStats) * count);
+		return count;
+	}
+
+	bool region_getTagStats(MemoryRegion* region, const char* tag, RegionTagStats* stats)
+	{
+		RegionTracking* tracking = region->tracking;
+		if (!tracking || !tag) { return false; }
+
+		for (u32 t = 1; t < tracking->tagCount; t++)
+		{
+			const RegionTag* entry = &tracking->tags[t];
+			if (strcmp(entry->name, tag) == 0)
+			{
+				*stats = { entry->name, entry->liveCount, entry->totalCount, entry->liveBytes, entry->highWaterMark };
+				return true;
+			}
+		}
+		return false;
+	}
 		
 	RelativePointer region_getRelativePointer(MemoryRegion* region, void* ptr)
 	{
@@ -526,7 +673,11 @@ namespace TFE_Memory
 		if (!region)
 		{
 			region = (MemoryRegion*)malloc(sizeof(MemoryRegion));
-			region->blockArrCapacity = 0;
+			if (region)
+			{
+				region->blockArrCapacity = 0;
+				region->tracking = nullptr;
+			}
 		}
 		if (!region)
 		{
@@ -641,6 +792,11 @@ namespace TFE_Memory
 				memPtr += header->size;
 			}
 		}
+		// Tags stored in the headers refer to the session that saved the region.
+		if (region->tracking)
+		{
+			trackRebuild(region);
+		}
 
 		return region;
 	}
@@ -742,6 +898,155 @@ namespace TFE_Memory
 		}
 	}
 
+	/////////////////////////////////////////////
+	// Allocation Tracking
+	/////////////////////////////////////////////
+	u32 getTagIndex(RegionTracking* tracking, const char* tag)
+	{
+		if (!tag) { return 0; }
+		if (tracking->tags[tracking->lastTag].name == tag) { return tracking->lastTag; }
+
+		// Tags are usually string literals, so first try matching by address.
+		for (u32 t = 1; t < tracking->tagCount; t++)
+		{
+			if (tracking->tags[t].name == tag)
+			{
+				tracking->lastTag = t;
+				return t;
+			}
+		}
+		// The same literal may live at different addresses in different translation units.
+		for (u32 t = 1; t < tracking->tagCount; t++)
+		{
+			if (strcmp(tracking->tags[t].name, tag) == 0)
+			{
+				tracking->lastTag = t;
+				return t;
+			}
+		}
+		// Fallback to the untagged entry if the tag list is full.
+		if (tracking->tagCount >= REGION_MAX_TAGS) { return 0; }
+
+		const u32 index = tracking->tagCount;
+		tracking->tags[index] = { tag, 0, 0, 0, 0 };
+		tracking->tagCount++;
+		tracking->lastTag = index;
+		return index;
+	}
+
+	void trackAlloc(MemoryRegion* region, RegionAllocHeader* header, const char* tag)
+	{
+		RegionTracking* tracking = region->tracking;
+		if (!tracking) { return; }
+
+		const s32 bin = getBinFromSize(header->size);
+		header->tag = getTagIndex(tracking, tag);
+		header->pad = 0;
+
+		tracking->used += header->size;
+		tracking->highWaterMark = std::max(tracking->highWaterMark, tracking->used);
+		tracking->liveAllocCount++;
+		tracking->totalAllocCount++;
+		tracking->sizeClassLive[bin]++;
+		tracking->sizeClassTotal[bin]++;
+
+		RegionTag* entry = &tracking->tags[header->tag];
+		entry->liveCount++;
+		entry->totalCount++;
+		entry->liveBytes += header->size;
+		entry->highWaterMark = std::max(entry->highWaterMark, entry->liveBytes);
+	}
+
+	void trackFree(MemoryRegion* region, RegionAllocHeader* header)
+	{
+		RegionTracking* tracking = region->tracking;
+		if (!tracking) { return; }
+
+		const s32 bin = getBinFromSize(header->size);
+		assert(header->tag < tracking->tagCount);
+		const u32 tag = header->tag < tracking->tagCount ? header->tag : 0;
+
+		tracking->used -= header->size;
+		tracking->liveAllocCount--;
+		tracking->totalFreeCount++;
+		tracking->sizeClassLive[bin]--;
+
+		RegionTag* entry = &tracking->tags[tag];
+		entry->liveCount--;
+		entry->liveBytes -= header->size;
+	}
+
+	void trackResize(MemoryRegion* region, RegionAllocHeader* header, u32 prevSize)
+	{
+		RegionTracking* tracking = region->tracking;
+		if (!tracking) { return; }
+
+		const s32 prevBin = getBinFromSize(prevSize);
+		const s32 bin = getBinFromSize(header->size);
+		tracking->sizeClassLive[prevBin]--;
+		tracking->sizeClassLive[bin]++;
+
+		tracking->used += header->size - prevSize;
+		tracking->highWaterMark = std::max(tracking->highWaterMark, tracking->used);
+
+		RegionTag* entry = &tracking->tags[header->tag < tracking->tagCount ? header->tag : 0];
+		entry->liveBytes += header->size - prevSize;
+		entry->highWaterMark = std::max(entry->highWaterMark, entry->liveBytes);
+	}
+
+	// Clearing the region frees everything, but the totals and high-water marks are kept
+	// so they accumulate across level transitions.
+	void trackClear(MemoryRegion* region)
+	{
+		RegionTracking* tracking = region->tracking;
+		if (!tracking) { return; }
+
+		tracking->used = 0;
+		tracking->liveAllocCount = 0;
+		memset(tracking->sizeClassLive, 0, sizeof(u32) * ALLOC_BIN_COUNT);
+		for (u32 t = 0; t < tracking->tagCount; t++)
+		{
+			tracking->tags[t].liveCount = 0;
+			tracking->tags[t].liveBytes = 0;
+		}
+	}
+
+	// Reset the tracking data and count the existing allocations as untagged.
+	void trackRebuild(MemoryRegion* region)
+	{
+		RegionTracking* tracking = region->tracking;
+		memset(tracking, 0, sizeof(RegionTracking));
+		tracking->tags[0].name = "untagged";
+		tracking->tagCount = 1;
+
+		RegionTag* untagged = &tracking->tags[0];
+		for (s32 i = 0; i < (s32)region->blockCount; i++)
+		{
+			MemoryBlock* block = region->memBlocks[i];
+			u8* mem = (u8*)block + sizeof(MemoryBlock);
+			for (u32 a = 0; a < block->count; a++)
+			{
+				RegionAllocHeader* header = (RegionAllocHeader*)mem;
+				mem += header->size;
+				if (header->free) { continue; }
+
+				header->tag = 0;
+				const s32 bin = getBinFromSize(header->size);
+				tracking->used += header->size;
+				tracking->liveAllocCount++;
+				tracking->totalAllocCount++;
+				tracking->sizeClassLive[bin]++;
+				tracking->sizeClassTotal[bin]++;
+
+				untagged->liveCount++;
+				untagged->totalCount++;
+				untagged->liveBytes += header->size;
+			}
+		}
+		tracking->highWaterMark = tracking->used;
+		untagged->highWaterMark = untagged->liveBytes;
+	}
+
 	bool allocateNewBlock(MemoryRegion* region)
 	{
 		if (region->blockCount >= MAX_BLOCK_COUNT)
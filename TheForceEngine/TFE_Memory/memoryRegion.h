@@ -13,19 +13,67 @@ typedef u32 RelativePointer;
 
 #define NULL_RELATIVE_POINTER 0
 
+enum RegionStatConst
+{
+	REGION_SIZE_CLASS_COUNT = 6,
+	REGION_MAX_TAGS = 128,
+};
+
+// Optional allocation telemetry, see region_enableTracking().
+struct RegionStats
+{
+	size_t used;
+	size_t capacity;
+	size_t highWaterMark;
+	size_t freeBytes;
+	size_t largestFreeBlock;
+	// 0 = all free memory is contiguous, approaches 1 as the free memory is split into small pieces.
+	f32 fragmentation;
+
+	u32 liveAllocCount;
+	u64 totalAllocCount;
+	u64 totalFreeCount;
+	// Size classes match the internal free list bins:
+	// [0, 32], [33, 64], [65, 128], [129, 256], [257, 512], [513+]
+	u32 sizeClassLive[REGION_SIZE_CLASS_COUNT];
+	u64 sizeClassTotal[REGION_SIZE_CLASS_COUNT];
+};
+
+struct RegionTagStats
+{
+	const char* tag;
+	u32 liveCount;
+	u64 totalCount;
+	size_t liveBytes;
+	size_t highWaterMark;
+};
+
 namespace TFE_Memory
 {
 	MemoryRegion* region_create(const char* name, size_t blockSize, size_t maxSize = 0u);
 	void region_clear(MemoryRegion* region);
 	void region_destroy(MemoryRegion* region);
 
-	void* region_alloc(MemoryRegion* region, size_t size);
-	void* region_realloc(MemoryRegion* region, void* ptr, size_t size);
+	// The optional tag identifies the call site when tracking is enabled, it must point to static memory (such as __FUNCTION__).
+	void* region_alloc(MemoryRegion* region, size_t size, const char* tag = nullptr);
+	void* region_realloc(MemoryRegion* region, void* ptr, size_t size, const char* tag = nullptr);
 	void  region_free(MemoryRegion* region, void* ptr);
 
 	size_t region_getMemoryUsed(MemoryRegion* region);
 	size_t region_getMemoryCapacity(MemoryRegion* region);
 	void region_getBlockInfo(MemoryRegion* region, size_t* blockCount, size_t* blockSize);
+	const char* region_getName(MemoryRegion* region);
+
+	// Allocation tracking - disabled by default.
+	// Enabling tracking rebuilds the statistics from the current state of the region, existing allocations are untagged.
+	void region_enableTracking(MemoryRegion* region, bool enable);
+	bool region_isTrackingEnabled(MemoryRegion* region);
+	// Fills in 'stats', the allocation counts and high-water mark are only valid if tracking is enabled.
+	void region_getStats(MemoryRegion* region, RegionStats* stats);
+	// Returns the number of tags written to 'tags', sorted by live bytes (largest first).
+	u32  region_getTopTags(MemoryRegion* region, RegionTagStats* tags, u32 maxCount);
+	// Returns false if tracking is disabled or the tag has not been used in this region.
+	bool region_getTagStats(MemoryRegion* region, const char* tag, RegionTagStats* stats);
 
 	RelativePointer region_getRelativePointer(MemoryRegion* region, void* ptr);
 	void* region_getRealPointer(MemoryRegion* region, RelativePointer ptr);
@@ -48,6 +48,7 @@ namespace TFE_RenderBackend
 	static u32 s_virtualWidthUi;
 	static u32 s_virtualWidth3d;
 
+	static bool s_headless = false;
 	static bool s_widescreen = false;
 	static bool s_asyncFrameBuffer = true;
 	static bool s_gpuColorConvert = false;
@@ -65,7 +66,7 @@ namespace TFE_RenderBackend
 	SDL_Window* createWindow(const WindowState& state)
 	{
 		u32 windowFlags = SDL_WINDOW_OPENGL;
-		bool windowed = !(state.flags & WINFLAG_FULLSCREEN);
+		bool windowed = !(state.flags & WINFLAG_FULLSCREEN) || s_headless;
 
 		TFE_Settings_Window* windowSettings = TFE_Settings::getWindowSettings();
 		
@@ -73,7 +74,12 @@ namespace TFE_RenderBackend
 		s32 displayIndex = getDisplayIndex(x, y);
 		assert(displayIndex >= 0);
 		
-		if (windowed)
+		if (s_headless)
+		{
+			// The window is only needed to own the GPU context.
+			windowFlags |= SDL_WINDOW_HIDDEN;
+		}
+		else if (windowed)
 		{
 			y = std::max(32, y);
 			windowSettings->y = y;
@@ -94,7 +100,7 @@ namespace TFE_RenderBackend
 		SDL_GLContext context = SDL_GL_CreateContext(window);
 
 		//swap buffer at the monitors rate
-		SDL_GL_SetSwapInterval((state.flags & WINFLAG_VSYNC) ? 1 : 0);
+		SDL_GL_SetSwapInterval(((state.flags & WINFLAG_VSYNC) && !s_headless) ? 1 : 0);
 
 		//GLEW is an OpenGL Loading Library used to reach GL functions
 		//Sets all functions available
@@ -127,6 +133,11 @@ namespace TFE_RenderBackend
 		
 	bool init(const WindowState& state)
 	{
+		s_headless = (state.flags & WINFLAG_HEADLESS) != 0;
+		if (s_headless)
+		{
+			TFE_System::logWrite(LOG_MSG, "RenderBackend", "Headless mode, nothing will be presented.");
+		}
 		m_window = createWindow(state);
 		m_windowState = state;
 
@@ -193,6 +204,13 @@ namespace TFE_RenderBackend
 		
 	void swap(bool blitVirtualDisplay)
 	{
+		if (s_headless)
+		{
+			// Nothing is presented, so skip the blit, UI and buffer swap.
+			TFE_Ui::endFrame();
+			return;
+		}
+
 		// Blit the texture or render target to the screen.
 		if (blitVirtualDisplay) { drawVirtualDisplay(); }
 		else { glClear(GL_COLOR_BUFFER_BIT); }
@@ -241,7 +259,7 @@ namespace TFE_RenderBackend
 	void updateSettings()
 	{
 		TFE_Settings_Window* windowSettings = TFE_Settings::getWindowSettings();
-		if (!(m_windowState.flags & WINFLAG_FULLSCREEN))
+		if (!(m_windowState.flags & (WINFLAG_FULLSCREEN | WINFLAG_HEADLESS)))
 		{
 			SDL_GetWindowPosition((SDL_Window*)m_window, &windowSettings->x, &windowSettings->y);
 		}
@@ -517,7 +535,7 @@ namespace TFE_RenderBackend
 	void updateVirtualDisplay(const void* buffer, size_t size)
 	{
 		TFE_ZONE("Update Virtual Display");
-		if (s_virtualDisplay)
+		if (s_virtualDisplay && !s_headless)
 		{
 			s_virtualDisplay->update(buffer, size);
 		}
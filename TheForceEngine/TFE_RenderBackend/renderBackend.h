@@ -18,6 +18,9 @@ enum WindowFlags
 {
 	WINFLAG_FULLSCREEN = 1 << 0,
 	WINFLAG_VSYNC = 1 << 1,
+	// TFE: No visible window - the GPU context lives in a hidden window and nothing is presented.
+	// Used by batch workers, which only run the simulation.
+	WINFLAG_HEADLESS = 1 << 2,
 };
 
 enum DisplayMode
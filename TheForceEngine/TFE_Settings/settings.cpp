@@ -337,6 +337,7 @@ namespace TFE_Settings
 		writeKeyValue_Bool(settings, "perspectiveCorrect3DO", s_graphicsSettings.perspectiveCorrectTexturing);
 		writeKeyValue_Bool(settings, "extendAjoinLimits", s_graphicsSettings.extendAjoinLimits);
 		writeKeyValue_Bool(settings, "vsync", s_graphicsSettings.vsync);
+		writeKeyValue_Bool(settings, "fixedTickInterpolation", s_graphicsSettings.fixedTickInterpolation);
 		writeKeyValue_Float(settings, "brightness", s_graphicsSettings.brightness);
 		writeKeyValue_Float(settings, "contrast", s_graphicsSettings.contrast);
 		writeKeyValue_Float(settings, "saturation", s_graphicsSettings.saturation);
@@ -375,6 +376,10 @@ namespace TFE_Settings
 		writeKeyValue_Bool(settings, "use16Channels", s_soundSettings.use16Channels);
 		writeKeyValue_Bool(settings, "disableSoundInMenus", s_soundSettings.disableSoundInMenus);
 		writeKeyValue_Int(settings, "midiDevice", s_soundSettings.midiDevice);
+		writeKeyValue_String(settings, "resampleQuality", c_tfeResampleQualityStrings[s_soundSettings.resampleQuality]);
+		writeKeyValue_Bool(settings, "useSoftwareSynth", s_soundSettings.useSoftwareSynth);
+		writeKeyValue_String(settings, "soundFont", s_soundSettings.soundFont);
+		writeKeyValue_Bool(settings, "midiAudioClock", s_soundSettings.midiAudioClock);
 	}
 
 	void writeGameSettings(FileStream& settings)
@@ -605,6 +610,10 @@ namespace TFE_Settings
 		{
 			s_graphicsSettings.vsync = parseBool(value);
 		}
+		else if (strcasecmp("fixedTickInterpolation", key) == 0)
+		{
+			s_graphicsSettings.fixedTickInterpolation = parseBool(value);
+		}
 		else if (strcasecmp("brightness", key) == 0)
 		{
 			s_graphicsSettings.brightness = parseFloat(value);
@@ -731,6 +740,29 @@ namespace TFE_Settings
 		{
 			s_soundSettings.midiDevice = parseInt(value);
 		}
+		else if (strcasecmp("resampleQuality", key) == 0)
+		{
+			for (size_t i = 0; i < TFE_ARRAYSIZE(c_tfeResampleQualityStrings); i++)
+			{
+				if (strcasecmp(value, c_tfeResampleQualityStrings[i]) == 0)
+				{
+					s_soundSettings.resampleQuality = TFE_ResampleQuality(i);
+					break;
+				}
+			}
+		}
+		else if (strcasecmp("useSoftwareSynth", key) == 0)
+		{
+			s_soundSettings.useSoftwareSynth = parseBool(value);
+		}
+		else if (strcasecmp("soundFont", key) == 0)
+		{
+			strcpy(s_soundSettings.soundFont, value);
+		}
+		else if (strcasecmp("midiAudioClock", key) == 0)
+		{
+			s_soundSettings.midiAudioClock = parseBool(value);
+		}
 	}
 
 	void parseGame(const char* key, const char* value)
@@ -46,6 +46,7 @@ struct TFE_Settings_Graphics
 	bool  perspectiveCorrectTexturing = false;
 	bool  extendAjoinLimits = true;
 	bool  vsync = true;
+	bool  fixedTickInterpolation = false;	// Simulate at a fixed tick rate and interpolate the rendering between ticks.
 	f32   brightness = 1.0f;
 	f32   contrast = 1.0f;
 	f32   saturation = 1.0f;
@@ -86,6 +87,23 @@ enum PitchLimit
 	PITCH_COUNT
 };
 
+// Selects how the 11025 Hz mix is converted to the device rate.
+enum TFE_ResampleQuality
+{
+	TFE_RESAMPLE_BACKEND = 0,	// Open the device at 11025 Hz and leave resampling to the backend or OS.
+	TFE_RESAMPLE_LOW,
+	TFE_RESAMPLE_MEDIUM,
+	TFE_RESAMPLE_HIGH,
+};
+
+static const char* c_tfeResampleQualityStrings[] =
+{
+	"Backend",	// TFE_RESAMPLE_BACKEND
+	"Low",		// TFE_RESAMPLE_LOW
+	"Medium",	// TFE_RESAMPLE_MEDIUM
+	"High",		// TFE_RESAMPLE_HIGH
+};
+
 static const char* c_tfeHudScaleStrings[] =
 {
 	"Proportional",		// TFE_HUDSCALE_PROPORTIONAL
@@ -128,6 +146,12 @@ struct TFE_Settings_Sound
 	bool use16Channels = false;
 	bool disableSoundInMenus = false;
 	u32 midiDevice = 0;
+	TFE_ResampleQuality resampleQuality = TFE_RESAMPLE_MEDIUM;
+	// Play the music with the built-in synthesizer instead of a MIDI device, the SoundFont path is relative to the program directory.
+	bool useSoftwareSynth = false;
+	char soundFont[TFE_MAX_PATH] = "SoundFonts/SYNTHGM.sf2";
+	// Sequence MIDI devices from the audio thread sample clock instead of a free running thread.
+	bool midiAudioClock = false;
 };
 
 struct TFE_Game
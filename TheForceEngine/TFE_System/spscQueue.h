@@ -0,0 +1,58 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Single Producer, Single Consumer Queue
+// A fixed size, lock-free ring buffer used to pass commands between
+// two threads (such as the game and audio threads) without a mutex.
+//
+// Only one thread may push and only one thread may pop at a time.
+// Items should be plain data, they are copied in and out of the ring.
+//////////////////////////////////////////////////////////////////////
+
+#include "types.h"
+
+template <typename T, u32 Capacity>
+class SpscQueue
+{
+	static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two.");
+
+public:
+	SpscQueue() : m_head(0), m_tail(0) {}
+
+	// Producer: returns false if the queue is full.
+	bool push(const T& item)
+	{
+		const u32 tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_head.load(std::memory_order_acquire) >= Capacity)
+		{
+			return false;
+		}
+		m_items[tail & (Capacity - 1)] = item;
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer: returns false if the queue is empty.
+	bool pop(T* item)
+	{
+		const u32 head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		*item = m_items[head & (Capacity - 1)];
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Only valid while neither thread is using the queue.
+	void clear()
+	{
+		m_head.store(0, std::memory_order_relaxed);
+		m_tail.store(0, std::memory_order_relaxed);
+	}
+
+private:
+	T m_items[Capacity];
+	atomic_u32 m_head;	// Written by the consumer.
+	atomic_u32 m_tail;	// Written by the producer.
+};
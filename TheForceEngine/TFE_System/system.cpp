@@ -8,6 +8,8 @@
 #include <stdlib.h>
 #include <time.h> 
 #include <algorithm>
+#include <string>
+#include <vector>
 
 #ifdef _WIN32
 // Following includes for Windows LinkCallback
@@ -17,6 +19,11 @@
 #include <synchapi.h>
 #undef min
 #undef max
+#else
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <limits.h>
+#include <unistd.h>
 #endif
 
 namespace TFE_System
@@ -217,6 +224,70 @@ namespace TFE_System
 		return false;
 	}
 
+	// Arguments are passed as-is, they are never interpreted by a shell.
+	bool osRunProcess(const char* pathToExe, const char* exeDir, const char* const* args, s32 argCount, bool waitForCompletion)
+	{
+#ifdef _WIN32
+		// Quote each argument so CommandLineToArgvW() / the CRT split it back into the same list.
+		std::string cmdLine;
+		for (s32 i = 0; i < argCount; i++)
+		{
+			if (i) { cmdLine += ' '; }
+			cmdLine += '"';
+			s32 slashCount = 0;
+			for (const char* c = args[i]; *c; c++)
+			{
+				if (*c == '\\')
+				{
+					slashCount++;
+					continue;
+				}
+				// Backslashes are only escaped when followed by a quote.
+				cmdLine.append(*c == '"' ? slashCount * 2 + 1 : slashCount, '\\');
+				cmdLine += *c;
+				slashCount = 0;
+			}
+			cmdLine.append(slashCount * 2, '\\');
+			cmdLine += '"';
+		}
+		return osShellExecute(pathToExe, exeDir, cmdLine.c_str(), waitForCompletion);
+#else
+		// Resolve a relative executable path before changing to exeDir.
+		char fullPath[PATH_MAX];
+		if (realpath(pathToExe, fullPath))
+		{
+			pathToExe = fullPath;
+		}
+
+		std::vector<char*> argv;
+		argv.push_back((char*)pathToExe);
+		for (s32 i = 0; i < argCount; i++)
+		{
+			argv.push_back((char*)args[i]);
+		}
+		argv.push_back(nullptr);
+
+		const pid_t pid = fork();
+		if (pid < 0)
+		{
+			return false;
+		}
+		else if (pid == 0)
+		{
+			if (exeDir && chdir(exeDir) != 0) { _exit(127); }
+			execv(pathToExe, argv.data());
+			_exit(127);
+		}
+
+		if (waitForCompletion)
+		{
+			s32 status = 0;
+			waitpid(pid, &status, 0);
+		}
+		return true;
+#endif
+	}
+
 #ifdef _WIN32
 	void sleep(u32 sleepDeltaMS)
 	{
@@ -54,6 +54,7 @@ namespace TFE_System
 
 	// System
 	bool osShellExecute(const char* pathToExe, const char* exeDir, const char* param, bool waitForCompletion);
+	bool osRunProcess(const char* pathToExe, const char* exeDir, const char* const* args, s32 argCount, bool waitForCompletion);
 	void sleep(u32 sleepDeltaMS);
 
 	void postQuitMessage();
@@ -96,6 +96,11 @@ void render()
 	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
 
+void endFrame()
+{
+	ImGui::EndFrame();
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 // General TFE tries to keep paths consistently using forward slashes for readability, consistency and
 // generally they work equally well on Linux, Mac and Windows.
@@ -26,6 +26,8 @@ namespace TFE_Ui
 	void setUiInput(const void* inputEvent);
 	void begin();
 	void render();
+	// Finish the frame without drawing it.
+	void endFrame();
 
 	void setUiScale(s32 scale);
 	s32  getUiScale();
@@ -8,6 +8,7 @@
 #include <TFE_Game/igame.h>
 #include <TFE_Game/saveSystem.h>
 #include <TFE_Game/reticle.h>
+#include <TFE_Game/batchRunner.h>
 #include <TFE_Jedi/InfSystem/infSystem.h>
 //#include <TFE_Editor/editor.h>
 #include <TFE_FileSystem/fileutil.h>
@@ -58,6 +59,7 @@ using namespace TFE_Input;
 
 static bool s_loop  = true;
 static bool s_nullAudioDevice = false;
+static const char* s_audioRenderPath = nullptr;
 static f32  s_refreshRate  = 0;
 static s32  s_displayIndex = 0;
 static u32  s_baseWindowWidth  = 1280;
@@ -70,6 +72,12 @@ static char s_screenshotTime[TFE_MAX_PATH];
 static s32  s_startupGame = -1;
 static IGame* s_curGame = nullptr;
 static const char* s_loadRequestFilename = nullptr;
+static bool s_fastForward = false;
+static s32  s_fastForwardRenderInterval = -1;
+static const char* s_batchLevelList = nullptr;
+static s32  s_batchWorkerCount = 0;
+static s32  s_batchTickCount = 145 * 60 * 5;	// 5 minutes of game time per level.
+static f64  s_batchTimeBudget = 60.0 * 60.0;
 
 void parseOption(const char* name, const std::vector<const char*>& values, bool longName);
 bool validatePath();
@@ -403,6 +411,30 @@ void setAppState(AppState newState, int argc, char* argv[])
 	s_curState = newState;
 }
 
+// TFE: Fast-forward mode - run as many simulation ticks as fit in the frame budget so that the UI stays responsive.
+// Game time is advanced by exactly one tick per run (see TFE_DarkForces::updateTime()).
+bool runFastForward()
+{
+	const f64 c_frameBudget = 1.0 / 30.0;
+	const u64 start = TFE_System::getCurrentTimeInTicks();
+	bool tasksRan = false;
+	while (true)
+	{
+		s_curGame->loopGame();
+		if (!TFE_Jedi::task_run()) { break; }
+		tasksRan = true;
+
+		if (!TFE_Jedi::task_isFastForward() || TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - start) >= c_frameBudget)
+		{
+			break;
+		}
+		// The input state only applies to the first tick.
+		TFE_Input::endFrame();
+		inputMapping_endFrame();
+	}
+	return tasksRan;
+}
+
 bool systemMenuKeyCombo()
 {
 	return TFE_System::systemUiRequestPosted() || (inputMapping_getActionState(IAS_SYSTEM_MENU) == STATE_PRESSED);
@@ -511,7 +543,17 @@ int main(int argc, char* argv[])
 	pathsSet &= TFE_Paths::setProgramPath();
 	pathsSet &= TFE_Paths::setProgramDataPath("TheForceEngine");
 	pathsSet &= TFE_Paths::setUserDocumentsPath("TheForceEngine");
-	TFE_System::logOpen("the_force_engine_log.txt");
+	// TFE: Batch workers each get their own log so they do not overwrite the runner log.
+	char logName[TFE_MAX_PATH] = "the_force_engine_log.txt";
+	for (s32 i = 1; i + 1 < argc; i++)
+	{
+		if (strcasecmp(argv[i], "--batchWorker") == 0)
+		{
+			sprintf(logName, "batch_worker_%s_log.txt", argv[i + 1]);
+			break;
+		}
+	}
+	TFE_System::logOpen(logName);
 	TFE_System::logWrite(LOG_MSG, "Main", "The Force Engine %s", c_gitVersion);
 	if (!pathsSet)
 	{
@@ -543,6 +585,15 @@ int main(int argc, char* argv[])
 	// Override settings with command line options.
 	parseCommandLine(argc, argv);
 
+	// TFE: The batch runner only launches worker processes, so it never opens a window.
+	if (s_batchLevelList)
+	{
+		const s32 workerCount = s_batchWorkerCount > 0 ? s_batchWorkerCount : SDL_GetCPUCount();
+		const bool res = batch_runWorkers(argv[0], s_batchLevelList, workerCount, s_batchTickCount, s_batchTimeBudget);
+		TFE_System::logClose();
+		return res ? PROGRAM_SUCCESS : PROGRAM_ERROR;
+	}
+
 	// Setup game paths.
 	// Get the current game.
 	const TFE_Game* game = TFE_Settings::getGame();
@@ -590,6 +641,8 @@ int main(int argc, char* argv[])
 	u32 windowFlags = 0;
 	if (windowSettings->fullscreen) { TFE_System::logWrite(LOG_MSG, "Display", "Fullscreen enabled."); windowFlags |= WINFLAG_FULLSCREEN; }
 	if (graphics->vsync) { TFE_System::logWrite(LOG_MSG, "Display", "Vertical Sync enabled."); windowFlags |= WINFLAG_VSYNC; }
+	// Batch workers only run the simulation, so they do not open a visible window.
+	if (batch_isWorker()) { windowFlags |= WINFLAG_HEADLESS; }
 	
 	WindowState windowState =
 	{
@@ -611,7 +664,7 @@ int main(int argc, char* argv[])
 		return PROGRAM_ERROR;
 	}
 	TFE_FrontEndUI::initConsole();
-	TFE_Audio::init(s_nullAudioDevice);
+	TFE_Audio::init(s_nullAudioDevice, s_audioRenderPath);
 	TFE_MidiPlayer::init(TFE_Settings::getSoundSettings()->midiDevice);
 	TFE_Polygon::init();
 	TFE_Image::init();
@@ -630,6 +683,12 @@ int main(int argc, char* argv[])
 
 	// Optional Reticle.
 	reticle_init();
+	// Uncapped simulation for soak testing.
+	if (s_fastForward)
+	{
+		if (s_fastForwardRenderInterval >= 0) { TFE_Jedi::task_setFastForward(JTRUE, s_fastForwardRenderInterval); }
+		else { TFE_Jedi::task_setFastForward(JTRUE); }
+	}
 
 	// Test
 	#ifdef VM_ENABLE
@@ -821,8 +880,16 @@ int main(int argc, char* argv[])
 			else
 			{
 				TFE_SaveSystem::update();
-				s_curGame->loopGame();
-				endInputFrame = TFE_Jedi::task_run() != 0;
+				if (TFE_Jedi::task_isFastForward())
+				{
+					endInputFrame = runFastForward();
+				}
+				else
+				{
+					s_curGame->loopGame();
+					endInputFrame = TFE_Jedi::task_run() != 0;
+					s_curGame->renderGame();
+				}
 			}
 		}
 		else
@@ -852,6 +919,12 @@ int main(int argc, char* argv[])
 		{
 			TFE_FRAME_END();
 		}
+
+		// Batch workers exit once their level has run long enough.
+		if (!batch_updateWorker())
+		{
+			s_loop = false;
+		}
 	}
 
 	if (s_curGame)
@@ -872,7 +945,11 @@ int main(int argc, char* argv[])
 	TFE_Image::shutdown();
 	TFE_Palette::freeAll();
 	TFE_RenderBackend::updateSettings();
-	TFE_Settings::shutdown();
+	// Batch workers run in parallel and should not overwrite the settings.
+	if (!batch_isWorker())
+	{
+		TFE_Settings::shutdown();
+	}
 	TFE_Jedi::texturepacker_freeGlobal();
 	TFE_RenderBackend::destroy();
 	TFE_SaveSystem::destroy();
@@ -921,5 +998,33 @@ void parseOption(const char* name, const std::vector<const char*>& values, bool
 			// --noaudio
 			s_nullAudioDevice = true;
 		}
+		else if (strcasecmp(name, "renderAudio") == 0 && values.size() >= 1)
+		{
+			// --renderAudio outputPath
+			// Renders the audio to outputPath.wav and the MIDI output to outputPath.mid instead of using the audio device,
+			// use with --fastForward for deterministic output.
+			s_audioRenderPath = values[0];
+			TFE_System::logWrite(LOG_MSG, "CommandLine", "Rendering audio to '%s'.", s_audioRenderPath);
+		}
+		else if (strcasecmp(name, "fastForward") == 0)
+		{
+			// --fastForward [renderInterval]
+			s_fastForward = true;
+			s_fastForwardRenderInterval = values.size() >= 1 ? atoi(values[0]) : -1;
+			TFE_System::logWrite(LOG_MSG, "CommandLine", "Fast-forward enabled.");
+		}
+		else if (strcasecmp(name, "batch") == 0 && values.size() >= 1)
+		{
+			// --batch levelList.txt [workerCount] [tickCount] [timeBudgetInSec]
+			s_batchLevelList = values[0];
+			if (values.size() >= 2) { s_batchWorkerCount = atoi(values[1]); }
+			if (values.size() >= 3) { s_batchTickCount = atoi(values[2]); }
+			if (values.size() >= 4) { s_batchTimeBudget = atof(values[3]); }
+		}
+		else if (strcasecmp(name, "batchWorker") == 0 && values.size() >= 3)
+		{
+			// --batchWorker workerId tickCount timeBudgetInSec
+			batch_beginWorker(atoi(values[0]), atoi(values[1]), atof(values[2]));
+		}
 	}
 }
\ No newline at end of file